@@ -0,0 +1,86 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* defined(HAVE_CONFIG_H) */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * bench_func runs the measured operation |n| times, and returns the
+ * elapsed time in nanoseconds.  Any setup and teardown must be done
+ * outside of the measured region, using bench_now to take
+ * timestamps.
+ */
+typedef uint64_t (*bench_func)(size_t n);
+
+typedef struct bench_case {
+  /* name is the name of the benchmark in the form of
+     "<module>/<operation>". */
+  const char *name;
+  bench_func func;
+} bench_case;
+
+/*
+ * bench_now returns the current monotonic time in nanoseconds.
+ */
+uint64_t bench_now(void);
+
+/*
+ * bench_rand is a xorshift64 generator.  All benchmarks seed it with
+ * BENCH_SEED so that the inputs are identical across runs and
+ * platforms.
+ */
+uint64_t bench_rand(uint64_t *state);
+
+#define BENCH_SEED 0x9E3779B97F4A7C15ULL
+
+/*
+ * bench_shuffle shuffles |n| elements of |size| bytes each in |base|
+ * with Fisher-Yates algorithm.
+ */
+void bench_shuffle(void *base, size_t n, size_t size, uint64_t *state);
+
+/*
+ * bench_sink is written by benchmarks so that the compiler does not
+ * optimize the measured operations away.
+ */
+extern volatile uint64_t bench_sink;
+
+extern const bench_case bench_ksl_cases[];
+extern const bench_case bench_map_cases[];
+extern const bench_case bench_pq_cases[];
+extern const bench_case bench_rob_cases[];
+extern const bench_case bench_gaptr_cases[];
+extern const bench_case bench_acktr_cases[];
+extern const bench_case bench_rtb_cases[];
+extern const bench_case bench_conv_cases[];
+extern const bench_case bench_pkt_cases[];
+
+#endif /* !defined(BENCH_H) */
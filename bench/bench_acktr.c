@@ -0,0 +1,101 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench.h"
+
+#include "ngtcp2_acktr.h"
+#include "ngtcp2_log.h"
+
+/*
+ * add_pkt_num returns the i-th received packet number.  One in every
+ * 8 packets is lost so that ngtcp2_acktr keeps multiple ranges.
+ */
+static int64_t add_pkt_num(size_t i) { return (int64_t)(i + i / 7); }
+
+static uint64_t bench_add(size_t n) {
+  ngtcp2_acktr acktr;
+  ngtcp2_log log;
+  uint64_t t;
+  size_t i;
+
+  ngtcp2_log_init(&log, NULL, NULL, NULL, NULL, 0, NULL);
+  ngtcp2_acktr_init(&acktr, &log, ngtcp2_mem_default());
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_acktr_add(&acktr, add_pkt_num(i), 1, i);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_acktr_free(&acktr);
+
+  return t;
+}
+
+/*
+ * bench_create_ack_frame creates ACK frame n times from ngtcp2_acktr
+ * which has the maximum number of ranges.
+ */
+static uint64_t bench_create_ack_frame(size_t n) {
+  ngtcp2_acktr acktr;
+  ngtcp2_log log;
+  ngtcp2_ack_range ranges[NGTCP2_MAX_ACK_RANGES];
+  ngtcp2_ack ack = {
+    .ranges = ranges,
+  };
+  uint64_t t, sink = 0;
+  size_t i;
+
+  ngtcp2_log_init(&log, NULL, NULL, NULL, NULL, 0, NULL);
+  ngtcp2_acktr_init(&acktr, &log, ngtcp2_mem_default());
+
+  for (i = 0; i < NGTCP2_ACKTR_MAX_ENT * 8; ++i) {
+    ngtcp2_acktr_add(&acktr, add_pkt_num(i), 1, i);
+  }
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_acktr_create_ack_frame(&acktr, &ack, NGTCP2_FRAME_ACK,
+                                  NGTCP2_ACKTR_MAX_ENT * 8, 0,
+                                  NGTCP2_DEFAULT_ACK_DELAY_EXPONENT);
+    sink += ack.rangecnt;
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  ngtcp2_acktr_free(&acktr);
+
+  return t;
+}
+
+const bench_case bench_acktr_cases[] = {
+  {"acktr/add", bench_add},
+  {"acktr/create_ack_frame", bench_create_ack_frame},
+  {0},
+};
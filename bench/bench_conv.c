@@ -0,0 +1,181 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include "ngtcp2_conv.h"
+
+/*
+ * The conv benchmarks encode and decode n variable-length integers.
+ * The lengths of the encoded integers are evenly distributed among
+ * 1, 2, 4, and 8 bytes.
+ */
+static uint64_t *values_new(size_t n) {
+  static const uint64_t masks[] = {
+    0x3F,
+    0x3FFF,
+    0x3FFFFFFF,
+    0x3FFFFFFFFFFFFFFFULL,
+  };
+  uint64_t *values = malloc(sizeof(*values) * n);
+  uint64_t state = BENCH_SEED;
+  size_t i;
+
+  if (values == NULL) {
+    abort();
+  }
+
+  for (i = 0; i < n; ++i) {
+    values[i] = bench_rand(&state) & masks[i & 0x3];
+  }
+
+  return values;
+}
+
+static uint8_t *encode_values(const uint64_t *values, size_t n) {
+  uint8_t *buf = malloc(n * 8);
+  uint8_t *p = buf;
+  size_t i;
+
+  if (buf == NULL) {
+    abort();
+  }
+
+  for (i = 0; i < n; ++i) {
+    p = ngtcp2_put_uvarint(p, values[i]);
+  }
+
+  return buf;
+}
+
+static uint64_t bench_put_uvarint(size_t n) {
+  uint64_t *values = values_new(n);
+  uint8_t *buf = malloc(n * 8);
+  uint8_t *p = buf;
+  uint64_t t;
+  size_t i;
+
+  if (buf == NULL) {
+    abort();
+  }
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    p = ngtcp2_put_uvarint(p, values[i]);
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = (uint64_t)(p - buf);
+
+  free(buf);
+  free(values);
+
+  return t;
+}
+
+static uint64_t bench_get_uvarint(size_t n) {
+  uint64_t *values = values_new(n);
+  uint8_t *buf = encode_values(values, n);
+  const uint8_t *p = buf;
+  uint64_t t, v, sink = 0;
+  size_t i;
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    p = ngtcp2_get_uvarint(&v, p);
+    sink += v;
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  free(buf);
+  free(values);
+
+  return t;
+}
+
+/*
+ * bench_get_uvarintv decodes the integers in the batches of 4, which
+ * is the number of integers in an ACK frame header after the frame
+ * type.
+ */
+static uint64_t bench_get_uvarintv(size_t n) {
+  uint64_t *values = values_new(n);
+  uint8_t *buf = encode_values(values, n);
+  const uint8_t *p = buf;
+  const uint8_t *end = buf + n * 8;
+  uint64_t t, v[4], sink = 0;
+  size_t i;
+
+  t = bench_now();
+
+  for (i = 0; i + 4 <= n; i += 4) {
+    p = ngtcp2_get_uvarintv(v, 4, p, end);
+    sink += v[0] + v[1] + v[2] + v[3];
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  free(buf);
+  free(values);
+
+  return t;
+}
+
+static uint64_t bench_put_uvarintlen(size_t n) {
+  uint64_t *values = values_new(n);
+  uint64_t t, sink = 0;
+  size_t i;
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    sink += ngtcp2_put_uvarintlen(values[i]);
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  free(values);
+
+  return t;
+}
+
+const bench_case bench_conv_cases[] = {
+  {"conv/put_uvarint", bench_put_uvarint},
+  {"conv/get_uvarint", bench_get_uvarint},
+  {"conv/get_uvarintv", bench_get_uvarintv},
+  {"conv/put_uvarintlen", bench_put_uvarintlen},
+  {0},
+};
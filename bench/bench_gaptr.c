@@ -0,0 +1,153 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include "ngtcp2_gaptr.h"
+#include "ngtcp2_macro.h"
+
+/*
+ * The gaptr benchmarks push n ranges of BENCH_GAPTR_DATALEN bytes
+ * each.  push_reordered shuffles the ranges in the windows of
+ * BENCH_GAPTR_WINDOW ranges, and push_sparse leaves a gap after each
+ * range so that the number of gaps grows with n.
+ */
+#define BENCH_GAPTR_DATALEN 1200
+#define BENCH_GAPTR_WINDOW 16
+
+static uint64_t bench_push_window(size_t n, int reorder) {
+  uint64_t offsets[BENCH_GAPTR_WINDOW];
+  ngtcp2_gaptr gaptr;
+  uint64_t state = BENCH_SEED;
+  uint64_t offset = 0;
+  uint64_t t, elapsed = 0;
+  size_t i, j, nwin;
+
+  ngtcp2_gaptr_init(&gaptr, ngtcp2_mem_default());
+
+  for (i = 0; i < n; i += nwin) {
+    nwin = ngtcp2_min(n - i, (size_t)BENCH_GAPTR_WINDOW);
+
+    for (j = 0; j < nwin; ++j) {
+      offsets[j] = offset;
+      offset += BENCH_GAPTR_DATALEN;
+    }
+
+    if (reorder) {
+      bench_shuffle(offsets, nwin, sizeof(offsets[0]), &state);
+    }
+
+    t = bench_now();
+
+    for (j = 0; j < nwin; ++j) {
+      ngtcp2_gaptr_push(&gaptr, offsets[j], BENCH_GAPTR_DATALEN);
+    }
+
+    elapsed += bench_now() - t;
+  }
+
+  bench_sink = ngtcp2_gaptr_first_gap_offset(&gaptr);
+
+  ngtcp2_gaptr_free(&gaptr);
+
+  return elapsed;
+}
+
+static uint64_t bench_push_in_order(size_t n) {
+  return bench_push_window(n, 0);
+}
+
+static uint64_t bench_push_reordered(size_t n) {
+  return bench_push_window(n, 1);
+}
+
+static uint64_t bench_push_sparse(size_t n) {
+  ngtcp2_gaptr gaptr;
+  uint64_t t;
+  size_t i;
+
+  ngtcp2_gaptr_init(&gaptr, ngtcp2_mem_default());
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_gaptr_push(&gaptr, i * BENCH_GAPTR_DATALEN * 2, BENCH_GAPTR_DATALEN);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_gaptr_free(&gaptr);
+
+  return t;
+}
+
+static uint64_t bench_is_pushed(size_t n) {
+  uint64_t *offsets = malloc(sizeof(*offsets) * n);
+  ngtcp2_gaptr gaptr;
+  uint64_t state = BENCH_SEED;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  if (offsets == NULL) {
+    abort();
+  }
+
+  ngtcp2_gaptr_init(&gaptr, ngtcp2_mem_default());
+
+  for (i = 0; i < n; ++i) {
+    offsets[i] = i * BENCH_GAPTR_DATALEN;
+
+    if (i % 2 == 0) {
+      ngtcp2_gaptr_push(&gaptr, offsets[i], BENCH_GAPTR_DATALEN);
+    }
+  }
+
+  bench_shuffle(offsets, n, sizeof(*offsets), &state);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    sink += (uint64_t)ngtcp2_gaptr_is_pushed(&gaptr, offsets[i],
+                                             BENCH_GAPTR_DATALEN);
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  ngtcp2_gaptr_free(&gaptr);
+  free(offsets);
+
+  return t;
+}
+
+const bench_case bench_gaptr_cases[] = {
+  {"gaptr/push_in_order", bench_push_in_order},
+  {"gaptr/push_reordered", bench_push_reordered},
+  {"gaptr/push_sparse", bench_push_sparse},
+  {"gaptr/is_pushed", bench_is_pushed},
+  {0},
+};
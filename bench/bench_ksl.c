@@ -0,0 +1,260 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include "ngtcp2_ksl.h"
+
+/*
+ * The int64_greater benchmarks mimic ngtcp2_rtb: packet numbers are
+ * inserted in increasing order into ngtcp2_ksl sorted in decreasing
+ * order, and looked up and removed in random order.
+ */
+static int64_t *int64_keys_new(size_t n) {
+  int64_t *keys = malloc(sizeof(*keys) * n);
+  size_t i;
+
+  if (keys == NULL) {
+    abort();
+  }
+
+  for (i = 0; i < n; ++i) {
+    keys[i] = (int64_t)i;
+  }
+
+  return keys;
+}
+
+static void int64_ksl_init(ngtcp2_ksl *ksl, const int64_t *keys, size_t n) {
+  size_t i;
+
+  ngtcp2_ksl_init(ksl, ngtcp2_ksl_int64_greater,
+                  ngtcp2_ksl_int64_greater_search, sizeof(int64_t),
+                  ngtcp2_mem_default());
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_ksl_insert(ksl, NULL, &keys[i], NULL);
+  }
+}
+
+static uint64_t bench_int64_insert(size_t n) {
+  int64_t *keys = int64_keys_new(n);
+  ngtcp2_ksl ksl;
+  uint64_t t;
+  size_t i;
+
+  ngtcp2_ksl_init(&ksl, ngtcp2_ksl_int64_greater,
+                  ngtcp2_ksl_int64_greater_search, sizeof(int64_t),
+                  ngtcp2_mem_default());
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_ksl_insert(&ksl, NULL, &keys[i], NULL);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_ksl_free(&ksl);
+  free(keys);
+
+  return t;
+}
+
+static uint64_t bench_int64_lower_bound(size_t n) {
+  int64_t *keys = int64_keys_new(n);
+  ngtcp2_ksl ksl;
+  ngtcp2_ksl_it it;
+  uint64_t state = BENCH_SEED;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  int64_ksl_init(&ksl, keys, n);
+  bench_shuffle(keys, n, sizeof(*keys), &state);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    it = ngtcp2_ksl_lower_bound(&ksl, &keys[i]);
+    sink += (uint64_t)*(int64_t *)ngtcp2_ksl_it_key(&it);
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  ngtcp2_ksl_free(&ksl);
+  free(keys);
+
+  return t;
+}
+
+static uint64_t bench_int64_remove(size_t n) {
+  int64_t *keys = int64_keys_new(n);
+  ngtcp2_ksl ksl;
+  uint64_t state = BENCH_SEED;
+  uint64_t t;
+  size_t i;
+
+  int64_ksl_init(&ksl, keys, n);
+  bench_shuffle(keys, n, sizeof(*keys), &state);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_ksl_remove(&ksl, NULL, &keys[i]);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_ksl_free(&ksl);
+  free(keys);
+
+  return t;
+}
+
+/*
+ * The range_exclusive benchmarks mimic ngtcp2_gaptr and ngtcp2_rob:
+ * disjoint ranges are looked up with
+ * ngtcp2_ksl_range_exclusive_compar.
+ */
+static ngtcp2_range *range_keys_new(size_t n) {
+  ngtcp2_range *keys = malloc(sizeof(*keys) * n);
+  size_t i;
+
+  if (keys == NULL) {
+    abort();
+  }
+
+  for (i = 0; i < n; ++i) {
+    keys[i] = (ngtcp2_range){
+      .begin = i * 4,
+      .end = i * 4 + 2,
+    };
+  }
+
+  return keys;
+}
+
+static void range_ksl_init(ngtcp2_ksl *ksl, const ngtcp2_range *keys,
+                           size_t n) {
+  size_t i;
+
+  ngtcp2_ksl_init(ksl, ngtcp2_ksl_range_exclusive_compar,
+                  ngtcp2_ksl_range_exclusive_search, sizeof(ngtcp2_range),
+                  ngtcp2_mem_default());
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_ksl_insert(ksl, NULL, &keys[i], NULL);
+  }
+}
+
+static uint64_t bench_range_insert(size_t n) {
+  ngtcp2_range *keys = range_keys_new(n);
+  ngtcp2_ksl ksl;
+  uint64_t t;
+  size_t i;
+
+  ngtcp2_ksl_init(&ksl, ngtcp2_ksl_range_exclusive_compar,
+                  ngtcp2_ksl_range_exclusive_search, sizeof(ngtcp2_range),
+                  ngtcp2_mem_default());
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_ksl_insert(&ksl, NULL, &keys[i], NULL);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_ksl_free(&ksl);
+  free(keys);
+
+  return t;
+}
+
+static uint64_t bench_range_lower_bound(size_t n) {
+  ngtcp2_range *keys = range_keys_new(n);
+  ngtcp2_ksl ksl;
+  ngtcp2_ksl_it it;
+  uint64_t state = BENCH_SEED;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  range_ksl_init(&ksl, keys, n);
+  bench_shuffle(keys, n, sizeof(*keys), &state);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    it = ngtcp2_ksl_lower_bound_search(&ksl, &keys[i],
+                                       ngtcp2_ksl_range_exclusive_search);
+    sink += ((ngtcp2_range *)ngtcp2_ksl_it_key(&it))->begin;
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  ngtcp2_ksl_free(&ksl);
+  free(keys);
+
+  return t;
+}
+
+static uint64_t bench_range_remove(size_t n) {
+  ngtcp2_range *keys = range_keys_new(n);
+  ngtcp2_ksl ksl;
+  uint64_t state = BENCH_SEED;
+  uint64_t t;
+  size_t i;
+
+  range_ksl_init(&ksl, keys, n);
+  bench_shuffle(keys, n, sizeof(*keys), &state);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_ksl_remove(&ksl, NULL, &keys[i]);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_ksl_free(&ksl);
+  free(keys);
+
+  return t;
+}
+
+const bench_case bench_ksl_cases[] = {
+  {"ksl/int64_greater/insert", bench_int64_insert},
+  {"ksl/int64_greater/lower_bound", bench_int64_lower_bound},
+  {"ksl/int64_greater/remove", bench_int64_remove},
+  {"ksl/range_exclusive/insert", bench_range_insert},
+  {"ksl/range_exclusive/lower_bound", bench_range_lower_bound},
+  {"ksl/range_exclusive/remove", bench_range_remove},
+  {0},
+};
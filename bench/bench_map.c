@@ -0,0 +1,163 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include "ngtcp2_map.h"
+
+/*
+ * The map benchmarks mimic the stream table of ngtcp2_conn: the keys
+ * are client initiated bidirectional stream IDs which are inserted
+ * in increasing order, and looked up and removed in random order.
+ */
+static uint64_t *keys_new(size_t n) {
+  uint64_t *keys = malloc(sizeof(*keys) * n);
+  size_t i;
+
+  if (keys == NULL) {
+    abort();
+  }
+
+  for (i = 0; i < n; ++i) {
+    keys[i] = i * 4;
+  }
+
+  return keys;
+}
+
+static void map_init(ngtcp2_map *map, uint64_t *keys, size_t n) {
+  size_t i;
+
+  ngtcp2_map_init(map, BENCH_SEED, ngtcp2_mem_default());
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_map_insert(map, keys[i], &keys[i]);
+  }
+}
+
+static uint64_t bench_insert(size_t n) {
+  uint64_t *keys = keys_new(n);
+  ngtcp2_map map;
+  uint64_t t;
+  size_t i;
+
+  ngtcp2_map_init(&map, BENCH_SEED, ngtcp2_mem_default());
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_map_insert(&map, keys[i], &keys[i]);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_map_free(&map);
+  free(keys);
+
+  return t;
+}
+
+static uint64_t bench_find(size_t n) {
+  uint64_t *keys = keys_new(n);
+  ngtcp2_map map;
+  uint64_t state = BENCH_SEED;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  map_init(&map, keys, n);
+  bench_shuffle(keys, n, sizeof(*keys), &state);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    sink += *(uint64_t *)ngtcp2_map_find(&map, keys[i]);
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  ngtcp2_map_free(&map);
+  free(keys);
+
+  return t;
+}
+
+static uint64_t bench_find_miss(size_t n) {
+  uint64_t *keys = keys_new(n);
+  ngtcp2_map map;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  map_init(&map, keys, n);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    sink += ngtcp2_map_find(&map, keys[i] + 1) != NULL;
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  ngtcp2_map_free(&map);
+  free(keys);
+
+  return t;
+}
+
+static uint64_t bench_remove(size_t n) {
+  uint64_t *keys = keys_new(n);
+  ngtcp2_map map;
+  uint64_t state = BENCH_SEED;
+  uint64_t t;
+  size_t i;
+
+  map_init(&map, keys, n);
+  bench_shuffle(keys, n, sizeof(*keys), &state);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_map_remove(&map, keys[i]);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_map_free(&map);
+  free(keys);
+
+  return t;
+}
+
+const bench_case bench_map_cases[] = {
+  {"map/insert", bench_insert},
+  {"map/find", bench_find},
+  {"map/find_miss", bench_find_miss},
+  {"map/remove", bench_remove},
+  {0},
+};
@@ -0,0 +1,177 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench.h"
+
+#include "ngtcp2_pkt.h"
+
+/*
+ * The pkt benchmarks encode and decode STREAM and ACK frames n times.
+ * STREAM frame carries 1200 bytes with 2 bytes stream ID and 4 bytes
+ * offset, and ACK frame has 8 ranges.
+ */
+#define BENCH_PKT_ACK_RANGES 8
+
+static uint8_t stream_data[1200];
+
+static void stream_frame_init(ngtcp2_stream *fr, ngtcp2_vec *data) {
+  *data = (ngtcp2_vec){
+    .base = stream_data,
+    .len = sizeof(stream_data),
+  };
+  *fr = (ngtcp2_stream){
+    .type = NGTCP2_FRAME_STREAM,
+    .stream_id = 4000,
+    .offset = 1000000,
+    .datacnt = 1,
+    .data = data,
+  };
+}
+
+static void ack_frame_init(ngtcp2_ack *fr, ngtcp2_ack_range *ranges) {
+  size_t i;
+
+  for (i = 0; i < BENCH_PKT_ACK_RANGES; ++i) {
+    ranges[i] = (ngtcp2_ack_range){
+      .gap = 1,
+      .len = 30,
+    };
+  }
+
+  *fr = (ngtcp2_ack){
+    .type = NGTCP2_FRAME_ACK,
+    .largest_ack = 1000000,
+    .ack_delay = 25000,
+    .first_ack_range = 100,
+    .rangecnt = BENCH_PKT_ACK_RANGES,
+    .ranges = ranges,
+  };
+}
+
+static uint64_t bench_encode_stream_frame(size_t n) {
+  uint8_t buf[1500];
+  ngtcp2_vec data;
+  ngtcp2_stream fr;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  stream_frame_init(&fr, &data);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    sink += (uint64_t)ngtcp2_pkt_encode_stream_frame(buf, sizeof(buf), &fr);
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  return t;
+}
+
+static uint64_t bench_decode_stream_frame(size_t n) {
+  uint8_t buf[1500];
+  ngtcp2_vec data, ndata;
+  ngtcp2_stream fr, nfr;
+  ngtcp2_ssize buflen;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  stream_frame_init(&fr, &data);
+  buflen = ngtcp2_pkt_encode_stream_frame(buf, sizeof(buf), &fr);
+
+  nfr.data = &ndata;
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_pkt_decode_stream_frame(&nfr, buf, (size_t)buflen);
+    sink += nfr.offset;
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  return t;
+}
+
+static uint64_t bench_encode_ack_frame(size_t n) {
+  uint8_t buf[1500];
+  ngtcp2_ack_range ranges[BENCH_PKT_ACK_RANGES];
+  ngtcp2_ack fr;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  ack_frame_init(&fr, ranges);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    sink += (uint64_t)ngtcp2_pkt_encode_ack_frame(buf, sizeof(buf), &fr);
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  return t;
+}
+
+static uint64_t bench_decode_ack_frame(size_t n) {
+  uint8_t buf[1500];
+  ngtcp2_ack_range ranges[BENCH_PKT_ACK_RANGES];
+  ngtcp2_ack_range nranges[NGTCP2_MAX_ACK_RANGES];
+  ngtcp2_ack fr, nfr;
+  ngtcp2_ssize buflen;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  ack_frame_init(&fr, ranges);
+  buflen = ngtcp2_pkt_encode_ack_frame(buf, sizeof(buf), &fr);
+
+  nfr.ranges = nranges;
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_pkt_decode_ack_frame(&nfr, buf, (size_t)buflen);
+    sink += nfr.first_ack_range + nfr.rangecnt;
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  return t;
+}
+
+const bench_case bench_pkt_cases[] = {
+  {"pkt/encode_stream_frame", bench_encode_stream_frame},
+  {"pkt/decode_stream_frame", bench_decode_stream_frame},
+  {"pkt/encode_ack_frame", bench_encode_ack_frame},
+  {"pkt/decode_ack_frame", bench_decode_ack_frame},
+  {0},
+};
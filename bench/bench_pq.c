@@ -0,0 +1,162 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include "ngtcp2_pq.h"
+#include "ngtcp2_macro.h"
+
+/*
+ * The pq benchmarks mimic the stream scheduler of ngtcp2_conn: the
+ * entries are ordered by a random 64 bits key, like the cycle of
+ * ngtcp2_strm.
+ */
+typedef struct entry {
+  ngtcp2_pq_entry pe;
+  uint64_t key;
+} entry;
+
+static int entry_less(const ngtcp2_pq_entry *lhs, const ngtcp2_pq_entry *rhs) {
+  const entry *a = ngtcp2_struct_of(lhs, entry, pe);
+  const entry *b = ngtcp2_struct_of(rhs, entry, pe);
+
+  return a->key < b->key;
+}
+
+static entry *entries_new(size_t n) {
+  entry *ents = malloc(sizeof(*ents) * n);
+  uint64_t state = BENCH_SEED;
+  size_t i;
+
+  if (ents == NULL) {
+    abort();
+  }
+
+  for (i = 0; i < n; ++i) {
+    ents[i] = (entry){
+      .pe.index = NGTCP2_PQ_BAD_INDEX,
+      .key = bench_rand(&state),
+    };
+  }
+
+  return ents;
+}
+
+static void pq_init(ngtcp2_pq *pq, entry *ents, size_t n) {
+  size_t i;
+
+  ngtcp2_pq_init(pq, entry_less, ngtcp2_mem_default());
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_pq_push(pq, &ents[i].pe);
+  }
+}
+
+static uint64_t bench_push(size_t n) {
+  entry *ents = entries_new(n);
+  ngtcp2_pq pq;
+  uint64_t t;
+  size_t i;
+
+  ngtcp2_pq_init(&pq, entry_less, ngtcp2_mem_default());
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_pq_push(&pq, &ents[i].pe);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_pq_free(&pq);
+  free(ents);
+
+  return t;
+}
+
+static uint64_t bench_pop(size_t n) {
+  entry *ents = entries_new(n);
+  ngtcp2_pq pq;
+  uint64_t t, sink = 0;
+  size_t i;
+
+  pq_init(&pq, ents, n);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    sink += ngtcp2_struct_of(ngtcp2_pq_top(&pq), entry, pe)->key;
+    ngtcp2_pq_pop(&pq);
+  }
+
+  t = bench_now() - t;
+
+  bench_sink = sink;
+
+  ngtcp2_pq_free(&pq);
+  free(ents);
+
+  return t;
+}
+
+/*
+ * bench_reschedule pops the top entry, and pushes it back with the
+ * larger key, which is what the stream scheduler does after writing
+ * a stream.
+ */
+static uint64_t bench_reschedule(size_t n) {
+  entry *ents = entries_new(n);
+  entry *ent;
+  ngtcp2_pq pq;
+  uint64_t state = BENCH_SEED;
+  uint64_t t;
+  size_t i;
+
+  pq_init(&pq, ents, n);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    ent = ngtcp2_struct_of(ngtcp2_pq_top(&pq), entry, pe);
+    ngtcp2_pq_pop(&pq);
+    ent->key += bench_rand(&state) >> 32;
+    ngtcp2_pq_push(&pq, &ent->pe);
+  }
+
+  t = bench_now() - t;
+
+  ngtcp2_pq_free(&pq);
+  free(ents);
+
+  return t;
+}
+
+const bench_case bench_pq_cases[] = {
+  {"pq/push", bench_push},
+  {"pq/pop", bench_pop},
+  {"pq/reschedule", bench_reschedule},
+  {0},
+};
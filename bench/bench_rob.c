@@ -0,0 +1,93 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench.h"
+
+#include "ngtcp2_rob.h"
+#include "ngtcp2_macro.h"
+
+/*
+ * The rob benchmarks mimic the reception of a stream: n STREAM
+ * frames of BENCH_ROB_DATALEN bytes each are pushed in the windows of
+ * BENCH_ROB_WINDOW frames, and the in-order data is consumed after
+ * each window.  The frames in a window are shuffled to simulate
+ * reordering.
+ */
+#define BENCH_ROB_DATALEN 1200
+#define BENCH_ROB_WINDOW 16
+
+static uint64_t bench_push(size_t n, int reorder) {
+  static uint8_t data[BENCH_ROB_DATALEN];
+  uint64_t offsets[BENCH_ROB_WINDOW];
+  ngtcp2_rob rob;
+  uint64_t state = BENCH_SEED;
+  uint64_t rx_offset = 0, offset = 0;
+  uint64_t t, elapsed = 0, len;
+  const uint8_t *p;
+  size_t i, j, nwin;
+
+  ngtcp2_rob_init(&rob, 8 * 1024, ngtcp2_mem_default());
+
+  for (i = 0; i < n; i += nwin) {
+    nwin = ngtcp2_min(n - i, (size_t)BENCH_ROB_WINDOW);
+
+    for (j = 0; j < nwin; ++j) {
+      offsets[j] = offset;
+      offset += BENCH_ROB_DATALEN;
+    }
+
+    if (reorder) {
+      bench_shuffle(offsets, nwin, sizeof(offsets[0]), &state);
+    }
+
+    t = bench_now();
+
+    for (j = 0; j < nwin; ++j) {
+      ngtcp2_rob_push(&rob, offsets[j], data, sizeof(data));
+    }
+
+    for (; (len = ngtcp2_rob_data_at(&rob, &p, rx_offset)) > 0;
+         rx_offset += len) {
+      ngtcp2_rob_pop(&rob, rx_offset, len);
+    }
+
+    elapsed += bench_now() - t;
+  }
+
+  bench_sink = rx_offset;
+
+  ngtcp2_rob_free(&rob);
+
+  return elapsed;
+}
+
+static uint64_t bench_push_in_order(size_t n) { return bench_push(n, 0); }
+
+static uint64_t bench_push_reordered(size_t n) { return bench_push(n, 1); }
+
+const bench_case bench_rob_cases[] = {
+  {"rob/push_in_order", bench_push_in_order},
+  {"rob/push_reordered", bench_push_reordered},
+  {0},
+};
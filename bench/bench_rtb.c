@@ -0,0 +1,191 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench.h"
+
+#include "ngtcp2_rtb.h"
+#include "ngtcp2_conn.h"
+
+/*
+ * rtb_fixture holds the objects that ngtcp2_rtb depends on.
+ */
+typedef struct rtb_fixture {
+  ngtcp2_rtb rtb;
+  ngtcp2_log log;
+  ngtcp2_conn_stat cstat;
+  ngtcp2_cc_reno cc;
+  ngtcp2_rst rst;
+  ngtcp2_objalloc frc_objalloc;
+  ngtcp2_objalloc rtb_entry_objalloc;
+  ngtcp2_pktns pktns;
+} rtb_fixture;
+
+static void rtb_fixture_init(rtb_fixture *fx) {
+  const ngtcp2_mem *mem = ngtcp2_mem_default();
+
+  ngtcp2_objalloc_init(&fx->frc_objalloc, 1024, mem);
+  ngtcp2_objalloc_init(&fx->rtb_entry_objalloc, 1024, mem);
+
+  ngtcp2_log_init(&fx->log, NULL, NULL, NULL, NULL, 0, NULL);
+
+  fx->cstat = (ngtcp2_conn_stat){
+    .cwnd = 10 * NGTCP2_MAX_UDP_PAYLOAD_SIZE,
+    .max_tx_udp_payload_size = NGTCP2_MAX_UDP_PAYLOAD_SIZE,
+  };
+  fx->pktns = (ngtcp2_pktns){
+    .id = NGTCP2_PKTNS_ID_HANDSHAKE,
+  };
+
+  ngtcp2_rst_init(&fx->rst);
+  ngtcp2_cc_reno_init(&fx->cc, &fx->log, &fx->cstat);
+  ngtcp2_rtb_init(&fx->rtb, &fx->rst, &fx->cc.cc, 0, &fx->log, NULL,
+                  &fx->rtb_entry_objalloc, &fx->frc_objalloc, mem);
+}
+
+static void rtb_fixture_free(rtb_fixture *fx) {
+  ngtcp2_rtb_free(&fx->rtb);
+  ngtcp2_objalloc_free(&fx->rtb_entry_objalloc);
+  ngtcp2_objalloc_free(&fx->frc_objalloc);
+}
+
+static void rtb_add_pkt(rtb_fixture *fx, int64_t pkt_num) {
+  ngtcp2_pkt_hd hd;
+  ngtcp2_rtb_entry *ent;
+
+  ngtcp2_pkt_hd_init(&hd, NGTCP2_PKT_FLAG_NONE, NGTCP2_PKT_1RTT, NULL, NULL,
+                     pkt_num, 1, NGTCP2_PROTO_VER_V1);
+  ngtcp2_rtb_entry_objalloc_new(&ent, &hd, NULL, (ngtcp2_tstamp)pkt_num, 0,
+                                NGTCP2_RTB_ENTRY_FLAG_NONE,
+                                &fx->rtb_entry_objalloc);
+  ngtcp2_rtb_add(&fx->rtb, ent, &fx->cstat);
+}
+
+static uint64_t bench_add(size_t n) {
+  rtb_fixture fx;
+  uint64_t t;
+  size_t i;
+
+  rtb_fixture_init(&fx);
+
+  t = bench_now();
+
+  for (i = 0; i < n; ++i) {
+    rtb_add_pkt(&fx, (int64_t)i);
+  }
+
+  t = bench_now() - t;
+
+  rtb_fixture_free(&fx);
+
+  return t;
+}
+
+/*
+ * bench_recv_ack_contiguous sends n packets, and acknowledges them
+ * with ACK frames each of which acknowledges 16 contiguous packets.
+ * The result is the time per acknowledged packet.
+ */
+static uint64_t bench_recv_ack_contiguous(size_t n) {
+  rtb_fixture fx;
+  ngtcp2_ack fr;
+  uint64_t t;
+  size_t i, len;
+
+  rtb_fixture_init(&fx);
+
+  for (i = 0; i < n; ++i) {
+    rtb_add_pkt(&fx, (int64_t)i);
+  }
+
+  t = bench_now();
+
+  for (i = 0; i < n; i += len) {
+    len = ngtcp2_min(n - i, (size_t)16);
+    fr = (ngtcp2_ack){
+      .largest_ack = (int64_t)(i + len - 1),
+      .first_ack_range = len - 1,
+    };
+
+    ngtcp2_rtb_recv_ack(&fx.rtb, &fr, &fx.cstat, NULL, &fx.pktns,
+                        (ngtcp2_tstamp)n, (ngtcp2_tstamp)n);
+  }
+
+  t = bench_now() - t;
+
+  rtb_fixture_free(&fx);
+
+  return t;
+}
+
+/*
+ * bench_recv_ack_ranges is like bench_recv_ack_contiguous, but every
+ * 4th packet is not acknowledged, and each ACK frame has 16 ranges.
+ */
+static uint64_t bench_recv_ack_ranges(size_t n) {
+  rtb_fixture fx;
+  ngtcp2_ack_range ranges[15];
+  ngtcp2_ack fr;
+  uint64_t t;
+  size_t i, j;
+
+  rtb_fixture_init(&fx);
+
+  for (i = 0; i < n; ++i) {
+    rtb_add_pkt(&fx, (int64_t)i);
+  }
+
+  for (j = 0; j < ngtcp2_arraylen(ranges); ++j) {
+    ranges[j] = (ngtcp2_ack_range){
+      .gap = 0,
+      .len = 2,
+    };
+  }
+
+  t = bench_now();
+
+  for (i = 0; i + 64 <= n; i += 64) {
+    fr = (ngtcp2_ack){
+      .largest_ack = (int64_t)(i + 63),
+      .first_ack_range = 2,
+      .rangecnt = ngtcp2_arraylen(ranges),
+      .ranges = ranges,
+    };
+
+    ngtcp2_rtb_recv_ack(&fx.rtb, &fr, &fx.cstat, NULL, &fx.pktns,
+                        (ngtcp2_tstamp)n, (ngtcp2_tstamp)n);
+  }
+
+  t = bench_now() - t;
+
+  rtb_fixture_free(&fx);
+
+  return t;
+}
+
+const bench_case bench_rtb_cases[] = {
+  {"rtb/add", bench_add},
+  {"rtb/recv_ack_contiguous", bench_recv_ack_contiguous},
+  {"rtb/recv_ack_ranges", bench_recv_ack_ranges},
+  {0},
+};
@@ -0,0 +1,201 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * bench runs microbenchmarks of the core data structures and codecs
+ * of the library, and writes the results to stdout in JSON.
+ *
+ * Build it with "make -C bench bench" (or "cmake --build <dir>
+ * --target bench").  Run "bench -h" for the options.
+ */
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* defined(HAVE_CONFIG_H) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ngtcp2/ngtcp2.h>
+
+#include "bench.h"
+#include "ngtcp2_macro.h"
+
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_REPEAT 101
+
+static const bench_case *const bench_suites[] = {
+  bench_ksl_cases,
+  bench_map_cases,
+  bench_pq_cases,
+  bench_rob_cases,
+  bench_gaptr_cases,
+  bench_acktr_cases,
+  bench_rtb_cases,
+  bench_conv_cases,
+  bench_pkt_cases,
+};
+
+static int compare_uint64(const void *lhs, const void *rhs) {
+  uint64_t a = *(const uint64_t *)lhs, b = *(const uint64_t *)rhs;
+
+  return a < b ? -1 : a > b;
+}
+
+static int match(const char *name, char **filters, size_t nfilters) {
+  size_t i;
+
+  if (nfilters == 0) {
+    return 1;
+  }
+
+  for (i = 0; i < nfilters; ++i) {
+    if (strstr(name, filters[i])) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static void print_usage(FILE *out) {
+  fprintf(out,
+          "Usage: bench [-l] [-r REPEAT] [-n SIZE]... [FILTER]...\n"
+          "\n"
+          "Run the benchmarks whose name contains any of FILTERs (all\n"
+          "benchmarks if no FILTER is given), and write the results in\n"
+          "JSON to stdout.\n"
+          "\n"
+          "  -l         List the benchmarks and exit.\n"
+          "  -r REPEAT  Run each benchmark REPEAT times after a warm-up\n"
+          "             run, and report the median, the minimum, and the\n"
+          "             maximum.  Default: 5\n"
+          "  -n SIZE    Run each benchmark with SIZE operations.  This\n"
+          "             option can be given multiple times.\n"
+          "             Default: 1000, 10000, 100000\n");
+}
+
+int main(int argc, char **argv) {
+  size_t sizes[BENCH_MAX_SIZES] = {1000, 10000, 100000};
+  size_t nsizes = 0;
+  size_t repeat = 5;
+  uint64_t samples[BENCH_MAX_REPEAT];
+  const bench_case *bc;
+  int list = 0;
+  int first = 1;
+  size_t i, j, k;
+  int c;
+
+  while ((c = getopt(argc, argv, "hln:r:")) != -1) {
+    switch (c) {
+    case 'h':
+      print_usage(stdout);
+      return EXIT_SUCCESS;
+    case 'l':
+      list = 1;
+      break;
+    case 'n':
+      if (nsizes == BENCH_MAX_SIZES) {
+        fprintf(stderr, "bench: too many -n options\n");
+        return EXIT_FAILURE;
+      }
+
+      sizes[nsizes] = (size_t)strtoull(optarg, NULL, 10);
+      if (sizes[nsizes] == 0) {
+        fprintf(stderr, "bench: -n: invalid argument: %s\n", optarg);
+        return EXIT_FAILURE;
+      }
+
+      ++nsizes;
+
+      break;
+    case 'r':
+      repeat = (size_t)strtoull(optarg, NULL, 10);
+      if (repeat == 0 || repeat > BENCH_MAX_REPEAT) {
+        fprintf(stderr, "bench: -r: must be in [1, %d]: %s\n",
+                BENCH_MAX_REPEAT, optarg);
+        return EXIT_FAILURE;
+      }
+
+      break;
+    default:
+      print_usage(stderr);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (nsizes == 0) {
+    nsizes = 3;
+  }
+
+  if (list) {
+    for (i = 0; i < ngtcp2_arraylen(bench_suites); ++i) {
+      for (bc = bench_suites[i]; bc->name; ++bc) {
+        printf("%s\n", bc->name);
+      }
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  printf("{\n"
+         "  \"version\": \"%s\",\n"
+         "  \"repeat\": %zu,\n"
+         "  \"results\": [",
+         ngtcp2_version(0)->version_str, repeat);
+
+  for (i = 0; i < ngtcp2_arraylen(bench_suites); ++i) {
+    for (bc = bench_suites[i]; bc->name; ++bc) {
+      if (!match(bc->name, argv + optind, (size_t)(argc - optind))) {
+        continue;
+      }
+
+      for (j = 0; j < nsizes; ++j) {
+        /* warm-up */
+        bc->func(sizes[j]);
+
+        for (k = 0; k < repeat; ++k) {
+          samples[k] = bc->func(sizes[j]);
+        }
+
+        qsort(samples, repeat, sizeof(samples[0]), compare_uint64);
+
+        printf("%s\n    {\"name\": \"%s\", \"n\": %zu, \"ns_per_op\": %.2f, "
+               "\"min_ns_per_op\": %.2f, \"max_ns_per_op\": %.2f}",
+               first ? "" : ",", bc->name, sizes[j],
+               (double)samples[repeat / 2] / (double)sizes[j],
+               (double)samples[0] / (double)sizes[j],
+               (double)samples[repeat - 1] / (double)sizes[j]);
+        fflush(stdout);
+
+        first = 0;
+      }
+    }
+  }
+
+  printf("\n  ]\n}\n");
+
+  return EXIT_SUCCESS;
+}
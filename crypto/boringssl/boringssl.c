@@ -38,6 +38,7 @@
 #include <openssl/aes.h>
 #include <openssl/chacha.h>
 #include <openssl/rand.h>
+#include <openssl/mem.h>
 
 #include "ngtcp2_macro.h"
 #include "shared.h"
@@ -93,6 +94,12 @@ ngtcp2_crypto_aead *ngtcp2_crypto_aead_retry(ngtcp2_crypto_aead *aead) {
   return ngtcp2_crypto_aead_init(aead, (void *)EVP_aead_aes_128_gcm());
 }
 
+ngtcp2_crypto_cipher *
+ngtcp2_crypto_cipher_chacha20(ngtcp2_crypto_cipher *cipher) {
+  cipher->native_handle = (void *)&crypto_cipher_chacha20;
+  return cipher;
+}
+
 static const EVP_AEAD *crypto_cipher_id_get_aead(uint32_t cipher_id) {
   switch (cipher_id) {
   case TLS1_CK_AES_128_GCM_SHA256:
@@ -238,6 +245,22 @@ int ngtcp2_crypto_aead_ctx_encrypt_init(ngtcp2_crypto_aead_ctx *aead_ctx,
 
   (void)noncelen;
 
+  /* A context in the pool has been cleaned up, and it can be
+     initialized for any AEAD.  All contexts share the same bucket. */
+  actx =
+    ngtcp2_crypto_ctx_pool_get(0, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT, 0);
+  if (actx) {
+    if (!EVP_AEAD_CTX_init(actx, cipher, key, keylen,
+                           EVP_AEAD_DEFAULT_TAG_LENGTH, NULL)) {
+      OPENSSL_free(actx);
+      return -1;
+    }
+
+    aead_ctx->native_handle = actx;
+
+    return 0;
+  }
+
   actx = EVP_AEAD_CTX_new(cipher, key, keylen, EVP_AEAD_DEFAULT_TAG_LENGTH);
   if (actx == NULL) {
     return -1;
@@ -254,9 +277,24 @@ int ngtcp2_crypto_aead_ctx_decrypt_init(ngtcp2_crypto_aead_ctx *aead_ctx,
   return ngtcp2_crypto_aead_ctx_encrypt_init(aead_ctx, aead, key, noncelen);
 }
 
+static void crypto_aead_ctx_free(void *native_handle) {
+  OPENSSL_free(native_handle);
+}
+
 void ngtcp2_crypto_aead_ctx_free(ngtcp2_crypto_aead_ctx *aead_ctx) {
-  if (aead_ctx->native_handle) {
-    EVP_AEAD_CTX_free(aead_ctx->native_handle);
+  EVP_AEAD_CTX *actx = aead_ctx->native_handle;
+
+  if (actx == NULL) {
+    return;
+  }
+
+  /* Release the key so that a cached context does not keep it. */
+  EVP_AEAD_CTX_cleanup(actx);
+  EVP_AEAD_CTX_zero(actx);
+
+  if (ngtcp2_crypto_ctx_pool_put(0, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT, 0,
+                                 actx, crypto_aead_ctx_free) != 0) {
+    OPENSSL_free(actx);
   }
 }
 
@@ -280,9 +318,13 @@ int ngtcp2_crypto_cipher_ctx_encrypt_init(ngtcp2_crypto_cipher_ctx *cipher_ctx,
   ngtcp2_crypto_boringssl_cipher_ctx *ctx;
   int rv = 0;
 
-  ctx = malloc(sizeof(*ctx));
+  ctx = ngtcp2_crypto_ctx_pool_get(
+    0, NGTCP2_CRYPTO_CTX_POOL_KIND_CIPHER_ENCRYPT, 0);
   if (ctx == NULL) {
-    return -1;
+    ctx = malloc(sizeof(*ctx));
+    if (ctx == NULL) {
+      return -1;
+    }
   }
 
   switch (hp_cipher->type) {
@@ -319,11 +361,18 @@ int ngtcp2_crypto_cipher_ctx_encrypt_init(ngtcp2_crypto_cipher_ctx *cipher_ctx,
 }
 
 void ngtcp2_crypto_cipher_ctx_free(ngtcp2_crypto_cipher_ctx *cipher_ctx) {
-  if (!cipher_ctx->native_handle) {
+  ngtcp2_crypto_boringssl_cipher_ctx *ctx = cipher_ctx->native_handle;
+
+  if (!ctx) {
     return;
   }
 
-  free(cipher_ctx->native_handle);
+  OPENSSL_cleanse(ctx, sizeof(*ctx));
+
+  if (ngtcp2_crypto_ctx_pool_put(0, NGTCP2_CRYPTO_CTX_POOL_KIND_CIPHER_ENCRYPT,
+                                 0, ctx, free) != 0) {
+    free(ctx);
+  }
 }
 
 int ngtcp2_crypto_hkdf_extract(uint8_t *dest, const ngtcp2_crypto_md *md,
@@ -385,6 +434,17 @@ int ngtcp2_crypto_encrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
   return 0;
 }
 
+int ngtcp2_crypto_encryptv(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                           const ngtcp2_crypto_aead_ctx *aead_ctx,
+                           const ngtcp2_vec *plaintextv, size_t plaintextcnt,
+                           const uint8_t *nonce, size_t noncelen,
+                           const uint8_t *aad, size_t aadlen) {
+  /* EVP_AEAD_CTX_seal only takes a contiguous plaintext. */
+  return ngtcp2_crypto_encryptv_gather(dest, aead, aead_ctx, plaintextv,
+                                       plaintextcnt, nonce, noncelen, aad,
+                                       aadlen);
+}
+
 int ngtcp2_crypto_decrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
                           const ngtcp2_crypto_aead_ctx *aead_ctx,
                           const uint8_t *ciphertext, size_t ciphertextlen,
@@ -440,6 +500,35 @@ int ngtcp2_crypto_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
   }
 }
 
+int ngtcp2_crypto_hp_mask_batch(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                                const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                                const uint8_t *const *samples,
+                                size_t nsamples) {
+  ngtcp2_crypto_boringssl_cipher_ctx *ctx = hp_ctx->native_handle;
+  size_t i;
+
+  switch (ctx->type) {
+  case NGTCP2_CRYPTO_BORINGSSL_CIPHER_TYPE_AES_128:
+  case NGTCP2_CRYPTO_BORINGSSL_CIPHER_TYPE_AES_256:
+    /* The expanded key is already at hand, so just run the block
+       function for each sample without any further dispatch. */
+    for (i = 0; i < nsamples; ++i) {
+      AES_encrypt(samples[i], dest + i * NGTCP2_HP_SAMPLELEN, &ctx->aes_key);
+    }
+
+    return 0;
+  default:
+    for (i = 0; i < nsamples; ++i) {
+      if (ngtcp2_crypto_hp_mask(dest + i * NGTCP2_HP_SAMPLELEN, hp, hp_ctx,
+                                samples[i]) != 0) {
+        return -1;
+      }
+    }
+
+    return 0;
+  }
+}
+
 int ngtcp2_crypto_read_write_crypto_data(
   ngtcp2_conn *conn, ngtcp2_encryption_level encryption_level,
   const uint8_t *data, size_t datalen) {
@@ -68,6 +68,12 @@ ngtcp2_crypto_aead *ngtcp2_crypto_aead_retry(ngtcp2_crypto_aead *aead) {
   return ngtcp2_crypto_aead_init(aead, (void *)GNUTLS_CIPHER_AES_128_GCM);
 }
 
+ngtcp2_crypto_cipher *
+ngtcp2_crypto_cipher_chacha20(ngtcp2_crypto_cipher *cipher) {
+  cipher->native_handle = (void *)GNUTLS_CIPHER_CHACHA20_32;
+  return cipher;
+}
+
 static gnutls_cipher_algorithm_t
 crypto_get_hp(gnutls_cipher_algorithm_t cipher) {
   switch (cipher) {
@@ -399,6 +405,44 @@ int ngtcp2_crypto_encrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
   return 0;
 }
 
+int ngtcp2_crypto_encryptv(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                           const ngtcp2_crypto_aead_ctx *aead_ctx,
+                           const ngtcp2_vec *plaintextv, size_t plaintextcnt,
+                           const uint8_t *nonce, size_t noncelen,
+                           const uint8_t *aad, size_t aadlen) {
+  gnutls_cipher_algorithm_t cipher =
+    (gnutls_cipher_algorithm_t)(intptr_t)aead->native_handle;
+  gnutls_aead_cipher_hd_t hd = aead_ctx->native_handle;
+  size_t taglen = gnutls_cipher_get_tag_size(cipher);
+  size_t ciphertextlen = taglen;
+  giovec_t auth_iov = {
+    .iov_base = (void *)aad,
+    .iov_len = aadlen,
+  };
+  giovec_t iov[64];
+  size_t i;
+
+  if (plaintextcnt > ngtcp2_arraylen(iov)) {
+    return ngtcp2_crypto_encryptv_gather(dest, aead, aead_ctx, plaintextv,
+                                         plaintextcnt, nonce, noncelen, aad,
+                                         aadlen);
+  }
+
+  for (i = 0; i < plaintextcnt; ++i) {
+    iov[i].iov_base = plaintextv[i].base;
+    iov[i].iov_len = plaintextv[i].len;
+    ciphertextlen += plaintextv[i].len;
+  }
+
+  if (gnutls_aead_cipher_encryptv(hd, nonce, noncelen, &auth_iov, 1, taglen,
+                                  iov, (int)plaintextcnt, dest,
+                                  &ciphertextlen) != 0) {
+    return -1;
+  }
+
+  return 0;
+}
+
 int ngtcp2_crypto_decrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
                           const ngtcp2_crypto_aead_ctx *aead_ctx,
                           const uint8_t *ciphertext, size_t ciphertextlen,
@@ -445,7 +489,9 @@ int ngtcp2_crypto_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
       return -1;
     }
 
-    memcpy(dest, buf, 5);
+    /* |dest| has NGTCP2_HP_SAMPLELEN bytes available.  Copy whole
+       block so that it can be used as AES-ECB. */
+    memcpy(dest, buf, sizeof(buf));
   } break;
 
   case GNUTLS_CIPHER_CHACHA20_32: {
@@ -469,6 +515,24 @@ int ngtcp2_crypto_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
   return 0;
 }
 
+int ngtcp2_crypto_hp_mask_batch(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                                const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                                const uint8_t *const *samples,
+                                size_t nsamples) {
+  size_t i;
+
+  /* AES-ECB is emulated with CBC, and each block needs its IV reset.
+     No multi-block operation is available here. */
+  for (i = 0; i < nsamples; ++i) {
+    if (ngtcp2_crypto_hp_mask(dest + i * NGTCP2_HP_SAMPLELEN, hp, hp_ctx,
+                              samples[i]) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
 ngtcp2_encryption_level
 ngtcp2_crypto_gnutls_from_gnutls_record_encryption_level(
   gnutls_record_encryption_level_t gtls_level) {
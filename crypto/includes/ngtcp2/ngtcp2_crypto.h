@@ -238,6 +238,47 @@ ngtcp2_crypto_encrypt_cb(uint8_t *dest, const ngtcp2_crypto_aead *aead,
                          const uint8_t *nonce, size_t noncelen,
                          const uint8_t *aad, size_t aadlen);
 
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_encryptv` encrypts the concatenation of
+ * |plaintextcnt| buffers pointed by |plaintextv|, and writes the
+ * ciphertext into the buffer pointed by |dest|.  The length of
+ * ciphertext is the sum of the length of buffers +
+ * :member:`aead->max_overhead <ngtcp2_crypto_aead.max_overhead>`
+ * bytes long.  |dest| must have enough capacity to store the
+ * ciphertext.  Each element of |plaintextv| either points to the
+ * exact position in |dest| where its ciphertext is written, or does
+ * not overlap |dest| at all.
+ *
+ * This function returns 0 if it succeeds, or -1.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_crypto_encryptv(
+  uint8_t *dest, const ngtcp2_crypto_aead *aead,
+  const ngtcp2_crypto_aead_ctx *aead_ctx, const ngtcp2_vec *plaintextv,
+  size_t plaintextcnt, const uint8_t *nonce, size_t noncelen,
+  const uint8_t *aad, size_t aadlen);
+
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_encryptv_cb` is a wrapper function around
+ * `ngtcp2_crypto_encryptv`.  It can be directly passed to
+ * :member:`ngtcp2_callbacks.encryptv` field.
+ *
+ * This function returns 0 if it succeeds, or
+ * :macro:`NGTCP2_ERR_CALLBACK_FAILURE`.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_crypto_encryptv_cb(
+  uint8_t *dest, const ngtcp2_crypto_aead *aead,
+  const ngtcp2_crypto_aead_ctx *aead_ctx, const ngtcp2_vec *plaintextv,
+  size_t plaintextcnt, const uint8_t *nonce, size_t noncelen,
+  const uint8_t *aad, size_t aadlen);
+
 /**
  * @function
  *
@@ -309,6 +350,49 @@ ngtcp2_crypto_hp_mask_cb(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
                          const ngtcp2_crypto_cipher_ctx *hp_ctx,
                          const uint8_t *sample);
 
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_hp_mask_batch` generates |nsamples| masks which are
+ * used in packet header encryption in one call.  |samples| points to
+ * the array of |nsamples| samples, each of which is
+ * :macro:`NGTCP2_HP_SAMPLELEN` bytes long.  The mask for
+ * *samples[i]* is written to the buffer pointed by |dest| + i *
+ * :macro:`NGTCP2_HP_SAMPLELEN`.  The buffer pointed by |dest| must
+ * have at least |nsamples| * :macro:`NGTCP2_HP_SAMPLELEN` bytes
+ * available, and must not overlap any of the samples.
+ *
+ * If |hp| is AES based, this function encrypts all samples with a
+ * single cipher operation where the backend allows it.  Otherwise, it
+ * falls back to calling `ngtcp2_crypto_hp_mask` for each sample.
+ *
+ * This function returns 0 if it succeeds, or -1.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int
+ngtcp2_crypto_hp_mask_batch(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                            const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                            const uint8_t *const *samples, size_t nsamples);
+
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_hp_mask_batch_cb` is a wrapper function around
+ * `ngtcp2_crypto_hp_mask_batch`.  It can be directly passed to
+ * :member:`ngtcp2_callbacks.hp_mask_batch` field.
+ *
+ * This function returns 0 if it succeeds, or
+ * :macro:`NGTCP2_ERR_CALLBACK_FAILURE`.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int
+ngtcp2_crypto_hp_mask_batch_cb(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                               const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                               const uint8_t *const *samples,
+                               size_t nsamples);
+
 /**
  * @function
  *
@@ -581,6 +665,232 @@ NGTCP2_EXTERN int ngtcp2_crypto_generate_stateless_reset_token(
   uint8_t *token, const uint8_t *secret, size_t secretlen,
   const ngtcp2_cid *cid);
 
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_CRYPTO_QUIC_LB_KEYLEN` is the length of the key
+ * which encrypts QUIC-LB routable Connection IDs.
+ *
+ * .. version-added:: 1.26.0
+ */
+#define NGTCP2_CRYPTO_QUIC_LB_KEYLEN 16
+
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_CRYPTO_QUIC_LB_MAX_CONFIG_ID` is the maximum value
+ * of QUIC-LB config rotation ID.  The value 0x7 is reserved for
+ * unroutable Connection IDs.
+ *
+ * .. version-added:: 1.26.0
+ */
+#define NGTCP2_CRYPTO_QUIC_LB_MAX_CONFIG_ID 0x6
+
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_crypto_quic_lb_config` is a QUIC-LB configuration
+ * (see draft-ietf-quic-load-balancers) which encodes the identity of
+ * a server, or a worker thread, in Connection IDs so that a load
+ * balancer, or a server which dispatches packets to worker threads,
+ * can route packets without sharing the Connection ID table.  It must
+ * be initialized with `ngtcp2_crypto_quic_lb_config_init`.  It is not
+ * thread-safe if a key is set.  Each thread should have its own copy
+ * initialized with the same parameters.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef struct ngtcp2_crypto_quic_lb_config {
+  /**
+   * :member:`ecb` is AES-128-ECB cipher.  It is only used if
+   * :member:`encrypted` is nonzero.
+   */
+  ngtcp2_crypto_cipher ecb;
+  /**
+   * :member:`ecb_ctx` is the cipher context of :member:`ecb`.
+   */
+  ngtcp2_crypto_cipher_ctx ecb_ctx;
+  /**
+   * :member:`server_idlen` is the length of server ID.
+   */
+  size_t server_idlen;
+  /**
+   * :member:`noncelen` is the length of nonce.
+   */
+  size_t noncelen;
+  /**
+   * :member:`config_id` is the config rotation ID which is encoded
+   * in the first 3 bits of Connection ID.
+   */
+  uint8_t config_id;
+  /**
+   * :member:`encrypted` is nonzero if Connection IDs are encrypted.
+   */
+  uint8_t encrypted;
+} ngtcp2_crypto_quic_lb_config;
+
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_quic_lb_config_init` initializes |config|.
+ * |config_id| is the config rotation ID, and it must not exceed
+ * :macro:`NGTCP2_CRYPTO_QUIC_LB_MAX_CONFIG_ID`.  |server_idlen| is
+ * the length of server ID, and it must be at least 1.  |noncelen| is
+ * the length of nonce, and it must be at least 4.  The sum of
+ * |server_idlen| and |noncelen| must not exceed
+ * :macro:`NGTCP2_MAX_CIDLEN` - 1.  The length of Connection ID is the
+ * sum plus 1.  If |key| is not ``NULL``, it is the key of length
+ * :macro:`NGTCP2_CRYPTO_QUIC_LB_KEYLEN`, and Connection IDs are
+ * encrypted with the four-pass algorithm.  Otherwise, server ID and
+ * nonce are encoded in plaintext.  The single-pass algorithm, which
+ * is used if the sum is exactly 16, is not supported because it
+ * requires AES decryption, and this function fails if |key| is not
+ * ``NULL`` and the sum is 16.
+ *
+ * The successfully initialized |config| must be freed with
+ * `ngtcp2_crypto_quic_lb_config_free`.
+ *
+ * This function returns 0 if it succeeds, or -1.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_crypto_quic_lb_config_init(
+  ngtcp2_crypto_quic_lb_config *config, uint8_t config_id,
+  size_t server_idlen, size_t noncelen, const uint8_t *key);
+
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_quic_lb_config_free` frees up resources used by
+ * |config|.  This function does not free the memory pointed by
+ * |config| itself.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void
+ngtcp2_crypto_quic_lb_config_free(ngtcp2_crypto_quic_lb_config *config);
+
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_quic_lb_generate_cid` writes a routable Connection
+ * ID which encodes |server_id| of length
+ * :member:`ngtcp2_crypto_quic_lb_config.server_idlen` and |nonce| of
+ * length :member:`ngtcp2_crypto_quic_lb_config.noncelen` to |cid|.
+ * The first octet contains the config rotation ID and the length of
+ * Connection ID minus 1.  The nonce must not be reused for the same
+ * server ID.  It can be random bytes or a counter.
+ *
+ * This function can be used inside
+ * :member:`ngtcp2_callbacks.get_new_connection_id2`.
+ *
+ * This function returns 0 if it succeeds, or -1.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_crypto_quic_lb_generate_cid(
+  const ngtcp2_crypto_quic_lb_config *config, ngtcp2_cid *cid,
+  const uint8_t *server_id, const uint8_t *nonce);
+
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_quic_lb_decode_cid` decodes the Connection ID
+ * pointed by |cid| of length |cidlen| generated by
+ * `ngtcp2_crypto_quic_lb_generate_cid`, and writes server ID to the
+ * buffer pointed by |server_id| which must have at least
+ * :member:`ngtcp2_crypto_quic_lb_config.server_idlen` bytes.  If
+ * |nonce| is not ``NULL``, nonce is written to the buffer pointed by
+ * it which must have at least
+ * :member:`ngtcp2_crypto_quic_lb_config.noncelen` bytes.  Passing
+ * ``NULL`` to |nonce| is faster if server ID fits in the first half
+ * of the encrypted octets, because the last pass of decryption is
+ * skipped.  |cid| is typically :member:`ngtcp2_version_cid.dcid`
+ * obtained by `ngtcp2_pkt_decode_version_cid`.
+ *
+ * This function returns 0 if it succeeds, or -1 if |cidlen| is too
+ * short, the config rotation ID does not match, or decryption fails.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_crypto_quic_lb_decode_cid(
+  const ngtcp2_crypto_quic_lb_config *config, uint8_t *server_id,
+  uint8_t *nonce, const uint8_t *cid, size_t cidlen);
+
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_crypto_ctx_pool_stat` holds the statistics of the
+ * per-thread pool of AEAD and cipher contexts.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef struct ngtcp2_crypto_ctx_pool_stat {
+  /**
+   * :member:`nhit` is the number of context initializations which
+   * reused a cached context.
+   */
+  uint64_t nhit;
+  /**
+   * :member:`nmiss` is the number of context initializations which
+   * created a new context while the pool is enabled.
+   */
+  uint64_t nmiss;
+  /**
+   * :member:`ndiscard` is the number of contexts which are freed
+   * rather than cached because the pool is full.
+   */
+  uint64_t ndiscard;
+  /**
+   * :member:`ncached` is the number of contexts currently cached in
+   * the pool.
+   */
+  size_t ncached;
+} ngtcp2_crypto_ctx_pool_stat;
+
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_ctx_pool_set_max` enables the pool of AEAD and
+ * cipher contexts for the calling thread.  The pool is disabled by
+ * default.  Once enabled, `ngtcp2_crypto_aead_ctx_free` and
+ * `ngtcp2_crypto_cipher_ctx_free` keep at most |max_cached| contexts
+ * in the pool instead of freeing them, and
+ * `ngtcp2_crypto_aead_ctx_encrypt_init`,
+ * `ngtcp2_crypto_aead_ctx_decrypt_init`, and
+ * `ngtcp2_crypto_cipher_ctx_encrypt_init` set a new key to a cached
+ * context of the same cipher rather than creating a new one.  This
+ * saves the allocations of contexts when many short-lived connections
+ * are handled by the same thread.  Because the pool is per-thread, a
+ * context must be freed by the thread that initialized it.
+ *
+ * Calling this function frees all contexts cached in the pool of the
+ * calling thread.  Passing 0 to |max_cached| disables the pool.  The
+ * thread must disable the pool before it exits, otherwise the cached
+ * contexts are leaked.  Depending on the backend, the cached contexts
+ * may keep the key of the last use until they are reused or freed.
+ *
+ * Currently, libngtcp2_crypto_ossl, libngtcp2_crypto_quictls,
+ * libngtcp2_crypto_libressl, and libngtcp2_crypto_boringssl use the
+ * pool.  The other crypto backends always create a new context.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void ngtcp2_crypto_ctx_pool_set_max(size_t max_cached);
+
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_ctx_pool_get_stat` assigns the statistics of the
+ * pool of AEAD and cipher contexts of the calling thread to the
+ * object pointed by |stat|.  The counters are kept across
+ * `ngtcp2_crypto_ctx_pool_set_max` calls.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void
+ngtcp2_crypto_ctx_pool_get_stat(ngtcp2_crypto_ctx_pool_stat *stat);
+
 /**
  * @macro
  *
@@ -27,6 +27,7 @@
 #endif /* defined(HAVE_CONFIG_H) */
 
 #include <assert.h>
+#include <string.h>
 
 #include <ngtcp2/ngtcp2_crypto.h>
 #include <ngtcp2/ngtcp2_crypto_ossl.h>
@@ -269,6 +270,17 @@ ngtcp2_crypto_aead *ngtcp2_crypto_aead_retry(ngtcp2_crypto_aead *aead) {
   return ngtcp2_crypto_aead_init(aead, (void *)crypto_aead_aes_128_gcm());
 }
 
+ngtcp2_crypto_cipher *
+ngtcp2_crypto_cipher_chacha20(ngtcp2_crypto_cipher *cipher) {
+#ifndef NGTCP2_NO_CHACHA_POLY1305
+  cipher->native_handle = (void *)crypto_cipher_chacha20();
+  return cipher;
+#else  /* defined(NGTCP2_NO_CHACHA_POLY1305) */
+  (void)cipher;
+  return NULL;
+#endif /* defined(NGTCP2_NO_CHACHA_POLY1305) */
+}
+
 static const EVP_CIPHER *crypto_cipher_id_get_aead(uint32_t cipher_id) {
   switch (cipher_id) {
   case TLS1_3_CK_AES_128_GCM_SHA256:
@@ -631,6 +643,19 @@ int ngtcp2_crypto_aead_ctx_encrypt_init(ngtcp2_crypto_aead_ctx *aead_ctx,
   size_t taglen = crypto_aead_max_overhead(cipher);
   OSSL_PARAM params[3];
 
+  actx = ngtcp2_crypto_ctx_pool_get(
+    cipher_nid, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT, noncelen);
+  if (actx) {
+    if (!EVP_EncryptInit_ex(actx, NULL, NULL, key, NULL)) {
+      EVP_CIPHER_CTX_free(actx);
+      return -1;
+    }
+
+    aead_ctx->native_handle = actx;
+
+    return 0;
+  }
+
   actx = EVP_CIPHER_CTX_new();
   if (actx == NULL) {
     return -1;
@@ -667,6 +692,19 @@ int ngtcp2_crypto_aead_ctx_decrypt_init(ngtcp2_crypto_aead_ctx *aead_ctx,
   size_t taglen = crypto_aead_max_overhead(cipher);
   OSSL_PARAM params[3];
 
+  actx = ngtcp2_crypto_ctx_pool_get(
+    cipher_nid, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_DECRYPT, noncelen);
+  if (actx) {
+    if (!EVP_DecryptInit_ex(actx, NULL, NULL, key, NULL)) {
+      EVP_CIPHER_CTX_free(actx);
+      return -1;
+    }
+
+    aead_ctx->native_handle = actx;
+
+    return 0;
+  }
+
   actx = EVP_CIPHER_CTX_new();
   if (actx == NULL) {
     return -1;
@@ -694,9 +732,25 @@ int ngtcp2_crypto_aead_ctx_decrypt_init(ngtcp2_crypto_aead_ctx *aead_ctx,
   return 0;
 }
 
+static void crypto_cipher_ctx_free(void *native_handle) {
+  EVP_CIPHER_CTX_free(native_handle);
+}
+
 void ngtcp2_crypto_aead_ctx_free(ngtcp2_crypto_aead_ctx *aead_ctx) {
-  if (aead_ctx->native_handle) {
-    EVP_CIPHER_CTX_free(aead_ctx->native_handle);
+  EVP_CIPHER_CTX *actx = aead_ctx->native_handle;
+
+  if (actx == NULL) {
+    return;
+  }
+
+  if (ngtcp2_crypto_ctx_pool_put(
+        EVP_CIPHER_CTX_get_nid(actx),
+        EVP_CIPHER_CTX_is_encrypting(actx)
+          ? NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT
+          : NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_DECRYPT,
+        (size_t)EVP_CIPHER_CTX_get_iv_length(actx), actx,
+        crypto_cipher_ctx_free) != 0) {
+    EVP_CIPHER_CTX_free(actx);
   }
 }
 
@@ -705,6 +759,20 @@ int ngtcp2_crypto_cipher_ctx_encrypt_init(ngtcp2_crypto_cipher_ctx *cipher_ctx,
                                           const uint8_t *key) {
   EVP_CIPHER_CTX *actx;
 
+  actx = ngtcp2_crypto_ctx_pool_get(EVP_CIPHER_nid(cipher->native_handle),
+                                    NGTCP2_CRYPTO_CTX_POOL_KIND_CIPHER_ENCRYPT,
+                                    0);
+  if (actx) {
+    if (!EVP_EncryptInit_ex(actx, NULL, NULL, key, NULL)) {
+      EVP_CIPHER_CTX_free(actx);
+      return -1;
+    }
+
+    cipher_ctx->native_handle = actx;
+
+    return 0;
+  }
+
   actx = EVP_CIPHER_CTX_new();
   if (actx == NULL) {
     return -1;
@@ -721,8 +789,16 @@ int ngtcp2_crypto_cipher_ctx_encrypt_init(ngtcp2_crypto_cipher_ctx *cipher_ctx,
 }
 
 void ngtcp2_crypto_cipher_ctx_free(ngtcp2_crypto_cipher_ctx *cipher_ctx) {
-  if (cipher_ctx->native_handle) {
-    EVP_CIPHER_CTX_free(cipher_ctx->native_handle);
+  EVP_CIPHER_CTX *actx = cipher_ctx->native_handle;
+
+  if (actx == NULL) {
+    return;
+  }
+
+  if (ngtcp2_crypto_ctx_pool_put(EVP_CIPHER_CTX_get_nid(actx),
+                                 NGTCP2_CRYPTO_CTX_POOL_KIND_CIPHER_ENCRYPT, 0,
+                                 actx, crypto_cipher_ctx_free) != 0) {
+    EVP_CIPHER_CTX_free(actx);
   }
 }
 
@@ -882,6 +958,59 @@ int ngtcp2_crypto_encrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
   return 0;
 }
 
+int ngtcp2_crypto_encryptv(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                           const ngtcp2_crypto_aead_ctx *aead_ctx,
+                           const ngtcp2_vec *plaintextv, size_t plaintextcnt,
+                           const uint8_t *nonce, size_t noncelen,
+                           const uint8_t *aad, size_t aadlen) {
+  const EVP_CIPHER *cipher = aead->native_handle;
+  size_t taglen = crypto_aead_max_overhead(cipher);
+  EVP_CIPHER_CTX *actx = aead_ctx->native_handle;
+  uint8_t *p = dest;
+  size_t i;
+  int len;
+  OSSL_PARAM params[2];
+
+  /* AES-CCM requires the whole plaintext in a single call. */
+  if (EVP_CIPHER_nid(cipher) == NID_aes_128_ccm) {
+    return ngtcp2_crypto_encryptv_gather(dest, aead, aead_ctx, plaintextv,
+                                         plaintextcnt, nonce, noncelen, aad,
+                                         aadlen);
+  }
+
+  (void)noncelen;
+
+  if (!EVP_EncryptInit_ex(actx, NULL, NULL, NULL, nonce) ||
+      !EVP_EncryptUpdate(actx, NULL, &len, aad, (int)aadlen)) {
+    return -1;
+  }
+
+  for (i = 0; i < plaintextcnt; ++i) {
+    if (!EVP_EncryptUpdate(actx, p, &len, plaintextv[i].base,
+                           (int)plaintextv[i].len)) {
+      return -1;
+    }
+
+    p += len;
+  }
+
+  if (!EVP_EncryptFinal_ex(actx, p, &len)) {
+    return -1;
+  }
+
+  p += len;
+
+  params[0] =
+    OSSL_PARAM_construct_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, p, taglen);
+  params[1] = OSSL_PARAM_construct_end();
+
+  if (!EVP_CIPHER_CTX_get_params(actx, params)) {
+    return -1;
+  }
+
+  return 0;
+}
+
 int ngtcp2_crypto_decrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
                           const ngtcp2_crypto_aead_ctx *aead_ctx,
                           const uint8_t *ciphertext, size_t ciphertextlen,
@@ -955,6 +1084,40 @@ int ngtcp2_crypto_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
   return 0;
 }
 
+int ngtcp2_crypto_hp_mask_batch(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                                const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                                const uint8_t *const *samples,
+                                size_t nsamples) {
+  EVP_CIPHER_CTX *actx = hp_ctx->native_handle;
+  size_t i;
+  int len;
+
+  switch (EVP_CIPHER_CTX_nid(actx)) {
+  case NID_aes_128_ecb:
+  case NID_aes_256_ecb:
+    /* Gather samples, and encrypt them in place in one go. */
+    for (i = 0; i < nsamples; ++i) {
+      memcpy(dest + i * NGTCP2_HP_SAMPLELEN, samples[i], NGTCP2_HP_SAMPLELEN);
+    }
+
+    if (!EVP_EncryptUpdate(actx, dest, &len, dest,
+                           (int)(nsamples * NGTCP2_HP_SAMPLELEN))) {
+      return -1;
+    }
+
+    return 0;
+  default:
+    for (i = 0; i < nsamples; ++i) {
+      if (ngtcp2_crypto_hp_mask(dest + i * NGTCP2_HP_SAMPLELEN, hp, hp_ctx,
+                                samples[i]) != 0) {
+        return -1;
+      }
+    }
+
+    return 0;
+  }
+}
+
 int ngtcp2_crypto_read_write_crypto_data(
   ngtcp2_conn *conn, ngtcp2_encryption_level encryption_level,
   const uint8_t *data, size_t datalen) {
@@ -69,6 +69,17 @@ ngtcp2_crypto_aead *ngtcp2_crypto_aead_retry(ngtcp2_crypto_aead *aead) {
   return ngtcp2_crypto_aead_init(aead, (void *)&ptls_openssl_aes128gcm);
 }
 
+ngtcp2_crypto_cipher *
+ngtcp2_crypto_cipher_chacha20(ngtcp2_crypto_cipher *cipher) {
+#ifdef PTLS_OPENSSL_HAVE_CHACHA20_POLY1305
+  cipher->native_handle = (void *)&ptls_openssl_chacha20;
+  return cipher;
+#else  /* !defined(PTLS_OPENSSL_HAVE_CHACHA20_POLY1305) */
+  (void)cipher;
+  return NULL;
+#endif /* !defined(PTLS_OPENSSL_HAVE_CHACHA20_POLY1305) */
+}
+
 static uint64_t
 crypto_cipher_suite_get_aead_max_encryption(ptls_cipher_suite_t *cs) {
   if (cs->aead == &ptls_openssl_aes128gcm ||
@@ -329,6 +340,35 @@ int ngtcp2_crypto_encrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
   return 0;
 }
 
+int ngtcp2_crypto_encryptv(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                           const ngtcp2_crypto_aead_ctx *aead_ctx,
+                           const ngtcp2_vec *plaintextv, size_t plaintextcnt,
+                           const uint8_t *nonce, size_t noncelen,
+                           const uint8_t *aad, size_t aadlen) {
+  ptls_aead_context_t *actx = aead_ctx->native_handle;
+  ptls_iovec_t input[64];
+  size_t i;
+
+  if (plaintextcnt > ngtcp2_arraylen(input)) {
+    return ngtcp2_crypto_encryptv_gather(dest, aead, aead_ctx, plaintextv,
+                                         plaintextcnt, nonce, noncelen, aad,
+                                         aadlen);
+  }
+
+  for (i = 0; i < plaintextcnt; ++i) {
+    input[i] = ptls_iovec_init(plaintextv[i].base, plaintextv[i].len);
+  }
+
+  ptls_aead_xor_iv(actx, nonce, noncelen);
+
+  ptls_aead_encrypt_v(actx, dest, input, plaintextcnt, 0, aad, aadlen);
+
+  /* zero-out static iv once again */
+  ptls_aead_xor_iv(actx, nonce, noncelen);
+
+  return 0;
+}
+
 int ngtcp2_crypto_decrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
                           const ngtcp2_crypto_aead_ctx *aead_ctx,
                           const uint8_t *ciphertext, size_t ciphertextlen,
@@ -375,6 +415,35 @@ int ngtcp2_crypto_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
   return 0;
 }
 
+int ngtcp2_crypto_hp_mask_batch(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                                const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                                const uint8_t *const *samples,
+                                size_t nsamples) {
+  ptls_cipher_context_t *actx = hp_ctx->native_handle;
+  size_t i;
+
+  if (hp->native_handle == &ptls_openssl_aes128ecb ||
+      hp->native_handle == &ptls_openssl_aes256ecb) {
+    /* Gather samples, and encrypt them in place in one go. */
+    for (i = 0; i < nsamples; ++i) {
+      memcpy(dest + i * NGTCP2_HP_SAMPLELEN, samples[i], NGTCP2_HP_SAMPLELEN);
+    }
+
+    ptls_cipher_encrypt(actx, dest, dest, nsamples * NGTCP2_HP_SAMPLELEN);
+
+    return 0;
+  }
+
+  for (i = 0; i < nsamples; ++i) {
+    if (ngtcp2_crypto_hp_mask(dest + i * NGTCP2_HP_SAMPLELEN, hp, hp_ctx,
+                              samples[i]) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
 int ngtcp2_crypto_read_write_crypto_data(
   ngtcp2_conn *conn, ngtcp2_encryption_level encryption_level,
   const uint8_t *data, size_t datalen) {
@@ -32,6 +32,7 @@
 #endif /* defined(HAVE_NETINET_IN_H) */
 
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
 
 #include "ngtcp2_macro.h"
@@ -866,6 +867,40 @@ int ngtcp2_crypto_decrypt_cb(uint8_t *dest, const ngtcp2_crypto_aead *aead,
   return 0;
 }
 
+int ngtcp2_crypto_encryptv_cb(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                              const ngtcp2_crypto_aead_ctx *aead_ctx,
+                              const ngtcp2_vec *plaintextv, size_t plaintextcnt,
+                              const uint8_t *nonce, size_t noncelen,
+                              const uint8_t *aad, size_t aadlen) {
+  if (ngtcp2_crypto_encryptv(dest, aead, aead_ctx, plaintextv, plaintextcnt,
+                             nonce, noncelen, aad, aadlen) != 0) {
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  }
+  return 0;
+}
+
+int ngtcp2_crypto_encryptv_gather(uint8_t *dest,
+                                  const ngtcp2_crypto_aead *aead,
+                                  const ngtcp2_crypto_aead_ctx *aead_ctx,
+                                  const ngtcp2_vec *plaintextv,
+                                  size_t plaintextcnt, const uint8_t *nonce,
+                                  size_t noncelen, const uint8_t *aad,
+                                  size_t aadlen) {
+  uint8_t *p = dest;
+  size_t i;
+
+  for (i = 0; i < plaintextcnt; ++i) {
+    if (plaintextv[i].base != p && plaintextv[i].len) {
+      memcpy(p, plaintextv[i].base, plaintextv[i].len);
+    }
+
+    p += plaintextv[i].len;
+  }
+
+  return ngtcp2_crypto_encrypt(dest, aead, aead_ctx, dest, (size_t)(p - dest),
+                               nonce, noncelen, aad, aadlen);
+}
+
 int ngtcp2_crypto_hp_mask_cb(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
                              const ngtcp2_crypto_cipher_ctx *hp_ctx,
                              const uint8_t *sample) {
@@ -875,6 +910,18 @@ int ngtcp2_crypto_hp_mask_cb(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
   return 0;
 }
 
+int ngtcp2_crypto_hp_mask_batch_cb(uint8_t *dest,
+                                   const ngtcp2_crypto_cipher *hp,
+                                   const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                                   const uint8_t *const *samples,
+                                   size_t nsamples) {
+  if (ngtcp2_crypto_hp_mask_batch(dest, hp, hp_ctx, samples, nsamples) !=
+      0) {
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  }
+  return 0;
+}
+
 int ngtcp2_crypto_update_key_cb(
   ngtcp2_conn *conn, uint8_t *rx_secret, uint8_t *tx_secret,
   ngtcp2_crypto_aead_ctx *rx_aead_ctx, uint8_t *rx_iv,
@@ -917,6 +964,227 @@ int ngtcp2_crypto_generate_stateless_reset_token(uint8_t *token,
   return 0;
 }
 
+/* NGTCP2_CRYPTO_QUIC_LB_MIN_NONCELEN is the minimum length of nonce
+   in QUIC-LB Connection ID. */
+#define NGTCP2_CRYPTO_QUIC_LB_MIN_NONCELEN 4
+/* NGTCP2_CRYPTO_QUIC_LB_MAX_HALFLEN is the maximum length of each
+   half of the plaintext in four-pass encryption. */
+#define NGTCP2_CRYPTO_QUIC_LB_MAX_HALFLEN ((NGTCP2_MAX_CIDLEN - 1 + 1) / 2)
+
+int ngtcp2_crypto_quic_lb_config_init(ngtcp2_crypto_quic_lb_config *config,
+                                      uint8_t config_id, size_t server_idlen,
+                                      size_t noncelen, const uint8_t *key) {
+  ngtcp2_crypto_ctx ctx;
+
+  if (config_id > NGTCP2_CRYPTO_QUIC_LB_MAX_CONFIG_ID || server_idlen == 0 ||
+      noncelen < NGTCP2_CRYPTO_QUIC_LB_MIN_NONCELEN ||
+      server_idlen + noncelen > NGTCP2_MAX_CIDLEN - 1) {
+    return -1;
+  }
+
+  memset(config, 0, sizeof(*config));
+
+  config->server_idlen = server_idlen;
+  config->noncelen = noncelen;
+  config->config_id = config_id;
+
+  if (!key) {
+    return 0;
+  }
+
+  /* Single-pass encryption requires AES decryption which the backends
+     do not provide. */
+  if (server_idlen + noncelen == 16) {
+    return -1;
+  }
+
+  /* The header protection cipher of Initial packets is AES-128-ECB
+     for all backends. */
+  ngtcp2_crypto_ctx_initial(&ctx);
+
+  config->ecb = ctx.hp;
+
+  if (ngtcp2_crypto_cipher_ctx_encrypt_init(&config->ecb_ctx, &config->ecb,
+                                            key) != 0) {
+    return -1;
+  }
+
+  config->encrypted = 1;
+
+  return 0;
+}
+
+void ngtcp2_crypto_quic_lb_config_free(ngtcp2_crypto_quic_lb_config *config) {
+  if (!config->encrypted) {
+    return;
+  }
+
+  ngtcp2_crypto_cipher_ctx_free(&config->ecb_ctx);
+}
+
+/*
+ * quic_lb_pass performs a single pass of QUIC-LB four-pass
+ * encryption.  It expands |half| with |pass|, encrypts it with
+ * AES-ECB, and XORs the first octets of the result into |target|.
+ * If |to_left| is nonzero, |target| is the left half, and the last
+ * nibble of the result is cleared if the plaintext length is odd.
+ * Otherwise, |target| is the right half, and the first nibble is
+ * cleared instead.  |plaintextlen| is the length of the whole
+ * plaintext.
+ */
+static int quic_lb_pass(const ngtcp2_crypto_quic_lb_config *config,
+                        uint8_t *target, const uint8_t *half,
+                        size_t plaintextlen, uint8_t pass, int to_left) {
+  uint8_t block[16] = {0};
+  uint8_t mask[NGTCP2_HP_SAMPLELEN];
+  size_t halflen = (plaintextlen + 1) / 2;
+  size_t i;
+
+  memcpy(block, half, halflen);
+  block[14] = (uint8_t)plaintextlen;
+  block[15] = pass;
+
+  if (ngtcp2_crypto_hp_mask(mask, &config->ecb, &config->ecb_ctx, block) !=
+      0) {
+    return -1;
+  }
+
+  if (plaintextlen & 1) {
+    if (to_left) {
+      mask[halflen - 1] &= 0xF0;
+    } else {
+      mask[0] &= 0x0F;
+    }
+  }
+
+  for (i = 0; i < halflen; ++i) {
+    target[i] ^= mask[i];
+  }
+
+  return 0;
+}
+
+/*
+ * quic_lb_split splits |src| of length |len| into |left| and |right|.
+ * If |len| is odd, the middle octet is split at the nibble boundary.
+ */
+static void quic_lb_split(uint8_t *left, uint8_t *right, const uint8_t *src,
+                          size_t len) {
+  size_t halflen = (len + 1) / 2;
+
+  memcpy(left, src, halflen);
+  memcpy(right, src + len - halflen, halflen);
+
+  if (len & 1) {
+    left[halflen - 1] &= 0xF0;
+    right[0] &= 0x0F;
+  }
+}
+
+/*
+ * quic_lb_merge is the inverse of quic_lb_split.
+ */
+static void quic_lb_merge(uint8_t *dest, const uint8_t *left,
+                          const uint8_t *right, size_t len) {
+  size_t halflen = (len + 1) / 2;
+
+  memcpy(dest, left, halflen);
+  memcpy(dest + halflen, right + (len & 1), halflen - (len & 1));
+
+  if (len & 1) {
+    dest[halflen - 1] |= right[0];
+  }
+}
+
+int ngtcp2_crypto_quic_lb_generate_cid(
+  const ngtcp2_crypto_quic_lb_config *config, ngtcp2_cid *cid,
+  const uint8_t *server_id, const uint8_t *nonce) {
+  uint8_t left[NGTCP2_CRYPTO_QUIC_LB_MAX_HALFLEN];
+  uint8_t right[NGTCP2_CRYPTO_QUIC_LB_MAX_HALFLEN];
+  size_t len = config->server_idlen + config->noncelen;
+  uint8_t *p = cid->data;
+
+  cid->datalen = len + 1;
+
+  *p++ = (uint8_t)((config->config_id << 5) | len);
+
+  memcpy(p, server_id, config->server_idlen);
+  memcpy(p + config->server_idlen, nonce, config->noncelen);
+
+  if (!config->encrypted) {
+    return 0;
+  }
+
+  quic_lb_split(left, right, p, len);
+
+  if (quic_lb_pass(config, right, left, len, 1, 0) != 0 ||
+      quic_lb_pass(config, left, right, len, 2, 1) != 0 ||
+      quic_lb_pass(config, right, left, len, 3, 0) != 0 ||
+      quic_lb_pass(config, left, right, len, 4, 1) != 0) {
+    return -1;
+  }
+
+  quic_lb_merge(p, left, right, len);
+
+  return 0;
+}
+
+int ngtcp2_crypto_quic_lb_decode_cid(
+  const ngtcp2_crypto_quic_lb_config *config, uint8_t *server_id,
+  uint8_t *nonce, const uint8_t *cid, size_t cidlen) {
+  uint8_t left[NGTCP2_CRYPTO_QUIC_LB_MAX_HALFLEN];
+  uint8_t right[NGTCP2_CRYPTO_QUIC_LB_MAX_HALFLEN];
+  uint8_t plaintext[NGTCP2_MAX_CIDLEN - 1];
+  size_t len = config->server_idlen + config->noncelen;
+
+  if (cidlen < len + 1 || (cid[0] >> 5) != config->config_id) {
+    return -1;
+  }
+
+  ++cid;
+
+  if (!config->encrypted) {
+    memcpy(server_id, cid, config->server_idlen);
+
+    if (nonce) {
+      memcpy(nonce, cid + config->server_idlen, config->noncelen);
+    }
+
+    return 0;
+  }
+
+  quic_lb_split(left, right, cid, len);
+
+  if (quic_lb_pass(config, left, right, len, 4, 1) != 0 ||
+      quic_lb_pass(config, right, left, len, 3, 0) != 0 ||
+      quic_lb_pass(config, left, right, len, 2, 1) != 0) {
+    return -1;
+  }
+
+  /* left_0 is now known.  If server ID lies entirely in the octets
+     which are not shared with the right half, the last pass is not
+     necessary. */
+  if (!nonce && config->server_idlen <= len / 2) {
+    memcpy(server_id, left, config->server_idlen);
+
+    return 0;
+  }
+
+  if (quic_lb_pass(config, right, left, len, 1, 0) != 0) {
+    return -1;
+  }
+
+  quic_lb_merge(plaintext, left, right, len);
+
+  memcpy(server_id, plaintext, config->server_idlen);
+
+  if (nonce) {
+    memcpy(nonce, plaintext + config->server_idlen, config->noncelen);
+  }
+
+  return 0;
+}
+
 static int crypto_derive_token_key(uint8_t *key, size_t keylen, uint8_t *iv,
                                    size_t ivlen, const ngtcp2_crypto_md *md,
                                    const uint8_t *secret, size_t secretlen,
@@ -1805,3 +2073,150 @@ int ngtcp2_crypto_recv_crypto_data_cb(ngtcp2_conn *conn,
 
   return 0;
 }
+
+#ifdef _MSC_VER
+#  define NGTCP2_CRYPTO_THREAD_LOCAL __declspec(thread)
+#else /* !defined(_MSC_VER) */
+#  define NGTCP2_CRYPTO_THREAD_LOCAL _Thread_local
+#endif /* !defined(_MSC_VER) */
+
+/*
+ * NGTCP2_CRYPTO_CTX_POOL_MAX_BUCKETS is the maximum number of
+ * distinct (cipher_id, kind, param) combinations that the pool caches.
+ * A QUIC endpoint uses only a handful of them.
+ */
+#define NGTCP2_CRYPTO_CTX_POOL_MAX_BUCKETS 16
+
+typedef struct crypto_ctx_pool_bucket {
+  int cipher_id;
+  size_t param;
+  ngtcp2_crypto_ctx_pool_kind kind;
+  void (*free_native_handle)(void *);
+  /* native_handles is the stack of cached contexts.  Its capacity
+     is max_cached of the pool. */
+  void **native_handles;
+  size_t len;
+} crypto_ctx_pool_bucket;
+
+typedef struct crypto_ctx_pool {
+  crypto_ctx_pool_bucket buckets[NGTCP2_CRYPTO_CTX_POOL_MAX_BUCKETS];
+  size_t nbuckets;
+  size_t max_cached;
+  ngtcp2_crypto_ctx_pool_stat stat;
+} crypto_ctx_pool;
+
+static NGTCP2_CRYPTO_THREAD_LOCAL crypto_ctx_pool ctx_pool;
+
+static crypto_ctx_pool_bucket *
+crypto_ctx_pool_find_bucket(crypto_ctx_pool *pool, int cipher_id,
+                            ngtcp2_crypto_ctx_pool_kind kind, size_t param) {
+  size_t i;
+  crypto_ctx_pool_bucket *b;
+
+  for (i = 0; i < pool->nbuckets; ++i) {
+    b = &pool->buckets[i];
+
+    if (b->cipher_id == cipher_id && b->kind == kind && b->param == param) {
+      return b;
+    }
+  }
+
+  return NULL;
+}
+
+static void crypto_ctx_pool_clear(crypto_ctx_pool *pool) {
+  size_t i, j;
+  crypto_ctx_pool_bucket *b;
+
+  for (i = 0; i < pool->nbuckets; ++i) {
+    b = &pool->buckets[i];
+
+    for (j = 0; j < b->len; ++j) {
+      b->free_native_handle(b->native_handles[j]);
+    }
+
+    free(b->native_handles);
+  }
+
+  pool->nbuckets = 0;
+  pool->stat.ncached = 0;
+}
+
+void ngtcp2_crypto_ctx_pool_set_max(size_t max_cached) {
+  crypto_ctx_pool_clear(&ctx_pool);
+
+  ctx_pool.max_cached = max_cached;
+}
+
+void ngtcp2_crypto_ctx_pool_get_stat(ngtcp2_crypto_ctx_pool_stat *stat) {
+  *stat = ctx_pool.stat;
+}
+
+void *ngtcp2_crypto_ctx_pool_get(int cipher_id,
+                                 ngtcp2_crypto_ctx_pool_kind kind,
+                                 size_t param) {
+  crypto_ctx_pool *pool = &ctx_pool;
+  crypto_ctx_pool_bucket *b;
+
+  if (pool->max_cached == 0) {
+    return NULL;
+  }
+
+  b = crypto_ctx_pool_find_bucket(pool, cipher_id, kind, param);
+  if (b == NULL || b->len == 0) {
+    ++pool->stat.nmiss;
+
+    return NULL;
+  }
+
+  ++pool->stat.nhit;
+  --pool->stat.ncached;
+
+  return b->native_handles[--b->len];
+}
+
+int ngtcp2_crypto_ctx_pool_put(int cipher_id, ngtcp2_crypto_ctx_pool_kind kind,
+                               size_t param, void *native_handle,
+                               void (*free_native_handle)(void *)) {
+  crypto_ctx_pool *pool = &ctx_pool;
+  crypto_ctx_pool_bucket *b;
+
+  if (pool->max_cached == 0) {
+    return -1;
+  }
+
+  if (pool->stat.ncached == pool->max_cached) {
+    ++pool->stat.ndiscard;
+
+    return -1;
+  }
+
+  b = crypto_ctx_pool_find_bucket(pool, cipher_id, kind, param);
+  if (b == NULL) {
+    if (pool->nbuckets == NGTCP2_CRYPTO_CTX_POOL_MAX_BUCKETS) {
+      ++pool->stat.ndiscard;
+
+      return -1;
+    }
+
+    b = &pool->buckets[pool->nbuckets];
+
+    b->native_handles = malloc(sizeof(void *) * pool->max_cached);
+    if (b->native_handles == NULL) {
+      return -1;
+    }
+
+    b->cipher_id = cipher_id;
+    b->param = param;
+    b->kind = kind;
+    b->free_native_handle = free_native_handle;
+    b->len = 0;
+
+    ++pool->nbuckets;
+  }
+
+  b->native_handles[b->len++] = native_handle;
+  ++pool->stat.ncached;
+
+  return 0;
+}
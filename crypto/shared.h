@@ -100,6 +100,16 @@ ngtcp2_crypto_aead *ngtcp2_crypto_aead_init(ngtcp2_crypto_aead *aead,
  */
 ngtcp2_crypto_aead *ngtcp2_crypto_aead_retry(ngtcp2_crypto_aead *aead);
 
+/**
+ * @function
+ *
+ * `ngtcp2_crypto_cipher_chacha20` initializes |cipher| with the
+ * ChaCha20 cipher for header protection.  It returns |cipher|, or
+ * NULL if the underlying TLS stack does not support ChaCha20.
+ */
+ngtcp2_crypto_cipher *
+ngtcp2_crypto_cipher_chacha20(ngtcp2_crypto_cipher *cipher);
+
 /**
  * @enum
  *
@@ -322,6 +332,23 @@ int ngtcp2_crypto_derive_and_install_vneg_initial_key(
   uint8_t *tx_key, uint8_t *tx_iv, uint8_t *tx_hp, uint32_t version,
   const ngtcp2_cid *client_dcid);
 
+/*
+ * `ngtcp2_crypto_encryptv_gather` copies the buffers in |plaintextv|
+ * of length |plaintextcnt| that are not in place into |dest|, and
+ * encrypts the whole payload in place by `ngtcp2_crypto_encrypt`.
+ * It is used by the backends which cannot encrypt scattered buffers
+ * in a single pass.
+ *
+ * This function returns 0 if it succeeds, or -1.
+ */
+int ngtcp2_crypto_encryptv_gather(uint8_t *dest,
+                                  const ngtcp2_crypto_aead *aead,
+                                  const ngtcp2_crypto_aead_ctx *aead_ctx,
+                                  const ngtcp2_vec *plaintextv,
+                                  size_t plaintextcnt, const uint8_t *nonce,
+                                  size_t noncelen, const uint8_t *aad,
+                                  size_t aadlen);
+
 /**
  * @function
  *
@@ -374,4 +401,38 @@ int ngtcp2_crypto_hkdf_expand_label(uint8_t *dest, size_t destlen,
                                     const uint8_t *secret, size_t secretlen,
                                     const uint8_t *label, size_t labellen);
 
+typedef enum ngtcp2_crypto_ctx_pool_kind {
+  NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT,
+  NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_DECRYPT,
+  NGTCP2_CRYPTO_CTX_POOL_KIND_CIPHER_ENCRYPT,
+} ngtcp2_crypto_ctx_pool_kind;
+
+/*
+ * ngtcp2_crypto_ctx_pool_get removes a context from the pool of the
+ * calling thread, and returns it.  The context must have been cached
+ * by ngtcp2_crypto_ctx_pool_put with the same |cipher_id|, |kind|,
+ * and |param|.  |cipher_id| is the backend specific identifier of
+ * the cipher (e.g., NID in OpenSSL).  |param| is an additional
+ * parameter that the context depends on (e.g., the length of nonce).
+ * This function returns NULL if no such context is cached, or the
+ * pool is disabled.
+ */
+void *ngtcp2_crypto_ctx_pool_get(int cipher_id,
+                                 ngtcp2_crypto_ctx_pool_kind kind,
+                                 size_t param);
+
+/*
+ * ngtcp2_crypto_ctx_pool_put caches |native_handle| in the pool of
+ * the calling thread so that ngtcp2_crypto_ctx_pool_get returns it
+ * later.  |free_native_handle| is called to free |native_handle| when
+ * the pool is cleared.
+ *
+ * This function returns 0 if it succeeds, or -1 if the pool is
+ * disabled or full.  In the latter case, the caller must free
+ * |native_handle| by itself.
+ */
+int ngtcp2_crypto_ctx_pool_put(int cipher_id, ngtcp2_crypto_ctx_pool_kind kind,
+                               size_t param, void *native_handle,
+                               void (*free_native_handle)(void *));
+
 #endif /* !defined(SHARED_H) */
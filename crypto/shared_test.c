@@ -25,6 +25,7 @@
 #include "shared_test.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "shared.h"
 #include "ngtcp2_macro.h"
@@ -32,6 +33,11 @@
 static const MunitTest tests[] = {
   munit_void_test(test_ngtcp2_crypto_verify_retry_token),
   munit_void_test(test_ngtcp2_crypto_verify_regular_token),
+  munit_void_test(test_ngtcp2_crypto_quic_lb),
+  munit_void_test(test_ngtcp2_crypto_ctx_pool),
+  munit_void_test(test_ngtcp2_crypto_ctx_pool_rekey),
+  munit_void_test(test_ngtcp2_crypto_hp_mask_batch),
+  munit_void_test(test_ngtcp2_crypto_encryptv),
   munit_test_end(),
 };
 
@@ -216,3 +222,567 @@ void test_ngtcp2_crypto_verify_regular_token(void) {
 
   assert_ptrdiff(NGTCP2_CRYPTO_ERR_UNREADABLE_TOKEN, ==, token_datalen);
 }
+
+void test_ngtcp2_crypto_quic_lb(void) {
+  static const uint8_t key[NGTCP2_CRYPTO_QUIC_LB_KEYLEN] = {
+    0x8F, 0x95, 0xF0, 0x92, 0x45, 0x76, 0x5F, 0x80,
+    0x25, 0x69, 0x34, 0xE5, 0x0C, 0x66, 0x20, 0x7F,
+  };
+  static const uint8_t server_id[] = {
+    0xED, 0x79, 0x3A, 0x51, 0xD4, 0x9B, 0x8F, 0x5F, 0xAB, 0x65,
+  };
+  static const uint8_t nonce[] = {
+    0xEE, 0x08, 0x0D, 0xBF, 0x48, 0xC0, 0xD1, 0xE5, 0xF3,
+  };
+  /* The first two are the test vectors in Appendix B of
+     draft-ietf-quic-load-balancers.  The others were produced by an
+     independent implementation of the draft. */
+  static const struct {
+    uint8_t config_id;
+    size_t server_idlen;
+    size_t noncelen;
+    const char *cid;
+  } params[] = {
+    {0, 3, 4, "\x07\x20\xB1\xD0\x7B\x35\x9D\x3C"},
+    {1, 10, 5,
+     "\x2F\xCC\x38\x1B\xC7\x4C\xB4\xFB\xAD\x28\x23\xA3\xD1\xF8\xFE"
+     "\xD2"},
+    {0, 1, 4, "\x05\x75\x0E\x65\x40\x12"},
+    {0, 3, 5, "\x08\x7B\xC6\x29\xF5\x88\x46\xDC\x8F"},
+    {0, 4, 5, "\x09\x81\xF2\x65\x04\x46\x43\x4B\x8B\x43"},
+    {0, 8, 7,
+     "\x0F\x2E\x8A\xC5\x37\xDA\x80\x10\x2C\xE6\xE3\xC8\x4C\x7F\x30"
+     "\x63"},
+    {0, 8, 9,
+     "\x11\xD3\x46\x77\xC6\xAD\xF0\x7E\x4C\x8C\x8C\x8E\x87\x30\x7D"
+     "\xA9\xC1\xAC"},
+    {0, 10, 9,
+     "\x13\x04\xE8\x60\x7D\x66\xC0\x7C\x98\x3B\x88\xB0\x14\xD9\x1C"
+     "\x09\x55\x39\x98\x62"},
+  };
+  ngtcp2_crypto_quic_lb_config config;
+  ngtcp2_cid cid;
+  uint8_t decoded_server_id[sizeof(server_id)];
+  uint8_t decoded_nonce[sizeof(nonce)];
+  size_t i;
+  int rv;
+
+  /* Invalid configurations */
+  assert_int(-1, ==,
+             ngtcp2_crypto_quic_lb_config_init(
+               &config, NGTCP2_CRYPTO_QUIC_LB_MAX_CONFIG_ID + 1, 3, 4, NULL));
+  assert_int(-1, ==, ngtcp2_crypto_quic_lb_config_init(&config, 0, 0, 4, NULL));
+  assert_int(-1, ==, ngtcp2_crypto_quic_lb_config_init(&config, 0, 3, 3, NULL));
+  assert_int(-1, ==,
+             ngtcp2_crypto_quic_lb_config_init(&config, 0, 10, 10, NULL));
+  assert_int(-1, ==, ngtcp2_crypto_quic_lb_config_init(&config, 0, 8, 8, key));
+
+  /* Plaintext */
+  rv = ngtcp2_crypto_quic_lb_config_init(&config, 1, 3, 4, NULL);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_crypto_quic_lb_generate_cid(&config, &cid, server_id, nonce);
+
+  assert_int(0, ==, rv);
+  assert_size(8, ==, cid.datalen);
+  assert_uint8((1 << 5) | 7, ==, cid.data[0]);
+  assert_memory_equal(3, server_id, cid.data + 1);
+  assert_memory_equal(4, nonce, cid.data + 4);
+
+  rv = ngtcp2_crypto_quic_lb_decode_cid(&config, decoded_server_id,
+                                        decoded_nonce, cid.data, cid.datalen);
+
+  assert_int(0, ==, rv);
+  assert_memory_equal(3, server_id, decoded_server_id);
+  assert_memory_equal(4, nonce, decoded_nonce);
+
+  /* Config rotation ID mismatch */
+  cid.data[0] = (uint8_t)((2 << 5) | 7);
+
+  rv = ngtcp2_crypto_quic_lb_decode_cid(&config, decoded_server_id, NULL,
+                                        cid.data, cid.datalen);
+
+  assert_int(-1, ==, rv);
+
+  /* Too short */
+  rv = ngtcp2_crypto_quic_lb_decode_cid(&config, decoded_server_id, NULL,
+                                        cid.data, 7);
+
+  assert_int(-1, ==, rv);
+
+  ngtcp2_crypto_quic_lb_config_free(&config);
+
+  /* Four-pass encryption */
+  for (i = 0; i < ngtcp2_arraylen(params); ++i) {
+    rv = ngtcp2_crypto_quic_lb_config_init(&config, params[i].config_id,
+                                           params[i].server_idlen,
+                                           params[i].noncelen, key);
+
+    assert_int(0, ==, rv);
+
+    rv = ngtcp2_crypto_quic_lb_generate_cid(&config, &cid, server_id, nonce);
+
+    assert_int(0, ==, rv);
+    assert_size(params[i].server_idlen + params[i].noncelen + 1, ==,
+                cid.datalen);
+    assert_memory_equal(cid.datalen, params[i].cid, cid.data);
+
+    memset(decoded_server_id, 0, sizeof(decoded_server_id));
+    memset(decoded_nonce, 0, sizeof(decoded_nonce));
+
+    rv = ngtcp2_crypto_quic_lb_decode_cid(&config, decoded_server_id,
+                                          decoded_nonce, cid.data, cid.datalen);
+
+    assert_int(0, ==, rv);
+    assert_memory_equal(params[i].server_idlen, server_id, decoded_server_id);
+    assert_memory_equal(params[i].noncelen, nonce, decoded_nonce);
+
+    /* Server ID only */
+    memset(decoded_server_id, 0, sizeof(decoded_server_id));
+
+    rv = ngtcp2_crypto_quic_lb_decode_cid(&config, decoded_server_id, NULL,
+                                          cid.data, cid.datalen);
+
+    assert_int(0, ==, rv);
+    assert_memory_equal(params[i].server_idlen, server_id, decoded_server_id);
+
+    ngtcp2_crypto_quic_lb_config_free(&config);
+  }
+}
+
+static size_t nfreed_ctx;
+
+static void free_ctx(void *native_handle) {
+  (void)native_handle;
+
+  ++nfreed_ctx;
+}
+
+void test_ngtcp2_crypto_ctx_pool(void) {
+  int ctx[4];
+  void *p;
+  int rv;
+  ngtcp2_crypto_ctx_pool_stat stat;
+
+  nfreed_ctx = 0;
+
+  /* Disabled by default */
+  rv = ngtcp2_crypto_ctx_pool_put(1, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT,
+                                  12, &ctx[0], free_ctx);
+
+  assert_int(-1, ==, rv);
+  assert_null(ngtcp2_crypto_ctx_pool_get(
+    1, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT, 12));
+
+  ngtcp2_crypto_ctx_pool_get_stat(&stat);
+
+  assert_uint64(0, ==, stat.nhit);
+  assert_uint64(0, ==, stat.nmiss);
+  assert_uint64(0, ==, stat.ndiscard);
+  assert_size(0, ==, stat.ncached);
+
+  ngtcp2_crypto_ctx_pool_set_max(2);
+
+  assert_null(ngtcp2_crypto_ctx_pool_get(
+    1, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT, 12));
+
+  rv = ngtcp2_crypto_ctx_pool_put(1, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT,
+                                  12, &ctx[0], free_ctx);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_crypto_ctx_pool_put(1, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_DECRYPT,
+                                  12, &ctx[1], free_ctx);
+
+  assert_int(0, ==, rv);
+
+  /* Pool is full */
+  rv = ngtcp2_crypto_ctx_pool_put(2, NGTCP2_CRYPTO_CTX_POOL_KIND_CIPHER_ENCRYPT,
+                                  0, &ctx[2], free_ctx);
+
+  assert_int(-1, ==, rv);
+
+  ngtcp2_crypto_ctx_pool_get_stat(&stat);
+
+  assert_uint64(0, ==, stat.nhit);
+  assert_uint64(1, ==, stat.nmiss);
+  assert_uint64(1, ==, stat.ndiscard);
+  assert_size(2, ==, stat.ncached);
+
+  /* Different parameter does not match */
+  assert_null(ngtcp2_crypto_ctx_pool_get(
+    1, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_ENCRYPT, 8));
+
+  p = ngtcp2_crypto_ctx_pool_get(1, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_DECRYPT,
+                                 12);
+
+  assert_ptr_equal(&ctx[1], p);
+
+  assert_null(ngtcp2_crypto_ctx_pool_get(
+    1, NGTCP2_CRYPTO_CTX_POOL_KIND_AEAD_DECRYPT, 12));
+
+  rv = ngtcp2_crypto_ctx_pool_put(2, NGTCP2_CRYPTO_CTX_POOL_KIND_CIPHER_ENCRYPT,
+                                  0, &ctx[2], free_ctx);
+
+  assert_int(0, ==, rv);
+
+  ngtcp2_crypto_ctx_pool_get_stat(&stat);
+
+  assert_uint64(1, ==, stat.nhit);
+  assert_uint64(3, ==, stat.nmiss);
+  assert_uint64(1, ==, stat.ndiscard);
+  assert_size(2, ==, stat.ncached);
+  assert_size(0, ==, nfreed_ctx);
+
+  /* Disabling the pool frees cached contexts */
+  ngtcp2_crypto_ctx_pool_set_max(0);
+
+  assert_size(2, ==, nfreed_ctx);
+
+  ngtcp2_crypto_ctx_pool_get_stat(&stat);
+
+  assert_size(0, ==, stat.ncached);
+
+  rv = ngtcp2_crypto_ctx_pool_put(2, NGTCP2_CRYPTO_CTX_POOL_KIND_CIPHER_ENCRYPT,
+                                  0, &ctx[3], free_ctx);
+
+  assert_int(-1, ==, rv);
+}
+
+void test_ngtcp2_crypto_ctx_pool_rekey(void) {
+  static const uint8_t key_a[16] = {
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+    0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+  };
+  static const uint8_t key_b[16] = {
+    0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87,
+    0x78, 0x69, 0x5A, 0x4B, 0x3C, 0x2D, 0x1E, 0x0F,
+  };
+  static const uint8_t nonce[12] = {0x42};
+  static const uint8_t aad[] = "header";
+  static const uint8_t plaintext[] = "recycled context must use the new key";
+  static const uint8_t sample[NGTCP2_HP_SAMPLELEN] = {0x99};
+  ngtcp2_crypto_ctx ctx;
+  ngtcp2_crypto_aead_ctx aead_ctx;
+  ngtcp2_crypto_cipher_ctx hp_ctx;
+  uint8_t expected[sizeof(plaintext) + 16];
+  uint8_t ciphertext[sizeof(plaintext) + 16];
+  uint8_t decrypted[sizeof(plaintext)];
+  uint8_t expected_mask[NGTCP2_HP_SAMPLELEN];
+  uint8_t mask[NGTCP2_HP_SAMPLELEN];
+  size_t noncelen;
+  size_t ciphertextlen;
+  ngtcp2_crypto_ctx_pool_stat stat, prev_stat;
+  int pooled;
+  int rv;
+
+  ngtcp2_crypto_ctx_initial(&ctx);
+
+  noncelen = ngtcp2_crypto_aead_noncelen(&ctx.aead);
+  ciphertextlen = sizeof(plaintext) + ctx.aead.max_overhead;
+
+  assert_size(sizeof(nonce), ==, noncelen);
+  assert_size(sizeof(ciphertext), >=, ciphertextlen);
+
+  /* Compute the expected output with fresh contexts. */
+  ngtcp2_crypto_ctx_pool_set_max(0);
+
+  rv = ngtcp2_crypto_aead_ctx_encrypt_init(&aead_ctx, &ctx.aead, key_b,
+                                           noncelen);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_crypto_encrypt(expected, &ctx.aead, &aead_ctx, plaintext,
+                             sizeof(plaintext), nonce, noncelen, aad,
+                             sizeof(aad));
+
+  assert_int(0, ==, rv);
+
+  ngtcp2_crypto_aead_ctx_free(&aead_ctx);
+
+  rv = ngtcp2_crypto_cipher_ctx_encrypt_init(&hp_ctx, &ctx.hp, key_b);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_crypto_hp_mask(expected_mask, &ctx.hp, &hp_ctx, sample);
+
+  assert_int(0, ==, rv);
+
+  ngtcp2_crypto_cipher_ctx_free(&hp_ctx);
+
+  /* Use contexts with key A, and return them to the pool. */
+  ngtcp2_crypto_ctx_pool_set_max(4);
+  ngtcp2_crypto_ctx_pool_get_stat(&prev_stat);
+
+  rv = ngtcp2_crypto_aead_ctx_encrypt_init(&aead_ctx, &ctx.aead, key_a,
+                                           noncelen);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_crypto_encrypt(ciphertext, &ctx.aead, &aead_ctx, plaintext,
+                             sizeof(plaintext), nonce, noncelen, aad,
+                             sizeof(aad));
+
+  assert_int(0, ==, rv);
+  assert_memory_not_equal(ciphertextlen, expected, ciphertext);
+
+  ngtcp2_crypto_aead_ctx_free(&aead_ctx);
+
+  rv = ngtcp2_crypto_aead_ctx_decrypt_init(&aead_ctx, &ctx.aead, key_a,
+                                           noncelen);
+
+  assert_int(0, ==, rv);
+
+  ngtcp2_crypto_aead_ctx_free(&aead_ctx);
+
+  rv = ngtcp2_crypto_cipher_ctx_encrypt_init(&hp_ctx, &ctx.hp, key_a);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_crypto_hp_mask(mask, &ctx.hp, &hp_ctx, sample);
+
+  assert_int(0, ==, rv);
+  assert_memory_not_equal(sizeof(mask), expected_mask, mask);
+
+  ngtcp2_crypto_cipher_ctx_free(&hp_ctx);
+
+  ngtcp2_crypto_ctx_pool_get_stat(&stat);
+
+  /* The backend uses the pool if it looked up a context in it. */
+  pooled = stat.nmiss > prev_stat.nmiss;
+
+  if (pooled) {
+    assert_size(0, <, stat.ncached);
+  }
+
+  /* Recycled contexts with key B must produce the same output as the
+     fresh ones. */
+  prev_stat = stat;
+
+  rv = ngtcp2_crypto_aead_ctx_encrypt_init(&aead_ctx, &ctx.aead, key_b,
+                                           noncelen);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_crypto_encrypt(ciphertext, &ctx.aead, &aead_ctx, plaintext,
+                             sizeof(plaintext), nonce, noncelen, aad,
+                             sizeof(aad));
+
+  assert_int(0, ==, rv);
+  assert_memory_equal(ciphertextlen, expected, ciphertext);
+
+  ngtcp2_crypto_aead_ctx_free(&aead_ctx);
+
+  rv = ngtcp2_crypto_aead_ctx_decrypt_init(&aead_ctx, &ctx.aead, key_b,
+                                           noncelen);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_crypto_decrypt(decrypted, &ctx.aead, &aead_ctx, expected,
+                             ciphertextlen, nonce, noncelen, aad, sizeof(aad));
+
+  assert_int(0, ==, rv);
+  assert_memory_equal(sizeof(plaintext), plaintext, decrypted);
+
+  ngtcp2_crypto_aead_ctx_free(&aead_ctx);
+
+  rv = ngtcp2_crypto_cipher_ctx_encrypt_init(&hp_ctx, &ctx.hp, key_b);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_crypto_hp_mask(mask, &ctx.hp, &hp_ctx, sample);
+
+  assert_int(0, ==, rv);
+  assert_memory_equal(sizeof(mask), expected_mask, mask);
+
+  ngtcp2_crypto_cipher_ctx_free(&hp_ctx);
+
+  if (pooled) {
+    ngtcp2_crypto_ctx_pool_get_stat(&stat);
+
+    assert_uint64(prev_stat.nhit + 3, ==, stat.nhit);
+  }
+
+  ngtcp2_crypto_ctx_pool_set_max(0);
+}
+
+void test_ngtcp2_crypto_hp_mask_batch(void) {
+  /* Include batch sizes which are not a multiple of the 4 or 8 block
+     interleave of the AES implementations. */
+  static const size_t nsamples[] = {1, 2, 3, 4, 5, 7, 8, 9, 17, 32};
+  uint8_t key[32];
+  uint8_t sample_buf[32][NGTCP2_HP_SAMPLELEN];
+  const uint8_t *samples[32];
+  uint8_t mask[32 * NGTCP2_HP_SAMPLELEN];
+  uint8_t expected_mask[32 * NGTCP2_HP_SAMPLELEN];
+  ngtcp2_crypto_ctx ctx;
+  ngtcp2_crypto_cipher ciphers[2];
+  size_t nciphers = 0;
+  ngtcp2_crypto_cipher_ctx hp_ctx;
+  size_t i, j, k;
+  int rv;
+
+  for (i = 0; i < sizeof(key); ++i) {
+    key[i] = (uint8_t)(0x5a ^ i);
+  }
+
+  for (i = 0; i < ngtcp2_arraylen(sample_buf); ++i) {
+    for (j = 0; j < NGTCP2_HP_SAMPLELEN; ++j) {
+      sample_buf[i][j] = (uint8_t)(i * 31 + j * 7 + 1);
+    }
+
+    samples[i] = sample_buf[i];
+  }
+
+  ngtcp2_crypto_ctx_initial(&ctx);
+  ciphers[nciphers++] = ctx.hp;
+
+  if (ngtcp2_crypto_cipher_chacha20(&ciphers[nciphers])) {
+    ++nciphers;
+  }
+
+  for (i = 0; i < nciphers; ++i) {
+    rv = ngtcp2_crypto_cipher_ctx_encrypt_init(&hp_ctx, &ciphers[i], key);
+
+    assert_int(0, ==, rv);
+
+    for (j = 0; j < ngtcp2_arraylen(nsamples); ++j) {
+      for (k = 0; k < nsamples[j]; ++k) {
+        rv = ngtcp2_crypto_hp_mask(expected_mask + k * NGTCP2_HP_SAMPLELEN,
+                                   &ciphers[i], &hp_ctx, samples[k]);
+
+        assert_int(0, ==, rv);
+      }
+
+      memset(mask, 0, sizeof(mask));
+
+      rv = ngtcp2_crypto_hp_mask_batch(mask, &ciphers[i], &hp_ctx, samples,
+                                       nsamples[j]);
+
+      assert_int(0, ==, rv);
+
+      /* Only the first NGTCP2_HP_MASKLEN bytes of each mask are
+         defined. */
+      for (k = 0; k < nsamples[j]; ++k) {
+        assert_memory_equal(NGTCP2_HP_MASKLEN,
+                            expected_mask + k * NGTCP2_HP_SAMPLELEN,
+                            mask + k * NGTCP2_HP_SAMPLELEN);
+      }
+    }
+
+    ngtcp2_crypto_cipher_ctx_free(&hp_ctx);
+  }
+}
+
+void test_ngtcp2_crypto_encryptv(void) {
+  static const uint8_t key[16] = {
+    0xBE, 0x0C, 0x69, 0x0B, 0x9F, 0x66, 0x57, 0x5A,
+    0x1D, 0x76, 0x6B, 0x54, 0xE3, 0x68, 0xC8, 0x4E,
+  };
+  static const uint8_t nonce[12] = {
+    0x46, 0x15, 0x99, 0xD3, 0x5D, 0x63, 0x2B, 0xF2, 0x23, 0x98, 0x25, 0xBB,
+  };
+  static const uint8_t aad[] = {0xC3, 0x00, 0x00, 0x00, 0x01, 0x08};
+  /* The lengths of vectors, including empty ones and splits which are
+     not aligned to the AES block size. */
+  static const struct {
+    size_t lens[6];
+    size_t cnt;
+  } params[] = {
+    {{0}, 1},
+    {{1}, 1},
+    {{97}, 1},
+    {{0, 97}, 2},
+    {{97, 0}, 2},
+    {{1, 96}, 2},
+    {{1, 1, 1}, 3},
+    {{15, 0, 17, 1, 64}, 5},
+    {{13, 29, 55}, 3},
+    {{16, 16, 33, 32}, 4},
+  };
+  uint8_t plaintext[97];
+  uint8_t expected[sizeof(plaintext) + 16];
+  uint8_t ciphertext[sizeof(plaintext) + 16];
+  ngtcp2_vec vec[sizeof(plaintext)];
+  ngtcp2_crypto_aead aead;
+  ngtcp2_crypto_aead_ctx aead_ctx;
+  size_t i, j, len, off;
+  int rv;
+
+  for (i = 0; i < sizeof(plaintext); ++i) {
+    plaintext[i] = (uint8_t)(i * 13 + 7);
+  }
+
+  ngtcp2_crypto_aead_retry(&aead);
+
+  assert_size(16, ==, aead.max_overhead);
+
+  rv = ngtcp2_crypto_aead_ctx_encrypt_init(&aead_ctx, &aead, key,
+                                           sizeof(nonce));
+
+  assert_int(0, ==, rv);
+
+  for (i = 0; i < ngtcp2_arraylen(params); ++i) {
+    len = 0;
+
+    for (j = 0; j < params[i].cnt; ++j) {
+      vec[j].base = plaintext + len;
+      vec[j].len = params[i].lens[j];
+      len += params[i].lens[j];
+    }
+
+    rv = ngtcp2_crypto_encrypt(expected, &aead, &aead_ctx, plaintext, len,
+                               nonce, sizeof(nonce), aad, sizeof(aad));
+
+    assert_int(0, ==, rv);
+
+    memset(ciphertext, 0, sizeof(ciphertext));
+
+    rv = ngtcp2_crypto_encryptv(ciphertext, &aead, &aead_ctx, vec,
+                                params[i].cnt, nonce, sizeof(nonce), aad,
+                                sizeof(aad));
+
+    assert_int(0, ==, rv);
+    assert_memory_equal(len + aead.max_overhead, expected, ciphertext);
+
+    /* In place */
+    memcpy(ciphertext, plaintext, len);
+
+    for (j = 0, off = 0; j < params[i].cnt; ++j) {
+      vec[j].base = ciphertext + off;
+      off += vec[j].len;
+    }
+
+    rv = ngtcp2_crypto_encryptv(ciphertext, &aead, &aead_ctx, vec,
+                                params[i].cnt, nonce, sizeof(nonce), aad,
+                                sizeof(aad));
+
+    assert_int(0, ==, rv);
+    assert_memory_equal(len + aead.max_overhead, expected, ciphertext);
+  }
+
+  /* One byte per vector, which is more than some backends can pass to
+     the TLS stack at once. */
+  for (i = 0; i < sizeof(plaintext); ++i) {
+    vec[i].base = plaintext + i;
+    vec[i].len = 1;
+  }
+
+  rv = ngtcp2_crypto_encrypt(expected, &aead, &aead_ctx, plaintext,
+                             sizeof(plaintext), nonce, sizeof(nonce), aad,
+                             sizeof(aad));
+
+  assert_int(0, ==, rv);
+
+  memset(ciphertext, 0, sizeof(ciphertext));
+
+  rv = ngtcp2_crypto_encryptv(ciphertext, &aead, &aead_ctx, vec,
+                              sizeof(plaintext), nonce, sizeof(nonce), aad,
+                              sizeof(aad));
+
+  assert_int(0, ==, rv);
+  assert_memory_equal(sizeof(ciphertext), expected, ciphertext);
+
+  ngtcp2_crypto_aead_ctx_free(&aead_ctx);
+}
@@ -37,5 +37,10 @@ extern const MunitSuite shared_suite;
 
 munit_void_test_decl(test_ngtcp2_crypto_verify_retry_token)
 munit_void_test_decl(test_ngtcp2_crypto_verify_regular_token)
+munit_void_test_decl(test_ngtcp2_crypto_quic_lb)
+munit_void_test_decl(test_ngtcp2_crypto_ctx_pool)
+munit_void_test_decl(test_ngtcp2_crypto_ctx_pool_rekey)
+munit_void_test_decl(test_ngtcp2_crypto_hp_mask_batch)
+munit_void_test_decl(test_ngtcp2_crypto_encryptv)
 
 #endif /* !defined(NGTCP2_SHARED_TEST_H) */
@@ -27,6 +27,7 @@
 #endif /* defined(HAVE_CONFIG_H) */
 
 #include <assert.h>
+#include <string.h>
 
 #include <ngtcp2/ngtcp2_crypto.h>
 #include <ngtcp2/ngtcp2_crypto_wolfssl.h>
@@ -74,6 +75,12 @@ ngtcp2_crypto_aead *ngtcp2_crypto_aead_retry(ngtcp2_crypto_aead *aead) {
   return ngtcp2_crypto_aead_init(aead, (void *)wolfSSL_EVP_aes_128_gcm());
 }
 
+ngtcp2_crypto_cipher *
+ngtcp2_crypto_cipher_chacha20(ngtcp2_crypto_cipher *cipher) {
+  cipher->native_handle = (void *)wolfSSL_EVP_chacha20();
+  return cipher;
+}
+
 static uint64_t
 crypto_aead_get_aead_max_encryption(const WOLFSSL_EVP_CIPHER *aead) {
   if (wolfSSL_quic_aead_is_gcm(aead)) {
@@ -285,6 +292,17 @@ int ngtcp2_crypto_encrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
   return 0;
 }
 
+int ngtcp2_crypto_encryptv(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                           const ngtcp2_crypto_aead_ctx *aead_ctx,
+                           const ngtcp2_vec *plaintextv, size_t plaintextcnt,
+                           const uint8_t *nonce, size_t noncelen,
+                           const uint8_t *aad, size_t aadlen) {
+  /* wolfSSL_quic_aead_encrypt only takes a contiguous plaintext. */
+  return ngtcp2_crypto_encryptv_gather(dest, aead, aead_ctx, plaintextv,
+                                       plaintextcnt, nonce, noncelen, aad,
+                                       aadlen);
+}
+
 int ngtcp2_crypto_decrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
                           const ngtcp2_crypto_aead_ctx *aead_ctx,
                           const uint8_t *ciphertext, size_t ciphertextlen,
@@ -336,6 +354,40 @@ int ngtcp2_crypto_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
   return 0;
 }
 
+int ngtcp2_crypto_hp_mask_batch(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                                const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                                const uint8_t *const *samples,
+                                size_t nsamples) {
+  WOLFSSL_EVP_CIPHER_CTX *actx = hp_ctx->native_handle;
+  size_t i;
+  int len;
+
+  switch (wolfSSL_EVP_CIPHER_CTX_nid(actx)) {
+  case NID_aes_128_ecb:
+  case NID_aes_256_ecb:
+    /* Gather samples, and encrypt them in place in one go. */
+    for (i = 0; i < nsamples; ++i) {
+      memcpy(dest + i * NGTCP2_HP_SAMPLELEN, samples[i], NGTCP2_HP_SAMPLELEN);
+    }
+
+    if (!wolfSSL_EVP_CipherUpdate(actx, dest, &len, dest,
+                                  (int)(nsamples * NGTCP2_HP_SAMPLELEN))) {
+      return -1;
+    }
+
+    return 0;
+  default:
+    for (i = 0; i < nsamples; ++i) {
+      if (ngtcp2_crypto_hp_mask(dest + i * NGTCP2_HP_SAMPLELEN, hp, hp_ctx,
+                                samples[i]) != 0) {
+        return -1;
+      }
+    }
+
+    return 0;
+  }
+}
+
 int ngtcp2_crypto_read_write_crypto_data(
   ngtcp2_conn *conn, ngtcp2_encryption_level encryption_level,
   const uint8_t *data, size_t datalen) {
@@ -179,7 +179,8 @@ Client::Client(struct ev_loop *loop, uint32_t client_chosen_version,
 #else  // !defined(UDP_SEGMENT)
       true
 #endif // !defined(UDP_SEGMENT)
-    } {
+    },
+    rbatch_{config.recv_batch} {
   ev_io_init(&wev_, writecb, 0, EV_WRITE);
   wev_.data = this;
   ev_timer_init(&timer_, timeoutcb, 0., 0.);
@@ -197,7 +198,14 @@ Client::Client(struct ev_loop *loop, uint32_t client_chosen_version,
   ev_signal_init(&sigintev_, siginthandler, SIGINT);
 }
 
-Client::~Client() { disconnect(); }
+Client::~Client() {
+  if (config.show_stat) {
+    print_batch_stats("Receive", rbatch_.stats);
+    print_batch_stats("Send", send_stats_);
+  }
+
+  disconnect();
+}
 
 void Client::disconnect() {
   tx_.send_blocked = false;
@@ -499,6 +507,25 @@ int do_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
 }
 } // namespace
 
+namespace {
+int do_hp_mask_batch(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                     const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                     const uint8_t *const *samples, size_t nsamples) {
+  if (ngtcp2_crypto_hp_mask_batch(dest, hp, hp_ctx, samples, nsamples) != 0) {
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  }
+
+  if (!config.quiet && config.show_secret) {
+    for (size_t i = 0; i < nsamples; ++i) {
+      debug::print_hp_mask({dest + i * NGTCP2_HP_SAMPLELEN, NGTCP2_HP_MASKLEN},
+                           {samples[i], NGTCP2_HP_SAMPLELEN});
+    }
+  }
+
+  return 0;
+}
+} // namespace
+
 namespace {
 int update_key(ngtcp2_conn *conn, uint8_t *rx_secret, uint8_t *tx_secret,
                ngtcp2_crypto_aead_ctx *rx_aead_ctx, uint8_t *rx_iv,
@@ -681,6 +708,8 @@ std::expected<void, Error> Client::init(int fd, const Address &local_addr,
     .get_new_connection_id2 = get_new_connection_id,
     .get_path_challenge_data2 = ngtcp2_crypto_get_path_challenge_data2_cb,
     .stream_close2 = stream_close,
+    .hp_mask_batch = do_hp_mask_batch,
+    .encryptv = ngtcp2_crypto_encryptv_cb,
   };
 
   ngtcp2_cid scid, dcid;
@@ -879,25 +908,9 @@ Client::feed_data(const Endpoint &ep, const sockaddr *sa, socklen_t salen,
 }
 
 std::expected<void, Error> Client::on_read(const Endpoint &ep) {
-  std::array<uint8_t, 64_k> buf;
-  sockaddr_storage ss;
   size_t pktcnt = 0;
   ngtcp2_pkt_info pi;
 
-  iovec msg_iov{
-    .iov_base = buf.data(),
-    .iov_len = buf.size(),
-  };
-
-  uint8_t msg_ctrl[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(int))];
-
-  msghdr msg{
-    .msg_name = &ss,
-    .msg_iov = &msg_iov,
-    .msg_iovlen = 1,
-    .msg_control = msg_ctrl,
-  };
-
   auto start = util::timestamp();
 
   for (; pktcnt < MAX_RECV_PKTS;) {
@@ -906,67 +919,66 @@ std::expected<void, Error> Client::on_read(const Endpoint &ep) {
       break;
     }
 
-    msg.msg_namelen = sizeof(ss);
-    msg.msg_controllen = sizeof(msg_ctrl);
-
-    auto nread = recvmsg(ep.fd, &msg, 0);
+    auto nmsg = rbatch_.recv(ep.fd, MAX_RECV_PKTS - pktcnt);
 
-    if (nread == -1) {
+    if (nmsg == -1) {
       if (errno != EAGAIN && errno != EWOULDBLOCK) {
-        std::println(stderr, "recvmsg: {}", strerror(errno));
+        std::println(stderr, "recvmmsg: {}", strerror(errno));
       }
       break;
     }
 
-    // Packets less than 21 bytes never be a valid QUIC packet.
-    if (nread < 21) {
-      ++pktcnt;
+    for (size_t i = 0; i < static_cast<size_t>(nmsg); ++i) {
+      auto msg = rbatch_.msg(i);
+      auto data = rbatch_.data(i);
 
-      continue;
-    }
-
-    pi.ecn = msghdr_get_ecn(&msg, ss.ss_family);
-    auto gso_size = msghdr_get_udp_gro(&msg);
-    if (gso_size == 0) {
-      gso_size = static_cast<size_t>(nread);
-    }
-
-    auto data = std::span{buf.data(), static_cast<size_t>(nread)};
+      // Packets less than 21 bytes never be a valid QUIC packet.
+      if (data.size() < 21) {
+        ++pktcnt;
 
-    for (;;) {
-      auto datalen = std::min(data.size(), gso_size);
+        continue;
+      }
 
-      ++pktcnt;
+      auto sa = static_cast<const sockaddr *>(msg->msg_name);
 
-      if (!config.quiet) {
-        std::println(stderr,
-                     "Received packet: local={} remote={} ecn={:#x} {} bytes",
-                     util::straddr(ep.addr),
-                     util::straddr(reinterpret_cast<const sockaddr *>(&ss),
-                                   msg.msg_namelen),
-                     pi.ecn, datalen);
+      pi.ecn = msghdr_get_ecn(msg, sa->sa_family);
+      auto gso_size = msghdr_get_udp_gro(msg);
+      if (gso_size == 0) {
+        gso_size = data.size();
       }
 
-      // Packets less than 21 bytes never be a valid QUIC packet.
-      if (datalen < 21) {
-        break;
-      }
+      for (;;) {
+        auto datalen = std::min(data.size(), gso_size);
+
+        ++pktcnt;
 
-      if (debug::packet_lost(config.rx_loss_prob)) {
         if (!config.quiet) {
-          std::println(stderr, "** Simulated incoming packet loss **");
+          std::println(stderr,
+                       "Received packet: local={} remote={} ecn={:#x} {} bytes",
+                       util::straddr(ep.addr),
+                       util::straddr(sa, msg->msg_namelen), pi.ecn, datalen);
         }
-      } else if (auto rv =
-                   feed_data(ep, reinterpret_cast<const sockaddr *>(&ss),
-                             msg.msg_namelen, &pi, {data.data(), datalen});
-                 !rv) {
-        return rv;
-      }
 
-      data = data.subspan(datalen);
+        // Packets less than 21 bytes never be a valid QUIC packet.
+        if (datalen < 21) {
+          break;
+        }
 
-      if (data.empty()) {
-        break;
+        if (debug::packet_lost(config.rx_loss_prob)) {
+          if (!config.quiet) {
+            std::println(stderr, "** Simulated incoming packet loss **");
+          }
+        } else if (auto rv = feed_data(ep, sa, msg->msg_namelen, &pi,
+                                       {data.data(), datalen});
+                   !rv) {
+          return rv;
+        }
+
+        data = data.subspan(datalen);
+
+        if (data.empty()) {
+          break;
+        }
       }
     }
   }
@@ -1460,29 +1472,12 @@ std::span<const uint8_t> Client::send_packet(const Endpoint &ep,
     return {};
   }
 
-  if (no_gso_ && data.size() > gso_size) {
-    for (; !data.empty();) {
-      auto len = std::min(gso_size, data.size());
-
-      auto rest = send_packet(ep, remote_addr, ecn, data.first(len), len);
-      if (!rest.empty()) {
-        assert(rest.size() == len);
-
-        return data;
-      }
-
-      data = data.subspan(len);
-    }
-
-    return {};
-  }
-
   iovec msg_iov{
     .iov_base = const_cast<uint8_t *>(data.data()),
     .iov_len = data.size(),
   };
 
-  uint8_t msg_ctrl[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(uint16_t))]{};
+  uint8_t msg_ctrl[SEND_CMSG_SPACE];
 
   msghdr msg{
 #ifdef HAVE_LINUX_RTNETLINK_H
@@ -1492,56 +1487,38 @@ std::span<const uint8_t> Client::send_packet(const Endpoint &ep,
     .msg_iov = &msg_iov,
     .msg_iovlen = 1,
     .msg_control = msg_ctrl,
-    .msg_controllen = sizeof(msg_ctrl),
   };
 
-  size_t controllen = 0;
+  msghdr_set_send_cmsg(&msg, nullptr, remote_addr.addr->sa_family, ecn,
+                       !no_gso_ && data.size() > gso_size ? gso_size : 0, 0);
 
-  auto cm = CMSG_FIRSTHDR(&msg);
-  controllen += CMSG_SPACE(sizeof(int));
-  cm->cmsg_len = CMSG_LEN(sizeof(int));
-  memcpy(CMSG_DATA(cm), &ecn, sizeof(ecn));
+  ssize_t nwrite = 0;
 
-  switch (remote_addr.addr->sa_family) {
-  case AF_INET:
-    cm->cmsg_level = IPPROTO_IP;
-    cm->cmsg_type = IP_TOS;
+  if (no_gso_ && data.size() > gso_size) {
+    nwrite = send_segments(ep.fd, msg, data, gso_size, config.send_batch,
+                           send_stats_);
+    if (nwrite != -1 && static_cast<size_t>(nwrite) < data.size()) {
+      switch (errno) {
+      case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+      case EWOULDBLOCK:
+#endif // EAGAIN != EWOULDBLOCK
+        return data.subspan(static_cast<size_t>(nwrite));
+      }
 
-    break;
-  case AF_INET6:
-    cm->cmsg_level = IPPROTO_IPV6;
-    cm->cmsg_type = IPV6_TCLASS;
+      std::println(stderr, "sendmmsg: {}", strerror(errno));
 
-    break;
-  default:
-    assert(0);
-  }
+      return {};
+    }
+  } else {
+    do {
+      nwrite = sendmsg(ep.fd, &msg, 0);
+    } while (nwrite == -1 && errno == EINTR);
 
-#ifdef UDP_SEGMENT
-  if (data.size() > gso_size) {
-    controllen += CMSG_SPACE(sizeof(uint16_t));
-    cm = CMSG_NXTHDR(&msg, cm);
-    cm->cmsg_level = SOL_UDP;
-    cm->cmsg_type = UDP_SEGMENT;
-    cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
-    auto n = static_cast<uint16_t>(gso_size);
-    memcpy(CMSG_DATA(cm), &n, sizeof(n));
+    if (nwrite != -1) {
+      send_stats_.add(1);
+    }
   }
-#endif // defined(UDP_SEGMENT)
-
-  msg.msg_controllen =
-#ifndef __APPLE__
-    controllen
-#else  // defined(__APPLE__)
-    static_cast<socklen_t>(controllen)
-#endif // defined(__APPLE__)
-    ;
-
-  ssize_t nwrite = 0;
-
-  do {
-    nwrite = sendmsg(ep.fd, &msg, 0);
-  } while (nwrite == -1 && errno == EINTR);
 
   if (nwrite == -1) {
     switch (errno) {
@@ -2167,6 +2144,18 @@ Options:
               to send  per an event  loop in a single  connection.  It
               defaults  to 0,  which means  it is  not limited  by the
               configuration.
+  --recv-batch=<N>
+              The maximum number of UDP datagrams to receive in a single
+              recvmmsg call.  It is  ignored if recvmmsg is unavailable.
+              It must be in range [1, 1024], inclusive.
+              Default: )"
+            << config.recv_batch << R"(
+  --send-batch=<N>
+              The maximum  number of UDP  datagrams to send in  a single
+              sendmmsg  call when  GSO  is disabled  or unavailable.  It
+              must be in range [1, 1024], inclusive.
+              Default: )"
+            << config.send_batch << R"(
   -h, --help  Display this help and exit.
 
 ---
@@ -2254,6 +2243,8 @@ int main(int argc, char **argv) {
       {"no-gso", no_argument, &flag, 45},
       {"show-stat", no_argument, &flag, 46},
       {"gso-burst", required_argument, &flag, 47},
+      {"recv-batch", required_argument, &flag, 48},
+      {"send-batch", required_argument, &flag, 49},
       {},
     };
 
@@ -2764,6 +2755,42 @@ int main(int argc, char **argv) {
 
         break;
       }
+      case 48: {
+        // --recv-batch
+        auto n = util::parse_uint(optarg);
+        if (!n) {
+          std::println(stderr, "recv-batch: invalid argument");
+          exit(EXIT_FAILURE);
+        }
+
+        if (*n < 1 || *n > 1024) {
+          std::println(stderr,
+                       "recv-batch: must be in range [1, 1024], inclusive.");
+          exit(EXIT_FAILURE);
+        }
+
+        config.recv_batch = static_cast<size_t>(*n);
+
+        break;
+      }
+      case 49: {
+        // --send-batch
+        auto n = util::parse_uint(optarg);
+        if (!n) {
+          std::println(stderr, "send-batch: invalid argument");
+          exit(EXIT_FAILURE);
+        }
+
+        if (*n < 1 || *n > 1024) {
+          std::println(stderr,
+                       "send-batch: must be in range [1, 1024], inclusive.");
+          exit(EXIT_FAILURE);
+        }
+
+        config.send_batch = static_cast<size_t>(*n);
+
+        break;
+      }
       }
       break;
     default:
@@ -200,6 +200,8 @@ private:
   // confirmed.
   bool handshake_confirmed_{};
   bool no_gso_;
+  RecvBatch rbatch_;
+  BatchStats send_stats_;
 
   struct {
     bool send_blocked;
@@ -206,6 +206,12 @@ struct Config {
   // gso_burst is the number of packets to aggregate in GSO.  0 means
   // it is not limited by the configuration.
   size_t gso_burst{};
+  // recv_batch is the maximum number of UDP datagrams to receive in
+  // a single recvmmsg call.
+  size_t recv_batch{16};
+  // send_batch is the maximum number of UDP datagrams to send in a
+  // single sendmmsg call when GSO is not used.
+  size_t send_batch{64};
 };
 
 class ClientBase {
@@ -28,9 +28,11 @@
 #include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <utility>
 #include <memory>
 #include <fstream>
 #include <iomanip>
+#include <thread>
 
 #include <unistd.h>
 #include <getopt.h>
@@ -62,7 +64,7 @@ constexpr auto NGTCP2_SV_SCIDLEN = 18UZ;
 constexpr auto max_preferred_versionslen = 4UZ;
 
 namespace {
-auto randgen = util::make_mt19937();
+thread_local auto randgen = util::make_mt19937();
 } // namespace
 
 Config config;
@@ -358,6 +360,12 @@ Handler::~Handler() {
   ev_timer_stop(loop_, &timer_);
   ev_io_stop(loop_, &wev_);
 
+  if (send_scheduled_) {
+    server_->cancel_send(this);
+  }
+
+  put_txbuf();
+
   if (qlog_) {
     fclose(qlog_);
   }
@@ -436,6 +444,25 @@ int do_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
 }
 } // namespace
 
+namespace {
+int do_hp_mask_batch(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                     const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                     const uint8_t *const *samples, size_t nsamples) {
+  if (ngtcp2_crypto_hp_mask_batch(dest, hp, hp_ctx, samples, nsamples) != 0) {
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  }
+
+  if (!config.quiet && config.show_secret) {
+    for (size_t i = 0; i < nsamples; ++i) {
+      debug::print_hp_mask({dest + i * NGTCP2_HP_SAMPLELEN, NGTCP2_HP_MASKLEN},
+                           {samples[i], NGTCP2_HP_SAMPLELEN});
+    }
+  }
+
+  return 0;
+}
+} // namespace
+
 namespace {
 int recv_crypto_data(ngtcp2_conn *conn,
                      ngtcp2_encryption_level encryption_level, uint64_t offset,
@@ -571,18 +598,20 @@ namespace {
 int get_new_connection_id(ngtcp2_conn *conn, ngtcp2_cid *cid,
                           ngtcp2_stateless_reset_token *token, size_t cidlen,
                           void *user_data) {
-  if (!util::generate_secure_random({cid->data, cidlen})) {
+  auto h = static_cast<Handler *>(user_data);
+
+  assert(cidlen == NGTCP2_SV_SCIDLEN);
+
+  if (!h->server()->generate_cid(*cid)) {
     return NGTCP2_ERR_CALLBACK_FAILURE;
   }
 
-  cid->datalen = cidlen;
   if (ngtcp2_crypto_generate_stateless_reset_token(
         token->data, config.static_secret.data(), config.static_secret.size(),
         cid) != 0) {
     return NGTCP2_ERR_CALLBACK_FAILURE;
   }
 
-  auto h = static_cast<Handler *>(user_data);
   h->server()->associate_cid(cid, h);
 
   return 0;
@@ -750,11 +779,11 @@ Handler::init(const Endpoint &ep, const Address &local_addr,
     .get_new_connection_id2 = get_new_connection_id,
     .get_path_challenge_data2 = ngtcp2_crypto_get_path_challenge_data2_cb,
     .stream_close2 = stream_close,
+    .hp_mask_batch = do_hp_mask_batch,
+    .encryptv = ngtcp2_crypto_encryptv_cb,
   };
 
-  scid_.datalen = NGTCP2_SV_SCIDLEN;
-  if (auto rv = util::generate_secure_random({scid_.data, scid_.datalen});
-      !rv) {
+  if (auto rv = server_->generate_cid(scid_); !rv) {
     std::println(stderr, "Could not generate connection ID");
     return rv;
   }
@@ -868,10 +897,7 @@ Handler::init(const Endpoint &ep, const Address &local_addr,
       return rv;
     }
 
-    params.preferred_addr.cid.datalen = NGTCP2_SV_SCIDLEN;
-    if (auto rv = util::generate_secure_random(
-          {params.preferred_addr.cid.data, params.preferred_addr.cid.datalen});
-        !rv) {
+    if (auto rv = server_->generate_cid(params.preferred_addr.cid); !rv) {
       std::println(stderr,
                    "Could not generate preferred address connection ID");
       return rv;
@@ -987,6 +1013,12 @@ std::expected<void, Error> Handler::on_write() {
 
   ev_io_stop(loop_, &wev_);
 
+  if (config.batch_send) {
+    signal_write();
+
+    return {};
+  }
+
   if (auto rv = write_streams(); !rv) {
     return rv;
   }
@@ -1012,21 +1044,91 @@ ngtcp2_ssize Handler::write_pkt(ngtcp2_path *path, ngtcp2_pkt_info *pi,
   return proto_codec_->write_pkt(path, pi, dest, destlen, ts);
 }
 
+std::span<uint8_t> Handler::get_txbuf() {
+#ifdef HAVE_LIBURING
+  // Packets are written directly into the buffer which io_uring
+  // sends.
+  if (!txsb_) {
+    txsb_ = server_->get_send_buf();
+    if (!txsb_) {
+      return {};
+    }
+  }
+
+  return txsb_->data;
+#else  // !defined(HAVE_LIBURING)
+  return txbuf_;
+#endif // !defined(HAVE_LIBURING)
+}
+
+void Handler::put_txbuf() {
+#ifdef HAVE_LIBURING
+  if (txsb_) {
+    server_->put_send_buf(std::exchange(txsb_, nullptr));
+  }
+#endif // defined(HAVE_LIBURING)
+}
+
 std::expected<void, Error> Handler::write_streams() {
   ngtcp2_path_storage ps;
   ngtcp2_pkt_info pi;
   size_t gso_size;
   auto ts = util::timestamp();
-  auto txbuf = std::span{txbuf_};
-  auto buflen = util::clamp_buffer_size(conn_, txbuf.size(), config.gso_burst);
 
   ngtcp2_path_storage_zero(&ps);
 
+  if (config.txtime_horizon) {
+    // Hand all bursts within the horizon to the kernel, which holds
+    // each of them until its departure time.
+    for (;;) {
+      ngtcp2_tstamp txtime;
+
+      auto txbuf = get_txbuf();
+      if (txbuf.empty()) {
+        return {};
+      }
+
+      auto buflen =
+        util::clamp_buffer_size(conn_, txbuf.size(), config.gso_burst);
+
+      auto nwrite = ngtcp2_conn_write_aggregate_pkt_txtime(
+        conn_, &ps.path, &pi, txbuf.data(), buflen, &gso_size, &txtime,
+        ::write_pkt, config.gso_burst, config.txtime_horizon, ts);
+      if (nwrite <= 0) {
+        put_txbuf();
+
+        if (nwrite < 0) {
+          return handle_error();
+        }
+
+        return {};
+      }
+
+      if (auto rv = send_packet(ps.path, pi.ecn,
+                                txbuf.first(static_cast<size_t>(nwrite)),
+                                gso_size, txtime);
+          !rv) {
+        return {};
+      }
+    }
+  }
+
+  auto txbuf = get_txbuf();
+  if (txbuf.empty()) {
+    return {};
+  }
+
+  auto buflen = util::clamp_buffer_size(conn_, txbuf.size(), config.gso_burst);
+
   auto nwrite = ngtcp2_conn_write_aggregate_pkt2(
     conn_, &ps.path, &pi, txbuf.data(), buflen, &gso_size, ::write_pkt,
     config.gso_burst, ts);
-  if (nwrite < 0) {
-    return handle_error();
+  if (nwrite <= 0) {
+    put_txbuf();
+
+    if (nwrite < 0) {
+      return handle_error();
+    }
   }
 
   ngtcp2_conn_update_pkt_tx_time(conn_, ts);
@@ -1036,20 +1138,99 @@ std::expected<void, Error> Handler::write_streams() {
   }
 
   (void)send_packet(ps.path, pi.ecn, txbuf.first(static_cast<size_t>(nwrite)),
-                    gso_size);
+                    gso_size, 0);
 
   return {};
 }
 
+std::expected<bool, Error> Handler::write_batch(SendEntry &ent) {
+  send_scheduled_ = false;
+
+  if (ngtcp2_conn_in_closing_period2(conn_) ||
+      ngtcp2_conn_in_draining_period2(conn_) || tx_.send_blocked) {
+    return false;
+  }
+
+  ngtcp2_path_storage ps;
+  ngtcp2_pkt_info pi;
+  size_t gso_size;
+  ngtcp2_tstamp txtime = 0;
+  auto ts = util::timestamp();
+  auto txbuf = get_txbuf();
+  if (txbuf.empty()) {
+    return false;
+  }
+
+  auto buflen = util::clamp_buffer_size(conn_, txbuf.size(), config.gso_burst);
+
+  ngtcp2_path_storage_zero(&ps);
+
+  ngtcp2_ssize nwrite;
+
+  if (config.txtime_horizon) {
+    nwrite = ngtcp2_conn_write_aggregate_pkt_txtime(
+      conn_, &ps.path, &pi, txbuf.data(), buflen, &gso_size, &txtime,
+      ::write_pkt, config.gso_burst, config.txtime_horizon, ts);
+  } else {
+    nwrite = ngtcp2_conn_write_aggregate_pkt2(conn_, &ps.path, &pi,
+                                              txbuf.data(), buflen, &gso_size,
+                                              ::write_pkt, config.gso_burst, ts);
+    if (nwrite >= 0) {
+      ngtcp2_conn_update_pkt_tx_time(conn_, ts);
+    }
+  }
+
+  if (nwrite <= 0) {
+    put_txbuf();
+
+    if (nwrite < 0) {
+      auto rv = handle_error();
+
+      assert(!rv);
+
+      return std::unexpected{rv.error()};
+    }
+
+    return false;
+  }
+
+  ent = {
+    .handler = this,
+    .endpoint = static_cast<Endpoint *>(ps.path.user_data),
+    .ecn = pi.ecn,
+    .data = txbuf.first(static_cast<size_t>(nwrite)),
+    .gso_size = gso_size,
+    .txtime = txtime,
+    .no_gso = no_gso_,
+  };
+
+  ent.local_addr.set(ps.path.local.addr);
+  ent.remote_addr.set(ps.path.remote.addr);
+
+  return true;
+}
+
 std::expected<void, Error> Handler::send_packet(const ngtcp2_path &path,
                                                 unsigned int ecn,
                                                 std::span<const uint8_t> data,
-                                                size_t gso_size) {
+                                                size_t gso_size,
+                                                ngtcp2_tstamp txtime) {
   auto &ep = *static_cast<Endpoint *>(path.user_data);
+
+#ifdef HAVE_LIBURING
+  // data is written in txsb_.
+  assert(txsb_ && data.data() == txsb_->data.data());
+
+  server_->send_packet(ep, no_gso_, path.local, path.remote, ecn,
+                       std::exchange(txsb_, nullptr), data.size(), gso_size,
+                       txtime);
+
+  return {};
+#else  // !defined(HAVE_LIBURING)
   auto rest = server_->send_packet(ep, no_gso_, path.local, path.remote, ecn,
-                                   data, gso_size);
+                                   data, gso_size, txtime);
   if (!rest.empty()) {
-    on_send_blocked(path, ecn, rest, gso_size);
+    on_send_blocked(path, ecn, rest, gso_size, txtime);
 
     start_wev_endpoint(ep);
 
@@ -1057,10 +1238,12 @@ std::expected<void, Error> Handler::send_packet(const ngtcp2_path &path,
   }
 
   return {};
+#endif // !defined(HAVE_LIBURING)
 }
 
 void Handler::on_send_blocked(const ngtcp2_path &path, unsigned int ecn,
-                              std::span<const uint8_t> data, size_t gso_size) {
+                              std::span<const uint8_t> data, size_t gso_size,
+                              ngtcp2_tstamp txtime) {
   assert(!tx_.send_blocked);
   assert(gso_size);
 
@@ -1075,6 +1258,7 @@ void Handler::on_send_blocked(const ngtcp2_path &path, unsigned int ecn,
   p.ecn = ecn;
   p.data = data;
   p.gso_size = gso_size;
+  p.txtime = txtime;
 }
 
 void Handler::start_wev_endpoint(const Endpoint &ep) {
@@ -1098,7 +1282,7 @@ void Handler::send_blocked_packet() {
 
   auto rest = server_->send_packet(
     *p.endpoint, no_gso_, as_ngtcp2_addr(p.local_addr),
-    as_ngtcp2_addr(p.remote_addr), p.ecn, p.data, p.gso_size);
+    as_ngtcp2_addr(p.remote_addr), p.ecn, p.data, p.gso_size, p.txtime);
   if (!rest.empty()) {
     p.data = rest;
 
@@ -1110,7 +1294,21 @@ void Handler::send_blocked_packet() {
   tx_.send_blocked = false;
 }
 
-void Handler::signal_write() { ev_io_start(loop_, &wev_); }
+void Handler::signal_write() {
+  if (!config.batch_send) {
+    ev_io_start(loop_, &wev_);
+
+    return;
+  }
+
+  if (send_scheduled_) {
+    return;
+  }
+
+  send_scheduled_ = true;
+
+  server_->schedule_send(this);
+}
 
 void Handler::start_draining_period() {
   ev_io_stop(loop_, &wev_);
@@ -1344,6 +1542,221 @@ void sreadcb(struct ev_loop *loop, ev_io *w, int revents) {
 }
 } // namespace
 
+namespace {
+void send_preparecb(struct ev_loop *loop, ev_prepare *w, int revents) {
+  auto sendq = static_cast<SendCoordinator *>(w->data);
+
+  sendq->run();
+}
+} // namespace
+
+SendCoordinator::SendCoordinator(Server *server) : server_{server} {
+  ev_prepare_init(&prep_, send_preparecb);
+  prep_.data = this;
+  // Run before the other prepare watchers (e.g., the one which
+  // submits io_uring requests) so that they see the packets written
+  // here.
+  ev_set_priority(&prep_, EV_MAXPRI);
+}
+
+SendCoordinator::~SendCoordinator() {
+  if (loop_) {
+    ev_prepare_stop(loop_, &prep_);
+  }
+}
+
+void SendCoordinator::init(struct ev_loop *loop) {
+  loop_ = loop;
+
+#ifdef HAVE_SENDMMSG
+  msgs_.resize(config.send_batch);
+  iovs_.resize(config.send_batch);
+  ctrls_.resize(config.send_batch);
+#endif // defined(HAVE_SENDMMSG)
+}
+
+void SendCoordinator::schedule(Handler *h) {
+  queue_.push_back(h);
+
+  ev_prepare_start(loop_, &prep_);
+}
+
+void SendCoordinator::cancel(const Handler *h) {
+  std::erase(queue_, h);
+}
+
+void SendCoordinator::run() {
+  // In each round, every queued connection writes at most one train
+  // of packets.  The connections which wrote something are queued
+  // again after the batch is sent, and get their next turn after
+  // all the others had theirs.
+  for (; !queue_.empty();) {
+    for (auto n = queue_.size(); n; --n) {
+#ifdef HAVE_LIBURING
+      // The entries hold the SendBufs of io_uring until they are
+      // flushed.  Flush them before waiting for a free SendBuf, which
+      // would never come.
+      if (!entries_.empty() && !server_->has_free_send_buf()) {
+        flush();
+      }
+#endif // defined(HAVE_LIBURING)
+
+      auto h = queue_.front();
+      queue_.pop_front();
+
+      auto &ent = entries_.emplace_back();
+
+      auto rv = h->write_batch(ent);
+      if (!rv) {
+        entries_.pop_back();
+
+        if (rv.error() != Error::CLOSE_WAIT) {
+          server_->remove(h);
+        }
+
+        continue;
+      }
+
+      if (!*rv) {
+        entries_.pop_back();
+
+        h->update_timer();
+
+        continue;
+      }
+
+      if (debug::packet_lost(config.tx_loss_prob)) {
+        if (!config.quiet) {
+          std::println(stderr, "** Simulated outgoing packet loss **");
+        }
+
+        entries_.pop_back();
+
+        h->put_txbuf();
+      }
+
+      // The connection might have more to send.  It is queued behind
+      // the connections that have not written in this round.
+      h->signal_write();
+    }
+
+    if (entries_.empty()) {
+      continue;
+    }
+
+    flush();
+  }
+
+  ev_prepare_stop(loop_, &prep_);
+}
+
+void SendCoordinator::flush() {
+  // sendmmsg takes a single socket.  Group the entries by socket.
+  std::ranges::stable_sort(entries_, {},
+                           [](const auto &ent) { return ent.endpoint->fd; });
+
+  auto entries = std::span{entries_};
+
+#if defined(HAVE_SENDMMSG) && !defined(HAVE_LIBURING)
+  for (; !entries.empty();) {
+    auto fd = entries[0].endpoint->fd;
+    size_t n = 0;
+
+    for (; n < entries.size() && n < msgs_.size(); ++n) {
+      auto &ent = entries[n];
+
+      // The connection which cannot use GSO sends each packet in a
+      // separate datagram.  Leave it to send_entry.
+      if (ent.endpoint->fd != fd ||
+          (ent.no_gso && ent.data.size() > ent.gso_size)) {
+        break;
+      }
+
+      iovs_[n] = {
+        .iov_base = const_cast<uint8_t *>(ent.data.data()),
+        .iov_len = ent.data.size(),
+      };
+
+      auto &msg = msgs_[n].msg_hdr;
+
+      msg = {
+        .msg_name = ent.remote_addr.as_sockaddr(),
+        .msg_namelen = ent.remote_addr.size(),
+        .msg_iov = &iovs_[n],
+        .msg_iovlen = 1,
+        .msg_control = ctrls_[n].data(),
+      };
+
+      auto local_addr = as_ngtcp2_addr(ent.local_addr);
+
+      msghdr_set_send_cmsg(&msg, &local_addr, ent.local_addr.family(),
+                           ent.ecn,
+                           ent.data.size() > ent.gso_size ? ent.gso_size : 0,
+                           ent.txtime);
+    }
+
+    if (n == 0) {
+      send_entry(entries[0]);
+      entries = entries.subspan(1);
+
+      continue;
+    }
+
+    int nsent;
+
+    do {
+      nsent = sendmmsg(fd, msgs_.data(), static_cast<unsigned int>(n), 0);
+    } while (nsent == -1 && errno == EINTR);
+
+    if (nsent > 0) {
+      stats.add(static_cast<size_t>(nsent));
+
+      if (!config.quiet) {
+        for (auto &ent : entries.first(static_cast<size_t>(nsent))) {
+          std::println(
+            stderr, "Sent packet: local={} remote={} ecn={:#x} {} bytes",
+            util::straddr(ent.local_addr.as_sockaddr(), ent.local_addr.size()),
+            util::straddr(ent.remote_addr.as_sockaddr(),
+                          ent.remote_addr.size()),
+            ent.ecn, ent.data.size());
+        }
+      }
+
+      entries = entries.subspan(static_cast<size_t>(nsent));
+
+      if (static_cast<size_t>(nsent) == n) {
+        continue;
+      }
+    }
+
+    // Sending the first remaining entry failed.  Retry it alone to
+    // handle the error (e.g., the socket would block, or GSO is not
+    // supported).
+    send_entry(entries[0]);
+    entries = entries.subspan(1);
+  }
+#else  // !(defined(HAVE_SENDMMSG) && !defined(HAVE_LIBURING))
+  for (auto &ent : entries) {
+    send_entry(ent);
+  }
+#endif // !(defined(HAVE_SENDMMSG) && !defined(HAVE_LIBURING))
+
+  entries_.clear();
+}
+
+void SendCoordinator::send_entry(const SendEntry &ent) {
+  ngtcp2_path path{
+    .local = as_ngtcp2_addr(ent.local_addr),
+    .remote = as_ngtcp2_addr(ent.remote_addr),
+    .user_data = const_cast<Endpoint *>(ent.endpoint),
+  };
+
+  // If the socket would block, the rest of data stays in the buffer
+  // of the handler, and it is sent when the socket becomes writable.
+  (void)ent.handler->send_packet(path, ent.ecn, ent.data, ent.gso_size,
+                                 ent.txtime);
+}
+
 namespace {
 void siginthandler(struct ev_loop *loop, ev_signal *watcher, int revents) {
   ev_break(loop, EVBREAK_ALL);
@@ -1351,7 +1764,7 @@ void siginthandler(struct ev_loop *loop, ev_signal *watcher, int revents) {
 } // namespace
 
 Server::Server(struct ev_loop *loop, TLSServerContext &tls_ctx)
-  : loop_{loop}, tls_ctx_{tls_ctx} {
+  : loop_{loop}, tls_ctx_{tls_ctx}, rbatch_{config.recv_batch}, sendq_{this} {
   ev_signal_init(&sigintev_, siginthandler, SIGINT);
 
   ev_timer_init(
@@ -1365,9 +1778,36 @@ Server::Server(struct ev_loop *loop, TLSServerContext &tls_ctx)
   stateless_reset_regen_timer_.data = this;
 }
 
+Server::Server(struct ev_loop *loop, TLSServerContext &tls_ctx,
+               uint8_t worker_id)
+  : Server{loop, tls_ctx} {
+  worker_id_ = worker_id;
+
+  // Worker ID occupies 1 byte, and the rest is nonce.
+  if (ngtcp2_crypto_quic_lb_config_init(&quic_lb_, 0, 1,
+                                        NGTCP2_SV_SCIDLEN - 2,
+                                        config.quic_lb_key.data()) != 0) {
+    assert(0);
+    abort();
+  }
+
+  ev_async_init(&fwdev_, [](struct ev_loop *loop, ev_async *w, int revents) {
+    auto server = static_cast<Server *>(w->data);
+
+    server->on_forwarded();
+  });
+  fwdev_.data = this;
+
+  ev_async_init(&stopev_, [](struct ev_loop *loop, ev_async *w, int revents) {
+    ev_break(loop, EVBREAK_ALL);
+  });
+}
+
 Server::~Server() {
   disconnect();
   close();
+
+  ngtcp2_crypto_quic_lb_config_free(&quic_lb_);
 }
 
 void Server::disconnect() {
@@ -1378,7 +1818,13 @@ void Server::disconnect() {
   }
 
   ev_timer_stop(loop_, &stateless_reset_regen_timer_);
-  ev_signal_stop(loop_, &sigintev_);
+
+  if (workers_.empty()) {
+    ev_signal_stop(loop_, &sigintev_);
+  } else {
+    ev_async_stop(loop_, &fwdev_);
+    ev_async_stop(loop_, &stopev_);
+  }
 
   while (!handlers_.empty()) {
     auto it = std::ranges::begin(handlers_);
@@ -1391,6 +1837,19 @@ void Server::disconnect() {
 }
 
 void Server::close() {
+  if (config.show_stat) {
+    print_batch_stats("Receive", rbatch_.stats);
+    print_batch_stats("Send", send_stats_);
+
+    if (config.batch_send) {
+      print_batch_stats("Coordinated Send", sendq_.stats);
+    }
+  }
+
+#ifdef HAVE_LIBURING
+  uring_.close();
+#endif // defined(HAVE_LIBURING)
+
   for (auto &ep : endpoints_) {
     ::close(ep.fd);
   }
@@ -1455,11 +1914,25 @@ std::expected<int, Error> create_sock(Address &local_addr, const char *addr,
       continue;
     }
 
+#ifdef SO_REUSEPORT
+    if (config.workers &&
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &val,
+                   static_cast<socklen_t>(sizeof(val))) == -1) {
+      close(fd);
+      continue;
+    }
+#endif // defined(SO_REUSEPORT)
+
     fd_set_recv_ecn(fd, rp->ai_family);
     fd_set_ip_mtu_discover(fd, rp->ai_family);
     fd_set_ip_dontfrag(fd, family);
     fd_set_udp_gro(fd);
 
+    if (config.txtime_horizon && !fd_set_txtime(fd)) {
+      close(fd);
+      continue;
+    }
+
     if (bind(fd, rp->ai_addr, rp->ai_addrlen) != -1) {
       break;
     }
@@ -1549,11 +2022,28 @@ std::expected<void, Error> add_endpoint(std::vector<Endpoint> &endpoints,
     return std::unexpected{Error::SYSCALL};
   }
 
+#ifdef SO_REUSEPORT
+  if (config.workers &&
+      setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &val,
+                 static_cast<socklen_t>(sizeof(val))) == -1) {
+    std::println(stderr, "setsockopt: SO_REUSEPORT: {}", strerror(errno));
+    close(fd);
+    return std::unexpected{Error::SYSCALL};
+  }
+#endif // defined(SO_REUSEPORT)
+
   fd_set_recv_ecn(fd, family);
   fd_set_ip_mtu_discover(fd, family);
   fd_set_ip_dontfrag(fd, family);
   fd_set_udp_gro(fd);
 
+  if (config.txtime_horizon) {
+    if (auto rv = fd_set_txtime(fd); !rv) {
+      close(fd);
+      return rv;
+    }
+  }
+
   if (bind(fd, addr.as_sockaddr(), addr.size()) == -1) {
     std::println(stderr, "bind: {}", strerror(errno));
     close(fd);
@@ -1607,40 +2097,43 @@ std::expected<void, Error> Server::init(const char *addr, const char *port) {
     }
   }
 
+#ifdef HAVE_LIBURING
+  if (auto rv = uring_.init(loop_, this); !rv) {
+    return rv;
+  }
+#endif // defined(HAVE_LIBURING)
+
+  sendq_.init(loop_);
+
   for (auto &ep : endpoints_) {
     ep.server = this;
+
+#ifdef HAVE_LIBURING
+    if (auto rv = uring_.start_recv(ep); !rv) {
+      return rv;
+    }
+#else  // !defined(HAVE_LIBURING)
     ep.rev.data = &ep;
 
     ev_io_set(&ep.rev, ep.fd, EV_READ);
 
     ev_io_start(loop_, &ep.rev);
+#endif // !defined(HAVE_LIBURING)
   }
 
-  ev_signal_start(loop_, &sigintev_);
+  if (workers_.empty()) {
+    ev_signal_start(loop_, &sigintev_);
+  } else {
+    // The main thread handles signals, and stops workers.
+    ev_async_start(loop_, &fwdev_);
+    ev_async_start(loop_, &stopev_);
+  }
 
   return {};
 }
 
 void Server::on_read(const Endpoint &ep) {
-  sockaddr_storage ss;
-  std::array<uint8_t, 64_k> buf;
   size_t pktcnt = 0;
-  ngtcp2_pkt_info pi;
-
-  iovec msg_iov{
-    .iov_base = buf.data(),
-    .iov_len = buf.size(),
-  };
-
-  uint8_t msg_ctrl[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(in6_pktinfo)) +
-                   CMSG_SPACE(sizeof(int))];
-
-  msghdr msg{
-    .msg_name = &ss,
-    .msg_iov = &msg_iov,
-    .msg_iovlen = 1,
-    .msg_control = msg_ctrl,
-  };
 
   auto start = util::timestamp();
 
@@ -1650,80 +2143,84 @@ void Server::on_read(const Endpoint &ep) {
       return;
     }
 
-    msg.msg_namelen = sizeof(ss);
-    msg.msg_controllen = sizeof(msg_ctrl);
-
-    auto nread = recvmsg(ep.fd, &msg, 0);
-    if (nread == -1) {
+    auto nmsg = rbatch_.recv(ep.fd, MAX_RECV_PKTS - pktcnt);
+    if (nmsg == -1) {
       if (!(errno == EAGAIN || errno == ENOTCONN)) {
-        std::println(stderr, "recvmsg: {}", strerror(errno));
+        std::println(stderr, "recvmmsg: {}", strerror(errno));
       }
       return;
     }
 
-    // Packets less than 21 bytes never be a valid QUIC packet.
-    if (nread < 21) {
-      ++pktcnt;
-
-      continue;
+    for (size_t i = 0; i < static_cast<size_t>(nmsg); ++i) {
+      pktcnt += read_dgram(ep, rbatch_.msg(i), rbatch_.data(i));
     }
+  }
+}
 
-    Address remote_addr;
-    remote_addr.set(reinterpret_cast<const sockaddr *>(&ss));
+size_t Server::read_dgram(const Endpoint &ep, msghdr *msg,
+                          std::span<const uint8_t> data) {
+  ngtcp2_pkt_info pi;
 
-    if (util::prohibited_port(remote_addr.port())) {
-      ++pktcnt;
+  // Packets less than 21 bytes never be a valid QUIC packet.
+  if (data.size() < 21) {
+    return 1;
+  }
 
-      continue;
-    }
+  auto sa = static_cast<const sockaddr *>(msg->msg_name);
 
-    pi.ecn = msghdr_get_ecn(&msg, ss.ss_family);
-    auto local_addr = msghdr_get_local_addr(&msg, ss.ss_family);
-    if (!local_addr) {
-      ++pktcnt;
-      std::println(stderr, "Unable to obtain local address");
-      continue;
-    }
+  Address remote_addr;
+  remote_addr.set(sa);
 
-    auto gso_size = msghdr_get_udp_gro(&msg);
-    if (gso_size == 0) {
-      gso_size = static_cast<size_t>(nread);
-    }
+  if (util::prohibited_port(remote_addr.port())) {
+    return 1;
+  }
 
-    local_addr->port(ep.addr.port());
+  pi.ecn = msghdr_get_ecn(msg, sa->sa_family);
+  auto local_addr = msghdr_get_local_addr(msg, sa->sa_family);
+  if (!local_addr) {
+    std::println(stderr, "Unable to obtain local address");
+    return 1;
+  }
 
-    auto data = std::span{buf.data(), static_cast<size_t>(nread)};
+  auto gso_size = msghdr_get_udp_gro(msg);
+  if (gso_size == 0) {
+    gso_size = data.size();
+  }
 
-    for (; !data.empty();) {
-      auto datalen = std::min(data.size(), gso_size);
+  local_addr->port(ep.addr.port());
 
-      ++pktcnt;
+  size_t pktcnt = 0;
 
-      if (!config.quiet) {
-        std::array<char, IF_NAMESIZE> ifname;
-        std::println(
-          stderr,
-          "Received packet: local={} remote={} if={} ecn={:#x} {} bytes",
-          util::straddr(*local_addr), util::straddr(remote_addr),
-          if_indextoname(local_addr->ifindex, ifname.data()), pi.ecn, datalen);
-      }
+  for (; !data.empty();) {
+    auto datalen = std::min(data.size(), gso_size);
 
-      // Packets less than 21 bytes never be a valid QUIC packet.
-      if (datalen < 21) {
-        break;
-      }
+    ++pktcnt;
 
-      if (debug::packet_lost(config.rx_loss_prob)) {
-        if (!config.quiet) {
-          std::println(stderr, "** Simulated incoming packet loss **");
-        }
-      } else {
-        read_pkt(ep, *local_addr, remote_addr, &pi, {data.data(), datalen});
-      }
+    if (!config.quiet) {
+      std::array<char, IF_NAMESIZE> ifname;
+      std::println(
+        stderr, "Received packet: local={} remote={} if={} ecn={:#x} {} bytes",
+        util::straddr(*local_addr), util::straddr(remote_addr),
+        if_indextoname(local_addr->ifindex, ifname.data()), pi.ecn, datalen);
+    }
+
+    // Packets less than 21 bytes never be a valid QUIC packet.
+    if (datalen < 21) {
+      break;
+    }
 
-      data = data.subspan(datalen);
+    if (debug::packet_lost(config.rx_loss_prob)) {
+      if (!config.quiet) {
+        std::println(stderr, "** Simulated incoming packet loss **");
+      }
+    } else {
+      read_pkt(ep, *local_addr, remote_addr, &pi, {data.data(), datalen});
     }
+
+    data = data.subspan(datalen);
   }
+
+  return pktcnt;
 }
 
 void Server::read_pkt(const Endpoint &ep, const Address &local_addr,
@@ -1753,6 +2250,24 @@ void Server::read_pkt(const Endpoint &ep, const Address &local_addr,
     return;
   }
 
+  // Packets which initiate a connection are routed by the kernel, and
+  // the connection stays on the same worker as long as its 4-tuple
+  // does not change.  Short header packets may arrive at a different
+  // worker after migration or NAT rebinding, and they are routed by
+  // the worker ID encoded in Connection ID.
+  if (!workers_.empty() && !(data[0] & 0x80) &&
+      vc.dcidlen == NGTCP2_SV_SCIDLEN) {
+    uint8_t worker_id;
+
+    if (ngtcp2_crypto_quic_lb_decode_cid(&quic_lb_, &worker_id, nullptr,
+                                         vc.dcid, vc.dcidlen) == 0 &&
+        worker_id != worker_id_ && worker_id < workers_.size()) {
+      forward(worker_id, ep, local_addr, remote_addr, pi, data);
+
+      return;
+    }
+  }
+
   auto dcid_key = util::make_cid_key({vc.dcid, vc.dcidlen});
 
   auto handler_it = handlers_.find(dcid_key);
@@ -2198,7 +2713,7 @@ std::expected<void, Error> Server::send_packet(const Endpoint &ep,
                                                std::span<const uint8_t> data) {
   auto no_gso = false;
   auto rest =
-    send_packet(ep, no_gso, local_addr, remote_addr, ecn, data, data.size());
+    send_packet(ep, no_gso, local_addr, remote_addr, ecn, data, data.size(), 0);
   if (!rest.empty()) {
     return std::unexpected{Error::SEND_BLOCKED};
   }
@@ -2211,7 +2726,8 @@ std::span<const uint8_t> Server::send_packet(const Endpoint &ep, bool &no_gso,
                                              const ngtcp2_addr &remote_addr,
                                              unsigned int ecn,
                                              std::span<const uint8_t> data,
-                                             size_t gso_size) {
+                                             size_t gso_size,
+                                             ngtcp2_tstamp txtime) {
   assert(gso_size);
 
   if (debug::packet_lost(config.tx_loss_prob)) {
@@ -2221,31 +2737,25 @@ std::span<const uint8_t> Server::send_packet(const Endpoint &ep, bool &no_gso,
     return {};
   }
 
-  if (no_gso && data.size() > gso_size) {
-    for (; !data.empty();) {
-      auto len = std::min(gso_size, data.size());
-
-      auto rest = send_packet(ep, no_gso, local_addr, remote_addr, ecn,
-                              data.first(len), len);
-      if (!rest.empty()) {
-        assert(rest.size() == len);
+#ifdef HAVE_LIBURING
+  uring_.send(ep, no_gso, local_addr, remote_addr, ecn, data, gso_size,
+              txtime);
 
-        return data;
-      }
-
-      data = data.subspan(len);
-    }
-
-    return {};
+  if (!config.quiet) {
+    std::println(stderr, "Queued packet: local={} remote={} ecn={:#x} {} bytes",
+                 util::straddr(local_addr.addr, local_addr.addrlen),
+                 util::straddr(remote_addr.addr, remote_addr.addrlen), ecn,
+                 data.size());
   }
 
+  return {};
+#else  // !defined(HAVE_LIBURING)
   iovec msg_iov{
     .iov_base = const_cast<uint8_t *>(data.data()),
     .iov_len = data.size(),
   };
 
-  uint8_t msg_ctrl[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(uint16_t)) +
-                   CMSG_SPACE(sizeof(in6_pktinfo))]{};
+  uint8_t msg_ctrl[SEND_CMSG_SPACE];
 
   msghdr msg{
     .msg_name = const_cast<sockaddr *>(remote_addr.addr),
@@ -2253,90 +2763,40 @@ std::span<const uint8_t> Server::send_packet(const Endpoint &ep, bool &no_gso,
     .msg_iov = &msg_iov,
     .msg_iovlen = 1,
     .msg_control = msg_ctrl,
-    .msg_controllen = sizeof(msg_ctrl),
   };
 
-  size_t controllen = 0;
-
-  auto cm = CMSG_FIRSTHDR(&msg);
-
-  switch (local_addr.addr->sa_family) {
-  case AF_INET: {
-    controllen += CMSG_SPACE(sizeof(in_pktinfo));
-    cm->cmsg_level = IPPROTO_IP;
-    cm->cmsg_type = IP_PKTINFO;
-    cm->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
-    auto addrin = reinterpret_cast<sockaddr_in *>(local_addr.addr);
-    in_pktinfo pktinfo{
-      .ipi_spec_dst = addrin->sin_addr,
-    };
-    memcpy(CMSG_DATA(cm), &pktinfo, sizeof(pktinfo));
-
-    break;
-  }
-  case AF_INET6: {
-    controllen += CMSG_SPACE(sizeof(in6_pktinfo));
-    cm->cmsg_level = IPPROTO_IPV6;
-    cm->cmsg_type = IPV6_PKTINFO;
-    cm->cmsg_len = CMSG_LEN(sizeof(in6_pktinfo));
-    auto addrin = reinterpret_cast<sockaddr_in6 *>(local_addr.addr);
-    in6_pktinfo pktinfo{
-      .ipi6_addr = addrin->sin6_addr,
-    };
-    memcpy(CMSG_DATA(cm), &pktinfo, sizeof(pktinfo));
+  msghdr_set_send_cmsg(&msg, &local_addr, local_addr.addr->sa_family, ecn,
+                       !no_gso && data.size() > gso_size ? gso_size : 0,
+                       txtime);
 
-    break;
-  }
-  default:
-    assert(0);
-  }
-
-#ifdef UDP_SEGMENT
-  if (data.size() > gso_size) {
-    controllen += CMSG_SPACE(sizeof(uint16_t));
-    cm = CMSG_NXTHDR(&msg, cm);
-    cm->cmsg_level = SOL_UDP;
-    cm->cmsg_type = UDP_SEGMENT;
-    cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
-    auto n = static_cast<uint16_t>(gso_size);
-    memcpy(CMSG_DATA(cm), &n, sizeof(n));
-  }
-#endif // defined(UDP_SEGMENT)
+  ssize_t nwrite = 0;
 
-  controllen += CMSG_SPACE(sizeof(int));
-  cm = CMSG_NXTHDR(&msg, cm);
-  cm->cmsg_len = CMSG_LEN(sizeof(int));
-  memcpy(CMSG_DATA(cm), &ecn, sizeof(ecn));
+  if (no_gso && data.size() > gso_size) {
+    nwrite = send_segments(ep.fd, msg, data, gso_size, config.send_batch,
+                           send_stats_);
+    if (nwrite != -1 && static_cast<size_t>(nwrite) < data.size()) {
+      switch (errno) {
+      case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+      case EWOULDBLOCK:
+#endif // EAGAIN != EWOULDBLOCK
+        return data.subspan(static_cast<size_t>(nwrite));
+      }
 
-  switch (local_addr.addr->sa_family) {
-  case AF_INET:
-    cm->cmsg_level = IPPROTO_IP;
-    cm->cmsg_type = IP_TOS;
+      std::println(stderr, "sendmmsg: {}", strerror(errno));
 
-    break;
-  case AF_INET6:
-    cm->cmsg_level = IPPROTO_IPV6;
-    cm->cmsg_type = IPV6_TCLASS;
+      return {};
+    }
+  } else {
+    do {
+      nwrite = sendmsg(ep.fd, &msg, 0);
+    } while (nwrite == -1 && errno == EINTR);
 
-    break;
-  default:
-    assert(0);
+    if (nwrite != -1) {
+      send_stats_.add(1);
+    }
   }
 
-  msg.msg_controllen =
-#ifndef __APPLE__
-    controllen
-#else  // defined(__APPLE__)
-    static_cast<socklen_t>(controllen)
-#endif // defined(__APPLE__)
-    ;
-
-  ssize_t nwrite = 0;
-
-  do {
-    nwrite = sendmsg(ep.fd, &msg, 0);
-  } while (nwrite == -1 && errno == EINTR);
-
   if (nwrite == -1) {
     switch (errno) {
     case EAGAIN:
@@ -2354,7 +2814,7 @@ std::span<const uint8_t> Server::send_packet(const Endpoint &ep, bool &no_gso,
         no_gso = true;
 
         return send_packet(ep, no_gso, local_addr, remote_addr, ecn, data,
-                           gso_size);
+                           gso_size, txtime);
       }
       break;
 #endif // defined(UDP_SEGMENT)
@@ -2374,6 +2834,7 @@ std::span<const uint8_t> Server::send_packet(const Endpoint &ep, bool &no_gso,
   }
 
   return {};
+#endif // !defined(HAVE_LIBURING)
 }
 
 void Server::associate_cid(const ngtcp2_cid *cid, Handler *h) {
@@ -2382,6 +2843,42 @@ void Server::associate_cid(const ngtcp2_cid *cid, Handler *h) {
 
 void Server::dissociate_cid(const ngtcp2_cid *cid) { handlers_.erase(*cid); }
 
+#ifdef HAVE_LIBURING
+URing::SendBuf *Server::get_send_buf() { return uring_.get_send_buf(); }
+
+void Server::put_send_buf(URing::SendBuf *sb) { uring_.put_send_buf(sb); }
+
+bool Server::has_free_send_buf() const { return uring_.has_free_send_buf(); }
+
+void Server::send_packet(const Endpoint &ep, bool no_gso,
+                         const ngtcp2_addr &local_addr,
+                         const ngtcp2_addr &remote_addr, unsigned int ecn,
+                         URing::SendBuf *sb, size_t datalen, size_t gso_size,
+                         ngtcp2_tstamp txtime) {
+  assert(gso_size);
+
+  if (debug::packet_lost(config.tx_loss_prob)) {
+    if (!config.quiet) {
+      std::println(stderr, "** Simulated outgoing packet loss **");
+    }
+
+    uring_.put_send_buf(sb);
+
+    return;
+  }
+
+  uring_.send(ep, no_gso, local_addr, remote_addr, ecn, sb, datalen, gso_size,
+              txtime);
+
+  if (!config.quiet) {
+    std::println(stderr, "Queued packet: local={} remote={} ecn={:#x} {} bytes",
+                 util::straddr(local_addr.addr, local_addr.addrlen),
+                 util::straddr(remote_addr.addr, remote_addr.addrlen), ecn,
+                 datalen);
+  }
+}
+#endif // defined(HAVE_LIBURING)
+
 void Server::remove(const Handler *h) {
   auto conn = h->conn();
 
@@ -2397,6 +2894,128 @@ void Server::remove(const Handler *h) {
   delete h;
 }
 
+void Server::schedule_send(Handler *h) { sendq_.schedule(h); }
+
+void Server::cancel_send(const Handler *h) { sendq_.cancel(h); }
+
+std::expected<void, Error> Server::generate_cid(ngtcp2_cid &cid) {
+  if (workers_.empty()) {
+    cid.datalen = NGTCP2_SV_SCIDLEN;
+
+    return util::generate_secure_random({cid.data, cid.datalen});
+  }
+
+  std::array<uint8_t, NGTCP2_SV_SCIDLEN - 2> nonce;
+
+  if (auto rv = util::generate_secure_random(nonce); !rv) {
+    return rv;
+  }
+
+  if (ngtcp2_crypto_quic_lb_generate_cid(&quic_lb_, &cid, &worker_id_,
+                                         nonce.data()) != 0) {
+    return std::unexpected{Error::CRYPTO};
+  }
+
+  return {};
+}
+
+void Server::set_workers(std::span<Server *const> workers) {
+  workers_ = workers;
+}
+
+void Server::forward(uint8_t worker_id, const Endpoint &ep,
+                     const Address &local_addr, const Address &remote_addr,
+                     const ngtcp2_pkt_info *pi,
+                     std::span<const uint8_t> data) {
+  auto pkt = std::make_unique<ForwardedPacket>();
+  pkt->endpoint_index = as_unsigned(&ep - endpoints_.data());
+  pkt->local_addr = local_addr;
+  pkt->remote_addr = remote_addr;
+  pkt->pi = *pi;
+  pkt->data.assign(std::ranges::begin(data), std::ranges::end(data));
+
+  auto target = workers_[worker_id];
+
+  target->fwdq_.push(std::move(pkt));
+
+  ev_async_send(target->loop_, &target->fwdev_);
+}
+
+void Server::on_forwarded() {
+  for (;;) {
+    auto pkt = fwdq_.pop();
+    if (!pkt) {
+      return;
+    }
+
+    assert(pkt->endpoint_index < endpoints_.size());
+
+    read_pkt(endpoints_[pkt->endpoint_index], pkt->local_addr,
+             pkt->remote_addr, &pkt->pi, pkt->data);
+  }
+}
+
+void Server::stop() { ev_async_send(loop_, &stopev_); }
+
+PacketQueue::PacketQueue() : head_{&stub_}, tail_{&stub_} {
+  stub_.next.store(nullptr, std::memory_order_relaxed);
+}
+
+PacketQueue::~PacketQueue() {
+  while (pop())
+    ;
+}
+
+void PacketQueue::push(std::unique_ptr<ForwardedPacket> pkt) {
+  push(pkt.release());
+}
+
+void PacketQueue::push(ForwardedPacket *pkt) {
+  pkt->next.store(nullptr, std::memory_order_relaxed);
+
+  auto prev = head_.exchange(pkt, std::memory_order_acq_rel);
+
+  prev->next.store(pkt, std::memory_order_release);
+}
+
+std::unique_ptr<ForwardedPacket> PacketQueue::pop() {
+  auto tail = tail_;
+  auto next = tail->next.load(std::memory_order_acquire);
+
+  if (tail == &stub_) {
+    if (!next) {
+      return {};
+    }
+
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if (next) {
+    tail_ = next;
+
+    return std::unique_ptr<ForwardedPacket>{tail};
+  }
+
+  if (tail != head_.load(std::memory_order_acquire)) {
+    // A producer is in the middle of push.  The packet will be
+    // picked up on the next wakeup.
+    return {};
+  }
+
+  push(&stub_);
+
+  next = tail->next.load(std::memory_order_acquire);
+  if (next) {
+    tail_ = next;
+
+    return std::unique_ptr<ForwardedPacket>{tail};
+  }
+
+  return {};
+}
+
 void Server::on_stateless_reset_regen() {
   assert(stateless_reset_bucket_ < NGTCP2_STATELESS_RESET_BURST);
 
@@ -2663,6 +3282,38 @@ Options:
               to send  per an event  loop in a single  connection.  It
               defaults  to 0,  which means  it is  not limited  by the
               configuration.
+  --workers=<N>
+              Run <N>  worker threads,  each of which has  its own event
+              loop  and   sockets  bound  with  SO_REUSEPORT.   A  new
+              connection is  assigned to a worker  by kernel hashing,
+              and the worker ID is encoded in Connection IDs so that a
+              packet which arrives at a different worker is forwarded
+              to the owner.   It defaults to 0, which  means that the
+              server runs in the main thread.
+  --recv-batch=<N>
+              The maximum number of UDP datagrams to receive in a single
+              recvmmsg call.  It is  ignored if recvmmsg is unavailable.
+              It must be in range [1, 1024], inclusive.
+              Default: )"
+            << config.recv_batch << R"(
+  --send-batch=<N>
+              The maximum  number of UDP  datagrams to send in  a single
+              sendmmsg  call when  GSO  is disabled  or unavailable.  It
+              must be in range [1, 1024], inclusive.
+              Default: )"
+            << config.send_batch << R"(
+  --txtime-horizon=<DURATION>
+              Let the kernel pace outgoing packets with SO_TXTIME.  The
+              server  writes packets  up to  <DURATION> ahead  of their
+              departure time, and  passes the departure time  to the
+              kernel.  It requires a qdisc that honors SO_TXTIME (e.g.,
+              fq).  It  defaults to 0,  which disables the  feature.
+  --batch-send
+              Let  the  connections  that have  packets to  send  write
+              them at the end of each event loop iteration, and send
+              them  together  in   a  single  sendmmsg  call.   Each
+              connection writes at most its send quantum per turn, and
+              takes turns in round-robin order.
   -h, --help  Display this help and exit.
 
 ---
@@ -2684,6 +3335,75 @@ Options:
 
 std::ofstream keylog_file;
 
+namespace {
+std::expected<void, Error> run_workers(const char *addr, const char *port,
+                                       TLSServerContext &tls_ctx) {
+  std::vector<struct ev_loop *> loops;
+
+  auto loops_d = defer([&loops] {
+    for (auto loop : loops) {
+      ev_loop_destroy(loop);
+    }
+  });
+
+  std::vector<Server *> workers;
+  // servers must be destroyed before loops.
+  std::vector<std::unique_ptr<Server>> servers;
+
+  for (size_t i = 0; i < config.workers; ++i) {
+    auto loop = ev_loop_new(EVFLAG_AUTO);
+    if (!loop) {
+      std::println(stderr, "Could not create event loop");
+      return std::unexpected{Error::INTERNAL};
+    }
+
+    loops.push_back(loop);
+    servers.push_back(
+      std::make_unique<Server>(loop, tls_ctx, static_cast<uint8_t>(i)));
+    workers.push_back(servers.back().get());
+  }
+
+  for (auto &s : servers) {
+    s->set_workers(workers);
+
+    if (auto rv = s->init(addr, port); !rv) {
+      return rv;
+    }
+  }
+
+  std::vector<std::thread> threads;
+
+  for (auto loop : loops) {
+    threads.emplace_back([loop] { ev_run(loop, 0); });
+  }
+
+  ev_signal sigintev;
+  ev_signal_init(&sigintev, siginthandler, SIGINT);
+  ev_signal_start(EV_DEFAULT, &sigintev);
+
+  ev_run(EV_DEFAULT, 0);
+
+  ev_signal_stop(EV_DEFAULT, &sigintev);
+
+  for (auto &s : servers) {
+    s->stop();
+  }
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  for (auto &s : servers) {
+    s->disconnect();
+    s->close();
+  }
+
+  servers.clear();
+
+  return {};
+}
+} // namespace
+
 int main(int argc, char **argv) {
   if (argc) {
     prog = basename(argv[0]);
@@ -2737,6 +3457,11 @@ int main(int argc, char **argv) {
       {"no-gso", no_argument, &flag, 35},
       {"show-stat", no_argument, &flag, 36},
       {"gso-burst", required_argument, &flag, 37},
+      {"workers", required_argument, &flag, 38},
+      {"recv-batch", required_argument, &flag, 39},
+      {"send-batch", required_argument, &flag, 40},
+      {"txtime-horizon", required_argument, &flag, 41},
+      {"batch-send", no_argument, &flag, 42},
       {},
     };
 
@@ -3168,6 +3893,80 @@ int main(int argc, char **argv) {
 
         break;
       }
+      case 38: {
+        // --workers
+        auto n = util::parse_uint(optarg);
+        if (!n) {
+          std::println(stderr, "workers: invalid argument");
+          exit(EXIT_FAILURE);
+        }
+
+        if (*n > 255) {
+          std::println(stderr,
+                       "workers: must be in range [0, 255], inclusive.");
+          exit(EXIT_FAILURE);
+        }
+
+#ifndef SO_REUSEPORT
+        if (*n) {
+          std::println(stderr, "workers: SO_REUSEPORT is not available");
+          exit(EXIT_FAILURE);
+        }
+#endif // !defined(SO_REUSEPORT)
+
+        config.workers = static_cast<size_t>(*n);
+
+        break;
+      }
+      case 39: {
+        // --recv-batch
+        auto n = util::parse_uint(optarg);
+        if (!n) {
+          std::println(stderr, "recv-batch: invalid argument");
+          exit(EXIT_FAILURE);
+        }
+
+        if (*n < 1 || *n > 1024) {
+          std::println(stderr,
+                       "recv-batch: must be in range [1, 1024], inclusive.");
+          exit(EXIT_FAILURE);
+        }
+
+        config.recv_batch = static_cast<size_t>(*n);
+
+        break;
+      }
+      case 40: {
+        // --send-batch
+        auto n = util::parse_uint(optarg);
+        if (!n) {
+          std::println(stderr, "send-batch: invalid argument");
+          exit(EXIT_FAILURE);
+        }
+
+        if (*n < 1 || *n > 1024) {
+          std::println(stderr,
+                       "send-batch: must be in range [1, 1024], inclusive.");
+          exit(EXIT_FAILURE);
+        }
+
+        config.send_batch = static_cast<size_t>(*n);
+
+        break;
+      }
+      case 41:
+        // --txtime-horizon
+        if (auto t = util::parse_duration(optarg); !t) {
+          std::println(stderr, "txtime-horizon: invalid argument");
+          exit(EXIT_FAILURE);
+        } else {
+          config.txtime_horizon = *t;
+        }
+        break;
+      case 42:
+        // --batch-send
+        config.batch_send = true;
+        break;
       }
       break;
     default:
@@ -3226,7 +4025,9 @@ int main(int argc, char **argv) {
   auto ev_loop_d = defer([] { ev_loop_destroy(EV_DEFAULT); });
 
   auto keylog_filename = getenv("SSLKEYLOGFILE");
-  if (keylog_filename) {
+  if (keylog_filename && config.workers) {
+    std::println(stderr, "SSLKEYLOGFILE is ignored with --workers");
+  } else if (keylog_filename) {
     keylog_file.open(keylog_filename, std::ios_base::app);
     if (keylog_file) {
       tls_ctx.enable_keylog();
@@ -3238,6 +4039,19 @@ int main(int argc, char **argv) {
     exit(EXIT_FAILURE);
   }
 
+  if (config.workers) {
+    if (!util::generate_secure_random(config.quic_lb_key)) {
+      std::println(stderr, "Unable to generate QUIC-LB key");
+      exit(EXIT_FAILURE);
+    }
+
+    if (!run_workers(addr, port, tls_ctx)) {
+      exit(EXIT_FAILURE);
+    }
+
+    return EXIT_SUCCESS;
+  }
+
   Server s(EV_DEFAULT, tls_ctx);
   if (!s.init(addr, port)) {
     exit(EXIT_FAILURE);
@@ -37,6 +37,7 @@
 #include <memory>
 #include <span>
 #include <optional>
+#include <atomic>
 
 #include <ngtcp2/ngtcp2.h>
 #include <ngtcp2/ngtcp2_crypto.h>
@@ -48,6 +49,7 @@
 #include "network.h"
 #include "shared.h"
 #include "util.h"
+#include "uring.h"
 
 #ifdef WITH_EXAMPLE_HTTP3_PROTO_CODEC
 #  include "http3_server_proto_codec.h"
@@ -133,6 +135,22 @@ struct Endpoint {
   int fd{};
 };
 
+// SendEntry is a train of packets written by a connection, which is
+// sent by SendCoordinator.
+struct SendEntry {
+  Handler *handler;
+  const Endpoint *endpoint;
+  Address local_addr;
+  Address remote_addr;
+  unsigned int ecn;
+  // data points to the buffer owned by handler.  With io_uring, it is
+  // the SendBuf which handler holds until it is sent.
+  std::span<const uint8_t> data;
+  size_t gso_size;
+  ngtcp2_tstamp txtime;
+  bool no_gso;
+};
+
 class Handler : public HandlerBase {
 public:
   Handler(struct ev_loop *loop, Server *server);
@@ -152,6 +170,12 @@ public:
                                      std::span<const uint8_t> data);
   std::expected<void, Error> on_write();
   std::expected<void, Error> write_streams();
+  // write_batch writes packets up to the send quantum on behalf of
+  // SendCoordinator, and fills |ent|.  It returns false if there is
+  // nothing to send.  It must be called after this object is taken
+  // out of the queue of SendCoordinator, and it can be queued again
+  // by signal_write.
+  std::expected<bool, Error> write_batch(SendEntry &ent);
   std::expected<void, Error> feed_data(const Endpoint &ep,
                                        const Address &local_addr,
                                        const Address &remote_addr,
@@ -200,16 +224,23 @@ public:
   void write_qlog(const void *data, size_t datalen);
 
   void on_send_blocked(const ngtcp2_path &path, unsigned int ecn,
-                       std::span<const uint8_t> data, size_t gso_size);
+                       std::span<const uint8_t> data, size_t gso_size,
+                       ngtcp2_tstamp txtime);
   void start_wev_endpoint(const Endpoint &ep);
   std::expected<void, Error> send_packet(const ngtcp2_path &path,
                                          unsigned int ecn,
                                          std::span<const uint8_t> data,
-                                         size_t gso_size);
+                                         size_t gso_size, ngtcp2_tstamp txtime);
   void send_blocked_packet();
 
   ngtcp2_ssize write_pkt(ngtcp2_path *path, ngtcp2_pkt_info *pi, uint8_t *dest,
                          size_t destlen, ngtcp2_tstamp ts);
+  // get_txbuf returns the buffer to write packets into.  It returns
+  // an empty span if no buffer is available.
+  std::span<uint8_t> get_txbuf();
+  // put_txbuf releases the buffer returned by get_txbuf if the
+  // packets written into it are not sent.
+  void put_txbuf();
 
   std::expected<void, Error> on_app_tx_ready();
 
@@ -231,6 +262,9 @@ private:
   // nkey_update_ is the number of key update occurred.
   size_t nkey_update_{};
   bool no_gso_;
+  // send_scheduled_ is true if this object is queued in
+  // SendCoordinator.
+  bool send_scheduled_{};
   struct {
     size_t bytes_recv;
     size_t bytes_sent;
@@ -248,14 +282,99 @@ private:
       unsigned int ecn;
       std::span<const uint8_t> data;
       size_t gso_size;
+      ngtcp2_tstamp txtime;
     } blocked;
   } tx_{};
+#ifdef HAVE_LIBURING
+  // txsb_ is the SendBuf of io_uring which packets are written into.
+  // It is handed over to io_uring when the packets are sent.
+  URing::SendBuf *txsb_{};
+#else  // !defined(HAVE_LIBURING)
   std::array<uint8_t, 64_k> txbuf_;
+#endif // !defined(HAVE_LIBURING)
+};
+
+// ForwardedPacket is a packet which is received by a worker, and
+// forwarded to the worker that owns the connection.
+struct ForwardedPacket {
+  std::atomic<ForwardedPacket *> next;
+  // endpoint_index is the index of Endpoint which received the
+  // packet.  All workers create the same set of endpoints in the same
+  // order.
+  size_t endpoint_index;
+  Address local_addr;
+  Address remote_addr;
+  ngtcp2_pkt_info pi;
+  std::vector<uint8_t> data;
+};
+
+// PacketQueue is a lock-free multi-producer single-consumer queue of
+// ForwardedPacket.  push can be called from any thread, and pop must
+// only be called from the thread that owns the queue.
+class PacketQueue {
+public:
+  PacketQueue();
+  ~PacketQueue();
+
+  void push(std::unique_ptr<ForwardedPacket> pkt);
+  std::unique_ptr<ForwardedPacket> pop();
+
+private:
+  void push(ForwardedPacket *pkt);
+
+  std::atomic<ForwardedPacket *> head_;
+  ForwardedPacket *tail_;
+  ForwardedPacket stub_;
+};
+
+// SendCoordinator lets the connections that have packets to send
+// write them in the same event loop iteration, and sends them in a
+// single sendmmsg call, one GSO train per connection.  The
+// connections take turns in round-robin order, each writing at most
+// its send quantum per round, so that a bulk flow cannot starve the
+// others.
+class SendCoordinator {
+public:
+  explicit SendCoordinator(Server *server);
+  ~SendCoordinator();
+
+  void init(struct ev_loop *loop);
+  // schedule queues |h| to write packets at the end of the current
+  // event loop iteration.  |h| must not be queued already.
+  void schedule(Handler *h);
+  // cancel removes |h| from the queue.
+  void cancel(const Handler *h);
+  // run lets the queued connections write packets, and sends them.
+  void run();
+
+  BatchStats stats;
+
+private:
+  // flush sends the packets in entries_.
+  void flush();
+  // send_entry sends |ent| in its own system call.  It also handles
+  // the failure of sending |ent| in batch.
+  void send_entry(const SendEntry &ent);
+
+  Server *server_;
+  struct ev_loop *loop_{};
+  ev_prepare prep_;
+  std::deque<Handler *> queue_;
+  std::vector<SendEntry> entries_;
+#ifdef HAVE_SENDMMSG
+  std::vector<mmsghdr> msgs_;
+  std::vector<iovec> iovs_;
+  std::vector<std::array<uint8_t, SEND_CMSG_SPACE>> ctrls_;
+#endif // defined(HAVE_SENDMMSG)
 };
 
 class Server {
 public:
   Server(struct ev_loop *loop, TLSServerContext &tls_ctx);
+  // This constructor creates a Server which runs as a worker of the
+  // multi-threaded server.  |worker_id| is encoded in Connection IDs
+  // that it issues.
+  Server(struct ev_loop *loop, TLSServerContext &tls_ctx, uint8_t worker_id);
   ~Server();
 
   std::expected<void, Error> init(const char *addr, const char *port);
@@ -263,6 +382,11 @@ public:
   void close();
 
   void on_read(const Endpoint &ep);
+  // read_dgram processes a UDP datagram |data| received on |ep|.
+  // |msg| contains the remote address and the ancillary data.  It
+  // returns the number of QUIC packets processed.
+  size_t read_dgram(const Endpoint &ep, msghdr *msg,
+                    std::span<const uint8_t> data);
   void read_pkt(const Endpoint &ep, const Address &local_addr,
                 const Address &remote_addr, const ngtcp2_pkt_info *pi,
                 std::span<const uint8_t> data);
@@ -295,17 +419,59 @@ public:
                                          const ngtcp2_addr &remote_addr,
                                          unsigned int ecn,
                                          std::span<const uint8_t> data);
+  // send_packet sends |data| from |local_addr| to |remote_addr| on
+  // |ep|.  If |txtime| is nonzero, it is the departure time of |data|
+  // passed in SCM_TXTIME.  It returns the portion of |data| that was
+  // not sent because the socket would block.
   std::span<const uint8_t>
   send_packet(const Endpoint &ep, bool &no_gso, const ngtcp2_addr &local_addr,
               const ngtcp2_addr &remote_addr, unsigned int ecn,
-              std::span<const uint8_t> data, size_t gso_size);
+              std::span<const uint8_t> data, size_t gso_size,
+              ngtcp2_tstamp txtime);
+#ifdef HAVE_LIBURING
+  // get_send_buf returns a SendBuf of io_uring which a connection
+  // writes packets into.  It returns nullptr if an error occurred.
+  URing::SendBuf *get_send_buf();
+  // put_send_buf returns |sb| which is not used for sending.
+  void put_send_buf(URing::SendBuf *sb);
+  // has_free_send_buf returns true if get_send_buf does not wait for
+  // the outstanding sends.
+  bool has_free_send_buf() const;
+  // send_packet queues the first |datalen| bytes of |sb| to be sent
+  // without copying them, and takes the ownership of |sb|.  The
+  // other parameters are the same as the above function.
+  void send_packet(const Endpoint &ep, bool no_gso,
+                   const ngtcp2_addr &local_addr,
+                   const ngtcp2_addr &remote_addr, unsigned int ecn,
+                   URing::SendBuf *sb, size_t datalen, size_t gso_size,
+                   ngtcp2_tstamp txtime);
+#endif // defined(HAVE_LIBURING)
   void remove(const Handler *h);
+  // schedule_send queues |h| to SendCoordinator.
+  void schedule_send(Handler *h);
+  // cancel_send removes |h| from the queue of SendCoordinator.
+  void cancel_send(const Handler *h);
 
   void associate_cid(const ngtcp2_cid *cid, Handler *h);
   void dissociate_cid(const ngtcp2_cid *cid);
 
   void on_stateless_reset_regen();
 
+  // generate_cid generates a new Connection ID for a connection.  In
+  // worker mode, the ID of this worker is encoded in it.
+  std::expected<void, Error> generate_cid(ngtcp2_cid &cid);
+  // set_workers sets all workers including this one, indexed by
+  // worker ID.  It must be called before init.
+  void set_workers(std::span<Server *const> workers);
+  // forward sends a packet to the worker |worker_id|.
+  void forward(uint8_t worker_id, const Endpoint &ep,
+               const Address &local_addr, const Address &remote_addr,
+               const ngtcp2_pkt_info *pi, std::span<const uint8_t> data);
+  void on_forwarded();
+  // stop breaks the event loop of this worker.  It can be called from
+  // any thread.
+  void stop();
+
 private:
   std::unordered_map<ngtcp2_cid, Handler *> handlers_;
   struct ev_loop *loop_;
@@ -314,6 +480,19 @@ private:
   ev_signal sigintev_;
   ev_timer stateless_reset_regen_timer_;
   size_t stateless_reset_bucket_{NGTCP2_STATELESS_RESET_BURST};
+  RecvBatch rbatch_;
+  BatchStats send_stats_;
+  SendCoordinator sendq_;
+#ifdef HAVE_LIBURING
+  URing uring_;
+#endif // defined(HAVE_LIBURING)
+  // The following fields are used in worker mode.
+  std::span<Server *const> workers_;
+  ngtcp2_crypto_quic_lb_config quic_lb_{};
+  PacketQueue fwdq_;
+  ev_async fwdev_;
+  ev_async stopev_;
+  uint8_t worker_id_{};
 };
 
 #endif // !defined(SERVER_H)
@@ -169,6 +169,24 @@ struct Config {
   // gso_burst is the number of packets to aggregate in GSO.  0 means
   // it is not limited by the configuration.
   size_t gso_burst{};
+  // recv_batch is the maximum number of UDP datagrams to receive in
+  // a single recvmmsg call.
+  size_t recv_batch{16};
+  // send_batch is the maximum number of UDP datagrams to send in a
+  // single sendmmsg call when GSO is not used.
+  size_t send_batch{64};
+  // txtime_horizon, if nonzero, enables kernel pacing with SO_TXTIME.
+  // Packets are written up to this duration ahead of their departure
+  // time.
+  ngtcp2_duration txtime_horizon{};
+  // batch_send, if true, sends the packets of the connections in a
+  // single sendmmsg call per event loop iteration.
+  bool batch_send{};
+  // workers is the number of worker threads.  0 means that server
+  // runs in the main thread without routable Connection IDs.
+  size_t workers{};
+  // quic_lb_key is the key to encrypt worker ID in Connection IDs.
+  std::array<uint8_t, NGTCP2_CRYPTO_QUIC_LB_KEYLEN> quic_lb_key;
 };
 
 struct HTTPHeader {
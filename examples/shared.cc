@@ -27,7 +27,9 @@
 #include <nghttp3/nghttp3.h>
 
 #include <cstring>
+#include <ctime>
 #include <cassert>
+#include <algorithm>
 
 #include <unistd.h>
 #ifdef HAVE_NETINET_IN_H
@@ -48,6 +50,9 @@
 #ifdef HAVE_LINUX_RTNETLINK_H
 #  include <linux/rtnetlink.h>
 #endif // defined(HAVE_LINUX_RTNETLINK_H)
+#ifdef HAVE_LINUX_NET_TSTAMP_H
+#  include <linux/net_tstamp.h>
+#endif // defined(HAVE_LINUX_NET_TSTAMP_H)
 
 #include "template.h"
 
@@ -159,6 +164,31 @@ void fd_set_udp_gro(int fd) {
 #endif // defined(UDP_GRO)
 }
 
+std::expected<void, Error> fd_set_txtime(int fd) {
+#if defined(SO_TXTIME) && defined(HAVE_LINUX_NET_TSTAMP_H)
+  // util::timestamp() uses steady_clock, which is CLOCK_MONOTONIC on
+  // Linux.
+  sock_txtime txtime{
+    .clockid = CLOCK_MONOTONIC,
+  };
+
+  if (setsockopt(fd, SOL_SOCKET, SO_TXTIME, &txtime,
+                 static_cast<socklen_t>(sizeof(txtime))) == -1) {
+    std::println(stderr, "setsockopt: SO_TXTIME: {}", strerror(errno));
+
+    return std::unexpected{Error::SYSCALL};
+  }
+
+  return {};
+#else  // !(defined(SO_TXTIME) && defined(HAVE_LINUX_NET_TSTAMP_H))
+  (void)fd;
+
+  std::println(stderr, "SO_TXTIME is not supported on this platform");
+
+  return std::unexpected{Error::UNSUPPORTED};
+#endif // !(defined(SO_TXTIME) && defined(HAVE_LINUX_NET_TSTAMP_H))
+}
+
 std::expected<Address, Error> msghdr_get_local_addr(msghdr *msg, int family) {
   switch (family) {
   case AF_INET:
@@ -211,6 +241,320 @@ size_t msghdr_get_udp_gro(msghdr *msg) {
   return static_cast<size_t>(gso_size);
 }
 
+void msghdr_set_send_cmsg(msghdr *msg, const ngtcp2_addr *local_addr,
+                          int family, unsigned int ecn, size_t gso_size,
+                          uint64_t txtime) {
+  memset(msg->msg_control, 0, SEND_CMSG_SPACE);
+  msg->msg_controllen = SEND_CMSG_SPACE;
+
+  size_t controllen = 0;
+
+  auto cm = CMSG_FIRSTHDR(msg);
+
+  if (local_addr) {
+    switch (family) {
+    case AF_INET: {
+      controllen += CMSG_SPACE(sizeof(in_pktinfo));
+      cm->cmsg_level = IPPROTO_IP;
+      cm->cmsg_type = IP_PKTINFO;
+      cm->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+      auto addrin = reinterpret_cast<sockaddr_in *>(local_addr->addr);
+      in_pktinfo pktinfo{
+        .ipi_spec_dst = addrin->sin_addr,
+      };
+      memcpy(CMSG_DATA(cm), &pktinfo, sizeof(pktinfo));
+
+      break;
+    }
+    case AF_INET6: {
+      controllen += CMSG_SPACE(sizeof(in6_pktinfo));
+      cm->cmsg_level = IPPROTO_IPV6;
+      cm->cmsg_type = IPV6_PKTINFO;
+      cm->cmsg_len = CMSG_LEN(sizeof(in6_pktinfo));
+      auto addrin = reinterpret_cast<sockaddr_in6 *>(local_addr->addr);
+      in6_pktinfo pktinfo{
+        .ipi6_addr = addrin->sin6_addr,
+      };
+      memcpy(CMSG_DATA(cm), &pktinfo, sizeof(pktinfo));
+
+      break;
+    }
+    default:
+      assert(0);
+    }
+
+    cm = CMSG_NXTHDR(msg, cm);
+  }
+
+#ifdef UDP_SEGMENT
+  if (gso_size) {
+    controllen += CMSG_SPACE(sizeof(uint16_t));
+    cm->cmsg_level = SOL_UDP;
+    cm->cmsg_type = UDP_SEGMENT;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    auto n = static_cast<uint16_t>(gso_size);
+    memcpy(CMSG_DATA(cm), &n, sizeof(n));
+
+    cm = CMSG_NXTHDR(msg, cm);
+  }
+#else  // !defined(UDP_SEGMENT)
+  (void)gso_size;
+#endif // !defined(UDP_SEGMENT)
+
+#ifdef SCM_TXTIME
+  if (txtime) {
+    controllen += CMSG_SPACE(sizeof(uint64_t));
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_TXTIME;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+    memcpy(CMSG_DATA(cm), &txtime, sizeof(txtime));
+
+    cm = CMSG_NXTHDR(msg, cm);
+  }
+#else  // !defined(SCM_TXTIME)
+  (void)txtime;
+#endif // !defined(SCM_TXTIME)
+
+  controllen += CMSG_SPACE(sizeof(int));
+  cm->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cm), &ecn, sizeof(ecn));
+
+  switch (family) {
+  case AF_INET:
+    cm->cmsg_level = IPPROTO_IP;
+    cm->cmsg_type = IP_TOS;
+
+    break;
+  case AF_INET6:
+    cm->cmsg_level = IPPROTO_IPV6;
+    cm->cmsg_type = IPV6_TCLASS;
+
+    break;
+  default:
+    assert(0);
+  }
+
+  msg->msg_controllen =
+#ifndef __APPLE__
+    controllen
+#else  // defined(__APPLE__)
+    static_cast<socklen_t>(controllen)
+#endif // defined(__APPLE__)
+    ;
+}
+
+void BatchStats::add(size_t n) {
+  if (n == 0) {
+    return;
+  }
+
+  ++ncall;
+  ndgram += n;
+  max_dgram = std::max(max_dgram, n);
+}
+
+void print_batch_stats(std::string_view name, const BatchStats &stats) {
+  std::println(R"(# {} Batch Statistics
+ncall={}
+ndgram={}
+max_dgram={}
+avg_dgram={:.2f})",
+               name, stats.ncall, stats.ndgram, stats.max_dgram,
+               stats.ncall ? static_cast<double>(stats.ndgram) /
+                               static_cast<double>(stats.ncall)
+                           : 0.);
+}
+
+RecvBatch::RecvBatch(size_t capacity)
+  : buf_(
+#ifdef HAVE_RECVMMSG
+      capacity
+#else  // !defined(HAVE_RECVMMSG)
+      1
+#endif // !defined(HAVE_RECVMMSG)
+      * 64_k),
+    addrs_(buf_.size() / 64_k),
+    iovs_(addrs_.size()),
+    ctrls_(addrs_.size()) {
+  assert(capacity);
+
+  for (size_t i = 0; i < iovs_.size(); ++i) {
+    iovs_[i] = {
+      .iov_base = buf_.data() + i * 64_k,
+      .iov_len = 64_k,
+    };
+  }
+
+#ifdef HAVE_RECVMMSG
+  msgs_.resize(iovs_.size());
+
+  for (size_t i = 0; i < msgs_.size(); ++i) {
+    msgs_[i].msg_hdr = {
+      .msg_name = &addrs_[i],
+      .msg_iov = &iovs_[i],
+      .msg_iovlen = 1,
+      .msg_control = ctrls_[i].data(),
+    };
+  }
+#else  // !defined(HAVE_RECVMMSG)
+  msg_ = {
+    .msg_name = &addrs_[0],
+    .msg_iov = &iovs_[0],
+    .msg_iovlen = 1,
+    .msg_control = ctrls_[0].data(),
+  };
+#endif // !defined(HAVE_RECVMMSG)
+}
+
+ssize_t RecvBatch::recv(int fd, size_t n) {
+  n = std::min(n, capacity());
+
+  assert(n);
+
+#ifdef HAVE_RECVMMSG
+  for (size_t i = 0; i < n; ++i) {
+    auto &hdr = msgs_[i].msg_hdr;
+    hdr.msg_namelen = sizeof(addrs_[i]);
+    hdr.msg_controllen = sizeof(ctrls_[i]);
+  }
+
+  int nread;
+
+  do {
+    nread = recvmmsg(fd, msgs_.data(), static_cast<unsigned int>(n), 0,
+                     nullptr);
+  } while (nread == -1 && errno == EINTR);
+#else  // !defined(HAVE_RECVMMSG)
+  msg_.msg_namelen = sizeof(addrs_[0]);
+  msg_.msg_controllen = sizeof(ctrls_[0]);
+
+  ssize_t nread;
+
+  do {
+    nread = recvmsg(fd, &msg_, 0);
+  } while (nread == -1 && errno == EINTR);
+
+  if (nread != -1) {
+    len_ = static_cast<size_t>(nread);
+    nread = 1;
+  }
+#endif // !defined(HAVE_RECVMMSG)
+
+  if (nread == -1) {
+    return -1;
+  }
+
+  stats.add(static_cast<size_t>(nread));
+
+  return nread;
+}
+
+msghdr *RecvBatch::msg(size_t i) {
+#ifdef HAVE_RECVMMSG
+  return &msgs_[i].msg_hdr;
+#else  // !defined(HAVE_RECVMMSG)
+  assert(i == 0);
+
+  return &msg_;
+#endif // !defined(HAVE_RECVMMSG)
+}
+
+std::span<const uint8_t> RecvBatch::data(size_t i) const {
+#ifdef HAVE_RECVMMSG
+  return {buf_.data() + i * 64_k, msgs_[i].msg_len};
+#else  // !defined(HAVE_RECVMMSG)
+  assert(i == 0);
+
+  return {buf_.data(), len_};
+#endif // !defined(HAVE_RECVMMSG)
+}
+
+size_t RecvBatch::capacity() const { return iovs_.size(); }
+
+ssize_t send_segments(int fd, const msghdr &msg, std::span<const uint8_t> data,
+                      size_t gso_size, size_t batch, BatchStats &stats) {
+  assert(gso_size);
+  assert(batch);
+
+  auto p = data;
+
+#ifdef HAVE_SENDMMSG
+  std::vector<iovec> iovs(std::min(batch, (data.size() + gso_size - 1) /
+                                            gso_size));
+  std::vector<mmsghdr> msgs(iovs.size());
+
+  for (; !p.empty();) {
+    size_t n = 0;
+
+    for (auto q = p; !q.empty() && n < iovs.size(); ++n) {
+      auto len = std::min(gso_size, q.size());
+
+      iovs[n] = {
+        .iov_base = const_cast<uint8_t *>(q.data()),
+        .iov_len = len,
+      };
+
+      msgs[n].msg_hdr = msg;
+      msgs[n].msg_hdr.msg_iov = &iovs[n];
+      msgs[n].msg_hdr.msg_iovlen = 1;
+
+      q = q.subspan(len);
+    }
+
+    int nwrite;
+
+    do {
+      nwrite = sendmmsg(fd, msgs.data(), static_cast<unsigned int>(n), 0);
+    } while (nwrite == -1 && errno == EINTR);
+
+    if (nwrite == -1) {
+      break;
+    }
+
+    stats.add(static_cast<size_t>(nwrite));
+
+    // If sendmmsg stops at a datagram which it fails to send, the
+    // next call starts from that datagram, and reports the error.
+    for (size_t i = 0; i < static_cast<size_t>(nwrite); ++i) {
+      p = p.subspan(iovs[i].iov_len);
+    }
+  }
+#else  // !defined(HAVE_SENDMMSG)
+  (void)batch;
+
+  for (; !p.empty();) {
+    iovec iov{
+      .iov_base = const_cast<uint8_t *>(p.data()),
+      .iov_len = std::min(gso_size, p.size()),
+    };
+
+    auto m = msg;
+    m.msg_iov = &iov;
+    m.msg_iovlen = 1;
+
+    ssize_t nwrite;
+
+    do {
+      nwrite = sendmsg(fd, &m, 0);
+    } while (nwrite == -1 && errno == EINTR);
+
+    if (nwrite == -1) {
+      break;
+    }
+
+    stats.add(1);
+
+    p = p.subspan(iov.iov_len);
+  }
+#endif // !defined(HAVE_SENDMMSG)
+
+  if (p.size() == data.size()) {
+    return -1;
+  }
+
+  return static_cast<ssize_t>(data.size() - p.size());
+}
+
 #ifdef HAVE_LINUX_RTNETLINK_H
 
 struct nlmsg {
@@ -31,6 +31,8 @@
 
 #include <optional>
 #include <string_view>
+#include <vector>
+#include <array>
 #include <span>
 #include <print>
 #include <expected>
@@ -121,12 +123,105 @@ void fd_set_ip_dontfrag(int fd, int family);
 // fd_set_udp_gro sets UDP_GRO socket option to |fd|.
 void fd_set_udp_gro(int fd);
 
+// fd_set_txtime sets SO_TXTIME socket option to |fd| so that the
+// departure time of a datagram can be given in SCM_TXTIME in terms of
+// util::timestamp().
+std::expected<void, Error> fd_set_txtime(int fd);
+
 std::expected<Address, Error> msghdr_get_local_addr(msghdr *msg, int family);
 
 // msghdr_get_udp_gro returns UDP_GRO value from |msg|.  If UDP_GRO is
 // not found, or UDP_GRO is not supported, this function returns 0.
 size_t msghdr_get_udp_gro(msghdr *msg);
 
+// SEND_CMSG_SPACE is the size of a buffer which can hold the
+// ancillary data written by msghdr_set_send_cmsg.
+inline constexpr auto SEND_CMSG_SPACE =
+  CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(uint16_t)) +
+  CMSG_SPACE(sizeof(uint64_t)) + CMSG_SPACE(sizeof(in6_pktinfo));
+
+// msghdr_set_send_cmsg writes the ancillary data to send UDP
+// datagrams into |msg|->msg_control, which must point to the buffer
+// of at least SEND_CMSG_SPACE bytes, and sets msg_controllen.  The
+// data includes the source address |local_addr| if it is not
+// nullptr, UDP_SEGMENT if |gso_size| is nonzero, SCM_TXTIME if
+// |txtime| is nonzero, and the ECN bits |ecn|.  |family| is the
+// address family of the socket.
+void msghdr_set_send_cmsg(msghdr *msg, const ngtcp2_addr *local_addr,
+                          int family, unsigned int ecn, size_t gso_size,
+                          uint64_t txtime);
+
+// BatchStats holds the statistics of batched socket I/O.
+struct BatchStats {
+  // add records a system call which transferred |n| datagrams.  It
+  // does nothing if |n| is 0.
+  void add(size_t n);
+
+  // ncall is the number of system calls which transferred at least
+  // one datagram.
+  uint64_t ncall{};
+  // ndgram is the total number of datagrams transferred.
+  uint64_t ndgram{};
+  // max_dgram is the largest number of datagrams transferred by a
+  // single system call.
+  size_t max_dgram{};
+};
+
+// print_batch_stats prints |stats| with |name| as a label.
+void print_batch_stats(std::string_view name, const BatchStats &stats);
+
+// RecvBatch owns the buffers to receive up to capacity() UDP
+// datagrams in a single recvmmsg call.  If recvmmsg is not available,
+// the capacity is always 1, and recvmsg is used instead.  Each buffer
+// is large enough to receive a datagram coalesced by UDP_GRO.
+class RecvBatch {
+public:
+  explicit RecvBatch(size_t capacity);
+  RecvBatch(const RecvBatch &) = delete;
+  RecvBatch &operator=(const RecvBatch &) = delete;
+
+  // recv receives at most |n| datagrams from |fd|.  It returns the
+  // number of datagrams received, or -1 with errno set.
+  ssize_t recv(int fd, size_t n);
+
+  // msg returns the message header of the |i|th received datagram.
+  // msg_name and msg_control are filled by the kernel.
+  [[nodiscard]] msghdr *msg(size_t i);
+  // data returns the payload of the |i|th received datagram.
+  [[nodiscard]] std::span<const uint8_t> data(size_t i) const;
+  [[nodiscard]] size_t capacity() const;
+
+  // stats is the statistics of the receive calls.
+  BatchStats stats;
+
+private:
+  std::vector<uint8_t> buf_;
+  std::vector<sockaddr_storage> addrs_;
+  std::vector<iovec> iovs_;
+  std::vector<std::array<uint8_t, CMSG_SPACE(sizeof(int)) +
+                                    CMSG_SPACE(sizeof(in6_pktinfo)) +
+                                    CMSG_SPACE(sizeof(int))>>
+    ctrls_;
+#ifdef HAVE_RECVMMSG
+  std::vector<mmsghdr> msgs_;
+#else  // !defined(HAVE_RECVMMSG)
+  msghdr msg_;
+  size_t len_{};
+#endif // !defined(HAVE_RECVMMSG)
+};
+
+// send_segments sends |data| as a sequence of datagrams, each of
+// which is |gso_size| bytes long except for the last one.  |msg|
+// supplies the destination address and the ancillary data shared by
+// all datagrams; its msg_iov is ignored.  At most |batch| datagrams
+// are passed to a single sendmmsg call.  If sendmmsg is not
+// available, a sendmsg call is made per datagram.  It returns the
+// number of bytes sent.  If the return value is less than
+// |data|.size(), an error occurred, and errno is set.  It returns -1
+// if no datagram was sent.
+ssize_t send_segments(int fd, const msghdr &msg, std::span<const uint8_t> data,
+                      size_t gso_size, size_t batch, BatchStats &stats);
+
 // get_local_addr returns the preferred local address (interface
 // address) for a given destination address |remote_addr|.
 std::expected<InAddr, Error> get_local_addr(const Address &remote_addr);
@@ -364,8 +364,8 @@ Endpoint::setup_server(std::span<const uint8_t> original_dcid,
   };
 
   if (ngtcp2_conn_server_new(&conn_, &dcid, &scid, &path, version,
-                             &config_.callbacks, &settings, &params, nullptr,
-                             config_.user_data) != 0) {
+                             &config_.callbacks, &settings, &params,
+                             config_.mem, config_.user_data) != 0) {
     return std::unexpected{Error::QUIC};
   }
 
@@ -436,7 +436,8 @@ Endpoint::setup_client(const ngtcp2_addr *remote_addr) {
 
   if (ngtcp2_conn_client_new(
         &conn_, &dcid, &scid, &path, NGTCP2_PROTO_VER_V1, &config_.callbacks,
-        &config_.settings, &config_.params, nullptr, config_.user_data) != 0) {
+        &config_.settings, &config_.params, config_.mem,
+        config_.user_data) != 0) {
     return std::unexpected{Error::QUIC};
   }
 
@@ -615,7 +616,8 @@ Channel::Channel(Channel &&other) noexcept
     link_free_ts_{std::exchange(other.link_free_ts_, {})},
     queue_{std::exchange(other.queue_, {})},
     timeout_{std::exchange(other.timeout_, {})},
-    ts_{std::exchange(other.ts_, {})} {}
+    ts_{std::exchange(other.ts_, {})},
+    num_pkts_sent_{std::exchange(other.num_pkts_sent_, 0)} {}
 
 Channel &Channel::operator=(Channel &&other) noexcept {
   link_config_ = std::exchange(other.link_config_, {});
@@ -626,6 +628,7 @@ Channel &Channel::operator=(Channel &&other) noexcept {
   queue_ = std::exchange(other.queue_, {});
   timeout_ = std::exchange(other.timeout_, {});
   ts_ = std::exchange(other.ts_, {});
+  num_pkts_sent_ = std::exchange(other.num_pkts_sent_, 0);
 
   return *this;
 }
@@ -633,6 +636,8 @@ Channel &Channel::operator=(Channel &&other) noexcept {
 void Channel::send_pkt(const NetworkPath &path, std::span<const uint8_t> pkt) {
   auto rate = link_config_.rate / 8;
 
+  ++num_pkts_sent_;
+
   if (rate == 0) {
     queue_.emplace(Event{
       .ts = ts_ + link_config_.delay,
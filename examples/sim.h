@@ -118,6 +118,8 @@ struct EndpointConfig {
   ngtcp2_transport_params params{};
   ngtcp2_addr local_addr{};
   void *user_data{};
+  // mem is an optional custom memory allocator passed to ngtcp2_conn.
+  const ngtcp2_mem *mem{};
   LinkConfig link;
 
   std::function<std::expected<void, Error>(ngtcp2_conn *, const Context &)>
@@ -195,6 +197,9 @@ public:
   Event get_next_event();
   void pop_tx_queue();
   void run_eventcb(Timestamp ts);
+  // get_num_pkts_sent returns the number of packets passed to
+  // send_pkt, including the ones dropped by this channel.
+  uint64_t get_num_pkts_sent() const { return num_pkts_sent_; }
 
 private:
   bool decide_pkt_lost();
@@ -209,6 +214,7 @@ private:
   EventQueue queue_;
   Timestamp timeout_{Timestamp::max()};
   Timestamp ts_{};
+  uint64_t num_pkts_sent_{};
 };
 
 struct TokenParams {
@@ -269,6 +275,8 @@ public:
 
   std::expected<void, Error> run();
   void set_max_events(size_t n) { max_events_ = n; }
+  Endpoint &get_client() { return client_; }
+  Endpoint &get_server() { return server_; }
 
 private:
   Endpoint &get_opposite_endpoint(const Endpoint &ep);
@@ -0,0 +1,459 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+// simbench runs bulk transfers over the in-process network simulator
+// in sim.h with various link profiles and congestion controllers, and
+// writes the results to stdout in JSON.  It needs no socket, and all
+// inputs including packet losses are deterministic, so that the
+// numbers are comparable across library versions and settings.
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif // defined(HAVE_CONFIG_H)
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <format>
+#include <print>
+
+#include "sim.h"
+#include "template.h"
+
+using namespace ngtcp2;
+using namespace std::literals;
+
+namespace {
+// AllocStat counts the memory allocations made by ngtcp2_conn.
+struct AllocStat {
+  uint64_t nalloc;
+  uint64_t nbytes;
+  uint64_t peak_nbytes;
+};
+
+// Each allocation is prefixed by its size so that free can account
+// for it.
+constexpr auto ALLOC_HDLEN = alignof(std::max_align_t);
+
+void *counting_malloc(size_t size, void *user_data) {
+  auto stat = static_cast<AllocStat *>(user_data);
+  auto p = static_cast<uint8_t *>(malloc(ALLOC_HDLEN + size));
+  if (!p) {
+    return nullptr;
+  }
+
+  memcpy(p, &size, sizeof(size));
+
+  ++stat->nalloc;
+  stat->nbytes += size;
+  stat->peak_nbytes = std::max(stat->peak_nbytes, stat->nbytes);
+
+  return p + ALLOC_HDLEN;
+}
+
+void counting_free(void *ptr, void *user_data) {
+  if (!ptr) {
+    return;
+  }
+
+  auto stat = static_cast<AllocStat *>(user_data);
+  auto p = static_cast<uint8_t *>(ptr) - ALLOC_HDLEN;
+  size_t size;
+
+  memcpy(&size, p, sizeof(size));
+
+  stat->nbytes -= size;
+
+  free(p);
+}
+
+void *counting_calloc(size_t nmemb, size_t size, void *user_data) {
+  auto p = counting_malloc(nmemb * size, user_data);
+  if (!p) {
+    return nullptr;
+  }
+
+  memset(p, 0, nmemb * size);
+
+  return p;
+}
+
+void *counting_realloc(void *ptr, size_t size, void *user_data) {
+  if (!ptr) {
+    return counting_malloc(size, user_data);
+  }
+
+  auto p = counting_malloc(size, user_data);
+  if (!p) {
+    return nullptr;
+  }
+
+  size_t oldsize;
+
+  memcpy(&oldsize, static_cast<uint8_t *>(ptr) - ALLOC_HDLEN, sizeof(oldsize));
+  memcpy(p, ptr, std::min(oldsize, size));
+
+  counting_free(ptr, user_data);
+
+  return p;
+}
+} // namespace
+
+namespace {
+struct LinkProfile {
+  std::string_view name;
+  Timestamp::duration delay;
+  uint64_t rate;
+  uint64_t limit;
+  double loss;
+};
+
+constexpr auto link_profiles = std::to_array<LinkProfile>({
+  {
+    .name = "lan"sv,
+    .delay = 1ms,
+    .rate = 1_gbps,
+    .limit = MAX_UDP_PAYLOAD_SIZE * 100,
+  },
+  {
+    .name = "wan"sv,
+    .delay = 15ms,
+    .rate = 100_mbps,
+    .limit = MAX_UDP_PAYLOAD_SIZE * 100,
+  },
+  {
+    .name = "lossy"sv,
+    .delay = 15ms,
+    .rate = 10_mbps,
+    .limit = MAX_UDP_PAYLOAD_SIZE * 25,
+    .loss = 0.01,
+  },
+  {
+    .name = "long_fat"sv,
+    .delay = 100ms,
+    .rate = 100_mbps,
+    .limit = MAX_UDP_PAYLOAD_SIZE * 1000,
+  },
+});
+
+struct CongestionController {
+  std::string_view name;
+  ngtcp2_cc_algo algo;
+};
+
+constexpr auto congestion_controllers = std::to_array<CongestionController>({
+  {"reno"sv, NGTCP2_CC_ALGO_RENO},
+  {"cubic"sv, NGTCP2_CC_ALGO_CUBIC},
+  {"bbr"sv, NGTCP2_CC_ALGO_BBR},
+});
+} // namespace
+
+namespace {
+struct Result {
+  // goodput is the goodput measured in bits per second in the
+  // simulated time.
+  uint64_t goodput;
+  // cpu_ns is the CPU time consumed by the simulation.
+  uint64_t cpu_ns;
+  // num_pkts is the number of packets sent by both endpoints.
+  uint64_t num_pkts;
+  AllocStat alloc_stat;
+  // max_rss_kb is the peak resident set size of the child process
+  // which ran the simulation.  See run_in_child.
+  uint64_t max_rss_kb;
+};
+
+uint64_t cpu_now() {
+  timespec ts;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+  return static_cast<uint64_t>(ts.tv_sec) * NGTCP2_SECONDS +
+         static_cast<uint64_t>(ts.tv_nsec);
+}
+
+std::expected<Result, Error> run(const LinkProfile &profile,
+                                 const CongestionController &cc,
+                                 uint64_t nbytes) {
+  Result res{};
+
+  auto mem = ngtcp2_mem{
+    .user_data = &res.alloc_stat,
+    .malloc = counting_malloc,
+    .free = counting_free,
+    .calloc = counting_calloc,
+    .realloc = counting_realloc,
+  };
+
+  auto link = LinkConfig{
+    .delay = profile.delay,
+    .rate = profile.rate,
+    .limit = profile.limit,
+    .loss = profile.loss,
+    .seed = 1,
+  };
+
+  HandshakeApp clapp;
+  auto cl = default_client_endpoint_config();
+  clapp.configure(cl);
+  cl.settings.log_write = nullptr;
+  cl.params.initial_max_streams_uni = 1;
+  cl.params.initial_max_stream_data_uni = 16_m;
+  cl.params.initial_max_data = 16_m;
+  cl.mem = &mem;
+  cl.link = link;
+
+  UniStreamApp svapp(nbytes);
+  auto sv = default_server_endpoint_config();
+  svapp.configure(sv);
+  sv.settings.log_write = nullptr;
+  sv.settings.cc_algo = cc.algo;
+  sv.mem = &mem;
+  sv.link = link;
+
+  auto t = cpu_now();
+
+  {
+    Simulator sim{Endpoint(cl), Endpoint(sv)};
+
+    if (auto rv = sim.run(); !rv) {
+      return std::unexpected{rv.error()};
+    }
+
+    res.num_pkts = sim.get_client().get_channel().get_num_pkts_sent() +
+                   sim.get_server().get_channel().get_num_pkts_sent();
+  }
+
+  res.cpu_ns = cpu_now() - t;
+
+  if (!svapp.is_all_bytes_sent()) {
+    return std::unexpected{Error::INTERNAL};
+  }
+
+  res.goodput = svapp.compute_goodput();
+
+  return res;
+}
+
+// run_median runs the simulation |repeat| times, and returns the
+// result which has the median CPU time.
+std::expected<Result, Error> run_median(const LinkProfile &profile,
+                                        const CongestionController &cc,
+                                        uint64_t nbytes, size_t repeat) {
+  std::vector<Result> results;
+
+  for (size_t i = 0; i < repeat; ++i) {
+    auto res = run(profile, cc, nbytes);
+    if (!res) {
+      return res;
+    }
+
+    results.emplace_back(*res);
+  }
+
+  std::ranges::sort(results, {}, &Result::cpu_ns);
+
+  // The simulation is deterministic except for the CPU time.
+  return results[results.size() / 2];
+}
+
+// run_in_child calls run_median in a forked child process, and
+// returns its result.  getrusage(RUSAGE_SELF) in this process would
+// report the peak of all combinations run so far, so the peak RSS is
+// taken from the rusage of the child collected by wait4.
+std::expected<Result, Error> run_in_child(const LinkProfile &profile,
+                                          const CongestionController &cc,
+                                          uint64_t nbytes, size_t repeat) {
+  int pfd[2];
+
+  if (pipe(pfd) != 0) {
+    return std::unexpected{Error::IO};
+  }
+
+  // Do not let the child flush the output buffered so far.
+  fflush(stdout);
+
+  auto pid = fork();
+  if (pid == -1) {
+    close(pfd[0]);
+    close(pfd[1]);
+
+    return std::unexpected{Error::INTERNAL};
+  }
+
+  if (pid == 0) {
+    close(pfd[0]);
+
+    auto res = run_median(profile, cc, nbytes, repeat);
+    if (!res) {
+      _exit(EXIT_FAILURE);
+    }
+
+    // Result is smaller than PIPE_BUF, so that it is written
+    // atomically.
+    if (write(pfd[1], &*res, sizeof(*res)) !=
+        static_cast<ssize_t>(sizeof(*res))) {
+      _exit(EXIT_FAILURE);
+    }
+
+    _exit(EXIT_SUCCESS);
+  }
+
+  close(pfd[1]);
+
+  Result res;
+  ssize_t nread;
+
+  while ((nread = read(pfd[0], &res, sizeof(res))) == -1 && errno == EINTR)
+    ;
+
+  close(pfd[0]);
+
+  int status;
+  rusage ru;
+
+  while (wait4(pid, &status, 0, &ru) == -1) {
+    if (errno != EINTR) {
+      return std::unexpected{Error::INTERNAL};
+    }
+  }
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS ||
+      nread != static_cast<ssize_t>(sizeof(res))) {
+    return std::unexpected{Error::INTERNAL};
+  }
+
+  res.max_rss_kb = static_cast<uint64_t>(ru.ru_maxrss);
+
+  return res;
+}
+} // namespace
+
+namespace {
+void print_usage(FILE *out) {
+  std::println(
+    out,
+    "Usage: simbench [-r REPEAT] [-s BYTES] [FILTER]...\n"
+    "\n"
+    "Transfer BYTES over a unidirectional stream for each combination of\n"
+    "link profile and congestion controller whose name \"<link>/<cc>\"\n"
+    "contains any of FILTERs (all if no FILTER is given), and write the\n"
+    "results in JSON to stdout.\n"
+    "\n"
+    "  -r REPEAT  Run each combination REPEAT times, and report the\n"
+    "             median CPU time.  Default: 3\n"
+    "  -s BYTES   The number of bytes to transfer.  Default: 10485760");
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  uint64_t nbytes = 10_m;
+  size_t repeat = 3;
+
+  for (int c; (c = getopt(argc, argv, "hr:s:")) != -1;) {
+    switch (c) {
+    case 'h':
+      print_usage(stdout);
+      return EXIT_SUCCESS;
+    case 'r':
+      repeat = strtoull(optarg, nullptr, 10);
+      if (repeat == 0) {
+        std::println(stderr, "simbench: -r: invalid argument: {}", optarg);
+        return EXIT_FAILURE;
+      }
+
+      break;
+    case 's':
+      nbytes = strtoull(optarg, nullptr, 10);
+      if (nbytes == 0) {
+        std::println(stderr, "simbench: -s: invalid argument: {}", optarg);
+        return EXIT_FAILURE;
+      }
+
+      break;
+    default:
+      print_usage(stderr);
+      return EXIT_FAILURE;
+    }
+  }
+
+  auto filters = std::vector<std::string_view>(argv + optind, argv + argc);
+
+  std::print("{{\n"
+             "  \"version\": \"{}\",\n"
+             "  \"bytes\": {},\n"
+             "  \"repeat\": {},\n"
+             "  \"results\": [",
+             ngtcp2_version(0)->version_str, nbytes, repeat);
+
+  auto first = true;
+
+  for (auto &profile : link_profiles) {
+    for (auto &cc : congestion_controllers) {
+      auto name = std::format("{}/{}", profile.name, cc.name);
+
+      if (!filters.empty() &&
+          std::ranges::none_of(filters, [&name](const auto &f) {
+            return name.find(f) != std::string::npos;
+          })) {
+        continue;
+      }
+
+      auto res = run_in_child(profile, cc, nbytes, repeat);
+      if (!res) {
+        std::println(stderr, "simbench: {}: simulation failed", name);
+        return EXIT_FAILURE;
+      }
+
+      std::print(
+        "{}\n"
+        "    {{\"name\": \"{}\", \"goodput_bps\": {}, "
+        "\"cpu_ns_per_byte\": {:.3f}, \"pkts\": {}, "
+        "\"allocs_per_pkt\": {:.3f}, \"peak_alloc_bytes\": {}, "
+        "\"max_rss_kb\": {}}}",
+        first ? "" : ",", name, res->goodput,
+        static_cast<double>(res->cpu_ns) / static_cast<double>(nbytes),
+        res->num_pkts,
+        static_cast<double>(res->alloc_stat.nalloc) /
+          static_cast<double>(res->num_pkts),
+        res->alloc_stat.peak_nbytes, res->max_rss_kb);
+      fflush(stdout);
+
+      first = false;
+    }
+  }
+
+  std::println("\n  ]\n}}");
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,519 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "uring.h"
+
+#ifdef HAVE_LIBURING
+
+#  include <cassert>
+#  include <cstring>
+#  include <algorithm>
+
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/eventfd.h>
+
+#  include "server.h"
+#  include "template.h"
+#  include "util.h"
+
+namespace {
+// The number of submission queue entries.
+constexpr auto NUM_SQE = 1024U;
+// The identifier of the provided buffer group for receiving.
+constexpr auto RECV_BGID = 0;
+// The number of buffers provided for receiving.  It must be a power
+// of 2.
+constexpr auto NUM_RECV_BUF = 64U;
+// The length of a provided buffer.  In addition to the payload which
+// might be coalesced by UDP_GRO, it contains io_uring_recvmsg_out,
+// the remote address, and the ancillary data.
+constexpr auto RECV_BUFLEN = 64_k + 512;
+// RECV_CMSG_SPACE is the size of the ancillary data to receive.
+constexpr auto RECV_CMSG_SPACE = CMSG_SPACE(sizeof(int)) +
+                                 CMSG_SPACE(sizeof(in6_pktinfo)) +
+                                 CMSG_SPACE(sizeof(int));
+// The number of SendBufs.
+constexpr auto NUM_SEND_BUF = 256U;
+// The length of a SendBuf which can hold the largest GSO burst.
+constexpr auto SEND_BUFLEN = 64_k;
+// The number of SendReqs.  A SendBuf is sent by a single SendReq
+// unless GSO is disabled.
+constexpr auto NUM_SEND_REQ = 1024U;
+// SEND_TAG is set to user_data of a send request to distinguish it
+// from a receive request whose user_data is a pointer to Endpoint.
+constexpr uint64_t SEND_TAG = 0x1;
+} // namespace
+
+URing::URing()
+  : recv_msg_{
+      .msg_namelen = sizeof(sockaddr_storage),
+      .msg_controllen = RECV_CMSG_SPACE,
+    } {}
+
+URing::~URing() { close(); }
+
+namespace {
+void completioncb(struct ev_loop *loop, ev_io *w, int revents) {
+  auto uring = static_cast<URing *>(w->data);
+
+  uring->on_completion();
+}
+} // namespace
+
+namespace {
+void preparecb(struct ev_loop *loop, ev_prepare *w, int revents) {
+  auto uring = static_cast<URing *>(w->data);
+
+  uring->submit();
+}
+} // namespace
+
+std::expected<void, Error> URing::init(struct ev_loop *loop, Server *server) {
+  loop_ = loop;
+  server_ = server;
+
+  io_uring_params params{};
+
+  if (auto rv = io_uring_queue_init_params(NUM_SQE, &ring_, &params); rv < 0) {
+    std::println(stderr, "io_uring_queue_init_params: {}", strerror(-rv));
+    return std::unexpected{Error::LIBC};
+  }
+
+  initialized_ = true;
+
+  int rv;
+
+  br_ = io_uring_setup_buf_ring(&ring_, NUM_RECV_BUF, RECV_BGID, 0, &rv);
+  if (!br_) {
+    std::println(stderr, "io_uring_setup_buf_ring: {}", strerror(-rv));
+    return std::unexpected{Error::LIBC};
+  }
+
+  rbuf_.resize(NUM_RECV_BUF * RECV_BUFLEN);
+
+  auto mask = io_uring_buf_ring_mask(NUM_RECV_BUF);
+
+  for (size_t i = 0; i < NUM_RECV_BUF; ++i) {
+    io_uring_buf_ring_add(br_, rbuf_.data() + i * RECV_BUFLEN, RECV_BUFLEN,
+                          static_cast<unsigned short>(i), mask,
+                          static_cast<int>(i));
+  }
+
+  io_uring_buf_ring_advance(br_, NUM_RECV_BUF);
+
+  sbuf_.resize(NUM_SEND_BUF * SEND_BUFLEN);
+  sendbufs_.resize(NUM_SEND_BUF);
+  free_sendbufs_.reserve(NUM_SEND_BUF);
+
+  for (size_t i = 0; i < NUM_SEND_BUF; ++i) {
+    auto &sb = sendbufs_[i];
+    sb.data = {sbuf_.data() + i * SEND_BUFLEN, SEND_BUFLEN};
+    free_sendbufs_.push_back(&sb);
+  }
+
+  sendreqs_.resize(NUM_SEND_REQ);
+  free_sendreqs_.reserve(NUM_SEND_REQ);
+
+  for (auto &req : sendreqs_) {
+    free_sendreqs_.push_back(&req);
+  }
+
+  efd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (efd_ == -1) {
+    std::println(stderr, "eventfd: {}", strerror(errno));
+    return std::unexpected{Error::LIBC};
+  }
+
+  if (auto rv = io_uring_register_eventfd(&ring_, efd_); rv < 0) {
+    std::println(stderr, "io_uring_register_eventfd: {}", strerror(-rv));
+    return std::unexpected{Error::LIBC};
+  }
+
+  ev_io_init(&ev_, completioncb, efd_, EV_READ);
+  ev_set_priority(&ev_, EV_MAXPRI);
+  ev_.data = this;
+  ev_io_start(loop_, &ev_);
+
+  ev_prepare_init(&prep_, preparecb);
+  prep_.data = this;
+  ev_prepare_start(loop_, &prep_);
+
+  return {};
+}
+
+void URing::close() {
+  if (!initialized_) {
+    return;
+  }
+
+  initialized_ = false;
+
+  ev_io_stop(loop_, &ev_);
+  ev_prepare_stop(loop_, &prep_);
+
+  // Flush the packets, including CONNECTION_CLOSE, which are queued
+  // during the shutdown.
+  while (free_sendreqs_.size() < sendreqs_.size()) {
+    if (!wait_sends()) {
+      break;
+    }
+  }
+
+  if (br_) {
+    io_uring_free_buf_ring(&ring_, br_, NUM_RECV_BUF, RECV_BGID);
+    br_ = nullptr;
+  }
+
+  io_uring_queue_exit(&ring_);
+
+  if (efd_ != -1) {
+    ::close(efd_);
+    efd_ = -1;
+  }
+}
+
+std::expected<void, Error> URing::start_recv(const Endpoint &ep) {
+  // io_uring retries a request internally when the socket is not
+  // ready only if it is in blocking mode.  Otherwise, a send could
+  // complete with EAGAIN, and there is no readiness event to retry
+  // it.
+  auto flags = fcntl(ep.fd, F_GETFL);
+  if (flags == -1 || fcntl(ep.fd, F_SETFL, flags & ~O_NONBLOCK) == -1) {
+    std::println(stderr, "fcntl: {}", strerror(errno));
+    return std::unexpected{Error::LIBC};
+  }
+
+  post_recv(ep);
+
+  return {};
+}
+
+void URing::post_recv(const Endpoint &ep) {
+  auto sqe = get_sqe();
+
+  io_uring_prep_recvmsg_multishot(sqe, ep.fd, &recv_msg_, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = RECV_BGID;
+  io_uring_sqe_set_data64(sqe, reinterpret_cast<uintptr_t>(&ep));
+}
+
+io_uring_sqe *URing::get_sqe() {
+  auto sqe = io_uring_get_sqe(&ring_);
+  if (sqe) {
+    return sqe;
+  }
+
+  // Submission queue is full.
+  submit();
+
+  sqe = io_uring_get_sqe(&ring_);
+
+  assert(sqe);
+
+  return sqe;
+}
+
+bool URing::wait_sends() {
+  if (auto rv = io_uring_submit_and_wait(&ring_, 1); rv < 0 && rv != -EINTR) {
+    std::println(stderr, "io_uring_submit_and_wait: {}", strerror(-rv));
+    return false;
+  }
+
+  reap_sends();
+
+  return true;
+}
+
+URing::SendBuf *URing::get_send_buf() {
+  while (free_sendbufs_.empty()) {
+    if (!wait_sends()) {
+      return nullptr;
+    }
+  }
+
+  auto sb = free_sendbufs_.back();
+  free_sendbufs_.pop_back();
+
+  return sb;
+}
+
+void URing::put_send_buf(SendBuf *sb) {
+  assert(sb->nref == 0);
+
+  free_sendbufs_.push_back(sb);
+}
+
+bool URing::has_free_send_buf() const { return !free_sendbufs_.empty(); }
+
+URing::SendReq *URing::get_send_req() {
+  while (free_sendreqs_.empty()) {
+    if (!wait_sends()) {
+      return nullptr;
+    }
+  }
+
+  auto req = free_sendreqs_.back();
+  free_sendreqs_.pop_back();
+
+  return req;
+}
+
+void URing::send(const Endpoint &ep, bool no_gso,
+                 const ngtcp2_addr &local_addr, const ngtcp2_addr &remote_addr,
+                 unsigned int ecn, std::span<const uint8_t> data,
+                 size_t gso_size, ngtcp2_tstamp txtime) {
+  assert(data.size() <= SEND_BUFLEN);
+
+  auto sb = get_send_buf();
+  if (!sb) {
+    return;
+  }
+
+  std::ranges::copy(data, sb->data.begin());
+
+  send(ep, no_gso, local_addr, remote_addr, ecn, sb, data.size(), gso_size,
+       txtime);
+}
+
+void URing::send(const Endpoint &ep, bool no_gso,
+                 const ngtcp2_addr &local_addr, const ngtcp2_addr &remote_addr,
+                 unsigned int ecn, SendBuf *sb, size_t datalen,
+                 size_t gso_size, ngtcp2_tstamp txtime) {
+  assert(datalen <= sb->data.size());
+  assert(sb->nref == 0);
+
+  // Without GSO, each datagram is sent by a separate request which
+  // refers to the same buffer.
+  auto seglen = (no_gso || no_gso_) ? gso_size : datalen;
+  auto data = sb->data.first(datalen);
+
+  // Keep sb while waiting for a free SendReq, which might complete
+  // the requests queued in this loop.
+  ++sb->nref;
+
+  for (; !data.empty();) {
+    auto req = get_send_req();
+    if (!req) {
+      break;
+    }
+
+    auto len = std::min(seglen, data.size());
+
+    memcpy(&req->remote_addr, remote_addr.addr, remote_addr.addrlen);
+
+    req->iov = {
+      .iov_base = data.data(),
+      .iov_len = len,
+    };
+    req->msg = {
+      .msg_name = &req->remote_addr,
+      .msg_namelen = remote_addr.addrlen,
+      .msg_iov = &req->iov,
+      .msg_iovlen = 1,
+      .msg_control = req->ctrl.data(),
+    };
+    req->sb = sb;
+    req->gso_size = len > gso_size ? gso_size : 0;
+
+    msghdr_set_send_cmsg(&req->msg, &local_addr, local_addr.addr->sa_family,
+                         ecn, req->gso_size, txtime);
+
+    auto sqe = get_sqe();
+
+    io_uring_prep_sendmsg(sqe, ep.fd, &req->msg, 0);
+    io_uring_sqe_set_data64(sqe, reinterpret_cast<uintptr_t>(req) | SEND_TAG);
+
+    ++sb->nref;
+
+    data = data.subspan(len);
+  }
+
+  if (--sb->nref == 0) {
+    put_send_buf(sb);
+  }
+}
+
+void URing::submit() {
+  if (!io_uring_sq_ready(&ring_)) {
+    return;
+  }
+
+  if (auto rv = io_uring_submit(&ring_); rv < 0) {
+    std::println(stderr, "io_uring_submit: {}", strerror(-rv));
+  }
+}
+
+void URing::reap_sends() {
+  io_uring_cqe *cqe;
+
+  while (io_uring_peek_cqe(&ring_, &cqe) == 0) {
+    Completion c{
+      .user_data = io_uring_cqe_get_data64(cqe),
+      .res = cqe->res,
+      .flags = cqe->flags,
+    };
+
+    io_uring_cqe_seen(&ring_, cqe);
+
+    if (c.user_data & SEND_TAG) {
+      handle_send(c);
+      continue;
+    }
+
+    // Processing received packets here would reenter the code path
+    // which is sending a packet.
+    deferred_.push_back(c);
+  }
+
+  if (!deferred_.empty()) {
+    // The eventfd is not signaled for the completions which are
+    // already reaped.
+    ev_feed_event(loop_, &ev_, EV_READ);
+  }
+}
+
+void URing::on_completion() {
+  uint64_t n;
+
+  while (read(efd_, &n, sizeof(n)) == -1 && errno == EINTR)
+    ;
+
+  for (;;) {
+    if (!deferred_.empty()) {
+      auto c = deferred_.front();
+      deferred_.pop_front();
+
+      handle_completion(c);
+
+      continue;
+    }
+
+    io_uring_cqe *cqe;
+
+    if (io_uring_peek_cqe(&ring_, &cqe) != 0) {
+      break;
+    }
+
+    Completion c{
+      .user_data = io_uring_cqe_get_data64(cqe),
+      .res = cqe->res,
+      .flags = cqe->flags,
+    };
+
+    io_uring_cqe_seen(&ring_, cqe);
+
+    handle_completion(c);
+  }
+}
+
+void URing::handle_completion(const Completion &c) {
+  if (c.user_data & SEND_TAG) {
+    handle_send(c);
+  } else {
+    handle_recv(c);
+  }
+}
+
+void URing::handle_recv(const Completion &c) {
+  auto &ep = *reinterpret_cast<const Endpoint *>(c.user_data);
+
+  if (c.flags & IORING_CQE_F_BUFFER) {
+    auto bid = c.flags >> IORING_CQE_BUFFER_SHIFT;
+    auto buf = rbuf_.data() + bid * RECV_BUFLEN;
+
+    if (c.res >= 0) {
+      auto o = io_uring_recvmsg_validate(buf, c.res, &recv_msg_);
+      if (o && !(o->flags & MSG_TRUNC)) {
+        auto name = io_uring_recvmsg_name(o);
+        msghdr msg{
+          .msg_name = name,
+          .msg_namelen = o->namelen,
+          .msg_control = static_cast<uint8_t *>(name) + recv_msg_.msg_namelen,
+          .msg_controllen = o->controllen,
+        };
+        auto payload = static_cast<const uint8_t *>(
+          io_uring_recvmsg_payload(o, &recv_msg_));
+        auto payloadlen =
+          io_uring_recvmsg_payload_length(o, c.res, &recv_msg_);
+
+        server_->read_dgram(ep, &msg, {payload, payloadlen});
+      }
+    }
+
+    io_uring_buf_ring_add(br_, buf, RECV_BUFLEN, static_cast<unsigned short>(bid),
+                          io_uring_buf_ring_mask(NUM_RECV_BUF), 0);
+    io_uring_buf_ring_advance(br_, 1);
+  }
+
+  if (c.flags & IORING_CQE_F_MORE) {
+    return;
+  }
+
+  // The multishot request has terminated.  It is restarted only if
+  // all provided buffers were in use, which are returned above, or
+  // the kernel ended it without an error (e.g., the completion queue
+  // overflowed).
+  if (c.res < 0 && c.res != -ENOBUFS) {
+    if (c.res != -ECANCELED) {
+      std::println(stderr, "recvmsg: {}; stop receiving on {}",
+                   strerror(-c.res),
+                   util::straddr(ep.addr.as_sockaddr(), ep.addr.size()));
+    }
+
+    return;
+  }
+
+  if (initialized_) {
+    post_recv(ep);
+  }
+}
+
+void URing::handle_send(const Completion &c) {
+  auto req = reinterpret_cast<SendReq *>(c.user_data & ~SEND_TAG);
+  auto sb = req->sb;
+
+  free_sendreqs_.push_back(req);
+
+  if (--sb->nref == 0) {
+    free_sendbufs_.push_back(sb);
+  }
+
+  if (c.res >= 0) {
+    return;
+  }
+
+  if (c.res == -EIO && req->gso_size) {
+    // GSO failure; the rest of the packets are sent without GSO.
+    std::println(stderr, "sendmsg: disabling GSO due to {}", strerror(-c.res));
+
+    no_gso_ = true;
+
+    return;
+  }
+
+  std::println(stderr, "sendmsg: {}", strerror(-c.res));
+}
+
+#endif // defined(HAVE_LIBURING)
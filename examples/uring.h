@@ -0,0 +1,173 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef URING_H
+#define URING_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif // defined(HAVE_CONFIG_H)
+
+#ifdef HAVE_LIBURING
+
+#  include <vector>
+#  include <deque>
+#  include <span>
+#  include <array>
+#  include <expected>
+
+#  include <liburing.h>
+
+#  include <ngtcp2/ngtcp2.h>
+
+#  include <ev.h>
+
+#  include "shared.h"
+
+using namespace ngtcp2;
+
+class Server;
+struct Endpoint;
+
+// URing performs UDP socket I/O of Server with io_uring instead of
+// readiness notifications.  Datagrams are received by a multishot
+// recvmsg per Endpoint into the buffers provided by a buffer ring.
+// Connections write outgoing datagrams directly into preallocated
+// send buffers, and the queued sendmsg requests are submitted in a
+// single io_uring_enter call right before the event loop blocks.  Timers are
+// still handled by libev, which is notified of completions through an
+// eventfd.
+class URing {
+public:
+  // SendBuf is a buffer which outgoing datagrams are written into.
+  struct SendBuf {
+    std::span<uint8_t> data;
+    // nref is the number of the outstanding send requests which
+    // refer to this buffer.
+    size_t nref;
+  };
+
+  URing();
+  ~URing();
+  URing(const URing &) = delete;
+  URing &operator=(const URing &) = delete;
+
+  std::expected<void, Error> init(struct ev_loop *loop, Server *server);
+  // close submits the pending requests, waits for the outstanding
+  // sends, and tears down io_uring.
+  void close();
+
+  // start_recv starts receiving datagrams on |ep|.
+  std::expected<void, Error> start_recv(const Endpoint &ep);
+  // get_send_buf returns a free SendBuf.  It waits for the
+  // outstanding sends to complete if there is none.  The caller must
+  // pass it to either send or put_send_buf.  It returns nullptr if an
+  // error occurred.
+  SendBuf *get_send_buf();
+  // put_send_buf returns |sb| which is not used for sending.
+  void put_send_buf(SendBuf *sb);
+  // send queues the first |datalen| bytes of |sb| to be sent from
+  // |local_addr| to |remote_addr| on |ep|, and takes the ownership of
+  // |sb|.  If |datalen| is larger than |gso_size|, the datagrams are
+  // sent with UDP_SEGMENT unless |no_gso| is true, or GSO has been
+  // disabled due to an error.  |txtime|, if nonzero, is the departure
+  // time passed in SCM_TXTIME.
+  void send(const Endpoint &ep, bool no_gso, const ngtcp2_addr &local_addr,
+            const ngtcp2_addr &remote_addr, unsigned int ecn, SendBuf *sb,
+            size_t datalen, size_t gso_size, ngtcp2_tstamp txtime);
+  // send is similar to the above function, but it copies |data| into
+  // a SendBuf.  It is used for the packets which are not written by
+  // connections, such as Stateless Reset.
+  void send(const Endpoint &ep, bool no_gso, const ngtcp2_addr &local_addr,
+            const ngtcp2_addr &remote_addr, unsigned int ecn,
+            std::span<const uint8_t> data, size_t gso_size,
+            ngtcp2_tstamp txtime);
+  // has_free_send_buf returns true if get_send_buf can return a
+  // SendBuf without waiting.
+  bool has_free_send_buf() const;
+  // submit submits the queued requests to the kernel.
+  void submit();
+  // on_completion processes the posted completions.
+  void on_completion();
+
+private:
+  struct Completion {
+    uint64_t user_data;
+    int32_t res;
+    uint32_t flags;
+  };
+
+  // SendReq is a sendmsg request.  More than one SendReq refers to
+  // the same SendBuf if it is split into datagrams without GSO.
+  struct SendReq {
+    msghdr msg;
+    iovec iov;
+    sockaddr_storage remote_addr;
+    std::array<uint8_t, SEND_CMSG_SPACE> ctrl;
+    SendBuf *sb;
+    size_t gso_size;
+  };
+
+  // post_recv queues a multishot recvmsg request for |ep|.
+  void post_recv(const Endpoint &ep);
+  io_uring_sqe *get_sqe();
+  SendReq *get_send_req();
+  // wait_sends submits the queued requests and processes the send
+  // completions, waiting for at least one of them.
+  bool wait_sends();
+  void reap_sends();
+  void handle_completion(const Completion &c);
+  void handle_recv(const Completion &c);
+  void handle_send(const Completion &c);
+
+  io_uring ring_;
+  io_uring_buf_ring *br_{};
+  // rbuf_ is the memory for the buffers provided to the kernel for
+  // receiving.
+  std::vector<uint8_t> rbuf_;
+  // recv_msg_ tells the kernel the sizes of the address and the
+  // ancillary data to store in a provided buffer.
+  msghdr recv_msg_;
+  // sbuf_ is the memory for SendBufs.
+  std::vector<uint8_t> sbuf_;
+  std::vector<SendBuf> sendbufs_;
+  std::vector<SendBuf *> free_sendbufs_;
+  std::vector<SendReq> sendreqs_;
+  std::vector<SendReq *> free_sendreqs_;
+  // deferred_ contains the receive completions which are reaped
+  // while waiting for a free SendBuf or SendReq.
+  std::deque<Completion> deferred_;
+  struct ev_loop *loop_{};
+  Server *server_{};
+  ev_io ev_;
+  ev_prepare prep_;
+  int efd_{-1};
+  // no_gso_ is true if GSO has failed.
+  bool no_gso_{};
+  bool initialized_{};
+};
+
+#endif // defined(HAVE_LIBURING)
+
+#endif // !defined(URING_H)
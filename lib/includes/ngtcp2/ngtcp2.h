@@ -1469,7 +1469,8 @@ typedef struct ngtcp2_version_info {
 } ngtcp2_version_info;
 
 #define NGTCP2_TRANSPORT_PARAMS_V1 1
-#define NGTCP2_TRANSPORT_PARAMS_VERSION NGTCP2_TRANSPORT_PARAMS_V1
+#define NGTCP2_TRANSPORT_PARAMS_V2 2
+#define NGTCP2_TRANSPORT_PARAMS_VERSION NGTCP2_TRANSPORT_PARAMS_V2
 
 /**
  * @struct
@@ -1637,6 +1638,21 @@ typedef struct ngtcp2_transport_params {
    * this field.
    */
   uint8_t version_info_present;
+  /* The following fields have been added since
+     NGTCP2_TRANSPORT_PARAMS_V2. */
+  /**
+   * :member:`min_ack_delay` is the minimum acknowledgement delay that
+   * the local endpoint can honor when a remote endpoint asks it to
+   * change its acknowledgement frequency with ACK_FREQUENCY frame.
+   * Specifying nonzero value enables ACK Frequency extension
+   * (draft-ietf-quic-ack-frequency).  It must not exceed
+   * :member:`max_ack_delay`.  Sub-microsecond part is dropped when
+   * sending it in a QUIC transport parameter.  0 means that the
+   * extension is not supported.
+   *
+   * .. version-added:: 1.26.0
+   */
+  ngtcp2_duration min_ack_delay;
 } ngtcp2_transport_params;
 
 #define NGTCP2_CONN_INFO_V1 1
@@ -1857,11 +1873,433 @@ typedef enum ngtcp2_token_type {
   NGTCP2_TOKEN_TYPE_NEW_TOKEN
 } ngtcp2_token_type;
 
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_objpool` is a memory pool which can be shared by
+ * multiple :type:`ngtcp2_conn` objects.  The connections which share
+ * the pool take the memory blocks for their internal object
+ * allocators (e.g., for frames and packets in flight) from the pool
+ * instead of calling :type:`ngtcp2_mem` every time.  A connection
+ * keeps the blocks of its object allocators until it is deleted, even
+ * if it becomes idle, and only then returns them to the pool.  The
+ * blocks of the handshake arena (see
+ * :member:`ngtcp2_settings.handshake_arena`) are returned as soon as
+ * the handshake state is discarded.  :type:`ngtcp2_objpool` is not
+ * thread-safe.  All connections which share the same pool
+ * must be used from the same thread.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef struct ngtcp2_objpool ngtcp2_objpool;
+
+#define NGTCP2_OBJPOOL_STAT_V1 1
+#define NGTCP2_OBJPOOL_STAT_VERSION NGTCP2_OBJPOOL_STAT_V1
+
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_objpool_stat` holds the statistics of
+ * :type:`ngtcp2_objpool`.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef struct ngtcp2_objpool_stat {
+  /**
+   * :member:`nhit` is the number of memory block requests which are
+   * satisfied by the cached memory blocks.
+   */
+  uint64_t nhit;
+  /**
+   * :member:`nmiss` is the number of memory block requests which
+   * allocated a new memory block.
+   */
+  uint64_t nmiss;
+  /**
+   * :member:`ndiscard` is the number of memory blocks which are
+   * released to :type:`ngtcp2_mem` rather than cached because the
+   * pool is full.
+   */
+  uint64_t ndiscard;
+  /**
+   * :member:`ncached` is the number of memory blocks currently
+   * cached in the pool.
+   */
+  size_t ncached;
+  /**
+   * :member:`cached_bytes` is the number of bytes currently cached
+   * in the pool.
+   */
+  size_t cached_bytes;
+} ngtcp2_objpool_stat;
+
+/**
+ * @function
+ *
+ * `ngtcp2_objpool_new` creates new :type:`ngtcp2_objpool`, and
+ * assigns its pointer to |*ppool|.  |max_cached_bytes| is the
+ * maximum number of bytes that the pool keeps for later reuse.  The
+ * memory blocks returned to the pool beyond this limit are released
+ * immediately.  |mem| is the memory allocator to allocate the memory
+ * blocks.  If |mem| is ``NULL``, the memory allocator returned by
+ * `ngtcp2_mem_default()` is used.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_NOMEM`
+ *     Out of memory.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_objpool_new(ngtcp2_objpool **ppool,
+                                     size_t max_cached_bytes,
+                                     const ngtcp2_mem *mem);
+
+/**
+ * @function
+ *
+ * `ngtcp2_objpool_del` frees resources allocated for |pool|.  All
+ * :type:`ngtcp2_conn` objects which use |pool| must be deleted before
+ * calling this function.  If |pool| is ``NULL``, this function does
+ * nothing.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void ngtcp2_objpool_del(ngtcp2_objpool *pool);
+
+/**
+ * @function
+ *
+ * `ngtcp2_objpool_get_stat_versioned` assigns the statistics of
+ * |pool| to |*stat|.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void
+ngtcp2_objpool_get_stat_versioned(const ngtcp2_objpool *pool,
+                                  int objpool_stat_version,
+                                  ngtcp2_objpool_stat *stat);
+
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_rx_budget` is the receive buffer budget which can be
+ * shared by multiple :type:`ngtcp2_conn` objects.  By default, each
+ * connection grows its connection-level and stream-level flow control
+ * windows independently up to :member:`ngtcp2_settings.max_window`
+ * and :member:`ngtcp2_settings.max_stream_window` respectively.  The
+ * connections which share the budget charge the growth of those
+ * windows beyond their initial values to the budget, so that the
+ * total amount of the receive buffer that they can commit is capped
+ * by the limit of the budget.  When the budget runs low, the
+ * connections shrink the windows that they advertise in MAX_DATA and
+ * MAX_STREAM_DATA frames, and return the released amount to the
+ * budget.  :type:`ngtcp2_rx_budget` is not thread-safe.  All
+ * connections which share the same budget must be used from the same
+ * thread.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef struct ngtcp2_rx_budget ngtcp2_rx_budget;
+
+/**
+ * @function
+ *
+ * `ngtcp2_rx_budget_new` creates new :type:`ngtcp2_rx_budget`, and
+ * assigns its pointer to |*pbudget|.  |limit| is the maximum number
+ * of bytes that the connections sharing the budget can add to their
+ * flow control windows beyond the initial values in total.  |mem| is
+ * the memory allocator to allocate the object.  If |mem| is ``NULL``,
+ * the memory allocator returned by `ngtcp2_mem_default()` is used.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_NOMEM`
+ *     Out of memory.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_rx_budget_new(ngtcp2_rx_budget **pbudget,
+                                       uint64_t limit, const ngtcp2_mem *mem);
+
+/**
+ * @function
+ *
+ * `ngtcp2_rx_budget_del` frees resources allocated for |budget|.  All
+ * :type:`ngtcp2_conn` objects which use |budget| must be deleted
+ * before calling this function.  If |budget| is ``NULL``, this
+ * function does nothing.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void ngtcp2_rx_budget_del(ngtcp2_rx_budget *budget);
+
+/**
+ * @function
+ *
+ * `ngtcp2_rx_budget_set_limit` changes the limit of |budget| to
+ * |limit|.  If |limit| is less than the number of bytes currently
+ * charged, the connections stop growing their windows, and shrink
+ * them as they send MAX_DATA and MAX_STREAM_DATA frames until the
+ * usage falls below the new limit.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void ngtcp2_rx_budget_set_limit(ngtcp2_rx_budget *budget,
+                                              uint64_t limit);
+
+/**
+ * @function
+ *
+ * `ngtcp2_rx_budget_get_used` returns the number of bytes currently
+ * charged to |budget|.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN uint64_t
+ngtcp2_rx_budget_get_used(const ngtcp2_rx_budget *budget);
+
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_timerq` is a timer wheel which manages the expiry of
+ * multiple :type:`ngtcp2_conn` objects.  A connection which is
+ * associated to the timer wheel through
+ * :member:`ngtcp2_settings.timerq` updates its deadline in the wheel
+ * in constant time whenever `ngtcp2_conn_read_pkt`,
+ * `ngtcp2_conn_read_pkts`, `ngtcp2_conn_writev_stream`,
+ * `ngtcp2_conn_writev_datagram`, or `ngtcp2_conn_handle_expiry` (and
+ * their variants) returns, so that an application does not have to
+ * call `ngtcp2_conn_get_expiry2` and maintain a timer per connection.
+ * Instead, it arms a single timer with `ngtcp2_timerq_get_expiry`,
+ * and when the timer fires, it takes the connections which are due
+ * with `ngtcp2_timerq_pop_expired`, and calls
+ * `ngtcp2_conn_handle_expiry` for each of them.  The deadlines are
+ * rounded up to the granularity of the wheel.
+ * :type:`ngtcp2_timerq` is not thread-safe.  All connections which
+ * share the same timer wheel must be used from the same thread.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef struct ngtcp2_timerq ngtcp2_timerq;
+
+/**
+ * @function
+ *
+ * `ngtcp2_timerq_new` creates new :type:`ngtcp2_timerq`, and assigns
+ * its pointer to |*ptimerq|.  |granularity| is the resolution of the
+ * timer wheel, and it must not be 0.  :macro:`NGTCP2_MILLISECONDS` is
+ * a reasonable choice.  |mem| is the memory allocator to allocate the
+ * object.  If |mem| is ``NULL``, the memory allocator returned by
+ * `ngtcp2_mem_default()` is used.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_NOMEM`
+ *     Out of memory.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_timerq_new(ngtcp2_timerq **ptimerq,
+                                    ngtcp2_duration granularity,
+                                    const ngtcp2_mem *mem);
+
+/**
+ * @function
+ *
+ * `ngtcp2_timerq_del` frees resources allocated for |timerq|.  All
+ * :type:`ngtcp2_conn` objects which use |timerq| must be deleted
+ * before calling this function.  If |timerq| is ``NULL``, this
+ * function does nothing.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void ngtcp2_timerq_del(ngtcp2_timerq *timerq);
+
+/**
+ * @function
+ *
+ * `ngtcp2_timerq_get_expiry` returns the time when an application
+ * should call `ngtcp2_timerq_pop_expired` next.  It returns
+ * ``UINT64_MAX`` if |timerq| is empty.  The returned value may be
+ * earlier than the earliest deadline of the connections, in which
+ * case `ngtcp2_timerq_pop_expired` may return no connection, and
+ * this function returns a later time after that.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN ngtcp2_tstamp
+ngtcp2_timerq_get_expiry(const ngtcp2_timerq *timerq);
+
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_CID_TABLE_KEYLEN` is the length of the secret key
+ * for :type:`ngtcp2_cid_table`.
+ *
+ * .. version-added:: 1.26.0
+ */
+#define NGTCP2_CID_TABLE_KEYLEN 16
+
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_cid_table` is a table which maps Connection IDs of
+ * fixed length to connections.  A server uses it to find the
+ * connection which an incoming packet belongs to.  The Connection IDs
+ * are hashed with SipHash-2-4 keyed by a secret so that a remote
+ * endpoint cannot force collisions.  A connection which is associated
+ * to the table through :member:`ngtcp2_settings.cid_table` registers
+ * all of its own Connection IDs with its user data (the |user_data|
+ * passed to `ngtcp2_conn_server_new`), and unregisters them when they
+ * are retired or the connection is deleted.
+ * :member:`ngtcp2_callbacks.get_new_connection_id` and
+ * :member:`ngtcp2_callbacks.remove_connection_id` are still called as
+ * usual.  If a Connection ID generated by
+ * :member:`ngtcp2_callbacks.get_new_connection_id` is already in the
+ * table, :member:`ngtcp2_callbacks.remove_connection_id` is called
+ * for it, and the former callback is called again to generate
+ * another one, a few times at most.
+ *
+ * The table only holds the Connection IDs chosen by a server.  The
+ * Destination Connection ID of the first Initial packet from a client
+ * (:member:`ngtcp2_transport_params.original_dcid`) is chosen by the
+ * client, and may not even be of the length of the table.  The
+ * application must keep routing the packets which carry it (e.g.,
+ * retransmitted Initial and 0-RTT packets) to the connection by its
+ * own means until the handshake completes.
+ *
+ * :type:`ngtcp2_cid_table` is not thread-safe.  All
+ * connections which share the same table must be used from the same
+ * thread.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef struct ngtcp2_cid_table ngtcp2_cid_table;
+
+/**
+ * @function
+ *
+ * `ngtcp2_cid_table_new` creates new :type:`ngtcp2_cid_table`, and
+ * assigns its pointer to |*ptable|.  |cidlen| is the length of
+ * Connection IDs stored in the table, and it must be in the range
+ * [1, :macro:`NGTCP2_MAX_CIDLEN`], inclusive.  |key| is the secret
+ * key of length :macro:`NGTCP2_CID_TABLE_KEYLEN`, and it should be
+ * generated by a cryptographically secure random number generator.
+ * |mem| is the memory allocator to allocate the object.  If |mem| is
+ * ``NULL``, the memory allocator returned by `ngtcp2_mem_default()`
+ * is used.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_NOMEM`
+ *     Out of memory.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_cid_table_new(ngtcp2_cid_table **ptable,
+                                       size_t cidlen, const uint8_t *key,
+                                       const ngtcp2_mem *mem);
+
+/**
+ * @function
+ *
+ * `ngtcp2_cid_table_del` frees resources allocated for |table|.  If
+ * |table| is ``NULL``, this function does nothing.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void ngtcp2_cid_table_del(ngtcp2_cid_table *table);
+
+/**
+ * @function
+ *
+ * `ngtcp2_cid_table_insert` associates |data| to |cid| in |table|.
+ * |data| must not be ``NULL``.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_INVALID_ARGUMENT`
+ *     |cid| is already present, or its length is not the one passed
+ *     to `ngtcp2_cid_table_new`.
+ * :macro:`NGTCP2_ERR_NOMEM`
+ *     Out of memory.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_cid_table_insert(ngtcp2_cid_table *table,
+                                          const ngtcp2_cid *cid, void *data);
+
+/**
+ * @function
+ *
+ * `ngtcp2_cid_table_remove` removes |cid| from |table|.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_INVALID_ARGUMENT`
+ *     |cid| is not present.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_cid_table_remove(ngtcp2_cid_table *table,
+                                          const ngtcp2_cid *cid);
+
+/**
+ * @function
+ *
+ * `ngtcp2_cid_table_find` returns the data associated to the
+ * Connection ID pointed by |cid| in |table|.  |cid| must point to the
+ * buffer of the length passed to `ngtcp2_cid_table_new`.  Typically,
+ * it is :member:`ngtcp2_version_cid.dcid` obtained by
+ * `ngtcp2_pkt_decode_version_cid`.  It returns ``NULL`` if no such
+ * Connection ID is found.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void *ngtcp2_cid_table_find(const ngtcp2_cid_table *table,
+                                          const uint8_t *cid);
+
+/**
+ * @function
+ *
+ * `ngtcp2_cid_table_find_batch` looks up |n| Connection IDs pointed
+ * by |cids|, and assigns the associated data to the corresponding
+ * element of |data|, or ``NULL`` if it is not found.  It is
+ * equivalent to calling `ngtcp2_cid_table_find` for each Connection
+ * ID, but it is faster for a batch of packets, e.g., received by a
+ * single recvmmsg(2) call, because the memory accesses of the
+ * lookups overlap.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN void ngtcp2_cid_table_find_batch(const ngtcp2_cid_table *table,
+                                               void **data,
+                                               const uint8_t *const *cids,
+                                               size_t n);
+
+/**
+ * @function
+ *
+ * `ngtcp2_cid_table_size` returns the number of Connection IDs in
+ * |table|.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN size_t ngtcp2_cid_table_size(const ngtcp2_cid_table *table);
+
 #define NGTCP2_SETTINGS_V1 1
 #define NGTCP2_SETTINGS_V2 2
 #define NGTCP2_SETTINGS_V3 3
 #define NGTCP2_SETTINGS_V4 4
-#define NGTCP2_SETTINGS_VERSION NGTCP2_SETTINGS_V4
+#define NGTCP2_SETTINGS_V5 5
+#define NGTCP2_SETTINGS_VERSION NGTCP2_SETTINGS_V5
 
 /**
  * @struct
@@ -2116,6 +2554,69 @@ typedef struct ngtcp2_settings {
    * .. version-added:: 1.23.0
    */
   ngtcp2_log_write log_write;
+  /* The following fields have been added since NGTCP2_SETTINGS_V5. */
+  /**
+   * :member:`handshake_arena`, if set to nonzero, makes the
+   * connection carve the objects which only live during the
+   * handshake, such as Initial and Handshake packet number spaces
+   * and their keying materials, from a per-connection memory arena.
+   * The arena allocates a few contiguous memory blocks through
+   * :type:`ngtcp2_mem` passed to `ngtcp2_conn_client_new` or
+   * `ngtcp2_conn_server_new`, and releases them in bulk when all of
+   * those objects are discarded, or the connection is deleted.  This
+   * reduces the number of small allocations per connection.
+   *
+   * .. version-added:: 1.26.0
+   */
+  uint8_t handshake_arena;
+  /**
+   * :member:`objpool`, if not ``NULL``, is the memory pool shared
+   * with other connections.  The connection takes the memory blocks
+   * for its internal object allocators from the pool, and returns
+   * them to it when the connection is deleted.  The blocks of the
+   * handshake arena are returned when the handshake state is
+   * discarded.  The pool must
+   * outlive the connection, and must only be used from the thread
+   * that uses the connection.  See :type:`ngtcp2_objpool`.
+   *
+   * .. version-added:: 1.26.0
+   */
+  ngtcp2_objpool *objpool;
+  /**
+   * :member:`rx_budget`, if not ``NULL``, is the receive buffer
+   * budget shared with other connections.  The growth of the flow
+   * control windows by auto-tuning is charged to the budget, and
+   * capped by it.  The budget must outlive the connection, and must
+   * only be used from the thread that uses the connection.  See
+   * :type:`ngtcp2_rx_budget`.
+   *
+   * .. version-added:: 1.26.0
+   */
+  ngtcp2_rx_budget *rx_budget;
+  /**
+   * :member:`timerq`, if not ``NULL``, is the timer wheel shared with
+   * other connections.  The connection keeps its deadline in the
+   * timer wheel up to date.  The timer wheel must outlive the
+   * connection, and must only be used from the thread that uses the
+   * connection.  See :type:`ngtcp2_timerq`.
+   *
+   * .. version-added:: 1.26.0
+   */
+  ngtcp2_timerq *timerq;
+  /**
+   * :member:`cid_table`, if not ``NULL``, is the Connection ID table
+   * shared with other connections.  This field is only used by
+   * server.  The connection registers its own Connection IDs to the
+   * table with its user data, which must not be ``NULL``; otherwise
+   * `ngtcp2_conn_server_new` returns
+   * :macro:`NGTCP2_ERR_INVALID_ARGUMENT`.  The length of the Connection IDs must be the one passed to
+   * `ngtcp2_cid_table_new`.  The table must outlive the connection,
+   * and must only be used from the thread that uses the connection.
+   * See :type:`ngtcp2_cid_table`.
+   *
+   * .. version-added:: 1.26.0
+   */
+  ngtcp2_cid_table *cid_table;
 } ngtcp2_settings;
 
 /**
@@ -2883,6 +3384,70 @@ typedef int (*ngtcp2_hp_mask)(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
                               const ngtcp2_crypto_cipher_ctx *hp_ctx,
                               const uint8_t *sample);
 
+/**
+ * @functypedef
+ *
+ * :type:`ngtcp2_hp_mask_batch` is invoked when the ngtcp2 library
+ * asks the application to produce header protection masks for
+ * multiple packets at once.  The encryption cipher is |hp|.  |hp_ctx|
+ * is the cipher context object which is initialized with the
+ * specific header protection key.  |samples| is an array of
+ * |nsamples| pointers, each of which points to the sample that is
+ * :macro:`NGTCP2_HP_SAMPLELEN` bytes long.
+ *
+ * The implementation of this callback must produce a mask for each
+ * sample as :type:`ngtcp2_hp_mask` does, and write the mask for
+ * |samples| [i] into the buffer pointed by |dest| + i *
+ * :macro:`NGTCP2_HP_SAMPLELEN`.  The buffer pointed by |dest| is
+ * guaranteed to have at least |nsamples| *
+ * :macro:`NGTCP2_HP_SAMPLELEN` bytes available.
+ *
+ * The callback function must return 0 if it succeeds, or
+ * :macro:`NGTCP2_ERR_CALLBACK_FAILURE` which makes the library call
+ * return immediately.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef int (*ngtcp2_hp_mask_batch)(uint8_t *dest,
+                                    const ngtcp2_crypto_cipher *hp,
+                                    const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                                    const uint8_t *const *samples,
+                                    size_t nsamples);
+
+/**
+ * @functypedef
+ *
+ * :type:`ngtcp2_encryptv` is invoked when the ngtcp2 library asks the
+ * application to encrypt packet payload which is scattered across
+ * multiple buffers.  The packet payload to encrypt is the
+ * concatenation of |plaintextcnt| buffers pointed by |plaintextv|.
+ * The AEAD cipher is |aead|.  |aead_ctx| is the AEAD cipher context
+ * object which is initialized with the specific encryption key.  The
+ * nonce is passed as |nonce| of length |noncelen|.  The Additional
+ * Authenticated Data is passed as |aad| of length |aadlen|.
+ *
+ * The implementation of this callback must encrypt the payload using
+ * the negotiated cipher suite, and write the ciphertext into the
+ * buffer pointed by |dest|.  |dest| has enough capacity to store the
+ * ciphertext and any additional AEAD tag data.
+ *
+ * Each element of |plaintextv| either points to the exact position in
+ * |dest| where its ciphertext is written (that is, it is encrypted in
+ * place), or does not overlap |dest| at all.
+ *
+ * The callback function must return 0 if it succeeds, or
+ * :macro:`NGTCP2_ERR_CALLBACK_FAILURE` which makes the library call
+ * return immediately.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef int (*ngtcp2_encryptv)(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                               const ngtcp2_crypto_aead_ctx *aead_ctx,
+                               const ngtcp2_vec *plaintextv,
+                               size_t plaintextcnt, const uint8_t *nonce,
+                               size_t noncelen, const uint8_t *aad,
+                               size_t aadlen);
+
 /**
  * @macrosection
  *
@@ -3737,6 +4302,20 @@ typedef int (*ngtcp2_stream_close2)(ngtcp2_conn *conn, uint32_t flags,
 typedef int (*ngtcp2_extend_max_data)(ngtcp2_conn *conn, uint64_t max_data,
                                       void *user_data);
 
+/**
+ * @functypedef
+ *
+ * :type:`ngtcp2_release_rx_buf` is a callback function which is
+ * invoked when the library no longer references the receive buffer
+ * |rx_buf| that was passed to `ngtcp2_conn_read_pkt_rx_buf`.  After
+ * this callback function returns, an application may reuse or free
+ * the buffer.
+ *
+ * .. version-added:: 1.26.0
+ */
+typedef void (*ngtcp2_release_rx_buf)(ngtcp2_conn *conn, void *rx_buf,
+                                      void *user_data);
+
 #define NGTCP2_CALLBACKS_V1 1
 #define NGTCP2_CALLBACKS_V2 2
 #define NGTCP2_CALLBACKS_V3 3
@@ -4115,6 +4694,38 @@ typedef struct ngtcp2_callbacks {
    * .. version-added:: 1.26.0
    */
   ngtcp2_extend_max_data extend_max_data;
+  /**
+   * :member:`hp_mask_batch` is a callback function which is invoked
+   * by `ngtcp2_conn_read_pkts` and
+   * `ngtcp2_conn_write_aggregate_pkt2` to get the header protection
+   * masks for several packets in a single call.  If it is not
+   * specified, :member:`hp_mask` is called for each packet.  This
+   * callback function is optional.
+   *
+   * .. version-added:: 1.26.0
+   */
+  ngtcp2_hp_mask_batch hp_mask_batch;
+  /**
+   * :member:`encryptv` is a callback function which is invoked to
+   * encrypt a packet which contains STREAM frames.  If it is
+   * specified, the library does not copy stream data into the packet
+   * buffer when encoding STREAM frame.  Instead, the data is encrypted
+   * directly from the buffers passed by an application.  If it is not
+   * specified, :member:`encrypt` is used.  This callback function is
+   * optional.
+   *
+   * .. version-added:: 1.26.0
+   */
+  ngtcp2_encryptv encryptv;
+  /**
+   * :member:`release_rx_buf` is a callback function which is invoked
+   * when the library releases the receive buffer passed to
+   * `ngtcp2_conn_read_pkt_rx_buf`.  This callback function is
+   * optional.
+   *
+   * .. version-added:: 1.26.0
+   */
+  ngtcp2_release_rx_buf release_rx_buf;
 } ngtcp2_callbacks;
 
 /**
@@ -4256,6 +4867,10 @@ NGTCP2_EXTERN int ngtcp2_conn_client_new_versioned(
  *
  * :macro:`NGTCP2_ERR_NOMEM`
  *     Out of memory.
+ * :macro:`NGTCP2_ERR_INVALID_ARGUMENT`
+ *     :member:`ngtcp2_settings.cid_table` is set, and |user_data| is
+ *     ``NULL``, or |scid| is already in the table, or its length does
+ *     not match the table.
  */
 NGTCP2_EXTERN int ngtcp2_conn_server_new_versioned(
   ngtcp2_conn **pconn, const ngtcp2_cid *dcid, const ngtcp2_cid *scid,
@@ -4319,6 +4934,78 @@ ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
                                const uint8_t *pkt, size_t pktlen,
                                ngtcp2_tstamp ts);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_read_pkts` processes |pktcnt| UDP datagrams pointed
+ * by |pktv|, which are received on the same |path| with the same
+ * packet metadata |pi|, typically from a single batched receive
+ * operation (e.g., recvmmsg, or UDP GRO).  |pi| may be ``NULL``.
+ *
+ * This function is equivalent to calling `ngtcp2_conn_read_pkt` for
+ * each datagram in order, except that, after the handshake has
+ * completed, the header protection masks for the short header
+ * packets at the beginning of each datagram are computed in advance
+ * by :member:`ngtcp2_callbacks.hp_mask_batch` if it is set, so that
+ * the crypto backend can process several samples in one call.
+ *
+ * This function must not be called from inside the callback
+ * functions.
+ *
+ * This function returns 0 if it succeeds.  If processing a datagram
+ * fails, this function returns immediately without processing the
+ * remaining datagrams, and returns the same error that
+ * `ngtcp2_conn_read_pkt` would return for that datagram.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int
+ngtcp2_conn_read_pkts_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
+                                int pkt_info_version, const ngtcp2_pkt_info *pi,
+                                const ngtcp2_vec *pktv, size_t pktcnt,
+                                ngtcp2_tstamp ts);
+
+/**
+ * @function
+ *
+ * `ngtcp2_conn_read_pkt_rx_buf` works like `ngtcp2_conn_read_pkt`,
+ * but it avoids copying the stream data which is received out of
+ * order.  |pkt| must point to the buffer which an application owns,
+ * and |rx_buf| is an opaque handle to it which is passed to
+ * :member:`ngtcp2_callbacks.release_rx_buf`.
+ *
+ * The library decrypts 1RTT and 0RTT packets in place, and the
+ * content of the buffer pointed by |pkt| is altered.  Instead of
+ * copying out-of-order stream data into its internal buffer, the
+ * library references the data in |pkt| until it is delivered to an
+ * application via :member:`ngtcp2_callbacks.recv_stream_data`, or
+ * discarded.  The data is still copied if it is less than half of
+ * |pktlen|, or if the buffers referenced by a stream or by the
+ * connection exceed the internal limit, so that the pinned memory
+ * stays proportional to the buffered data.  An application must not
+ * modify or free the buffer
+ * until :member:`ngtcp2_callbacks.release_rx_buf` is called for
+ * |rx_buf|.  It is called exactly once for each call of this
+ * function, possibly before this function returns.  It might be
+ * called from `ngtcp2_conn_del`.
+ *
+ * If :member:`ngtcp2_callbacks.release_rx_buf` is not set, this
+ * function is equivalent to `ngtcp2_conn_read_pkt`.
+ *
+ * This function returns 0 if it succeeds, or negative error codes
+ * that `ngtcp2_conn_read_pkt` returns.  In addition to them, it might
+ * return the following negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_NOMEM`
+ *     Out of memory.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_conn_read_pkt_rx_buf_versioned(
+  ngtcp2_conn *conn, const ngtcp2_path *path, int pkt_info_version,
+  const ngtcp2_pkt_info *pi, uint8_t *pkt, size_t pktlen, void *rx_buf,
+  ngtcp2_tstamp ts);
+
 /**
  * @function
  *
@@ -4726,10 +5413,32 @@ NGTCP2_EXTERN ngtcp2_tstamp ngtcp2_conn_get_expiry(ngtcp2_conn *conn);
  *
  * Call `ngtcp2_conn_handle_expiry` when the expiry time has passed.
  *
+ * The connection does not compute its expiry while it reads or
+ * writes packets.  This function computes it if something that
+ * affects the timers has changed since `ngtcp2_conn_poll_expiry`
+ * cached it, and returns the cached value otherwise.
+ *
  * .. version-added:: 1.23.0
  */
 NGTCP2_EXTERN ngtcp2_tstamp ngtcp2_conn_get_expiry2(const ngtcp2_conn *conn);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_poll_expiry` assigns the next expiry time to
+ * |*pexpiry| as `ngtcp2_conn_get_expiry2` returns.  It returns
+ * nonzero if the expiry time differs from the one assigned by the
+ * previous call of this function, or 0 otherwise.  An application
+ * can call this function after every `ngtcp2_conn_read_pkt` and
+ * `ngtcp2_conn_writev_stream`, and reschedule its timer only if it
+ * returns nonzero.  Initially, the previous expiry time is assumed to
+ * be ``UINT64_MAX``.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_conn_poll_expiry(ngtcp2_conn *conn,
+                                          ngtcp2_tstamp *pexpiry);
+
 /**
  * @function
  *
@@ -4752,6 +5461,25 @@ NGTCP2_EXTERN ngtcp2_tstamp ngtcp2_conn_get_expiry2(const ngtcp2_conn *conn);
 NGTCP2_EXTERN int ngtcp2_conn_handle_expiry(ngtcp2_conn *conn,
                                             ngtcp2_tstamp ts);
 
+/**
+ * @function
+ *
+ * `ngtcp2_timerq_pop_expired` removes at most |nconns| connections
+ * whose deadlines have passed at |ts| from |timerq|, and assigns them
+ * to |pconns|.  It returns the number of connections assigned.  If it
+ * returns |nconns|, there might be more connections which are due.
+ * |ts| must not be less than the one passed to the previous call.
+ *
+ * The removed connection is added back to |timerq| when
+ * `ngtcp2_conn_handle_expiry` is called for it.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN size_t ngtcp2_timerq_pop_expired(ngtcp2_timerq *timerq,
+                                               ngtcp2_conn **pconns,
+                                               size_t nconns,
+                                               ngtcp2_tstamp ts);
+
 /**
  * @function
  *
@@ -6008,6 +6736,49 @@ ngtcp2_conn_submit_crypto_data(ngtcp2_conn *conn,
                                ngtcp2_encryption_level encryption_level,
                                const uint8_t *data, const size_t datalen);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_submit_ack_frequency` asks a remote endpoint to change
+ * its acknowledgement frequency by sending ACK_FREQUENCY frame
+ * (draft-ietf-quic-ack-frequency).  The remote endpoint sends an
+ * acknowledgement after receiving more than |ack_eliciting_thresh|
+ * ack-eliciting packets, or after |max_ack_delay| has passed since it
+ * received an unacknowledged ack-eliciting packet, whichever comes
+ * first.  |reordering_thresh| is the number of out-of-order packets
+ * that triggers an immediate acknowledgement.  0 disables immediate
+ * acknowledgement on reordering, and 1 is the default behavior of
+ * QUIC v1.
+ *
+ * For example, bulk transfer on a path with large
+ * bandwidth-delay product might ask for an acknowledgement every 10
+ * packets or every smoothed RTT / 4.  The local endpoint takes
+ * |max_ack_delay| into account when it computes PTO.
+ *
+ * This function can be called only after the handshake has
+ * completed, and the remote endpoint advertised min_ack_delay
+ * transport parameter.  Only the most recent request is
+ * retransmitted if it is lost.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_INVALID_STATE`
+ *     The remote endpoint does not support ACK Frequency extension.
+ * :macro:`NGTCP2_ERR_INVALID_ARGUMENT`
+ *     |max_ack_delay| is less than min_ack_delay of the remote
+ *     endpoint, or it is not less than (1 << 14) milliseconds; or
+ *     |ack_eliciting_thresh| or |reordering_thresh| exceeds
+ *     :macro:`NGTCP2_MAX_VARINT`.
+ * :macro:`NGTCP2_ERR_NOMEM`
+ *     Out of memory.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_conn_submit_ack_frequency(
+  ngtcp2_conn *conn, uint64_t ack_eliciting_thresh,
+  ngtcp2_duration max_ack_delay, uint64_t reordering_thresh);
+
 /**
  * @function
  *
@@ -6817,6 +7588,95 @@ NGTCP2_EXTERN int ngtcp2_conn_after_retry(ngtcp2_conn *conn);
  */
 NGTCP2_EXTERN int ngtcp2_conn_after_retry2(const ngtcp2_conn *conn);
 
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_STREAM_URGENCY_LEVELS` is the number of stream
+ * urgency levels.  The valid urgency is in the range [0,
+ * :macro:`NGTCP2_STREAM_URGENCY_LEVELS`).
+ *
+ * .. version-added:: 1.26.0
+ */
+#define NGTCP2_STREAM_URGENCY_LEVELS 8
+
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_DEFAULT_STREAM_URGENCY` is the default urgency of a
+ * stream.
+ *
+ * .. version-added:: 1.26.0
+ */
+#define NGTCP2_DEFAULT_STREAM_URGENCY 3
+
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_MAX_STREAM_WEIGHT` is the maximum weight of a
+ * stream.
+ *
+ * .. version-added:: 1.26.0
+ */
+#define NGTCP2_MAX_STREAM_WEIGHT 256
+
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_DEFAULT_STREAM_WEIGHT` is the default weight of a
+ * stream.
+ *
+ * .. version-added:: 1.26.0
+ */
+#define NGTCP2_DEFAULT_STREAM_WEIGHT 16
+
+/**
+ * @function
+ *
+ * `ngtcp2_conn_set_stream_priority` sets the priority of the stream
+ * identified by |stream_id|.  The priority decides the order of
+ * streams when the library retransmits lost STREAM frames, and
+ * whether the new data given to `ngtcp2_conn_writev_stream` can be
+ * sent ahead of those retransmissions.
+ *
+ * |urgency| is the urgency of the stream in [0,
+ * :macro:`NGTCP2_STREAM_URGENCY_LEVELS`), following the urgency of
+ * RFC 9218.  The smaller value is more urgent.  The data of a more
+ * urgent stream are always sent before the data of a less urgent
+ * stream.  When `ngtcp2_conn_writev_stream` is called with a stream,
+ * its new data are sent before any retransmission of less urgent
+ * streams.
+ *
+ * If |incremental| is nonzero, the stream shares the bandwidth with
+ * the other incremental streams of the same urgency in proportion to
+ * |weight|.  If |weight| is 0, :macro:`NGTCP2_DEFAULT_STREAM_WEIGHT`
+ * is used.  The maximum value is :macro:`NGTCP2_MAX_STREAM_WEIGHT`.
+ * If |incremental| is 0, the stream is served until it has nothing
+ * to retransmit, and |weight| is ignored.  Non-incremental streams of
+ * the same urgency are served in the ascending order of stream ID.
+ *
+ * A newly opened stream has urgency
+ * :macro:`NGTCP2_DEFAULT_STREAM_URGENCY`, and it is incremental with
+ * weight :macro:`NGTCP2_DEFAULT_STREAM_WEIGHT`.  This is the round
+ * robin scheduling the library has used so far.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_INVALID_ARGUMENT`
+ *     |urgency| or |weight| is out of range.
+ * :macro:`NGTCP2_ERR_STREAM_NOT_FOUND`
+ *     Stream does not exist
+ * :macro:`NGTCP2_ERR_NOMEM`
+ *     Out of memory
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN int ngtcp2_conn_set_stream_priority(ngtcp2_conn *conn,
+                                                  int64_t stream_id,
+                                                  uint32_t urgency,
+                                                  int incremental,
+                                                  uint32_t weight);
+
 /**
  * @function
  *
@@ -7042,6 +7902,12 @@ NGTCP2_EXTERN ngtcp2_ssize ngtcp2_conn_write_aggregate_pkt_versioned(
  * an application.  It can experiment different GSO buffer size
  * strategy and number of GSO writes per event loop.
  *
+ * If :member:`ngtcp2_callbacks.hp_mask_batch` is set, header
+ * protection of 1RTT packets is applied in batch just before this
+ * function returns.  Therefore, |write_pkt| must leave the packet
+ * written by `ngtcp2_conn_writev_stream` or the similar functions in
+ * the buffer that is passed to it, and must not copy it elsewhere.
+ *
  * .. version-added:: 1.17.0
  */
 NGTCP2_EXTERN ngtcp2_ssize ngtcp2_conn_write_aggregate_pkt2_versioned(
@@ -7049,6 +7915,46 @@ NGTCP2_EXTERN ngtcp2_ssize ngtcp2_conn_write_aggregate_pkt2_versioned(
   ngtcp2_pkt_info *pi, uint8_t *buf, size_t buflen, size_t *pgsolen,
   ngtcp2_write_pkt write_pkt, size_t num_pkts, ngtcp2_tstamp ts);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_write_aggregate_pkt_txtime` behaves like
+ * `ngtcp2_conn_write_aggregate_pkt2`, but it is intended for an
+ * application that delegates packet pacing to the kernel (e.g., Linux
+ * SO_TXTIME with fq qdisc).  Instead of waiting for the pacing timer
+ * to expire, this function writes packets whose scheduled departure
+ * time is at most |horizon| ahead of |ts|, and assigns the departure
+ * time of the written packets to |*ptxtime|.  The application should
+ * pass |*ptxtime| to the kernel along with the packets (e.g., in
+ * SCM_TXTIME control message).  |*ptxtime| is never earlier than
+ * |ts|.  If |horizon| is 0, packets are written only when pacing
+ * allows them to be sent immediately, just like
+ * `ngtcp2_conn_write_aggregate_pkt2`.
+ *
+ * After all packets are written, this function schedules the next
+ * transmission relative to |*ptxtime| so that the application can
+ * call this function repeatedly to hand a train of bursts to the
+ * kernel in a single wakeup.  If |horizon| is nonzero, consecutive
+ * bursts are at least one pacing interval apart even after a late
+ * wakeup.  The application must not call
+ * `ngtcp2_conn_update_pkt_tx_time` for the packets written by this
+ * function.  `ngtcp2_conn_get_expiry2` returns the departure
+ * time of the next burst; the application can call this function
+ * again when the remaining horizon runs short, rather than at that
+ * exact time.
+ *
+ * This function returns the number of bytes written to the buffer, or
+ * a negative error code returned by |write_pkt|.  If this function
+ * returns 0, |*ptxtime| is unspecified.
+ *
+ * .. version-added:: 1.26.0
+ */
+NGTCP2_EXTERN ngtcp2_ssize ngtcp2_conn_write_aggregate_pkt_txtime_versioned(
+  ngtcp2_conn *conn, ngtcp2_path *path, int pkt_info_version,
+  ngtcp2_pkt_info *pi, uint8_t *buf, size_t buflen, size_t *pgsolen,
+  ngtcp2_tstamp *ptxtime, ngtcp2_write_pkt write_pkt, size_t num_pkts,
+  ngtcp2_duration horizon, ngtcp2_tstamp ts);
+
 /**
  * @function
  *
@@ -7332,6 +8238,25 @@ NGTCP2_EXTERN void ngtcp2_secure_clear(void *data, size_t len);
   ngtcp2_conn_read_pkt_versioned((CONN), (PATH), NGTCP2_PKT_INFO_VERSION,      \
                                  (PI), (PKT), (PKTLEN), (TS))
 
+/*
+ * `ngtcp2_conn_read_pkts` is a wrapper around
+ * `ngtcp2_conn_read_pkts_versioned` to set the correct struct
+ * version.
+ */
+#define ngtcp2_conn_read_pkts(CONN, PATH, PI, PKTV, PKTCNT, TS)                \
+  ngtcp2_conn_read_pkts_versioned((CONN), (PATH), NGTCP2_PKT_INFO_VERSION,     \
+                                  (PI), (PKTV), (PKTCNT), (TS))
+
+/*
+ * `ngtcp2_conn_read_pkt_rx_buf` is a wrapper around
+ * `ngtcp2_conn_read_pkt_rx_buf_versioned` to set the correct struct
+ * version.
+ */
+#define ngtcp2_conn_read_pkt_rx_buf(CONN, PATH, PI, PKT, PKTLEN, RX_BUF, TS)   \
+  ngtcp2_conn_read_pkt_rx_buf_versioned((CONN), (PATH),                        \
+                                        NGTCP2_PKT_INFO_VERSION, (PI), (PKT),  \
+                                        (PKTLEN), (RX_BUF), (TS))
+
 /*
  * `ngtcp2_conn_write_pkt` is a wrapper around
  * `ngtcp2_conn_write_pkt_versioned` to set the correct struct
@@ -7473,6 +8398,15 @@ NGTCP2_EXTERN void ngtcp2_secure_clear(void *data, size_t len);
   ngtcp2_conn_get_conn_info2_versioned((CONN), NGTCP2_CONN_INFO_VERSION,       \
                                        (CINFO))
 
+/*
+ * `ngtcp2_objpool_get_stat` is a wrapper around
+ * `ngtcp2_objpool_get_stat_versioned` to set the correct struct
+ * version.
+ */
+#define ngtcp2_objpool_get_stat(POOL, STAT)                                    \
+  ngtcp2_objpool_get_stat_versioned((POOL), NGTCP2_OBJPOOL_STAT_VERSION,       \
+                                    (STAT))
+
 /*
  * `ngtcp2_conn_write_aggregate_pkt` is a wrapper around
  * `ngtcp2_conn_write_aggregate_pkt_versioned` to set the correct
@@ -7495,6 +8429,18 @@ NGTCP2_EXTERN void ngtcp2_secure_clear(void *data, size_t len);
     (CONN), (PATH), NGTCP2_PKT_INFO_VERSION, (PI), (BUF), (BUFLEN), (PGSOLEN), \
     (WRITE_PKT), (NUM_PKTS), (TS))
 
+/*
+ * `ngtcp2_conn_write_aggregate_pkt_txtime` is a wrapper around
+ * `ngtcp2_conn_write_aggregate_pkt_txtime_versioned` to set the
+ * correct struct version.
+ */
+#define ngtcp2_conn_write_aggregate_pkt_txtime(CONN, PATH, PI, BUF, BUFLEN,    \
+                                               PGSOLEN, PTXTIME, WRITE_PKT,    \
+                                               NUM_PKTS, HORIZON, TS)          \
+  ngtcp2_conn_write_aggregate_pkt_txtime_versioned(                            \
+    (CONN), (PATH), NGTCP2_PKT_INFO_VERSION, (PI), (BUF), (BUFLEN), (PGSOLEN), \
+    (PTXTIME), (WRITE_PKT), (NUM_PKTS), (HORIZON), (TS))
+
 /*
  * `ngtcp2_settings_default` is a wrapper around
  * `ngtcp2_settings_default_versioned` to set the correct struct
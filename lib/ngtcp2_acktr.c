@@ -38,7 +38,7 @@ static int pkt_range_greater(const ngtcp2_ksl_key *lhs,
   return a->pkt_num > b->pkt_num;
 }
 
-ngtcp2_ksl_search_def(pkt_range_greater, pkt_range_greater)
+ngtcp2_ksl_bsearch_def(pkt_range_greater, pkt_range_greater)
 
 void ngtcp2_acktr_init(ngtcp2_acktr *acktr, ngtcp2_log *log,
                        const ngtcp2_mem *mem) {
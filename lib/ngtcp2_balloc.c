@@ -26,7 +26,10 @@
 
 #include <assert.h>
 
+#include <string.h>
+
 #include "ngtcp2_mem.h"
+#include "ngtcp2_objpool.h"
 
 void ngtcp2_balloc_init(ngtcp2_balloc *balloc, size_t blklen,
                         const ngtcp2_mem *mem) {
@@ -36,6 +39,21 @@ void ngtcp2_balloc_init(ngtcp2_balloc *balloc, size_t blklen,
   balloc->blklen = blklen;
   balloc->head = NULL;
   ngtcp2_buf_init(&balloc->buf, (void *)"", 0);
+  balloc->pool = NULL;
+}
+
+void ngtcp2_balloc_set_objpool(ngtcp2_balloc *balloc, ngtcp2_objpool *pool) {
+  assert(balloc->head == NULL);
+
+  balloc->pool = pool;
+}
+
+/*
+ * balloc_memblock_len returns the number of bytes of a memory block
+ * allocated by |balloc|.
+ */
+static size_t balloc_memblock_len(const ngtcp2_balloc *balloc) {
+  return sizeof(ngtcp2_memblock_hd) + 0x8U + balloc->blklen;
 }
 
 void ngtcp2_balloc_free(ngtcp2_balloc *balloc) {
@@ -51,7 +69,12 @@ void ngtcp2_balloc_clear(ngtcp2_balloc *balloc) {
 
   for (p = balloc->head; p; p = next) {
     next = p->next;
-    ngtcp2_mem_free(balloc->mem, p);
+
+    if (balloc->pool) {
+      ngtcp2_objpool_put_block(balloc->pool, p, balloc_memblock_len(balloc));
+    } else {
+      ngtcp2_mem_free(balloc->mem, p);
+    }
   }
 
   balloc->head = NULL;
@@ -65,8 +88,11 @@ int ngtcp2_balloc_get(ngtcp2_balloc *balloc, void **pbuf, size_t n) {
   assert(n <= balloc->blklen);
 
   if (ngtcp2_buf_left(&balloc->buf) < n) {
-    p = ngtcp2_mem_malloc(balloc->mem,
-                          sizeof(ngtcp2_memblock_hd) + 0x8U + balloc->blklen);
+    if (balloc->pool) {
+      p = ngtcp2_objpool_get_block(balloc->pool, balloc_memblock_len(balloc));
+    } else {
+      p = ngtcp2_mem_malloc(balloc->mem, balloc_memblock_len(balloc));
+    }
     if (p == NULL) {
       return NGTCP2_ERR_NOMEM;
     }
@@ -88,3 +114,55 @@ int ngtcp2_balloc_get(ngtcp2_balloc *balloc, void **pbuf, size_t n) {
 
   return 0;
 }
+
+static void *balloc_mem_malloc(size_t size, void *user_data) {
+  ngtcp2_balloc *balloc = user_data;
+  void *p;
+
+  if (size > balloc->blklen || ngtcp2_balloc_get(balloc, &p, size) != 0) {
+    return NULL;
+  }
+
+  return p;
+}
+
+static void balloc_mem_free(void *ptr, void *user_data) {
+  (void)ptr;
+  (void)user_data;
+}
+
+static void *balloc_mem_calloc(size_t nmemb, size_t size, void *user_data) {
+  ngtcp2_balloc *balloc = user_data;
+  void *p;
+
+  if (size && nmemb > balloc->blklen / size) {
+    return NULL;
+  }
+
+  p = balloc_mem_malloc(nmemb * size, user_data);
+  if (p == NULL) {
+    return NULL;
+  }
+
+  memset(p, 0, nmemb * size);
+
+  return p;
+}
+
+static void *balloc_mem_realloc(void *ptr, size_t size, void *user_data) {
+  (void)ptr;
+  (void)size;
+  (void)user_data;
+
+  return NULL;
+}
+
+void ngtcp2_balloc_mem_init(ngtcp2_mem *mem, ngtcp2_balloc *balloc) {
+  *mem = (ngtcp2_mem){
+    .user_data = balloc,
+    .malloc = balloc_mem_malloc,
+    .free = balloc_mem_free,
+    .calloc = balloc_mem_calloc,
+    .realloc = balloc_mem_realloc,
+  };
+}
@@ -59,6 +59,10 @@ typedef struct ngtcp2_balloc {
   ngtcp2_memblock_hd *head;
   /* buf wraps the current memory block for allocation requests. */
   ngtcp2_buf buf;
+  /* pool, if not NULL, is the shared memory pool from which memory
+     blocks are obtained, and to which they are returned instead of
+     mem. */
+  ngtcp2_objpool *pool;
 } ngtcp2_balloc;
 
 /*
@@ -91,4 +95,22 @@ int ngtcp2_balloc_get(ngtcp2_balloc *balloc, void **pbuf, size_t n);
  */
 void ngtcp2_balloc_clear(ngtcp2_balloc *balloc);
 
+/*
+ * ngtcp2_balloc_set_objpool makes |balloc| obtain memory blocks from
+ * |pool|, and return them to |pool|.  This function must be called
+ * before any memory is allocated from |balloc|.
+ */
+void ngtcp2_balloc_set_objpool(ngtcp2_balloc *balloc, ngtcp2_objpool *pool);
+
+/*
+ * ngtcp2_balloc_mem_init initializes |mem| so that it allocates
+ * memory from |balloc|.  The memory obtained through |mem| is never
+ * returned to |balloc| individually; ngtcp2_mem_free is a no-op, and
+ * all memory is released in bulk by ngtcp2_balloc_clear or
+ * ngtcp2_balloc_free.  An allocation request which is larger than
+ * |balloc|->blklen fails, and ngtcp2_mem_realloc is not supported.
+ * |balloc| must outlive |mem|.
+ */
+void ngtcp2_balloc_mem_init(ngtcp2_mem *mem, ngtcp2_balloc *balloc);
+
 #endif /* !defined(NGTCP2_BALLOC_H) */
@@ -0,0 +1,406 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_cid_table.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include "ngtcp2_mem.h"
+#include "ngtcp2_macro.h"
+
+#define NGTCP2_CID_TABLE_INITIAL_HASHBITS 4
+
+/* NGTCP2_CID_TABLE_MAX_PSL_RESIZE_THRESH is the maximum psl
+   threshold.  If reached, resize the table. */
+#define NGTCP2_CID_TABLE_MAX_PSL_RESIZE_THRESH 128
+
+/* NGTCP2_CID_TABLE_BATCHLEN is the number of lookups whose slots are
+   prefetched at once by ngtcp2_cid_table_find_batch. */
+#define NGTCP2_CID_TABLE_BATCHLEN 16
+
+static uint64_t load_uint64le(const uint8_t *p) {
+  return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) |
+         ((uint64_t)p[3] << 24) | ((uint64_t)p[4] << 32) |
+         ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) |
+         ((uint64_t)p[7] << 56);
+}
+
+static uint64_t rotl(uint64_t x, size_t n) {
+  return (x << n) | (x >> (64 - n));
+}
+
+static void siphash_round(uint64_t v[4]) {
+  v[0] += v[1];
+  v[2] += v[3];
+  v[1] = rotl(v[1], 13);
+  v[3] = rotl(v[3], 16);
+  v[1] ^= v[0];
+  v[3] ^= v[2];
+  v[0] = rotl(v[0], 32);
+  v[2] += v[1];
+  v[0] += v[3];
+  v[1] = rotl(v[1], 17);
+  v[3] = rotl(v[3], 21);
+  v[1] ^= v[2];
+  v[3] ^= v[0];
+  v[2] = rotl(v[2], 32);
+}
+
+uint64_t ngtcp2_cid_table_hash(const uint64_t key[2], const uint8_t *data,
+                               size_t datalen) {
+  uint64_t v[] = {
+    key[0] ^ 0x736F6D6570736575ULL,
+    key[1] ^ 0x646F72616E646F6DULL,
+    key[0] ^ 0x6C7967656E657261ULL,
+    key[1] ^ 0x7465646279746573ULL,
+  };
+  uint8_t last_block[8] = {0};
+  size_t origlen = datalen;
+  uint64_t m;
+
+  for (; datalen >= sizeof(uint64_t);
+       data += sizeof(uint64_t), datalen -= sizeof(uint64_t)) {
+    m = load_uint64le(data);
+    v[3] ^= m;
+    siphash_round(v);
+    siphash_round(v);
+    v[0] ^= m;
+  }
+
+  if (datalen) {
+    memcpy(last_block, data, datalen);
+  }
+
+  last_block[7] = (uint8_t)origlen;
+
+  m = load_uint64le(last_block);
+  v[3] ^= m;
+  siphash_round(v);
+  siphash_round(v);
+  v[0] ^= m;
+
+  v[2] ^= 0xFF;
+  siphash_round(v);
+  siphash_round(v);
+  siphash_round(v);
+  siphash_round(v);
+
+  return v[0] ^ v[1] ^ v[2] ^ v[3];
+}
+
+int ngtcp2_cid_table_new(ngtcp2_cid_table **ptable, size_t cidlen,
+                         const uint8_t *key, const ngtcp2_mem *mem) {
+  ngtcp2_cid_table *table;
+
+  assert(cidlen);
+  assert(cidlen <= NGTCP2_MAX_CIDLEN);
+
+  if (mem == NULL) {
+    mem = ngtcp2_mem_default();
+  }
+
+  table = ngtcp2_mem_malloc(mem, sizeof(*table));
+  if (table == NULL) {
+    return NGTCP2_ERR_NOMEM;
+  }
+
+  *table = (ngtcp2_cid_table){
+    .mem = mem,
+    .key =
+      {
+        load_uint64le(key),
+        load_uint64le(key + sizeof(uint64_t)),
+      },
+    .cidlen = cidlen,
+  };
+
+  *ptable = table;
+
+  return 0;
+}
+
+void ngtcp2_cid_table_del(ngtcp2_cid_table *table) {
+  if (table == NULL) {
+    return;
+  }
+
+  ngtcp2_mem_free(table->mem, table->ents);
+  ngtcp2_mem_free(table->mem, table);
+}
+
+size_t ngtcp2_cid_table_size(const ngtcp2_cid_table *table) {
+  return table->size;
+}
+
+static size_t cid_table_index(const ngtcp2_cid_table *table, uint64_t hash) {
+  return (size_t)(hash >> (64 - table->hashbits));
+}
+
+/*
+ * cid_table_insert inserts |cid| and |data| whose hash is |hash| to
+ * |table|, and returns the index where the pair is stored if it
+ * succeeds.  Otherwise, it returns NGTCP2_ERR_INVALID_ARGUMENT which
+ * indicates that |cid| is already present.
+ */
+static ngtcp2_ssize cid_table_insert(ngtcp2_cid_table *table, uint64_t hash,
+                                     const uint8_t *cid, void *data) {
+  size_t idx = cid_table_index(table, hash);
+  size_t mask = ((size_t)1 << table->hashbits) - 1;
+  ngtcp2_cid_table_entry ent, *p, t;
+  ngtcp2_ssize res = -1;
+
+  ent.hash = hash;
+  ent.data = data;
+  memcpy(ent.cid, cid, table->cidlen);
+  ent.psl = 1;
+
+  for (;; ++ent.psl, idx = (idx + 1) & mask) {
+    p = &table->ents[idx];
+
+    if (p->psl == 0) {
+      *p = ent;
+      ++table->size;
+
+      return res == -1 ? (ngtcp2_ssize)idx : res;
+    }
+
+    if (ent.psl > p->psl) {
+      t = *p;
+      *p = ent;
+      ent = t;
+
+      if (res == -1) {
+        res = (ngtcp2_ssize)idx;
+      }
+    } else if (res == -1 && p->hash == hash &&
+               memcmp(p->cid, cid, table->cidlen) == 0) {
+      return NGTCP2_ERR_INVALID_ARGUMENT;
+    }
+  }
+}
+
+/* NGTCP2_CID_TABLE_MAX_HASHBITS is the maximum number of bits used
+   for hash table. */
+#define NGTCP2_CID_TABLE_MAX_HASHBITS (sizeof(size_t) * 8 - 1)
+
+static int cid_table_resize(ngtcp2_cid_table *table, size_t new_hashbits) {
+  ngtcp2_cid_table_entry *ents = table->ents;
+  size_t i, tablelen;
+  ngtcp2_ssize idx;
+  (void)idx;
+
+  if (new_hashbits > NGTCP2_CID_TABLE_MAX_HASHBITS) {
+    return NGTCP2_ERR_NOMEM;
+  }
+
+  table->ents = ngtcp2_mem_calloc(table->mem, (size_t)1 << new_hashbits,
+                                  sizeof(ngtcp2_cid_table_entry));
+  if (table->ents == NULL) {
+    table->ents = ents;
+
+    return NGTCP2_ERR_NOMEM;
+  }
+
+  tablelen = table->hashbits ? (size_t)1 << table->hashbits : 0;
+  table->hashbits = new_hashbits;
+  table->size = 0;
+
+  for (i = 0; i < tablelen; ++i) {
+    if (ents[i].psl == 0) {
+      continue;
+    }
+
+    idx = cid_table_insert(table, ents[i].hash, ents[i].cid, ents[i].data);
+
+    /* cid_table_insert must not fail because all keys are unique
+       during resize. */
+    assert(idx >= 0);
+  }
+
+  ngtcp2_mem_free(table->mem, ents);
+
+  return 0;
+}
+
+int ngtcp2_cid_table_insert(ngtcp2_cid_table *table, const ngtcp2_cid *cid,
+                            void *data) {
+  uint64_t hash;
+  size_t tablelen;
+  ngtcp2_ssize idx;
+  int rv;
+
+  assert(data);
+
+  if (cid->datalen != table->cidlen) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  hash = ngtcp2_cid_table_hash(table->key, cid->data, cid->datalen);
+
+  tablelen = (size_t)1 << table->hashbits;
+
+  /* Load factor is 7 / 8. */
+  if (table->size + 1 >= (tablelen - (tablelen >> 3))) {
+    rv = cid_table_resize(table, table->hashbits
+                                   ? table->hashbits + 1
+                                   : NGTCP2_CID_TABLE_INITIAL_HASHBITS);
+    if (rv != 0) {
+      return rv;
+    }
+
+    idx = cid_table_insert(table, hash, cid->data, data);
+    if (idx < 0) {
+      return (int)idx;
+    }
+
+    return 0;
+  }
+
+  idx = cid_table_insert(table, hash, cid->data, data);
+  if (idx < 0) {
+    return (int)idx;
+  }
+
+  /* Resize if psl reaches really large value which is almost
+     improbable, but just in case. */
+  if (table->ents[idx].psl - 1 < NGTCP2_CID_TABLE_MAX_PSL_RESIZE_THRESH) {
+    return 0;
+  }
+
+  rv = cid_table_resize(table, table->hashbits + 1);
+  if (rv != 0) {
+    ngtcp2_cid_table_remove(table, cid);
+  }
+
+  return rv;
+}
+
+/*
+ * cid_table_find_index returns the index of the slot which contains
+ * |cid| whose hash is |hash|, or -1 if there is no such slot.
+ */
+static ngtcp2_ssize cid_table_find_index(const ngtcp2_cid_table *table,
+                                         uint64_t hash, const uint8_t *cid) {
+  size_t idx = cid_table_index(table, hash);
+  size_t mask = ((size_t)1 << table->hashbits) - 1;
+  size_t psl = 1;
+  const ngtcp2_cid_table_entry *p;
+
+  for (;; ++psl, idx = (idx + 1) & mask) {
+    p = &table->ents[idx];
+
+    if (psl > p->psl) {
+      return -1;
+    }
+
+    if (p->hash == hash && memcmp(p->cid, cid, table->cidlen) == 0) {
+      return (ngtcp2_ssize)idx;
+    }
+  }
+}
+
+void *ngtcp2_cid_table_find(const ngtcp2_cid_table *table,
+                            const uint8_t *cid) {
+  ngtcp2_ssize idx;
+
+  if (table->size == 0) {
+    return NULL;
+  }
+
+  idx = cid_table_find_index(
+    table, ngtcp2_cid_table_hash(table->key, cid, table->cidlen), cid);
+  if (idx < 0) {
+    return NULL;
+  }
+
+  return table->ents[idx].data;
+}
+
+void ngtcp2_cid_table_find_batch(const ngtcp2_cid_table *table, void **data,
+                                 const uint8_t *const *cids, size_t n) {
+  uint64_t hashes[NGTCP2_CID_TABLE_BATCHLEN];
+  size_t i, len;
+  ngtcp2_ssize idx;
+
+  if (table->size == 0) {
+    memset(data, 0, sizeof(*data) * n);
+    return;
+  }
+
+  for (; n; data += len, cids += len, n -= len) {
+    len = ngtcp2_min(n, NGTCP2_CID_TABLE_BATCHLEN);
+
+    /* Compute all hashes first, and bring the home slots into cache
+       so that their loads overlap. */
+    for (i = 0; i < len; ++i) {
+      hashes[i] = ngtcp2_cid_table_hash(table->key, cids[i], table->cidlen);
+#ifdef __GNUC__
+      __builtin_prefetch(&table->ents[cid_table_index(table, hashes[i])]);
+#endif /* defined(__GNUC__) */
+    }
+
+    for (i = 0; i < len; ++i) {
+      idx = cid_table_find_index(table, hashes[i], cids[i]);
+      data[i] = idx < 0 ? NULL : table->ents[idx].data;
+    }
+  }
+}
+
+int ngtcp2_cid_table_remove(ngtcp2_cid_table *table, const ngtcp2_cid *cid) {
+  ngtcp2_ssize idx;
+  size_t dest, mask;
+
+  if (table->size == 0 || cid->datalen != table->cidlen) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  idx = cid_table_find_index(
+    table, ngtcp2_cid_table_hash(table->key, cid->data, cid->datalen),
+    cid->data);
+  if (idx < 0) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  mask = ((size_t)1 << table->hashbits) - 1;
+  dest = (size_t)idx;
+
+  for (;;) {
+    idx = (ngtcp2_ssize)(((size_t)idx + 1) & mask);
+
+    if (table->ents[idx].psl <= 1) {
+      table->ents[dest].psl = 0;
+      break;
+    }
+
+    table->ents[dest] = table->ents[idx];
+    --table->ents[dest].psl;
+
+    dest = (size_t)idx;
+  }
+
+  --table->size;
+
+  return 0;
+}
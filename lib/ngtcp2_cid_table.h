@@ -0,0 +1,75 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef NGTCP2_CID_TABLE_H
+#define NGTCP2_CID_TABLE_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* defined(HAVE_CONFIG_H) */
+
+#include <ngtcp2/ngtcp2.h>
+
+/*
+ * ngtcp2_cid_table_entry is a slot of ngtcp2_cid_table.  The key is
+ * stored inline so that a probe touches a single cache line in most
+ * cases.
+ */
+typedef struct ngtcp2_cid_table_entry {
+  /* hash is the keyed hash of cid. */
+  uint64_t hash;
+  /* data is the data associated to cid. */
+  void *data;
+  /* cid is the Connection ID of ngtcp2_cid_table.cidlen bytes. */
+  uint8_t cid[NGTCP2_MAX_CIDLEN];
+  /* psl is the Probe Sequence Length.  0 means that the slot is
+     empty.  Otherwise, the actual psl value is psl - 1. */
+  uint8_t psl;
+} ngtcp2_cid_table_entry;
+
+/*
+ * ngtcp2_cid_table is an unordered map from fixed-length Connection
+ * IDs to opaque pointers.  It uses Robin Hood hashing as ngtcp2_map
+ * does, and hashes the keys with SipHash-2-4 keyed by a secret so that
+ * a remote endpoint cannot craft colliding Connection IDs.
+ */
+struct ngtcp2_cid_table {
+  ngtcp2_cid_table_entry *ents;
+  const ngtcp2_mem *mem;
+  /* key is SipHash key. */
+  uint64_t key[2];
+  /* cidlen is the length of Connection IDs stored in this table. */
+  size_t cidlen;
+  size_t size;
+  size_t hashbits;
+};
+
+/*
+ * ngtcp2_cid_table_hash returns SipHash-2-4 of |data| of length
+ * |datalen| keyed by |key|.
+ */
+uint64_t ngtcp2_cid_table_hash(const uint64_t key[2], const uint8_t *data,
+                               size_t datalen);
+
+#endif /* !defined(NGTCP2_CID_TABLE_H) */
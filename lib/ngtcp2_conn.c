@@ -43,6 +43,8 @@
 #include "ngtcp2_tstamp.h"
 #include "ngtcp2_frame_chain.h"
 #include "ngtcp2_conn_info.h"
+#include "ngtcp2_rx_budget.h"
+#include "ngtcp2_cid_table.h"
 
 /* NGTCP2_FLOW_WINDOW_RTT_FACTOR is the factor of RTT when flow
    control window auto-tuning is triggered. */
@@ -84,12 +86,61 @@ static int conn_local_stream(const ngtcp2_conn *conn, int64_t stream_id) {
  */
 static int bidi_stream(int64_t stream_id) { return (stream_id & 0x2) == 0; }
 
+/*
+ * conn_invalidate_expiry marks the cached expiry of |conn| stale.  It
+ * is recomputed lazily by ngtcp2_conn_get_expiry2 or
+ * ngtcp2_conn_poll_expiry, or by conn_update_expiry if
+ * ngtcp2_settings.timerq is set.
+ */
+static void conn_invalidate_expiry(ngtcp2_conn *conn) {
+  conn->flags |= NGTCP2_CONN_FLAG_EXPIRY_STALE;
+}
+
+static ngtcp2_tstamp conn_compute_expiry(const ngtcp2_conn *conn);
+
+/*
+ * conn_refresh_expiry recomputes the cached expiry of |conn|, and
+ * updates the deadline of |conn| in ngtcp2_settings.timerq if it is
+ * set.
+ */
+static void conn_refresh_expiry(ngtcp2_conn *conn) {
+  conn->expiry.ts = conn_compute_expiry(conn);
+  conn->flags &= (uint32_t)~NGTCP2_CONN_FLAG_EXPIRY_STALE;
+
+  if (!conn->local.settings.timerq) {
+    return;
+  }
+
+  ngtcp2_timerq_update(conn->local.settings.timerq, &conn->timerq_ent,
+                       conn->expiry.ts);
+}
+
+/*
+ * conn_update_expiry must be called before a public function returns
+ * if it might have changed any timer of |conn|.  Without
+ * ngtcp2_settings.timerq, it just marks the cached expiry stale.
+ * Otherwise, it recomputes the expiry and reschedules |conn| in the
+ * timer queue, unless packets are being aggregated, in which case
+ * the aggregating function does it once before returning.
+ */
+static void conn_update_expiry(ngtcp2_conn *conn) {
+  if (!conn->local.settings.timerq ||
+      (conn->flags & NGTCP2_CONN_FLAG_AGGREGATE_PKTS)) {
+    conn_invalidate_expiry(conn);
+    return;
+  }
+
+  conn_refresh_expiry(conn);
+}
+
 static void conn_update_timestamp(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   assert(conn->log.last_ts <= ts);
   assert(conn->qlog.last_ts <= ts);
 
   conn->log.last_ts = ts;
   conn->qlog.last_ts = ts;
+
+  conn_invalidate_expiry(conn);
 }
 
 /*
@@ -830,8 +881,9 @@ static int pktns_new(ngtcp2_pktns **ppktns, ngtcp2_pktns_id pktns_id,
                      ngtcp2_rst *rst, ngtcp2_cc *cc, int64_t initial_pkt_num,
                      ngtcp2_log *log, ngtcp2_qlog *qlog,
                      ngtcp2_objalloc *rtb_entry_objalloc,
-                     ngtcp2_objalloc *frc_objalloc, const ngtcp2_mem *mem) {
-  *ppktns = ngtcp2_mem_calloc(mem, 1, sizeof(ngtcp2_pktns));
+                     ngtcp2_objalloc *frc_objalloc, const ngtcp2_mem *hs_mem,
+                     const ngtcp2_mem *mem) {
+  *ppktns = ngtcp2_mem_calloc(hs_mem, 1, sizeof(ngtcp2_pktns));
   if (*ppktns == NULL) {
     return NGTCP2_ERR_NOMEM;
   }
@@ -842,15 +894,50 @@ static int pktns_new(ngtcp2_pktns **ppktns, ngtcp2_pktns_id pktns_id,
   return 0;
 }
 
-static int cycle_less(const ngtcp2_pq_entry *lhs, const ngtcp2_pq_entry *rhs) {
+/*
+ * strmq_less orders ngtcp2_strm in conn->tx.strmq by urgency first,
+ * and then by cycle.  The streams which have the same urgency and
+ * cycle are ordered by stream ID.
+ */
+static int strmq_less(const ngtcp2_pq_entry *lhs, const ngtcp2_pq_entry *rhs) {
   ngtcp2_strm *ls = ngtcp2_struct_of(lhs, ngtcp2_strm, pe);
   ngtcp2_strm *rs = ngtcp2_struct_of(rhs, ngtcp2_strm, pe);
 
+  if (ls->urgency != rs->urgency) {
+    return ls->urgency < rs->urgency;
+  }
+
   if (ls->cycle == rs->cycle) {
     return ls->stream_id < rs->stream_id;
   }
 
-  return rs->cycle - ls->cycle <= 1;
+  return (int64_t)(ls->cycle - rs->cycle) < 0;
+}
+
+/*
+ * conn_tx_strmq_advance_cycle advances |strm|->cycle after a frame of
+ * |strm| is sent.  It also records the current cycle of the urgency
+ * of |strm| so that a stream which joins the queue later starts from
+ * there.  The cycle of a non-incremental stream is not advanced so
+ * that it is served until it has nothing to send.
+ */
+static void conn_tx_strmq_advance_cycle(ngtcp2_conn *conn, ngtcp2_strm *strm) {
+  conn->tx.strmq_cycle[strm->urgency] = strm->cycle;
+
+  if (strm->flags & NGTCP2_STRM_FLAG_NON_INCREMENTAL) {
+    return;
+  }
+
+  strm->cycle += NGTCP2_STRM_CYCLE_STRIDE / strm->weight;
+}
+
+/*
+ * conn_tx_strmq_preempts returns nonzero if the stream at the top of
+ * conn->tx.strmq must be served before the new data of |strm|.
+ */
+static int conn_tx_strmq_preempts(ngtcp2_conn *conn, const ngtcp2_strm *strm) {
+  return !ngtcp2_pq_empty(&conn->tx.strmq) &&
+         ngtcp2_conn_tx_strmq_top(conn)->urgency <= strm->urgency;
 }
 
 static void delete_buffed_pkts(ngtcp2_pkt_chain *pc, const ngtcp2_mem *mem) {
@@ -891,14 +978,25 @@ static void pktns_free(ngtcp2_pktns *pktns, const ngtcp2_mem *mem) {
   ngtcp2_gaptr_free(&pktns->rx.pngap);
 }
 
-static void pktns_del(ngtcp2_pktns *pktns, const ngtcp2_mem *mem) {
+/*
+ * pktns_del frees |pktns| allocated by pktns_new.  |pktns| and its
+ * keying materials are freed by |hs_mem|, and the other objects
+ * owned by |pktns| are freed by |mem|.
+ */
+static void pktns_del(ngtcp2_pktns *pktns, const ngtcp2_mem *hs_mem,
+                      const ngtcp2_mem *mem) {
   if (pktns == NULL) {
     return;
   }
 
+  ngtcp2_crypto_km_del(pktns->crypto.rx.ckm, hs_mem);
+  pktns->crypto.rx.ckm = NULL;
+  ngtcp2_crypto_km_del(pktns->crypto.tx.ckm, hs_mem);
+  pktns->crypto.tx.ckm = NULL;
+
   pktns_free(pktns, mem);
 
-  ngtcp2_mem_free(mem, pktns);
+  ngtcp2_mem_free(hs_mem, pktns);
 }
 
 static int cid_less(const ngtcp2_ksl_key *lhs, const ngtcp2_ksl_key *rhs) {
@@ -957,12 +1055,20 @@ static void conn_reset_conn_stat(ngtcp2_conn *conn, ngtcp2_conn_stat *cstat) {
   reset_conn_stat_recovery(cstat);
 }
 
-static void delete_scid(ngtcp2_ksl *scids, const ngtcp2_mem *mem) {
+static void delete_scid(ngtcp2_ksl *scids, ngtcp2_cid_table *cid_table,
+                        const ngtcp2_mem *mem) {
   ngtcp2_ksl_it it;
+  ngtcp2_scid *scid;
 
   for (it = ngtcp2_ksl_begin(scids); !ngtcp2_ksl_it_end(&it);
        ngtcp2_ksl_it_next(&it)) {
-    ngtcp2_mem_free(mem, ngtcp2_ksl_it_get(&it));
+    scid = ngtcp2_ksl_it_get(&it);
+
+    if (cid_table) {
+      ngtcp2_cid_table_remove(cid_table, &scid->cid);
+    }
+
+    ngtcp2_mem_free(mem, scid);
   }
 }
 
@@ -976,6 +1082,17 @@ static ngtcp2_duration compute_pto(ngtcp2_duration smoothed_rtt,
   return smoothed_rtt + var + max_ack_delay;
 }
 
+/*
+ * conn_remote_max_ack_delay returns the maximum ACK delay of the
+ * remote endpoint, taking into account the delay requested by
+ * ACK_FREQUENCY frame.  conn->remote.transport_params must not be
+ * NULL.
+ */
+static ngtcp2_duration conn_remote_max_ack_delay(const ngtcp2_conn *conn) {
+  return ngtcp2_max(conn->remote.transport_params->max_ack_delay,
+                    conn->tx.ack_freq.max_ack_delay);
+}
+
 /*
  * conn_compute_initial_pto computes PTO using the initial RTT.
  */
@@ -986,7 +1103,7 @@ static ngtcp2_duration conn_compute_initial_pto(const ngtcp2_conn *conn,
 
   if (pktns->id == NGTCP2_PKTNS_ID_APPLICATION &&
       conn->remote.transport_params) {
-    max_ack_delay = conn->remote.transport_params->max_ack_delay;
+    max_ack_delay = conn_remote_max_ack_delay(conn);
   } else {
     max_ack_delay = 0;
   }
@@ -1000,7 +1117,7 @@ ngtcp2_duration ngtcp2_conn_compute_pto(const ngtcp2_conn *conn,
 
   if (pktns->id == NGTCP2_PKTNS_ID_APPLICATION &&
       conn->remote.transport_params) {
-    max_ack_delay = conn->remote.transport_params->max_ack_delay;
+    max_ack_delay = conn_remote_max_ack_delay(conn);
   } else {
     max_ack_delay = 0;
   }
@@ -1284,6 +1401,7 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   assert(server || !params->retry_scid_present);
   assert(params->max_idle_timeout != UINT64_MAX);
   assert(params->max_ack_delay < (1 << 14) * NGTCP2_MILLISECONDS);
+  assert(params->min_ack_delay <= params->max_ack_delay);
   assert(server || callbacks->client_initial);
   assert(!server || callbacks->recv_client_initial);
   assert(callbacks->recv_crypto_data);
@@ -1300,6 +1418,10 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
          callbacks->get_path_challenge_data);
   assert(!server || !ngtcp2_is_reserved_version(client_chosen_version));
 
+  if (server && settings->cid_table && !user_data) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
   for (i = 0; i < settings->pmtud_probeslen; ++i) {
     assert(settings->pmtud_probes[i] > NGTCP2_MAX_UDP_PAYLOAD_SIZE);
     assert(settings->pmtud_probes[i] <= NGTCP2_MAX_TX_UDP_PAYLOAD_SIZE);
@@ -1360,6 +1482,29 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   ngtcp2_objalloc_rtb_entry_init(&(*pconn)->rtb_entry_objalloc, 16, mem);
   ngtcp2_objalloc_strm_init(&(*pconn)->strm_objalloc, 16, mem);
 
+  ngtcp2_balloc_init(&(*pconn)->hs_arena, NGTCP2_HS_ARENA_BLKLEN, mem);
+
+  if (settings->objpool) {
+    ngtcp2_balloc_set_objpool(&(*pconn)->frc_objalloc.balloc,
+                              settings->objpool);
+    ngtcp2_balloc_set_objpool(&(*pconn)->rtb_entry_objalloc.balloc,
+                              settings->objpool);
+    ngtcp2_balloc_set_objpool(&(*pconn)->strm_objalloc.balloc,
+                              settings->objpool);
+    ngtcp2_balloc_set_objpool(&(*pconn)->hs_arena, settings->objpool);
+  }
+
+  ngtcp2_timerq_entry_init(&(*pconn)->timerq_ent);
+  (*pconn)->expiry.last_polled_ts = UINT64_MAX;
+  (*pconn)->flags |= NGTCP2_CONN_FLAG_EXPIRY_STALE;
+
+  if (settings->handshake_arena) {
+    ngtcp2_balloc_mem_init(&(*pconn)->hs_arena_mem, &(*pconn)->hs_arena);
+    (*pconn)->hs_mem = &(*pconn)->hs_arena_mem;
+  } else {
+    (*pconn)->hs_mem = mem;
+  }
+
   ngtcp2_dcidtr_init(&(*pconn)->dcid.dtr);
 
   ngtcp2_gaptr_init(&(*pconn)->dcid.seqgap, mem);
@@ -1375,7 +1520,7 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   callbacks->rand((uint8_t *)&seed, sizeof(seed), &settings->rand_ctx);
   ngtcp2_pcg32_init(&(*pconn)->pcg, seed);
 
-  ngtcp2_pq_init(&(*pconn)->tx.strmq, cycle_less, mem);
+  ngtcp2_pq_init(&(*pconn)->tx.strmq, strmq_less, mem);
 
   ngtcp2_idtr_init(&(*pconn)->bidi.idtr, mem);
 
@@ -1472,12 +1617,15 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   ngtcp2_ratelim_init(&(*pconn)->glitch_rlim, settings->glitch_ratelim_burst,
                       settings->glitch_ratelim_rate, settings->initial_ts);
 
+  ngtcp2_rxbuf_lim_init(&(*pconn)->rx.rxbuf.lim, NGTCP2_MAX_RXBUF_BYTES,
+                        NGTCP2_MAX_RXBUF_REF);
+
   (*pconn)->callbacks = *callbacks;
 
   rv = pktns_new(&(*pconn)->in_pktns, NGTCP2_PKTNS_ID_INITIAL, &(*pconn)->rst,
                  &(*pconn)->cc, settings->initial_pkt_num, &(*pconn)->log,
                  &(*pconn)->qlog, &(*pconn)->rtb_entry_objalloc,
-                 &(*pconn)->frc_objalloc, mem);
+                 &(*pconn)->frc_objalloc, (*pconn)->hs_mem, mem);
   if (rv != 0) {
     goto fail_in_pktns_init;
   }
@@ -1485,7 +1633,7 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   rv = pktns_new(&(*pconn)->hs_pktns, NGTCP2_PKTNS_ID_HANDSHAKE, &(*pconn)->rst,
                  &(*pconn)->cc, settings->initial_pkt_num, &(*pconn)->log,
                  &(*pconn)->qlog, &(*pconn)->rtb_entry_objalloc,
-                 &(*pconn)->frc_objalloc, mem);
+                 &(*pconn)->frc_objalloc, (*pconn)->hs_mem, mem);
   if (rv != 0) {
     goto fail_hs_pktns_init;
   }
@@ -1507,6 +1655,13 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
      transport parameters */
   ngtcp2_scid_init(scident, 0, scid);
 
+  if (server && settings->cid_table) {
+    rv = ngtcp2_cid_table_insert(settings->cid_table, scid, user_data);
+    if (rv != 0) {
+      goto fail_cid_table_insert;
+    }
+  }
+
   rv = ngtcp2_ksl_insert(&(*pconn)->scid.set, NULL, &scident->cid, scident);
   if (rv != 0) {
     goto fail_scid_set_insert;
@@ -1612,6 +1767,10 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   (*pconn)->tx.pacing.next_ts = UINT64_MAX;
   (*pconn)->tx.last_blocked_offset = UINT64_MAX;
   (*pconn)->rx.preferred_addr.pkt_num = -1;
+  (*pconn)->rx.ack_freq.seq = -1;
+  (*pconn)->rx.ack_freq.thresh = settings->ack_thresh;
+  (*pconn)->rx.ack_freq.reordering_thresh = 1;
+  (*pconn)->tx.ack_freq.seq = -1;
   (*pconn)->early.discard_started_ts = UINT64_MAX;
 
   conn_reset_ecn_validation_state(*pconn);
@@ -1627,12 +1786,17 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   return 0;
 
 fail_scid_set_insert:
+  if (server && settings->cid_table) {
+    ngtcp2_cid_table_remove(settings->cid_table, scid);
+  }
+fail_cid_table_insert:
   ngtcp2_mem_free(mem, scident);
 fail_scident:
-  pktns_del((*pconn)->hs_pktns, mem);
+  pktns_del((*pconn)->hs_pktns, (*pconn)->hs_mem, mem);
 fail_hs_pktns_init:
-  pktns_del((*pconn)->in_pktns, mem);
+  pktns_del((*pconn)->in_pktns, (*pconn)->hs_mem, mem);
 fail_in_pktns_init:
+  ngtcp2_balloc_free(&(*pconn)->hs_arena);
   ngtcp2_gaptr_free(&(*pconn)->dcid.seqgap);
 fail_seqgap_push:
   ngtcp2_mem_free(mem, (uint8_t *)(*pconn)->local.settings.token);
@@ -1727,10 +1891,24 @@ static uint64_t conn_enforce_flow_control(const ngtcp2_conn *conn,
   return ngtcp2_min(len, fc_credits);
 }
 
+/*
+ * conn_release_rx_budget returns |*pused| bytes charged to
+ * ngtcp2_settings.rx_budget, and sets 0 to |*pused|.
+ */
+static void conn_release_rx_budget(ngtcp2_conn *conn, uint64_t *pused) {
+  if (!conn->local.settings.rx_budget || *pused == 0) {
+    return;
+  }
+
+  ngtcp2_rx_budget_release(conn->local.settings.rx_budget, *pused);
+  *pused = 0;
+}
+
 static int delete_strms_each(void *data, void *ptr) {
   ngtcp2_conn *conn = ptr;
   ngtcp2_strm *s = data;
 
+  conn_release_rx_budget(conn, &s->rx.budget_used);
   ngtcp2_strm_free(s);
   ngtcp2_objalloc_strm_release(&conn->strm_objalloc, s);
 
@@ -1748,8 +1926,8 @@ static void conn_vneg_crypto_free(ngtcp2_conn *conn) {
   }
   conn_call_delete_crypto_cipher_ctx(conn, &conn->vneg.tx.hp_ctx);
 
-  ngtcp2_crypto_km_del(conn->vneg.rx.ckm, conn->mem);
-  ngtcp2_crypto_km_del(conn->vneg.tx.ckm, conn->mem);
+  ngtcp2_crypto_km_del(conn->vneg.rx.ckm, conn->hs_mem);
+  ngtcp2_crypto_km_del(conn->vneg.tx.ckm, conn->hs_mem);
 }
 
 void ngtcp2_conn_del(ngtcp2_conn *conn) {
@@ -1759,6 +1937,10 @@ void ngtcp2_conn_del(ngtcp2_conn *conn) {
 
   ngtcp2_qlog_end(&conn->qlog);
 
+  if (conn->local.settings.timerq) {
+    ngtcp2_timerq_remove(conn->local.settings.timerq, &conn->timerq_ent);
+  }
+
   if (conn->early.ckm) {
     conn_call_delete_crypto_aead_ctx(conn, &conn->early.ckm->aead_ctx);
   }
@@ -1830,11 +2012,11 @@ void ngtcp2_conn_del(ngtcp2_conn *conn) {
   ngtcp2_crypto_km_del(conn->crypto.key_update.old_rx_ckm, conn->mem);
   ngtcp2_crypto_km_del(conn->crypto.key_update.new_rx_ckm, conn->mem);
   ngtcp2_crypto_km_del(conn->crypto.key_update.new_tx_ckm, conn->mem);
-  ngtcp2_crypto_km_del(conn->early.ckm, conn->mem);
+  ngtcp2_crypto_km_del(conn->early.ckm, conn->hs_mem);
 
   pktns_free(&conn->pktns, conn->mem);
-  pktns_del(conn->hs_pktns, conn->mem);
-  pktns_del(conn->in_pktns, conn->mem);
+  pktns_del(conn->hs_pktns, conn->hs_mem, conn->mem);
+  pktns_del(conn->in_pktns, conn->hs_mem, conn->mem);
 
   ngtcp2_pmtud_del(conn->pmtud);
   ngtcp2_pv_del(conn->pv);
@@ -1847,8 +2029,11 @@ void ngtcp2_conn_del(ngtcp2_conn *conn) {
   ngtcp2_map_each(&conn->strms, delete_strms_each, (void *)conn);
   ngtcp2_map_free(&conn->strms);
 
+  conn_release_rx_budget(conn, &conn->rx.budget_used);
+
   ngtcp2_pq_free(&conn->scid.used);
-  delete_scid(&conn->scid.set, conn->mem);
+  delete_scid(&conn->scid.set,
+              conn->server ? conn->local.settings.cid_table : NULL, conn->mem);
   ngtcp2_ksl_free(&conn->scid.set);
   ngtcp2_gaptr_free(&conn->dcid.seqgap);
 
@@ -1856,6 +2041,8 @@ void ngtcp2_conn_del(ngtcp2_conn *conn) {
   ngtcp2_objalloc_free(&conn->rtb_entry_objalloc);
   ngtcp2_objalloc_free(&conn->frc_objalloc);
 
+  ngtcp2_balloc_free(&conn->hs_arena);
+
   ngtcp2_mem_free(conn->mem, conn);
 }
 
@@ -1864,6 +2051,10 @@ void ngtcp2_conn_del(ngtcp2_conn *conn) {
  * ACK.
  */
 static ngtcp2_duration conn_compute_ack_delay(const ngtcp2_conn *conn) {
+  if (conn->rx.ack_freq.seq != -1) {
+    return conn->rx.ack_freq.max_ack_delay;
+  }
+
   return ngtcp2_min(
     conn->local.transport_params.max_ack_delay,
     ngtcp2_max(conn->cstat.smoothed_rtt / 8, NGTCP2_NANOSECONDS));
@@ -2240,6 +2431,8 @@ void ngtcp2_conn_set_keep_alive_timeout(ngtcp2_conn *conn,
   }
 
   conn->keep_alive.timeout = timeout;
+
+  conn_update_expiry(conn);
 }
 
 static void conn_cancel_expired_pkt_tx_timer(ngtcp2_conn *conn,
@@ -2265,7 +2458,7 @@ static int conn_pacing_pkt_tx_allowed(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   }
 
   if (conn->tx.pacing.next_ts > ts) {
-    return 0;
+    return conn->tx.pacing.next_ts - ts <= conn->tx.pacing.horizon;
   }
 
   conn->tx.pacing.compensation += ts - conn->tx.pacing.next_ts;
@@ -2589,6 +2782,7 @@ conn_write_handshake_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi, uint8_t *dest,
   cc.aead = pktns->crypto.ctx.aead;
   cc.hp = pktns->crypto.ctx.hp;
   cc.encrypt = conn->callbacks.encrypt;
+  cc.encryptv = NULL;
   cc.hp_mask = conn->callbacks.hp_mask;
 
   ngtcp2_pkt_hd_init(
@@ -2951,6 +3145,21 @@ static ngtcp2_ssize conn_write_ack_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
   return spktlen;
 }
 
+/*
+ * conn_release_hs_arena releases the memory blocks of the handshake
+ * arena if all handshake-lifetime objects allocated from it have
+ * been discarded.
+ */
+static void conn_release_hs_arena(ngtcp2_conn *conn) {
+  if (conn->hs_mem != &conn->hs_arena_mem || conn->in_pktns ||
+      conn->hs_pktns || conn->early.ckm || conn->vneg.rx.ckm ||
+      conn->vneg.tx.ckm) {
+    return;
+  }
+
+  ngtcp2_balloc_clear(&conn->hs_arena);
+}
+
 static void conn_discard_pktns(ngtcp2_conn *conn, ngtcp2_pktns **ppktns,
                                ngtcp2_tstamp ts) {
   ngtcp2_pktns *pktns = *ppktns;
@@ -2970,7 +3179,7 @@ static void conn_discard_pktns(ngtcp2_conn *conn, ngtcp2_pktns **ppktns,
   conn_call_delete_crypto_aead_ctx(conn, &pktns->crypto.tx.ckm->aead_ctx);
   conn_call_delete_crypto_cipher_ctx(conn, &pktns->crypto.tx.hp_ctx);
 
-  pktns_del(pktns, conn->mem);
+  pktns_del(pktns, conn->hs_mem, conn->mem);
   *ppktns = NULL;
 
   ngtcp2_conn_set_loss_detection_timer(conn, ts);
@@ -2990,6 +3199,8 @@ void ngtcp2_conn_discard_initial_state(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
 
   memset(&conn->vneg.rx, 0, sizeof(conn->vneg.rx));
   memset(&conn->vneg.tx, 0, sizeof(conn->vneg.tx));
+
+  conn_release_hs_arena(conn);
 }
 
 void ngtcp2_conn_discard_handshake_state(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
@@ -3001,6 +3212,8 @@ void ngtcp2_conn_discard_handshake_state(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
                   "discarding Handshake packet number space");
 
   conn_discard_pktns(conn, &conn->hs_pktns, ts);
+
+  conn_release_hs_arena(conn);
 }
 
 /*
@@ -3015,8 +3228,10 @@ static void conn_discard_early_key(ngtcp2_conn *conn) {
   conn_call_delete_crypto_cipher_ctx(conn, &conn->early.hp_ctx);
   conn->early.hp_ctx = (ngtcp2_crypto_cipher_ctx){0};
 
-  ngtcp2_crypto_km_del(conn->early.ckm, conn->mem);
+  ngtcp2_crypto_km_del(conn->early.ckm, conn->hs_mem);
   conn->early.ckm = NULL;
+
+  conn_release_hs_arena(conn);
 }
 
 /*
@@ -3281,6 +3496,59 @@ static int conn_should_send_max_data(const ngtcp2_conn *conn) {
   return conn->rx.window < 4 * inc;
 }
 
+/*
+ * conn_acquire_rx_budget charges at most |n| bytes of the flow
+ * control window growth to ngtcp2_settings.rx_budget, and returns the
+ * number of bytes charged.  |*pused| is increased by the returned
+ * value.  If rx_budget is not set, this function returns |n|.  If
+ * rx_budget is under pressure, this function returns 0.
+ */
+static uint64_t conn_acquire_rx_budget(ngtcp2_conn *conn, uint64_t *pused,
+                                       uint64_t n) {
+  ngtcp2_rx_budget *budget = conn->local.settings.rx_budget;
+
+  if (!budget) {
+    return n;
+  }
+
+  if (ngtcp2_rx_budget_under_pressure(budget)) {
+    return 0;
+  }
+
+  n = ngtcp2_rx_budget_acquire(budget, n);
+  *pused += n;
+
+  return n;
+}
+
+/*
+ * conn_shrink_rx_window shrinks the flow control window |*pwindow| if
+ * ngtcp2_settings.rx_budget is under pressure.  |*pused| is the
+ * number of bytes of |*pwindow| charged to rx_budget, and |inc| is
+ * the increment of the limit which is about to be advertised.  The
+ * window is shrunk by at most the half of |inc| so that the new
+ * limit still exceeds the current one, and the shrunk amount is
+ * returned to rx_budget.  This function returns the number of bytes
+ * to subtract from |inc|.
+ */
+static uint64_t conn_shrink_rx_window(ngtcp2_conn *conn, uint64_t *pwindow,
+                                      uint64_t *pused, uint64_t inc) {
+  ngtcp2_rx_budget *budget = conn->local.settings.rx_budget;
+  uint64_t n;
+
+  if (!budget || !ngtcp2_rx_budget_under_pressure(budget)) {
+    return 0;
+  }
+
+  n = ngtcp2_min(*pused, inc / 2);
+
+  *pwindow -= n;
+  *pused -= n;
+  ngtcp2_rx_budget_release(budget, n);
+
+  return n;
+}
+
 /*
  * conn_required_num_new_connection_id returns the number of
  * additional connection ID the local endpoint has to provide to the
@@ -3317,9 +3585,45 @@ static size_t conn_required_num_new_connection_id(const ngtcp2_conn *conn) {
   return ngtcp2_min(lim, n);
 }
 
+/*
+ * conn_register_scid registers |cid| to ngtcp2_settings.cid_table
+ * with the user data of |conn| if |conn| is server and the table is
+ * set.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * NGTCP2_ERR_INVALID_ARGUMENT
+ *     |cid| is already registered, or its length does not match.
+ * NGTCP2_ERR_NOMEM
+ *     Out of memory.
+ */
+static int conn_register_scid(ngtcp2_conn *conn, const ngtcp2_cid *cid) {
+  if (!conn->server || !conn->local.settings.cid_table) {
+    return 0;
+  }
+
+  return ngtcp2_cid_table_insert(conn->local.settings.cid_table, cid,
+                                 conn->user_data);
+}
+
+/*
+ * conn_unregister_scid removes |cid| from ngtcp2_settings.cid_table
+ * if |conn| is server and the table is set.
+ */
+static void conn_unregister_scid(ngtcp2_conn *conn, const ngtcp2_cid *cid) {
+  if (!conn->server || !conn->local.settings.cid_table) {
+    return;
+  }
+
+  ngtcp2_cid_table_remove(conn->local.settings.cid_table, cid);
+}
+
 /*
  * conn_enqueue_new_connection_id generates additional connection IDs
- * and prepares to send them to the remote endpoint.
+ * and prepares to send them to the remote endpoint.  If a generated
+ * connection ID is already registered to ngtcp2_settings.cid_table,
+ * it is generated again up to NGTCP2_MAX_SCID_REGEN times.
  *
  * This function returns 0 if it succeeds, or one of the following
  * negative error codes:
@@ -3330,7 +3634,7 @@ static size_t conn_required_num_new_connection_id(const ngtcp2_conn *conn) {
  *     User-defined callback function failed.
  */
 static int conn_enqueue_new_connection_id(ngtcp2_conn *conn) {
-  size_t i, need = conn_required_num_new_connection_id(conn);
+  size_t i, j, need = conn_required_num_new_connection_id(conn);
   size_t cidlen = conn->oscid.datalen;
   int rv;
   ngtcp2_frame_chain *nfrc;
@@ -3348,30 +3652,56 @@ static int conn_enqueue_new_connection_id(ngtcp2_conn *conn) {
     nfrc->fr.new_connection_id.seq = ++conn->scid.last_seq;
     nfrc->fr.new_connection_id.retire_prior_to = 0;
 
-    rv = conn_call_get_new_connection_id(conn, &nfrc->fr.new_connection_id.cid,
-                                         &nfrc->fr.new_connection_id.token,
-                                         cidlen);
-    if (rv != 0) {
-      goto fail;
-    }
+    for (j = 0;; ++j) {
+      rv = conn_call_get_new_connection_id(
+        conn, &nfrc->fr.new_connection_id.cid,
+        &nfrc->fr.new_connection_id.token, cidlen);
+      if (rv != 0) {
+        goto fail;
+      }
 
-    if (nfrc->fr.new_connection_id.cid.datalen != cidlen) {
-      rv = NGTCP2_ERR_CALLBACK_FAILURE;
-      goto fail;
-    }
+      if (nfrc->fr.new_connection_id.cid.datalen != cidlen) {
+        rv = NGTCP2_ERR_CALLBACK_FAILURE;
+        goto fail;
+      }
 
-    /* Assert uniqueness */
-    it =
-      ngtcp2_ksl_lower_bound(&conn->scid.set, &nfrc->fr.new_connection_id.cid);
-    if (!ngtcp2_ksl_it_end(&it) &&
-        ngtcp2_cid_eq(ngtcp2_ksl_it_key(&it),
-                      &nfrc->fr.new_connection_id.cid)) {
-      rv = NGTCP2_ERR_CALLBACK_FAILURE;
-      goto fail;
+      /* Assert uniqueness */
+      it = ngtcp2_ksl_lower_bound(&conn->scid.set,
+                                  &nfrc->fr.new_connection_id.cid);
+      if (!ngtcp2_ksl_it_end(&it) &&
+          ngtcp2_cid_eq(ngtcp2_ksl_it_key(&it),
+                        &nfrc->fr.new_connection_id.cid)) {
+        rv = NGTCP2_ERR_CALLBACK_FAILURE;
+        goto fail;
+      }
+
+      rv = conn_register_scid(conn, &nfrc->fr.new_connection_id.cid);
+      if (rv == 0) {
+        break;
+      }
+
+      if (rv != NGTCP2_ERR_INVALID_ARGUMENT) {
+        goto fail;
+      }
+
+      /* Connection ID is used by another connection.  Tell the
+         application that it is not used by this connection, and ask
+         for another one. */
+      rv = conn_call_remove_connection_id(conn,
+                                          &nfrc->fr.new_connection_id.cid);
+      if (rv != 0) {
+        goto fail;
+      }
+
+      if (j + 1 == NGTCP2_MAX_SCID_REGEN) {
+        rv = NGTCP2_ERR_CALLBACK_FAILURE;
+        goto fail;
+      }
     }
 
     scid = ngtcp2_mem_malloc(conn->mem, sizeof(*scid));
     if (scid == NULL) {
+      conn_unregister_scid(conn, &nfrc->fr.new_connection_id.cid);
       rv = NGTCP2_ERR_NOMEM;
       goto fail;
     }
@@ -3381,6 +3711,7 @@ static int conn_enqueue_new_connection_id(ngtcp2_conn *conn) {
 
     rv = ngtcp2_ksl_insert(&conn->scid.set, NULL, &scid->cid, scid);
     if (rv != 0) {
+      conn_unregister_scid(conn, &scid->cid);
       ngtcp2_mem_free(conn->mem, scid);
       goto fail;
     }
@@ -3440,6 +3771,7 @@ static int conn_remove_retired_connection_id(ngtcp2_conn *conn,
       return rv;
     }
 
+    conn_unregister_scid(conn, &scid->cid);
     ngtcp2_ksl_remove(&conn->scid.set, NULL, &scid->cid);
     ngtcp2_pq_pop(&conn->scid.used);
     ngtcp2_mem_free(conn->mem, scid);
@@ -3517,6 +3849,93 @@ static void conn_reset_ppe_pending(ngtcp2_conn *conn) {
   memset(&conn->pkt, 0, sizeof(conn->pkt));
 }
 
+/*
+ * conn_flush_hp_batch computes the header protection masks for the
+ * 1RTT packets in conn->tx.hp_batch with a single
+ * ngtcp2_callbacks.hp_mask_batch call, and applies them.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * NGTCP2_ERR_CALLBACK_FAILURE
+ *     User-defined callback function failed.
+ */
+static int conn_flush_hp_batch(ngtcp2_conn *conn) {
+  ngtcp2_pktns *pktns = &conn->pktns;
+  const uint8_t *samples[NGTCP2_HP_MASK_BATCH_MAX];
+  uint8_t masks[NGTCP2_HP_MASK_BATCH_MAX * NGTCP2_HP_SAMPLELEN];
+  size_t i, len = conn->tx.hp_batch.len;
+  int rv;
+
+  if (len == 0) {
+    return 0;
+  }
+
+  conn->tx.hp_batch.len = 0;
+
+  for (i = 0; i < len; ++i) {
+    samples[i] = conn->tx.hp_batch.ents[i].pkt +
+                 conn->tx.hp_batch.ents[i].pkt_num_offset + 4;
+  }
+
+  rv = conn->callbacks.hp_mask_batch(masks, &pktns->crypto.ctx.hp,
+                                     &pktns->crypto.tx.hp_ctx, samples, len);
+  if (rv != 0) {
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  }
+
+  for (i = 0; i < len; ++i) {
+    ngtcp2_ppe_apply_hp_mask(conn->tx.hp_batch.ents[i].pkt,
+                             conn->tx.hp_batch.ents[i].pkt_num_offset,
+                             conn->tx.hp_batch.ents[i].pkt_numlen,
+                             masks + i * NGTCP2_HP_SAMPLELEN);
+  }
+
+  return 0;
+}
+
+/*
+ * conn_ppe_final finalizes the packet in |ppe| of type |type|.  If
+ * NGTCP2_CONN_FLAG_DEFER_HP is set and |type| is NGTCP2_PKT_1RTT,
+ * header protection is deferred until conn_flush_hp_batch is called.
+ *
+ * This function returns the length of QUIC packet if it succeeds, or
+ * one of the following negative error codes:
+ *
+ * NGTCP2_ERR_CALLBACK_FAILURE
+ *     User-defined callback function failed.
+ */
+static ngtcp2_ssize conn_ppe_final(ngtcp2_conn *conn, ngtcp2_ppe *ppe,
+                                   uint8_t type) {
+  const uint8_t *pkt;
+  ngtcp2_ssize nwrite;
+  size_t len;
+  int rv;
+
+  if (type != NGTCP2_PKT_1RTT || !(conn->flags & NGTCP2_CONN_FLAG_DEFER_HP)) {
+    return ngtcp2_ppe_final(ppe, NULL);
+  }
+
+  if (conn->tx.hp_batch.len == NGTCP2_HP_MASK_BATCH_MAX) {
+    rv = conn_flush_hp_batch(conn);
+    if (rv != 0) {
+      return rv;
+    }
+  }
+
+  nwrite = ngtcp2_ppe_final_defer_hp(ppe, &pkt);
+  if (nwrite < 0) {
+    return nwrite;
+  }
+
+  len = conn->tx.hp_batch.len++;
+  conn->tx.hp_batch.ents[len].pkt = (uint8_t *)pkt;
+  conn->tx.hp_batch.ents[len].pkt_num_offset = ppe->pkt_num_offset;
+  conn->tx.hp_batch.ents[len].pkt_numlen = ppe->pkt_numlen;
+
+  return nwrite;
+}
+
 /*
  * conn_write_pkt writes a protected packet in the buffer pointed by
  * |dest| whose length if |destlen|.  |dgram_offset| is the offset in
@@ -3589,6 +4008,7 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
   uint64_t target_max_data;
   ngtcp2_conn_stat *cstat = &conn->cstat;
   uint64_t delta;
+  uint64_t shrink;
   const ngtcp2_cid *scid = NULL;
   int keep_alive_expired = 0;
   uint32_t version = 0;
@@ -3668,6 +4088,7 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
     }
 
     cc->encrypt = conn->callbacks.encrypt;
+    cc->encryptv = conn->callbacks.encryptv;
     cc->hp_mask = conn->callbacks.hp_mask;
 
     if (conn_should_send_max_data(conn)) {
@@ -3686,21 +4107,31 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
           target_max_data = conn->local.settings.max_window;
         }
 
-        delta = target_max_data - conn->rx.window;
+        delta = conn_acquire_rx_budget(conn, &conn->rx.budget_used,
+                                       target_max_data - conn->rx.window);
+
+        conn->rx.window += delta;
+
         if (conn->rx.unsent_max_offset + delta > NGTCP2_MAX_VARINT) {
           delta = NGTCP2_MAX_VARINT - conn->rx.unsent_max_offset;
         }
-
-        conn->rx.window = target_max_data;
       } else {
         delta = 0;
       }
 
+      if (delta == 0) {
+        shrink = conn_shrink_rx_window(
+          conn, &conn->rx.window, &conn->rx.budget_used,
+          conn->rx.unsent_max_offset - conn->rx.max_offset);
+      } else {
+        shrink = 0;
+      }
+
       conn->tx.last_max_data_ts = ts;
 
       nfrc->fr.max_data = (ngtcp2_max_data){
         .type = NGTCP2_FRAME_MAX_DATA,
-        .max_data = conn->rx.unsent_max_offset + delta,
+        .max_data = conn->rx.unsent_max_offset + delta - shrink,
       };
       nfrc->next = pktns->tx.frq;
       pktns->tx.frq = nfrc;
@@ -3869,6 +4300,14 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
           continue;
         }
         break;
+      case NGTCP2_FRAME_ACK_FREQUENCY:
+        if ((int64_t)(*pfrc)->fr.ack_frequency.seq != conn->tx.ack_freq.seq) {
+          frc = *pfrc;
+          *pfrc = (*pfrc)->next;
+          ngtcp2_frame_chain_objalloc_del(frc, &conn->frc_objalloc, conn->mem);
+          continue;
+        }
+        break;
       case NGTCP2_FRAME_CRYPTO:
         ngtcp2_unreachable();
       }
@@ -4094,22 +4533,32 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
               target_max_data = conn->local.settings.max_stream_window;
             }
 
-            delta = target_max_data - strm->rx.window;
+            delta = conn_acquire_rx_budget(conn, &strm->rx.budget_used,
+                                           target_max_data - strm->rx.window);
+
+            strm->rx.window += delta;
+
             if (strm->rx.unsent_max_offset + delta > NGTCP2_MAX_VARINT) {
               delta = NGTCP2_MAX_VARINT - strm->rx.unsent_max_offset;
             }
-
-            strm->rx.window = target_max_data;
           } else {
             delta = 0;
           }
 
+          if (delta == 0) {
+            shrink = conn_shrink_rx_window(
+              conn, &strm->rx.window, &strm->rx.budget_used,
+              strm->rx.unsent_max_offset - strm->rx.max_offset);
+          } else {
+            shrink = 0;
+          }
+
           strm->tx.last_max_stream_data_ts = ts;
 
           nfrc->fr.max_stream_data = (ngtcp2_max_stream_data){
             .type = NGTCP2_FRAME_MAX_STREAM_DATA,
             .stream_id = strm->stream_id,
-            .max_stream_data = strm->rx.unsent_max_offset + delta,
+            .max_stream_data = strm->rx.unsent_max_offset + delta - shrink,
           };
           *pfrc = nfrc;
 
@@ -4142,6 +4591,12 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
           continue;
         }
 
+        if (send_stream && strm->urgency > vmsg->stream.strm->urgency) {
+          /* The stream that an application is writing is more urgent
+             than the rest of the queue.  Send its data first. */
+          break;
+        }
+
         left = ngtcp2_ppe_left(ppe);
 
         left = ngtcp2_pkt_stream_max_datalen(strm->stream_id, stream_offset,
@@ -4183,7 +4638,7 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
         }
 
         ngtcp2_conn_tx_strmq_pop(conn);
-        ++strm->cycle;
+        conn_tx_strmq_advance_cycle(conn, strm);
         rv = ngtcp2_conn_tx_strmq_push(conn, strm);
         if (rv != 0) {
           assert(ngtcp2_err_is_fatal(rv));
@@ -4295,7 +4750,8 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
 
   left = ngtcp2_ppe_left(ppe);
 
-  if (*pfrc == NULL && send_stream && ngtcp2_pq_empty(&conn->tx.strmq) &&
+  if (*pfrc == NULL && send_stream &&
+      !conn_tx_strmq_preempts(conn, vmsg->stream.strm) &&
       (wdatalen = ngtcp2_pkt_stream_max_datalen(
          vmsg->stream.strm->stream_id, vmsg->stream.strm->tx.offset, ndatalen,
          left)) != (size_t)-1 &&
@@ -4553,7 +5009,15 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
     if (ngtcp2_tstamp_elapsed(pktns->tx.non_ack_pkt_start_ts,
                               cstat->smoothed_rtt, ts) ||
         keep_alive_expired || conn->pktns.rtb.probe_pkt_left) {
-      lfr.ping.type = NGTCP2_FRAME_PING;
+      /* Ask the remote endpoint to acknowledge a probe packet without
+         delay if it supports ACK Frequency extension. */
+      if (conn->pktns.rtb.probe_pkt_left && type == NGTCP2_PKT_1RTT &&
+          conn->remote.transport_params &&
+          conn->remote.transport_params->min_ack_delay) {
+        lfr.immediate_ack.type = NGTCP2_FRAME_IMMEDIATE_ACK;
+      } else {
+        lfr.ping.type = NGTCP2_FRAME_PING;
+      }
 
       rv = conn_ppe_write_frame_hd_log(conn, ppe, &hd_logged, hd, &lfr);
       if (rv != 0) {
@@ -4598,7 +5062,7 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
     ngtcp2_qlog_write_frame(&conn->qlog, &lfr);
   }
 
-  nwrite = ngtcp2_ppe_final(ppe, NULL);
+  nwrite = conn_ppe_final(conn, ppe, type);
   if (nwrite < 0) {
     assert(ngtcp2_err_is_fatal((int)nwrite));
     return nwrite;
@@ -4735,6 +5199,7 @@ ngtcp2_ssize ngtcp2_conn_write_single_frame_pkt(
   cc.aead = pktns->crypto.ctx.aead;
   cc.hp = pktns->crypto.ctx.hp;
   cc.encrypt = conn->callbacks.encrypt;
+  cc.encryptv = NULL;
   cc.hp_mask = conn->callbacks.hp_mask;
 
   ngtcp2_pkt_hd_init(&hd, hd_flags, type, dcid, scid,
@@ -4783,7 +5248,7 @@ ngtcp2_ssize ngtcp2_conn_write_single_frame_pkt(
     ngtcp2_qlog_write_frame(&conn->qlog, &lfr);
   }
 
-  nwrite = ngtcp2_ppe_final(&ppe, NULL);
+  nwrite = conn_ppe_final(conn, &ppe, type);
   if (nwrite < 0) {
     return nwrite;
   }
@@ -5053,7 +5518,13 @@ static int conn_start_pmtud(ngtcp2_conn *conn) {
 }
 
 int ngtcp2_conn_start_pmtud(ngtcp2_conn *conn) {
-  return conn_start_pmtud(conn);
+  int rv;
+
+  rv = conn_start_pmtud(conn);
+
+  conn_update_expiry(conn);
+
+  return rv;
 }
 
 void ngtcp2_conn_stop_pmtud(ngtcp2_conn *conn) {
@@ -5064,6 +5535,8 @@ void ngtcp2_conn_stop_pmtud(ngtcp2_conn *conn) {
   ngtcp2_pmtud_del(conn->pmtud);
 
   conn->pmtud = NULL;
+
+  conn_update_expiry(conn);
 }
 
 static ngtcp2_ssize conn_write_pmtud_probe(ngtcp2_conn *conn,
@@ -5541,17 +6014,6 @@ fin:
   return rv;
 }
 
-uint64_t ngtcp2_conn_tx_strmq_first_cycle(const ngtcp2_conn *conn) {
-  ngtcp2_strm *strm;
-
-  if (ngtcp2_pq_empty(&conn->tx.strmq)) {
-    return 0;
-  }
-
-  strm = ngtcp2_struct_of(ngtcp2_pq_top(&conn->tx.strmq), ngtcp2_strm, pe);
-  return strm->cycle;
-}
-
 /*
  * conn_on_retry is called when Retry packet is received.  The
  * function decodes the data in the buffer pointed by |pkt| whose
@@ -6003,7 +6465,8 @@ static ngtcp2_ssize decrypt_pkt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
  * decrypt_hp decryptes packet header.  The packet number starts at
  * |pkt| + |pkt_num_offset|.  The entire plaintext QUIC packet header
  * will be written to the buffer pointed by |dest| whose capacity is
- * |destlen|.
+ * |destlen|.  If |batched_mask| is not NULL, it is used as a header
+ * protection mask instead of calling |hp_mask|.
  *
  * This function returns the number of bytes written to |dest|, or one
  * of the following negative error codes:
@@ -6017,10 +6480,12 @@ static ngtcp2_ssize decrypt_pkt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
 static ngtcp2_ssize
 decrypt_hp(ngtcp2_pkt_hd *hd, uint8_t *dest, const ngtcp2_crypto_cipher *hp,
            const uint8_t *pkt, size_t pktlen, size_t pkt_num_offset,
-           const ngtcp2_crypto_cipher_ctx *hp_ctx, ngtcp2_hp_mask hp_mask) {
+           const ngtcp2_crypto_cipher_ctx *hp_ctx, ngtcp2_hp_mask hp_mask,
+           const uint8_t *batched_mask) {
   size_t sample_offset;
   uint8_t *p = dest;
-  uint8_t mask[NGTCP2_HP_SAMPLELEN];
+  uint8_t maskbuf[NGTCP2_HP_SAMPLELEN];
+  const uint8_t *mask = batched_mask;
   size_t i;
   int rv;
 
@@ -6034,9 +6499,13 @@ decrypt_hp(ngtcp2_pkt_hd *hd, uint8_t *dest, const ngtcp2_crypto_cipher *hp,
 
   sample_offset = pkt_num_offset + 4;
 
-  rv = hp_mask(mask, hp, hp_ctx, pkt + sample_offset);
-  if (rv != 0) {
-    return NGTCP2_ERR_CALLBACK_FAILURE;
+  if (!mask) {
+    rv = hp_mask(maskbuf, hp, hp_ctx, pkt + sample_offset);
+    if (rv != 0) {
+      return NGTCP2_ERR_CALLBACK_FAILURE;
+    }
+
+    mask = maskbuf;
   }
 
   if (hd->flags & NGTCP2_PKT_FLAG_LONG_FORM) {
@@ -6062,7 +6531,27 @@ decrypt_hp(ngtcp2_pkt_hd *hd, uint8_t *dest, const ngtcp2_crypto_cipher *hp,
 }
 
 /*
- * conn_emit_pending_crypto_data delivers pending stream data to the
+ * conn_get_batched_hp_mask returns the header protection mask that
+ * ngtcp2_conn_read_pkts has computed for the short header packet
+ * pointed by |pkt|.  It returns NULL if |pkt| is not the beginning
+ * of the datagram which is being processed, or no mask has been
+ * computed for it.
+ */
+static const uint8_t *conn_get_batched_hp_mask(ngtcp2_conn *conn,
+                                               const uint8_t *pkt) {
+  const ngtcp2_vec *pktv = conn->crypto.hp_mask_batch.pktv;
+  size_t idx = conn->crypto.hp_mask_batch.idx;
+
+  if (!pktv || pktv[idx].base != pkt ||
+      !conn->crypto.hp_mask_batch.samples[idx]) {
+    return NULL;
+  }
+
+  return conn->crypto.hp_mask_batch.masks + idx * NGTCP2_HP_SAMPLELEN;
+}
+
+/*
+ * conn_emit_pending_crypto_data delivers pending stream data to the
  * application due to packet reordering.
  *
  * This function returns 0 if it succeeds, or one of the following
@@ -6340,6 +6829,8 @@ static int pktns_pkt_num_is_duplicate(const ngtcp2_pktns *pktns,
  * received.  It stores |pkt_num| and its reception timestamp |ts| in
  * order to send its ACK.  It also increase ECN counts from |pi|.
  * |require_ack| is nonzero if the received packet is ack-eliciting.
+ * |reordering_thresh| is the number of out-of-order packets which
+ * triggers an immediate acknowledgement.  0 disables it.
  *
  * It returns 0 if it succeeds, or one of the following negative error
  * codes:
@@ -6351,6 +6842,7 @@ static int pktns_pkt_num_is_duplicate(const ngtcp2_pktns *pktns,
  */
 static int pktns_commit_recv_pkt_num(ngtcp2_pktns *pktns, int64_t pkt_num,
                                      const ngtcp2_pkt_info *pi, int require_ack,
+                                     uint64_t reordering_thresh,
                                      ngtcp2_tstamp ts) {
   ngtcp2_acktr *acktr = &pktns->acktr;
   ngtcp2_range r;
@@ -6366,14 +6858,15 @@ static int pktns_commit_recv_pkt_num(ngtcp2_pktns *pktns, int64_t pkt_num,
   }
 
   if (require_ack) {
-    if (pktns->rx.max_ack_eliciting_pkt_num != -1) {
+    if (pktns->rx.max_ack_eliciting_pkt_num != -1 && reordering_thresh) {
       if (pkt_num < pktns->rx.max_ack_eliciting_pkt_num) {
         ngtcp2_acktr_immediate_ack(&pktns->acktr);
       } else if (pkt_num != pktns->rx.max_ack_eliciting_pkt_num + 1) {
         r = ngtcp2_gaptr_get_first_gap_after(
           &pktns->rx.pngap, (uint64_t)pktns->rx.max_ack_eliciting_pkt_num);
 
-        if (r.begin < (uint64_t)pkt_num) {
+        if (r.begin < (uint64_t)pkt_num &&
+            (uint64_t)pkt_num - r.begin >= reordering_thresh) {
           ngtcp2_acktr_immediate_ack(&pktns->acktr);
         }
       }
@@ -6857,7 +7350,7 @@ conn_recv_handshake_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
   }
 
   nwrite = decrypt_hp(&hd, conn->crypto.decrypt_hp_buf.base, hp, pkt, pktlen,
-                      (size_t)nread, hp_ctx, hp_mask);
+                      (size_t)nread, hp_ctx, hp_mask, NULL);
   if (nwrite < 0) {
     if (ngtcp2_err_is_fatal((int)nwrite)) {
       return nwrite;
@@ -7063,7 +7556,8 @@ conn_recv_handshake_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
 
   ngtcp2_qlog_pkt_received_end(&conn->qlog, &hd, pktlen);
 
-  rv = pktns_commit_recv_pkt_num(pktns, hd.pkt_num, pi, require_ack, pkt_ts);
+  rv = pktns_commit_recv_pkt_num(pktns, hd.pkt_num, pi, require_ack,
+                                 /* reordering_thresh = */ 1, pkt_ts);
   if (rv != 0) {
     return rv;
   }
@@ -7458,7 +7952,8 @@ static int conn_recv_crypto(ngtcp2_conn *conn,
   }
 
   nwrite = ngtcp2_strm_recv_reordering(crypto, fr->data[0].base,
-                                       fr->data[0].len, fr->offset);
+                                       fr->data[0].len, fr->offset,
+                                       /* rxbuf = */ NULL);
   if (nwrite < 0) {
     return (int)nwrite;
   }
@@ -7506,7 +8001,7 @@ static int conn_max_data_violated(const ngtcp2_conn *conn, uint64_t datalen) {
  *     Suspicious remote endpoint activity exceeded threshold.
  */
 static int conn_recv_stream(ngtcp2_conn *conn, const ngtcp2_stream *fr,
-                            ngtcp2_tstamp ts) {
+                            ngtcp2_rxbuf *rxbuf, ngtcp2_tstamp ts) {
   int rv;
   ngtcp2_strm *strm;
   ngtcp2_idtr *idtr;
@@ -7709,7 +8204,7 @@ static int conn_recv_stream(ngtcp2_conn *conn, const ngtcp2_stream *fr,
     }
   } else if (fr->datacnt) {
     nwrite = ngtcp2_strm_recv_reordering(strm, fr->data[0].base,
-                                         fr->data[0].len, fr->offset);
+                                         fr->data[0].len, fr->offset, rxbuf);
     if (nwrite < 0) {
       return (int)nwrite;
     }
@@ -8754,6 +9249,43 @@ static int conn_recv_datagram(ngtcp2_conn *conn, ngtcp2_datagram *fr) {
   return conn_call_recv_datagram(conn, fr);
 }
 
+/*
+ * conn_recv_ack_frequency processes the incoming ACK_FREQUENCY frame
+ * |fr|.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * NGTCP2_ERR_PROTO
+ *     The local endpoint does not support ACK Frequency extension;
+ *     or Requested Max Ack Delay is out of range.
+ */
+static int conn_recv_ack_frequency(ngtcp2_conn *conn,
+                                   const ngtcp2_ack_frequency *fr) {
+  if (!conn->local.transport_params.min_ack_delay) {
+    return NGTCP2_ERR_PROTO;
+  }
+
+  if (fr->max_ack_delay <
+        conn->local.transport_params.min_ack_delay / NGTCP2_MICROSECONDS ||
+      fr->max_ack_delay >= 16384 * 1000) {
+    return NGTCP2_ERR_PROTO;
+  }
+
+  if ((int64_t)fr->seq <= conn->rx.ack_freq.seq) {
+    return 0;
+  }
+
+  conn->rx.ack_freq.seq = (int64_t)fr->seq;
+  conn->rx.ack_freq.thresh = fr->ack_eliciting_thresh >= SIZE_MAX
+                               ? SIZE_MAX
+                               : (size_t)fr->ack_eliciting_thresh + 1;
+  conn->rx.ack_freq.max_ack_delay = fr->max_ack_delay * NGTCP2_MICROSECONDS;
+  conn->rx.ack_freq.reordering_thresh = fr->reordering_thresh;
+
+  return 0;
+}
+
 /*
  * conn_key_phase_changed returns nonzero if |hd| indicates that the
  * key phase has unexpected value.
@@ -9235,7 +9767,8 @@ conn_recv_delayed_handshake_pkt(ngtcp2_conn *conn, const ngtcp2_pkt_info *pi,
 
   ngtcp2_qlog_pkt_received_end(&conn->qlog, hd, pktlen);
 
-  rv = pktns_commit_recv_pkt_num(pktns, hd->pkt_num, pi, require_ack, pkt_ts);
+  rv = pktns_commit_recv_pkt_num(pktns, hd->pkt_num, pi, require_ack,
+                                 /* reordering_thresh = */ 1, pkt_ts);
   if (rv != 0) {
     return rv;
   }
@@ -9314,7 +9847,11 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
   int recv_ncid = 0;
   int new_cid_used = 0;
   int path_challenge_recved = 0;
+  int immediate_ack = 0;
   size_t num_ack_processed = 0;
+  uint8_t *dest;
+  ngtcp2_rxbuf *rxbuf = NULL;
+  const uint8_t *batched_mask = NULL;
 
   if (pkt[0] & NGTCP2_HEADER_FORM_BIT) {
     nread = ngtcp2_pkt_decode_hd_long(&hd, pkt, pktlen);
@@ -9416,6 +9953,7 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
     hp_ctx = &pktns->crypto.rx.hp_ctx;
     hp_mask = conn->callbacks.hp_mask;
     decrypt = conn->callbacks.decrypt;
+    batched_mask = conn_get_batched_hp_mask(conn, pkt);
   }
 
   rv = conn_ensure_decrypt_hp_buffer(conn, (size_t)nread + 4);
@@ -9424,7 +9962,7 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
   }
 
   nwrite = decrypt_hp(&hd, conn->crypto.decrypt_hp_buf.base, hp, pkt, pktlen,
-                      (size_t)nread, hp_ctx, hp_mask);
+                      (size_t)nread, hp_ctx, hp_mask, batched_mask);
   if (nwrite < 0) {
     if (ngtcp2_err_is_fatal((int)nwrite)) {
       return nwrite;
@@ -9463,9 +10001,19 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
     key_phase_bit_changed = conn_key_phase_changed(conn, &hd);
   }
 
-  rv = conn_ensure_decrypt_buffer(conn, payloadlen);
-  if (rv != 0) {
-    return rv;
+  if (conn->rx.rxbuf.buf && payload >= conn->rx.rxbuf.pkt &&
+      payload + payloadlen <= conn->rx.rxbuf.pkt + conn->rx.rxbuf.pktlen) {
+    /* Decrypt in place so that stream data can be referenced from
+       the receive buffer. */
+    dest = conn->rx.rxbuf.pkt + (payload - conn->rx.rxbuf.pkt);
+    rxbuf = conn->rx.rxbuf.buf;
+  } else {
+    rv = conn_ensure_decrypt_buffer(conn, payloadlen);
+    if (rv != 0) {
+      return rv;
+    }
+
+    dest = conn->crypto.decrypt_buf.base;
   }
 
   if (key_phase_bit_changed) {
@@ -9497,7 +10045,7 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
     }
   }
 
-  nwrite = decrypt_pkt(conn->crypto.decrypt_buf.base, aead, payload, payloadlen,
+  nwrite = decrypt_pkt(dest, aead, payload, payloadlen,
                        conn->crypto.decrypt_hp_buf.base, hdpktlen, hd.pkt_num,
                        ckm, decrypt);
 
@@ -9543,7 +10091,7 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
     return NGTCP2_ERR_DISCARD_PKT;
   }
 
-  payload = conn->crypto.decrypt_buf.base;
+  payload = dest;
   payloadlen = (size_t)nwrite;
 
   if (payloadlen == 0) {
@@ -9688,7 +10236,7 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
       ++num_ack_processed;
       break;
     case NGTCP2_FRAME_STREAM:
-      rv = conn_recv_stream(conn, &fr.stream, ts);
+      rv = conn_recv_stream(conn, &fr.stream, rxbuf, ts);
       if (rv != 0) {
         return rv;
       }
@@ -9825,6 +10373,20 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
       }
       non_probing_pkt = 1;
       break;
+    case NGTCP2_FRAME_ACK_FREQUENCY:
+      rv = conn_recv_ack_frequency(conn, &fr.ack_frequency);
+      if (rv != 0) {
+        return rv;
+      }
+      non_probing_pkt = 1;
+      break;
+    case NGTCP2_FRAME_IMMEDIATE_ACK:
+      if (!conn->local.transport_params.min_ack_delay) {
+        return NGTCP2_ERR_PROTO;
+      }
+      immediate_ack = 1;
+      non_probing_pkt = 1;
+      break;
     }
 
     ngtcp2_qlog_write_frame(&conn->qlog, &fr);
@@ -9885,13 +10447,14 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
     }
   }
 
-  rv = pktns_commit_recv_pkt_num(pktns, hd.pkt_num, pi, require_ack, pkt_ts);
+  rv = pktns_commit_recv_pkt_num(pktns, hd.pkt_num, pi, require_ack,
+                                 conn->rx.ack_freq.reordering_thresh, pkt_ts);
   if (rv != 0) {
     return rv;
   }
 
   if (require_ack &&
-      (++pktns->acktr.rx_npkt >= conn->local.settings.ack_thresh ||
+      (++pktns->acktr.rx_npkt >= conn->rx.ack_freq.thresh || immediate_ack ||
        (pi->ecn & NGTCP2_ECN_MASK) == NGTCP2_ECN_CE)) {
     ngtcp2_acktr_immediate_ack(&pktns->acktr);
   }
@@ -10382,11 +10945,9 @@ static ngtcp2_ssize conn_read_handshake(ngtcp2_conn *conn,
   }
 }
 
-int ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
-                                   int pkt_info_version,
-                                   const ngtcp2_pkt_info *pi,
-                                   const uint8_t *pkt, size_t pktlen,
-                                   ngtcp2_tstamp ts) {
+static int conn_read_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
+                         int pkt_info_version, const ngtcp2_pkt_info *pi,
+                         const uint8_t *pkt, size_t pktlen, ngtcp2_tstamp ts) {
   int rv = 0;
   ngtcp2_ssize nread = 0;
   const ngtcp2_pkt_info zero_pi = {0};
@@ -10484,7 +11045,179 @@ int ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
   return conn_recv_cpkt(conn, path, pi, pkt, pktlen, ts);
 }
 
-int ngtcp2_conn_continue_handshake(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+int ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
+                                   int pkt_info_version,
+                                   const ngtcp2_pkt_info *pi,
+                                   const uint8_t *pkt, size_t pktlen,
+                                   ngtcp2_tstamp ts) {
+  int rv;
+
+  rv = conn_read_pkt(conn, path, pkt_info_version, pi, pkt, pktlen, ts);
+
+  conn_update_expiry(conn);
+
+  return rv;
+}
+
+/*
+ * conn_compute_batched_hp_mask computes the header protection masks
+ * for the short header packets at the beginning of |pktcnt|
+ * datagrams pointed by |pktv| in a single call of
+ * ngtcp2_callbacks.hp_mask_batch.  The masks are written to |masks|,
+ * and the pointers to samples are written to |samples|.  If no mask
+ * is computed for pktv[i], samples[i] is set to NULL.
+ *
+ * This function returns 0 if it succeeds, or
+ * NGTCP2_ERR_CALLBACK_FAILURE.
+ */
+static int conn_compute_batched_hp_mask(ngtcp2_conn *conn, uint8_t *masks,
+                                        const uint8_t **samples,
+                                        const ngtcp2_vec *pktv,
+                                        size_t pktcnt) {
+  ngtcp2_pktns *pktns = &conn->pktns;
+  const uint8_t *batch[NGTCP2_HP_MASK_BATCH_MAX];
+  size_t sample_offset = 1 + conn->oscid.datalen + 4;
+  size_t i, nsamples = 0;
+  uint8_t *dest;
+  int rv;
+
+  assert(pktcnt <= NGTCP2_HP_MASK_BATCH_MAX);
+
+  for (i = 0; i < pktcnt; ++i) {
+    if (pktv[i].len < sample_offset + NGTCP2_HP_SAMPLELEN ||
+        (pktv[i].base[0] & NGTCP2_HEADER_FORM_BIT)) {
+      samples[i] = NULL;
+      continue;
+    }
+
+    samples[i] = pktv[i].base + sample_offset;
+    batch[nsamples++] = samples[i];
+  }
+
+  if (nsamples == 0) {
+    return 0;
+  }
+
+  rv = conn->callbacks.hp_mask_batch(masks, &pktns->crypto.ctx.hp,
+                                     &pktns->crypto.rx.hp_ctx, batch, nsamples);
+  if (rv != 0) {
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  }
+
+  /* Spread the masks so that the mask for samples[i] starts at masks
+     + i * NGTCP2_HP_SAMPLELEN.  Iterate backwards so that no mask is
+     overwritten before it is moved. */
+  for (i = pktcnt; i > 0 && nsamples < i; --i) {
+    if (!samples[i - 1]) {
+      continue;
+    }
+
+    dest = masks + (i - 1) * NGTCP2_HP_SAMPLELEN;
+    --nsamples;
+    memmove(dest, masks + nsamples * NGTCP2_HP_SAMPLELEN, NGTCP2_HP_SAMPLELEN);
+  }
+
+  return 0;
+}
+
+int ngtcp2_conn_read_pkts_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
+                                    int pkt_info_version,
+                                    const ngtcp2_pkt_info *pi,
+                                    const ngtcp2_vec *pktv, size_t pktcnt,
+                                    ngtcp2_tstamp ts) {
+  uint8_t masks[NGTCP2_HP_MASK_BATCH_MAX * NGTCP2_HP_SAMPLELEN];
+  const uint8_t *samples[NGTCP2_HP_MASK_BATCH_MAX];
+  size_t i, n;
+  int rv;
+
+  for (; pktcnt; pktv += n, pktcnt -= n) {
+    n = ngtcp2_min(pktcnt, NGTCP2_HP_MASK_BATCH_MAX);
+
+    if (n > 1 && conn->callbacks.hp_mask_batch &&
+        conn->state == NGTCP2_CS_POST_HANDSHAKE) {
+      rv = conn_compute_batched_hp_mask(conn, masks, samples, pktv, n);
+      if (rv != 0) {
+        return rv;
+      }
+
+      conn->crypto.hp_mask_batch.pktv = pktv;
+      conn->crypto.hp_mask_batch.samples = samples;
+      conn->crypto.hp_mask_batch.masks = masks;
+    }
+
+    for (i = 0; i < n; ++i) {
+      conn->crypto.hp_mask_batch.idx = i;
+
+      rv = conn_read_pkt(conn, path, pkt_info_version, pi, pktv[i].base,
+                         pktv[i].len, ts);
+      if (rv != 0) {
+        conn->crypto.hp_mask_batch.pktv = NULL;
+
+        conn_update_expiry(conn);
+
+        return rv;
+      }
+    }
+
+    conn->crypto.hp_mask_batch.pktv = NULL;
+  }
+
+  conn_update_expiry(conn);
+
+  return 0;
+}
+
+/*
+ * conn_release_rxbuf is called when the last reference to |rxbuf| is
+ * dropped.
+ */
+static void conn_release_rxbuf(ngtcp2_rxbuf *rxbuf) {
+  ngtcp2_conn *conn = rxbuf->ctx;
+
+  conn->callbacks.release_rx_buf(conn, rxbuf->user_data, conn->user_data);
+
+  ngtcp2_mem_free(conn->mem, rxbuf);
+}
+
+int ngtcp2_conn_read_pkt_rx_buf_versioned(ngtcp2_conn *conn,
+                                          const ngtcp2_path *path,
+                                          int pkt_info_version,
+                                          const ngtcp2_pkt_info *pi,
+                                          uint8_t *pkt, size_t pktlen,
+                                          void *rx_buf, ngtcp2_tstamp ts) {
+  ngtcp2_rxbuf *rxbuf;
+  int rv;
+
+  if (!conn->callbacks.release_rx_buf) {
+    return ngtcp2_conn_read_pkt_versioned(conn, path, pkt_info_version, pi,
+                                          pkt, pktlen, ts);
+  }
+
+  rxbuf = ngtcp2_mem_malloc(conn->mem, sizeof(*rxbuf));
+  if (rxbuf == NULL) {
+    conn->callbacks.release_rx_buf(conn, rx_buf, conn->user_data);
+
+    return NGTCP2_ERR_NOMEM;
+  }
+
+  ngtcp2_rxbuf_init(rxbuf, conn_release_rxbuf, conn, rx_buf, pktlen,
+                    &conn->rx.rxbuf.lim);
+
+  conn->rx.rxbuf.buf = rxbuf;
+  conn->rx.rxbuf.pkt = pkt;
+  conn->rx.rxbuf.pktlen = pktlen;
+
+  rv = ngtcp2_conn_read_pkt_versioned(conn, path, pkt_info_version, pi, pkt,
+                                      pktlen, ts);
+
+  conn->rx.rxbuf.buf = NULL;
+
+  ngtcp2_rxbuf_decref(rxbuf);
+
+  return rv;
+}
+
+static int conn_continue_handshake(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   int rv;
   ngtcp2_encryption_level encryption_level;
   uint64_t offset;
@@ -10527,6 +11260,16 @@ int ngtcp2_conn_continue_handshake(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   }
 }
 
+int ngtcp2_conn_continue_handshake(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+  int rv;
+
+  rv = conn_continue_handshake(conn, ts);
+
+  conn_update_expiry(conn);
+
+  return rv;
+}
+
 /*
  * conn_check_pkt_num_exhausted returns nonzero if packet number is
  * exhausted in at least one of packet number space.
@@ -10967,6 +11710,8 @@ void ngtcp2_conn_tls_handshake_completed(ngtcp2_conn *conn) {
   if (conn->server) {
     conn->flags |= NGTCP2_CONN_FLAG_HANDSHAKE_CONFIRMED;
   }
+
+  conn_update_expiry(conn);
 }
 
 int ngtcp2_conn_get_handshake_completed(ngtcp2_conn *conn) {
@@ -11036,7 +11781,7 @@ int ngtcp2_conn_install_initial_key(
 
   if (pktns->crypto.rx.ckm) {
     conn_call_delete_crypto_aead_ctx(conn, &pktns->crypto.rx.ckm->aead_ctx);
-    ngtcp2_crypto_km_del(pktns->crypto.rx.ckm, conn->mem);
+    ngtcp2_crypto_km_del(pktns->crypto.rx.ckm, conn->hs_mem);
     pktns->crypto.rx.ckm = NULL;
   }
 
@@ -11045,20 +11790,20 @@ int ngtcp2_conn_install_initial_key(
 
   if (pktns->crypto.tx.ckm) {
     conn_call_delete_crypto_aead_ctx(conn, &pktns->crypto.tx.ckm->aead_ctx);
-    ngtcp2_crypto_km_del(pktns->crypto.tx.ckm, conn->mem);
+    ngtcp2_crypto_km_del(pktns->crypto.tx.ckm, conn->hs_mem);
     pktns->crypto.tx.ckm = NULL;
   }
 
   rv = ngtcp2_crypto_km_new(&pktns->crypto.rx.ckm, NULL, 0, NULL, rx_iv, ivlen,
-                            conn->mem);
+                            conn->hs_mem);
   if (rv != 0) {
     return rv;
   }
 
   rv = ngtcp2_crypto_km_new(&pktns->crypto.tx.ckm, NULL, 0, NULL, tx_iv, ivlen,
-                            conn->mem);
+                            conn->hs_mem);
   if (rv != 0) {
-    ngtcp2_crypto_km_del(pktns->crypto.rx.ckm, conn->mem);
+    ngtcp2_crypto_km_del(pktns->crypto.rx.ckm, conn->hs_mem);
     pktns->crypto.rx.ckm = NULL;
 
     return rv;
@@ -11089,7 +11834,7 @@ int ngtcp2_conn_install_vneg_initial_key(
 
   if (conn->vneg.rx.ckm) {
     conn_call_delete_crypto_aead_ctx(conn, &conn->vneg.rx.ckm->aead_ctx);
-    ngtcp2_crypto_km_del(conn->vneg.rx.ckm, conn->mem);
+    ngtcp2_crypto_km_del(conn->vneg.rx.ckm, conn->hs_mem);
     conn->vneg.rx.ckm = NULL;
   }
 
@@ -11098,20 +11843,20 @@ int ngtcp2_conn_install_vneg_initial_key(
 
   if (conn->vneg.tx.ckm) {
     conn_call_delete_crypto_aead_ctx(conn, &conn->vneg.tx.ckm->aead_ctx);
-    ngtcp2_crypto_km_del(conn->vneg.tx.ckm, conn->mem);
+    ngtcp2_crypto_km_del(conn->vneg.tx.ckm, conn->hs_mem);
     conn->vneg.tx.ckm = NULL;
   }
 
   rv = ngtcp2_crypto_km_new(&conn->vneg.rx.ckm, NULL, 0, NULL, rx_iv, ivlen,
-                            conn->mem);
+                            conn->hs_mem);
   if (rv != 0) {
     return rv;
   }
 
   rv = ngtcp2_crypto_km_new(&conn->vneg.tx.ckm, NULL, 0, NULL, tx_iv, ivlen,
-                            conn->mem);
+                            conn->hs_mem);
   if (rv != 0) {
-    ngtcp2_crypto_km_del(conn->vneg.rx.ckm, conn->mem);
+    ngtcp2_crypto_km_del(conn->vneg.rx.ckm, conn->hs_mem);
     conn->vneg.rx.ckm = NULL;
 
     return rv;
@@ -11140,7 +11885,7 @@ int ngtcp2_conn_install_rx_handshake_key(
   assert(!pktns->crypto.rx.ckm);
 
   rv = ngtcp2_crypto_km_new(&pktns->crypto.rx.ckm, NULL, 0, aead_ctx, iv, ivlen,
-                            conn->mem);
+                            conn->hs_mem);
   if (rv != 0) {
     return rv;
   }
@@ -11149,7 +11894,7 @@ int ngtcp2_conn_install_rx_handshake_key(
 
   rv = conn_call_recv_rx_key(conn, NGTCP2_ENCRYPTION_LEVEL_HANDSHAKE);
   if (rv != 0) {
-    ngtcp2_crypto_km_del(pktns->crypto.rx.ckm, conn->mem);
+    ngtcp2_crypto_km_del(pktns->crypto.rx.ckm, conn->hs_mem);
     pktns->crypto.rx.ckm = NULL;
     pktns->crypto.rx.hp_ctx = (ngtcp2_crypto_cipher_ctx){0};
 
@@ -11171,7 +11916,7 @@ int ngtcp2_conn_install_tx_handshake_key(
   assert(!pktns->crypto.tx.ckm);
 
   rv = ngtcp2_crypto_km_new(&pktns->crypto.tx.ckm, NULL, 0, aead_ctx, iv, ivlen,
-                            conn->mem);
+                            conn->hs_mem);
   if (rv != 0) {
     return rv;
   }
@@ -11196,7 +11941,7 @@ fail:
   /* If this function fails, aead_ctx and hp_ctx are still owned by
      the caller.  Delete the install key to remove the any reference
      to them. */
-  ngtcp2_crypto_km_del(pktns->crypto.tx.ckm, conn->mem);
+  ngtcp2_crypto_km_del(pktns->crypto.tx.ckm, conn->hs_mem);
   pktns->crypto.tx.ckm = NULL;
   pktns->crypto.tx.hp_ctx = (ngtcp2_crypto_cipher_ctx){0};
 
@@ -11214,7 +11959,7 @@ int ngtcp2_conn_install_0rtt_key(ngtcp2_conn *conn,
   assert(!conn->early.ckm);
 
   rv = ngtcp2_crypto_km_new(&conn->early.ckm, NULL, 0, aead_ctx, iv, ivlen,
-                            conn->mem);
+                            conn->hs_mem);
   if (rv != 0) {
     return rv;
   }
@@ -11229,7 +11974,7 @@ int ngtcp2_conn_install_0rtt_key(ngtcp2_conn *conn,
     rv = conn_call_recv_tx_key(conn, NGTCP2_ENCRYPTION_LEVEL_0RTT);
   }
   if (rv != 0) {
-    ngtcp2_crypto_km_del(conn->early.ckm, conn->mem);
+    ngtcp2_crypto_km_del(conn->early.ckm, conn->hs_mem);
     conn->early.ckm = NULL;
     conn->early.hp_ctx = (ngtcp2_crypto_cipher_ctx){0};
 
@@ -11351,9 +12096,15 @@ static int conn_initiate_key_update(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
 }
 
 int ngtcp2_conn_initiate_key_update(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+  int rv;
+
   conn_update_timestamp(conn, ts);
 
-  return conn_initiate_key_update(conn, ts);
+  rv = conn_initiate_key_update(conn, ts);
+
+  conn_update_expiry(conn);
+
+  return rv;
 }
 
 ngtcp2_tstamp ngtcp2_conn_loss_detection_expiry(const ngtcp2_conn *conn) {
@@ -11422,11 +12173,11 @@ static ngtcp2_tstamp conn_handshake_expiry(const ngtcp2_conn *conn) {
          conn->local.settings.handshake_timeout;
 }
 
-ngtcp2_tstamp ngtcp2_conn_get_expiry(ngtcp2_conn *conn) {
-  return ngtcp2_conn_get_expiry2(conn);
-}
-
-ngtcp2_tstamp ngtcp2_conn_get_expiry2(const ngtcp2_conn *conn) {
+/*
+ * conn_compute_expiry returns the earliest expiry among the timers
+ * of |conn|.
+ */
+static ngtcp2_tstamp conn_compute_expiry(const ngtcp2_conn *conn) {
   ngtcp2_tstamp res = ngtcp2_min(ngtcp2_conn_loss_detection_expiry(conn),
                                  ngtcp2_conn_ack_delay_expiry(conn));
   res = ngtcp2_min(res, ngtcp2_conn_internal_expiry(conn));
@@ -11437,7 +12188,34 @@ ngtcp2_tstamp ngtcp2_conn_get_expiry2(const ngtcp2_conn *conn) {
   return ngtcp2_min(res, conn->tx.pacing.next_ts);
 }
 
-int ngtcp2_conn_handle_expiry(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+ngtcp2_tstamp ngtcp2_conn_get_expiry(ngtcp2_conn *conn) {
+  return ngtcp2_conn_get_expiry2(conn);
+}
+
+ngtcp2_tstamp ngtcp2_conn_get_expiry2(const ngtcp2_conn *conn) {
+  if (conn->flags & NGTCP2_CONN_FLAG_EXPIRY_STALE) {
+    return conn_compute_expiry(conn);
+  }
+
+  return conn->expiry.ts;
+}
+
+int ngtcp2_conn_poll_expiry(ngtcp2_conn *conn, ngtcp2_tstamp *pexpiry) {
+  int changed;
+
+  if (conn->flags & NGTCP2_CONN_FLAG_EXPIRY_STALE) {
+    conn_refresh_expiry(conn);
+  }
+
+  changed = conn->expiry.ts != conn->expiry.last_polled_ts;
+  conn->expiry.last_polled_ts = conn->expiry.ts;
+
+  *pexpiry = conn->expiry.ts;
+
+  return changed;
+}
+
+static int conn_handle_expiry(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   int rv;
   ngtcp2_duration pto;
 
@@ -11504,6 +12282,16 @@ int ngtcp2_conn_handle_expiry(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   return 0;
 }
 
+int ngtcp2_conn_handle_expiry(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+  int rv;
+
+  rv = conn_handle_expiry(conn, ts);
+
+  conn_update_expiry(conn);
+
+  return rv;
+}
+
 static void acktr_cancel_expired_ack_delay_timer(ngtcp2_acktr *acktr,
                                                  ngtcp2_duration max_ack_delay,
                                                  ngtcp2_tstamp ts) {
@@ -11715,8 +12503,9 @@ ngtcp2_conn_server_negotiate_version(ngtcp2_conn *conn,
     version_info->available_versionslen, version_info->chosen_version);
 }
 
-int ngtcp2_conn_set_remote_transport_params(
-  ngtcp2_conn *conn, const ngtcp2_transport_params *params) {
+static int
+conn_set_remote_transport_params(ngtcp2_conn *conn,
+                                 const ngtcp2_transport_params *params) {
   int rv;
 
   /* We expect this function is called once per QUIC connection, but
@@ -11750,6 +12539,10 @@ int ngtcp2_conn_set_remote_transport_params(
     return NGTCP2_ERR_TRANSPORT_PARAM;
   }
 
+  if (params->min_ack_delay > params->max_ack_delay) {
+    return NGTCP2_ERR_TRANSPORT_PARAM;
+  }
+
   if (conn->server) {
     if (params->original_dcid_present ||
         params->stateless_reset_token_present ||
@@ -11827,6 +12620,17 @@ int ngtcp2_conn_set_remote_transport_params(
   return 0;
 }
 
+int ngtcp2_conn_set_remote_transport_params(
+  ngtcp2_conn *conn, const ngtcp2_transport_params *params) {
+  int rv;
+
+  rv = conn_set_remote_transport_params(conn, params);
+
+  conn_update_expiry(conn);
+
+  return rv;
+}
+
 int ngtcp2_conn_decode_and_set_remote_transport_params(ngtcp2_conn *conn,
                                                        const uint8_t *data,
                                                        size_t datalen) {
@@ -11971,6 +12775,8 @@ int ngtcp2_conn_set_0rtt_remote_transport_params(
   ngtcp2_qlog_parameters_set_transport_params(&conn->qlog, p, conn->server,
                                               NGTCP2_QLOG_SIDE_REMOTE);
 
+  conn_update_expiry(conn);
+
   return 0;
 }
 
@@ -11987,6 +12793,7 @@ int ngtcp2_conn_set_local_transport_params_versioned(
          NGTCP2_DEFAULT_ACTIVE_CONNECTION_ID_LIMIT);
   assert(params->active_connection_id_limit <=
          NGTCP2_DCIDTR_MAX_UNUSED_DCID_SIZE);
+  assert(params->min_ack_delay <= params->max_ack_delay);
 
   if (conn->hs_pktns == NULL || conn->hs_pktns->crypto.tx.ckm) {
     return NGTCP2_ERR_INVALID_STATE;
@@ -11994,6 +12801,8 @@ int ngtcp2_conn_set_local_transport_params_versioned(
 
   conn_set_local_transport_params(conn, params);
 
+  conn_update_expiry(conn);
+
   return 0;
 }
 
@@ -12026,6 +12835,13 @@ int ngtcp2_conn_commit_local_transport_params(ngtcp2_conn *conn) {
       return rv;
     }
 
+    rv = conn_register_scid(conn, &scident->cid);
+    if (rv != 0) {
+      ngtcp2_ksl_remove(&conn->scid.set, NULL, &scident->cid);
+      ngtcp2_mem_free(mem, scident);
+      return rv;
+    }
+
     conn->scid.last_seq = 1;
   }
 
@@ -12164,6 +12980,9 @@ conn_write_vmsg_wrapper(ngtcp2_conn *conn, ngtcp2_path *path,
 
   nwrite = ngtcp2_conn_write_vmsg(conn, path, pkt_info_version, pi, dest,
                                   destlen, wflags, vmsg, ts);
+
+  conn_update_expiry(conn);
+
   if (nwrite < 0) {
     return nwrite;
   }
@@ -12954,22 +13773,29 @@ ngtcp2_ssize ngtcp2_conn_write_connection_close_versioned(
   ngtcp2_conn *conn, ngtcp2_path *path, int pkt_info_version,
   ngtcp2_pkt_info *pi, uint8_t *dest, size_t destlen, const ngtcp2_ccerr *ccerr,
   ngtcp2_tstamp ts) {
+  ngtcp2_ssize nwrite;
   (void)pkt_info_version;
 
   conn_update_timestamp(conn, ts);
 
   switch (ccerr->type) {
   case NGTCP2_CCERR_TYPE_TRANSPORT:
-    return ngtcp2_conn_write_connection_close_pkt(
+    nwrite = ngtcp2_conn_write_connection_close_pkt(
       conn, path, pi, dest, destlen, ccerr->error_code, ccerr->reason,
       ccerr->reasonlen, ts);
+    break;
   case NGTCP2_CCERR_TYPE_APPLICATION:
-    return ngtcp2_conn_write_application_close_pkt(
+    nwrite = ngtcp2_conn_write_application_close_pkt(
       conn, path, pi, dest, destlen, ccerr->error_code, ccerr->reason,
       ccerr->reasonlen, ts);
+    break;
   default:
     return 0;
   }
+
+  conn_update_expiry(conn);
+
+  return nwrite;
 }
 
 int ngtcp2_conn_in_closing_period(ngtcp2_conn *conn) {
@@ -13006,6 +13832,7 @@ int ngtcp2_conn_close_stream(ngtcp2_conn *conn, ngtcp2_strm *strm) {
     ngtcp2_pq_remove(&conn->tx.strmq, &strm->pe);
   }
 
+  conn_release_rx_budget(conn, &strm->rx.budget_used);
   ngtcp2_strm_free(strm);
   ngtcp2_objalloc_strm_release(&conn->strm_objalloc, strm);
 
@@ -13251,6 +14078,7 @@ static int delete_strms_pq_each(void *data, void *ptr) {
     ngtcp2_pq_remove(&conn->tx.strmq, &s->pe);
   }
 
+  conn_release_rx_budget(conn, &s->rx.budget_used);
   ngtcp2_strm_free(s);
   ngtcp2_objalloc_strm_release(&conn->strm_objalloc, s);
 
@@ -13340,8 +14168,7 @@ void ngtcp2_conn_update_rtt(ngtcp2_conn *conn, ngtcp2_duration rtt,
     if (conn->flags & NGTCP2_CONN_FLAG_HANDSHAKE_CONFIRMED) {
       assert(conn->remote.transport_params);
 
-      ack_delay =
-        ngtcp2_min(ack_delay, conn->remote.transport_params->max_ack_delay);
+      ack_delay = ngtcp2_min(ack_delay, conn_remote_max_ack_delay(conn));
     } else if (ack_delay > 0 && rtt >= cstat->min_rtt &&
                rtt < cstat->min_rtt + ack_delay) {
       /* Ignore RTT sample if adjusting ack_delay causes the sample
@@ -13440,8 +14267,7 @@ static ngtcp2_tstamp conn_get_earliest_pto_expiry(const ngtcp2_conn *conn,
 
     if (i == NGTCP2_PKTNS_ID_APPLICATION) {
       assert(conn->remote.transport_params);
-      t += conn->remote.transport_params->max_ack_delay *
-           (1ULL << cstat->pto_count);
+      t += conn_remote_max_ack_delay(conn) * (1ULL << cstat->pto_count);
     }
 
     if (t < earliest_ts) {
@@ -13688,6 +14514,48 @@ int ngtcp2_conn_submit_new_token(ngtcp2_conn *conn, const uint8_t *token,
   return 0;
 }
 
+int ngtcp2_conn_submit_ack_frequency(ngtcp2_conn *conn,
+                                     uint64_t ack_eliciting_thresh,
+                                     ngtcp2_duration max_ack_delay,
+                                     uint64_t reordering_thresh) {
+  int rv;
+  ngtcp2_frame_chain *nfrc;
+
+  if (!conn_is_tls_handshake_completed(conn) ||
+      !conn->remote.transport_params ||
+      !conn->remote.transport_params->min_ack_delay) {
+    return NGTCP2_ERR_INVALID_STATE;
+  }
+
+  if (max_ack_delay < conn->remote.transport_params->min_ack_delay ||
+      max_ack_delay >= (1 << 14) * NGTCP2_MILLISECONDS ||
+      ack_eliciting_thresh > NGTCP2_MAX_VARINT ||
+      reordering_thresh > NGTCP2_MAX_VARINT) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  rv = ngtcp2_frame_chain_objalloc_new(&nfrc, &conn->frc_objalloc);
+  if (rv != 0) {
+    return rv;
+  }
+
+  ++conn->tx.ack_freq.seq;
+  conn->tx.ack_freq.max_ack_delay = max_ack_delay;
+
+  nfrc->fr.ack_frequency = (ngtcp2_ack_frequency){
+    .type = NGTCP2_FRAME_ACK_FREQUENCY,
+    .seq = (uint64_t)conn->tx.ack_freq.seq,
+    .ack_eliciting_thresh = ack_eliciting_thresh,
+    .max_ack_delay = max_ack_delay / NGTCP2_MICROSECONDS,
+    .reordering_thresh = reordering_thresh,
+  };
+
+  nfrc->next = conn->pktns.tx.frq;
+  conn->pktns.tx.frq = nfrc;
+
+  return 0;
+}
+
 ngtcp2_strm *ngtcp2_conn_tx_strmq_top(ngtcp2_conn *conn) {
   assert(!ngtcp2_pq_empty(&conn->tx.strmq));
   return ngtcp2_struct_of(ngtcp2_pq_top(&conn->tx.strmq), ngtcp2_strm, pe);
@@ -13709,7 +14577,7 @@ int ngtcp2_conn_tx_strmq_push_if_not(ngtcp2_conn *conn, ngtcp2_strm *strm) {
     return 0;
   }
 
-  strm->cycle = ngtcp2_conn_tx_strmq_first_cycle(conn);
+  strm->cycle = conn->tx.strmq_cycle[strm->urgency];
 
   return ngtcp2_conn_tx_strmq_push(conn, strm);
 }
@@ -13918,7 +14786,7 @@ static int conn_initiate_migration_precheck(ngtcp2_conn *conn,
   return 0;
 }
 
-int ngtcp2_conn_initiate_immediate_migration(ngtcp2_conn *conn,
+static int conn_initiate_immediate_migration(ngtcp2_conn *conn,
                                              const ngtcp2_path *path,
                                              ngtcp2_tstamp ts) {
   int rv;
@@ -13993,7 +14861,19 @@ int ngtcp2_conn_initiate_immediate_migration(ngtcp2_conn *conn,
   return conn_call_begin_path_validation(conn, conn->pv);
 }
 
-int ngtcp2_conn_initiate_migration(ngtcp2_conn *conn, const ngtcp2_path *path,
+int ngtcp2_conn_initiate_immediate_migration(ngtcp2_conn *conn,
+                                             const ngtcp2_path *path,
+                                             ngtcp2_tstamp ts) {
+  int rv;
+
+  rv = conn_initiate_immediate_migration(conn, path, ts);
+
+  conn_update_expiry(conn);
+
+  return rv;
+}
+
+static int conn_initiate_migration(ngtcp2_conn *conn, const ngtcp2_path *path,
                                    ngtcp2_tstamp ts) {
   int rv;
   ngtcp2_dcid dcid;
@@ -14002,7 +14882,7 @@ int ngtcp2_conn_initiate_migration(ngtcp2_conn *conn, const ngtcp2_path *path,
   assert(!conn->server);
 
   if (ngtcp2_conn_find_path_history(conn, path, ts)) {
-    return ngtcp2_conn_initiate_immediate_migration(conn, path, ts);
+    return conn_initiate_immediate_migration(conn, path, ts);
   }
 
   conn_update_timestamp(conn, ts);
@@ -14038,6 +14918,17 @@ int ngtcp2_conn_initiate_migration(ngtcp2_conn *conn, const ngtcp2_path *path,
   return conn_call_begin_path_validation(conn, conn->pv);
 }
 
+int ngtcp2_conn_initiate_migration(ngtcp2_conn *conn, const ngtcp2_path *path,
+                                   ngtcp2_tstamp ts) {
+  int rv;
+
+  rv = conn_initiate_migration(conn, path, ts);
+
+  conn_update_expiry(conn);
+
+  return rv;
+}
+
 uint64_t ngtcp2_conn_get_max_data_left(ngtcp2_conn *conn) {
   return ngtcp2_conn_get_max_data_left2(conn);
 }
@@ -14262,6 +15153,51 @@ int ngtcp2_conn_after_retry2(const ngtcp2_conn *conn) {
   return (conn->flags & NGTCP2_CONN_FLAG_RECV_RETRY) != 0;
 }
 
+int ngtcp2_conn_set_stream_priority(ngtcp2_conn *conn, int64_t stream_id,
+                                    uint32_t urgency, int incremental,
+                                    uint32_t weight) {
+  ngtcp2_strm *strm;
+
+  if (urgency >= NGTCP2_STREAM_URGENCY_LEVELS ||
+      weight > NGTCP2_MAX_STREAM_WEIGHT) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  strm = ngtcp2_conn_find_stream(conn, stream_id);
+  if (strm == NULL) {
+    return NGTCP2_ERR_STREAM_NOT_FOUND;
+  }
+
+  if (weight == 0) {
+    weight = NGTCP2_DEFAULT_STREAM_WEIGHT;
+  }
+
+  if (incremental) {
+    strm->flags &= ~NGTCP2_STRM_FLAG_NON_INCREMENTAL;
+  } else {
+    strm->flags |= NGTCP2_STRM_FLAG_NON_INCREMENTAL;
+  }
+
+  strm->weight = (uint16_t)weight;
+
+  if (strm->urgency == urgency) {
+    return 0;
+  }
+
+  if (!ngtcp2_strm_is_tx_queued(strm)) {
+    strm->urgency = (uint8_t)urgency;
+
+    return 0;
+  }
+
+  ngtcp2_pq_remove(&conn->tx.strmq, &strm->pe);
+  strm->pe.index = NGTCP2_PQ_BAD_INDEX;
+
+  strm->urgency = (uint8_t)urgency;
+
+  return ngtcp2_conn_tx_strmq_push_if_not(conn, strm);
+}
+
 int ngtcp2_conn_set_stream_user_data(ngtcp2_conn *conn, int64_t stream_id,
                                      void *stream_user_data) {
   ngtcp2_strm *strm = ngtcp2_conn_find_stream(conn, stream_id);
@@ -14290,11 +15226,14 @@ void *ngtcp2_conn_get_stream_user_data2(const ngtcp2_conn *conn,
   return strm->stream_user_data;
 }
 
-void ngtcp2_conn_update_pkt_tx_time(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+/*
+ * conn_update_pkt_tx_time schedules the next packet transmission
+ * after the packets written since the last call, which depart at
+ * |txtime|.
+ */
+static void conn_update_pkt_tx_time(ngtcp2_conn *conn, ngtcp2_tstamp txtime) {
   ngtcp2_duration wait, d;
 
-  conn_update_timestamp(conn, ts);
-
   if (conn->tx.pacing.pktlen == 0) {
     return;
   }
@@ -14307,10 +15246,18 @@ void ngtcp2_conn_update_pkt_tx_time(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   wait -= d;
   conn->tx.pacing.compensation -= d;
 
-  conn->tx.pacing.next_ts = ts + wait;
+  conn->tx.pacing.next_ts = txtime + wait;
   conn->tx.pacing.pktlen = 0;
 }
 
+void ngtcp2_conn_update_pkt_tx_time(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+  conn_update_timestamp(conn, ts);
+
+  conn_update_pkt_tx_time(conn, ts);
+
+  conn_update_expiry(conn);
+}
+
 size_t ngtcp2_conn_get_send_quantum(ngtcp2_conn *conn) {
   return ngtcp2_conn_get_send_quantum2(conn);
 }
@@ -14377,6 +15324,7 @@ ngtcp2_ssize ngtcp2_conn_write_aggregate_pkt2_versioned(
   int first_pkt;
   ngtcp2_pkt_info pi_discard;
   ngtcp2_path_storage path_discard;
+  int rv;
   (void)pkt_info_version;
 
   assert(buflen >= path_max_udp_payloadlen);
@@ -14385,6 +15333,10 @@ ngtcp2_ssize ngtcp2_conn_write_aggregate_pkt2_versioned(
     num_pkts = SIZE_MAX;
   }
 
+  if (conn->callbacks.hp_mask_batch) {
+    conn->flags |= NGTCP2_CONN_FLAG_DEFER_HP;
+  }
+
   for (;;) {
     ecn_state = conn->tx.ecn.state;
 
@@ -14444,7 +15396,64 @@ ngtcp2_ssize ngtcp2_conn_write_aggregate_pkt2_versioned(
     }
   }
 
-  conn->flags &= ~NGTCP2_CONN_FLAG_AGGREGATE_PKTS;
+  conn->flags &= ~(NGTCP2_CONN_FLAG_AGGREGATE_PKTS | NGTCP2_CONN_FLAG_DEFER_HP);
+
+  conn_update_expiry(conn);
+
+  if (nwrite < 0) {
+    conn->tx.hp_batch.len = 0;
+
+    return nwrite;
+  }
+
+  rv = conn_flush_hp_batch(conn);
+  if (rv != 0) {
+    return rv;
+  }
+
+  return nwrite;
+}
+
+ngtcp2_ssize ngtcp2_conn_write_aggregate_pkt_txtime_versioned(
+  ngtcp2_conn *conn, ngtcp2_path *path, int pkt_info_version,
+  ngtcp2_pkt_info *pi, uint8_t *buf, size_t buflen, size_t *pgsolen,
+  ngtcp2_tstamp *ptxtime, ngtcp2_write_pkt write_pkt, size_t num_pkts,
+  ngtcp2_duration horizon, ngtcp2_tstamp ts) {
+  ngtcp2_ssize nwrite;
+  ngtcp2_tstamp txtime;
+
+  if (conn->tx.pacing.next_ts == UINT64_MAX) {
+    txtime = ts;
+  } else {
+    txtime = ngtcp2_max(conn->tx.pacing.next_ts, ts);
+  }
+
+  conn->tx.pacing.horizon = horizon;
+
+  nwrite = ngtcp2_conn_write_aggregate_pkt2_versioned(
+    conn, path, pkt_info_version, pi, buf, buflen, pgsolen, write_pkt, num_pkts,
+    ts);
+
+  conn->tx.pacing.horizon = 0;
+
+  if (nwrite < 0) {
+    return nwrite;
+  }
+
+  *ptxtime = txtime;
+
+  conn_update_timestamp(conn, ts);
+
+  if (horizon) {
+    /* The kernel sends the packets at txtime.  Shortening the gap to
+       the next burst to make up for a late wakeup would send two
+       bursts closer than the pacing interval. */
+    conn->tx.pacing.compensation = 0;
+  }
+
+  conn_update_pkt_tx_time(conn, txtime);
+
+  conn_update_expiry(conn);
 
   return nwrite;
 }
@@ -14513,6 +15522,7 @@ ngtcp2_ssize ngtcp2_pkt_write_connection_close(
   cc.ckm = &ckm;
   cc.hp_ctx = *hp_ctx;
   cc.encrypt = encrypt;
+  cc.encryptv = NULL;
   cc.hp_mask = hp_mask;
 
   ngtcp2_ppe_init(&ppe, dest, destlen, 0, &cc);
@@ -54,6 +54,7 @@
 #include "ngtcp2_dcidtr.h"
 #include "ngtcp2_pcg.h"
 #include "ngtcp2_ratelim.h"
+#include "ngtcp2_timerq.h"
 
 typedef enum {
   /* Client specific handshake states */
@@ -84,6 +85,11 @@ typedef enum {
    to put the sane limit.*/
 #define NGTCP2_MAX_SCID_POOL_SIZE 8
 
+/* NGTCP2_MAX_SCID_REGEN is the maximum number of times a server asks
+   for a new connection ID because the generated one is already
+   registered to ngtcp2_settings.cid_table by another connection. */
+#define NGTCP2_MAX_SCID_REGEN 8
+
 /* NGTCP2_ECN_MAX_NUM_VALIDATION_PKTS is the maximum number of ECN marked
    packets sent in NGTCP2_ECN_STATE_TESTING period. */
 #define NGTCP2_ECN_MAX_NUM_VALIDATION_PKTS 10
@@ -93,6 +99,21 @@ typedef enum {
    value, it is truncated. */
 #define NGTCP2_CCERR_MAX_REASONLEN 1024
 
+/* NGTCP2_MAX_RXBUF_BYTES is the maximum total length of the receive
+   buffers passed to ngtcp2_conn_read_pkt_rx_buf which the streams of
+   a connection reference.  Beyond this limit, out-of-order stream
+   data is copied. */
+#define NGTCP2_MAX_RXBUF_BYTES (1024 * 1024)
+
+/* NGTCP2_MAX_RXBUF_REF is the maximum number of references to the
+   receive buffers that the streams of a connection hold. */
+#define NGTCP2_MAX_RXBUF_REF 512
+
+/* NGTCP2_HP_MASK_BATCH_MAX is the maximum number of header
+   protection masks that ngtcp2_conn_read_pkts computes in a single
+   ngtcp2_hp_mask_batch call. */
+#define NGTCP2_HP_MASK_BATCH_MAX 32
+
 /* NGTCP2_WRITE_PKT_FLAG_NONE indicates that no flag is set. */
 #define NGTCP2_WRITE_PKT_FLAG_NONE 0x00U
 /* NGTCP2_WRITE_PKT_FLAG_REQUIRE_PADDING indicates that packet other
@@ -193,6 +214,15 @@ void ngtcp2_path_challenge_entry_init(ngtcp2_path_challenge_entry *pcent,
    Initial CRYPTO frame into pieces as a countermeasure against Deep
    Packet Inspection. */
 #define NGTCP2_CONN_FLAG_CRUMBLE_INITIAL_CRYPTO 0x40000U
+/* NGTCP2_CONN_FLAG_DEFER_HP is set when
+   ngtcp2_conn_write_aggregate_pkt defers header protection of 1RTT
+   packets so that their masks are computed by a single
+   ngtcp2_hp_mask_batch call. */
+#define NGTCP2_CONN_FLAG_DEFER_HP 0x80000U
+/* NGTCP2_CONN_FLAG_EXPIRY_STALE is set when the inputs of the
+   connection expiry might have changed since ngtcp2_conn.expiry.ts
+   was computed. */
+#define NGTCP2_CONN_FLAG_EXPIRY_STALE 0x100000U
 
 typedef struct ngtcp2_pktns {
   struct {
@@ -288,6 +318,13 @@ typedef struct ngtcp2_pktns {
   ngtcp2_pktns_id id;
 } ngtcp2_pktns;
 
+/* NGTCP2_HS_ARENA_BLKLEN is the size of memory block that the
+   handshake arena allocates at once.  It is large enough to hold
+   Initial and Handshake packet number spaces and their keying
+   materials in a single block. */
+#define NGTCP2_HS_ARENA_BLKLEN                                                 \
+  ((((sizeof(ngtcp2_pktns) + 0xFU) & ~(size_t)0xFU) * 2) + 512)
+
 typedef enum ngtcp2_ecn_state {
   NGTCP2_ECN_STATE_TESTING,
   NGTCP2_ECN_STATE_UNKNOWN,
@@ -324,8 +361,32 @@ struct ngtcp2_conn {
   ngtcp2_objalloc frc_objalloc;
   ngtcp2_objalloc rtb_entry_objalloc;
   ngtcp2_objalloc strm_objalloc;
+  /* hs_arena is the block allocator from which handshake-lifetime
+     objects are allocated if ngtcp2_settings.handshake_arena is
+     nonzero. */
+  ngtcp2_balloc hs_arena;
+  /* hs_arena_mem is the allocator which allocates memory from
+     hs_arena. */
+  ngtcp2_mem hs_arena_mem;
+  /* hs_mem is the allocator for handshake-lifetime objects, that is
+     Initial and Handshake packet number spaces, and the keying
+     materials for Initial, Handshake, 0-RTT, and Version
+     Negotiation.  It points to either hs_arena_mem or mem. */
+  const ngtcp2_mem *hs_mem;
   ngtcp2_conn_state state;
   ngtcp2_callbacks callbacks;
+  /* timerq_ent is the entry in ngtcp2_settings.timerq. */
+  ngtcp2_timerq_entry timerq_ent;
+  struct {
+    /* ts is the cached connection expiry.  It is updated by
+       ngtcp2_conn_poll_expiry, or on return of the public functions
+       if ngtcp2_settings.timerq is set.  It is valid only if
+       NGTCP2_CONN_FLAG_EXPIRY_STALE is not set. */
+    ngtcp2_tstamp ts;
+    /* last_polled_ts is the expiry returned by the last
+       ngtcp2_conn_poll_expiry call. */
+    ngtcp2_tstamp last_polled_ts;
+  } expiry;
   /* rcid is a connection ID present in Initial or 0-RTT packet from
      client as destination connection ID.  Server uses this field to
      check that duplicated Initial or 0-RTT packet are indeed sent to
@@ -378,6 +439,9 @@ struct ngtcp2_conn {
   struct {
     /* strmq contains ngtcp2_strm which has frames to send. */
     ngtcp2_pq strmq;
+    /* strmq_cycle is the cycle of the stream in strmq which is most
+       recently served, for each urgency level. */
+    uint64_t strmq_cycle[NGTCP2_STREAM_URGENCY_LEVELS];
     /* offset is the offset the local endpoint has sent to the remote
        endpoint. */
     uint64_t offset;
@@ -437,7 +501,36 @@ struct ngtcp2_conn {
          for example, TLS handshake, and packet encryption/decryption,
          etc. */
       ngtcp2_duration compensation;
+      /* horizon is the amount of time that packets are allowed to be
+         written ahead of next_ts.  It is nonzero only inside
+         ngtcp2_conn_write_aggregate_pkt_txtime, where the kernel
+         paces the packets according to their departure time. */
+      ngtcp2_duration horizon;
     } pacing;
+
+    struct {
+      /* seq is the sequence number of the last ACK_FREQUENCY frame
+         sent.  It is -1 if no ACK_FREQUENCY frame has been sent. */
+      int64_t seq;
+      /* max_ack_delay is Requested Max Ack Delay in the last
+         ACK_FREQUENCY frame sent. */
+      ngtcp2_duration max_ack_delay;
+    } ack_freq;
+
+    /* hp_batch contains 1RTT packets whose header protection is
+       deferred while NGTCP2_CONN_FLAG_DEFER_HP is set. */
+    struct {
+      struct {
+        /* pkt points to the beginning of the packet. */
+        uint8_t *pkt;
+        /* pkt_num_offset is the offset to packet number field. */
+        size_t pkt_num_offset;
+        /* pkt_numlen is the length of packet number field. */
+        size_t pkt_numlen;
+      } ents[NGTCP2_HP_MASK_BATCH_MAX];
+      /* len is the number of entries in ents. */
+      size_t len;
+    } hp_batch;
   } tx;
 
   struct {
@@ -453,6 +546,9 @@ struct ngtcp2_conn {
     uint64_t max_offset;
     /* window is the connection-level flow control window size. */
     uint64_t window;
+    /* budget_used is the number of bytes of window which are charged
+       to ngtcp2_settings.rx_budget. */
+    uint64_t budget_used;
     /* path_challenge stores received PATH_CHALLENGE data. */
     ngtcp2_static_ringbuf_path_challenge path_challenge;
     /* ccerr is the received connection close error. */
@@ -487,6 +583,37 @@ struct ngtcp2_conn {
          that server verified preferred address usage of client. */
       int64_t pkt_num;
     } preferred_addr;
+
+    struct {
+      /* seq is the largest sequence number of ACK_FREQUENCY frame
+         received.  It is -1 if no ACK_FREQUENCY frame has been
+         received. */
+      int64_t seq;
+      /* thresh is the number of ack-eliciting packets which triggers
+         an immediate acknowledgement.  It is initialized to
+         ngtcp2_settings.ack_thresh. */
+      size_t thresh;
+      /* max_ack_delay is the maximum ACK delay requested by the
+         remote endpoint.  It is only used if seq != -1. */
+      ngtcp2_duration max_ack_delay;
+      /* reordering_thresh is the number of out-of-order packets which
+         triggers an immediate acknowledgement.  0 disables immediate
+         acknowledgement on reordering. */
+      uint64_t reordering_thresh;
+    } ack_freq;
+
+    struct {
+      /* buf is the receive buffer passed to
+         ngtcp2_conn_read_pkt_rx_buf.  It is not NULL only while the
+         function is running. */
+      ngtcp2_rxbuf *buf;
+      /* pkt points to the packet in the receive buffer. */
+      uint8_t *pkt;
+      /* pktlen is the length of pkt. */
+      size_t pktlen;
+      /* lim limits the receive buffers referenced by all streams. */
+      ngtcp2_rxbuf_lim lim;
+    } rxbuf;
   } rx;
 
   struct {
@@ -554,6 +681,23 @@ struct ngtcp2_conn {
     ngtcp2_vec decrypt_hp_buf;
     /* decrypt_buf is a buffer which is used to write decrypted data. */
     ngtcp2_vec decrypt_buf;
+    /* hp_mask_batch holds the header protection masks that
+       ngtcp2_conn_read_pkts computes in advance.  pktv is NULL
+       outside of that function. */
+    struct {
+      /* pktv points to the datagrams in the current batch. */
+      const ngtcp2_vec *pktv;
+      /* samples[i] points to the sample of the short header packet at
+         the beginning of pktv[i], or NULL if no mask is computed for
+         it. */
+      const uint8_t **samples;
+      /* masks contains the mask for samples[i] at masks + i *
+         NGTCP2_HP_SAMPLELEN. */
+      const uint8_t *masks;
+      /* idx is the index of the datagram which is being
+         processed. */
+      size_t idx;
+    } hp_mask_batch;
     /* retry_aead is AEAD to verify Retry packet integrity.  It is
        used by client only. */
     ngtcp2_crypto_aead retry_aead;
@@ -890,8 +1034,6 @@ ngtcp2_tstamp ngtcp2_conn_lost_pkt_expiry(const ngtcp2_conn *conn);
  */
 void ngtcp2_conn_remove_lost_pkt(ngtcp2_conn *conn, ngtcp2_tstamp ts);
 
-uint64_t ngtcp2_conn_tx_strmq_first_cycle(const ngtcp2_conn *conn);
-
 /**
  * @function
  *
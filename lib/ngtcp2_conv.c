@@ -97,6 +97,19 @@ const uint8_t *ngtcp2_get_uvarint(uint64_t *dest, const uint8_t *p) {
   }
 }
 
+const uint8_t *ngtcp2_get_uvarintv(uint64_t *dest, size_t n,
+                                   const uint8_t *p, const uint8_t *end) {
+  for (; n; --n) {
+    if (p == end || (size_t)(end - p) < ngtcp2_get_uvarintlen(p)) {
+      return NULL;
+    }
+
+    p = ngtcp2_get_uvarint(dest++, p);
+  }
+
+  return p;
+}
+
 int64_t ngtcp2_get_pkt_num(const uint8_t *p, size_t pkt_numlen) {
   uint32_t l;
   uint16_t s;
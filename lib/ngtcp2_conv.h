@@ -73,6 +73,17 @@ const uint8_t *ngtcp2_get_uint16(uint16_t *dest, const uint8_t *p);
  */
 const uint8_t *ngtcp2_get_uvarint(uint64_t *dest, const uint8_t *p);
 
+/*
+ * ngtcp2_get_uvarintv reads |n| consecutive variable-length unsigned
+ * integers from the buffer pointed by |p| of length |end| - |p|, and
+ * stores them in |dest| in host byte order.  |dest| must have room
+ * for at least |n| integers.  It returns |p| plus the number of bytes
+ * read from |p|, or NULL if the buffer is too short.  The contents of
+ * |dest| are unspecified if it returns NULL.
+ */
+const uint8_t *ngtcp2_get_uvarintv(uint64_t *dest, size_t n,
+                                   const uint8_t *p, const uint8_t *end);
+
 /*
  * ngtcp2_get_varint reads variable-length unsigned integer from |p|,
  * and casts it to the signed integer, and stores it in the buffer
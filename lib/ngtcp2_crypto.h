@@ -92,6 +92,9 @@ typedef struct ngtcp2_crypto_cc {
   ngtcp2_crypto_km *ckm;
   ngtcp2_crypto_cipher_ctx hp_ctx;
   ngtcp2_encrypt encrypt;
+  /* encryptv, if not NULL, is used to encrypt a packet that contains
+     STREAM data which is not copied into the packet buffer. */
+  ngtcp2_encryptv encryptv;
   ngtcp2_decrypt decrypt;
   ngtcp2_hp_mask hp_mask;
 } ngtcp2_crypto_cc;
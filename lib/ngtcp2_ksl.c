@@ -830,14 +830,14 @@ size_t ngtcp2_ksl_range_exclusive_search(const ngtcp2_ksl *ksl,
   return ksl_range_exclusive_search(ksl, blk, key);
 }
 
-ngtcp2_ksl_search_def(uint64_less, ngtcp2_ksl_uint64_less)
+ngtcp2_ksl_bsearch_def(uint64_less, ngtcp2_ksl_uint64_less)
 
 size_t ngtcp2_ksl_uint64_less_search(const ngtcp2_ksl *ksl, ngtcp2_ksl_blk *blk,
                                      const ngtcp2_ksl_key *key) {
   return ksl_uint64_less_search(ksl, blk, key);
 }
 
-ngtcp2_ksl_search_def(int64_greater, ngtcp2_ksl_int64_greater)
+ngtcp2_ksl_bsearch_def(int64_greater, ngtcp2_ksl_int64_greater)
 
 size_t ngtcp2_ksl_int64_greater_search(const ngtcp2_ksl *ksl,
                                        ngtcp2_ksl_blk *blk,
@@ -36,7 +36,11 @@
 #include "ngtcp2_objalloc.h"
 #include "ngtcp2_range.h"
 
-#define NGTCP2_KSL_DEGR 16
+/* NGTCP2_KSL_DEGR is the degree of ngtcp2_ksl.  It can be overridden
+   at build time to tune the block size. */
+#ifndef NGTCP2_KSL_DEGR
+#  define NGTCP2_KSL_DEGR 16
+#endif /* !defined(NGTCP2_KSL_DEGR) */
 /* NGTCP2_KSL_MAX_NBLK is the maximum number of nodes which a single
    block can contain. */
 #define NGTCP2_KSL_MAX_NBLK (2 * NGTCP2_KSL_DEGR)
@@ -132,6 +136,36 @@ typedef size_t (*ngtcp2_ksl_search)(const ngtcp2_ksl *ksl, ngtcp2_ksl_blk *blk,
     return i;                                                                  \
   }
 
+/*
+ * ngtcp2_ksl_bsearch_def is a macro to implement ngtcp2_ksl_search
+ * with COMPAR which is supposed to be ngtcp2_ksl_compar.  Unlike
+ * ngtcp2_ksl_search_def, it does branchless binary search.  It is
+ * suitable for the keys which are cheap to compare, and for which
+ * the cost of the linear scan is dominated by the number of
+ * comparisons.
+ */
+#define ngtcp2_ksl_bsearch_def(NAME, COMPAR)                                   \
+  static size_t ksl_##NAME##_search(                                           \
+    const ngtcp2_ksl *ksl, ngtcp2_ksl_blk *blk, const ngtcp2_ksl_key *key) {   \
+    size_t n = blk->n, half;                                                   \
+    size_t aligned_keylen = ksl->aligned_keylen;                               \
+    uint8_t *base = blk->keys;                                                 \
+                                                                               \
+    if (n == 0) {                                                              \
+      return 0;                                                                \
+    }                                                                          \
+                                                                               \
+    for (; n > 1; n -= half) {                                                 \
+      half = n / 2;                                                            \
+      base += COMPAR(base + half * aligned_keylen, key)                        \
+                ? half * aligned_keylen                                        \
+                : 0;                                                           \
+    }                                                                          \
+                                                                               \
+    return (size_t)(base - blk->keys) / aligned_keylen +                       \
+           (COMPAR(base, key) != 0);                                           \
+  }
+
 typedef struct ngtcp2_ksl_it ngtcp2_ksl_it;
 
 /*
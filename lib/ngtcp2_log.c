@@ -384,6 +384,24 @@ static void log_fr_datagram(ngtcp2_log *log, const ngtcp2_pkt_hd *hd,
                        ") len=", ngtcp2_vec_len(fr->data, fr->datacnt));
 }
 
+static void log_fr_ack_frequency(ngtcp2_log *log, const ngtcp2_pkt_hd *hd,
+                                 const ngtcp2_ack_frequency *fr,
+                                 const char *dir) {
+  ngtcp2_log_infof_raw(
+    log, NGTCP2_LOG_EVENT_FRM, NGTCP2_LOG_PKT(dir, hd), " ACK_FREQUENCY(0x",
+    hex(fr->type), ") seq=", fr->seq,
+    " ack_eliciting_thresh=", fr->ack_eliciting_thresh,
+    " max_ack_delay=", fr->max_ack_delay, "(us) reordering_thresh=",
+    fr->reordering_thresh);
+}
+
+static void log_fr_immediate_ack(ngtcp2_log *log, const ngtcp2_pkt_hd *hd,
+                                 const ngtcp2_immediate_ack *fr,
+                                 const char *dir) {
+  ngtcp2_log_infof_raw(log, NGTCP2_LOG_EVENT_FRM, NGTCP2_LOG_PKT(dir, hd),
+                       " IMMEDIATE_ACK(0x", hex(fr->type), ")");
+}
+
 static void log_fr(ngtcp2_log *log, const ngtcp2_pkt_hd *hd,
                    const ngtcp2_frame *fr, const char *dir) {
   switch (fr->hd.type) {
@@ -455,6 +473,12 @@ static void log_fr(ngtcp2_log *log, const ngtcp2_pkt_hd *hd,
   case NGTCP2_FRAME_DATAGRAM_LEN:
     log_fr_datagram(log, hd, &fr->datagram, dir);
     break;
+  case NGTCP2_FRAME_ACK_FREQUENCY:
+    log_fr_ack_frequency(log, hd, &fr->ack_frequency, dir);
+    break;
+  case NGTCP2_FRAME_IMMEDIATE_ACK:
+    log_fr_immediate_ack(log, hd, &fr->immediate_ack, dir);
+    break;
   default:
     ngtcp2_unreachable();
   }
@@ -623,6 +647,12 @@ void ngtcp2_log_remote_tp(ngtcp2_log *log,
     log, NGTCP2_LOG_EVENT_CRY,
     NGTCP2_LOG_TP " grease_quic_bit=", params->grease_quic_bit);
 
+  if (params->min_ack_delay) {
+    ngtcp2_log_infof_raw(log, NGTCP2_LOG_EVENT_CRY,
+                         NGTCP2_LOG_TP " min_ack_delay=",
+                         params->min_ack_delay / NGTCP2_MICROSECONDS, "(us)");
+  }
+
   if (params->version_info_present) {
     ngtcp2_log_infof_raw(log, NGTCP2_LOG_EVENT_CRY,
                          NGTCP2_LOG_TP " version_information.chosen_version=0x",
@@ -0,0 +1,148 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_objpool.h"
+
+#include "ngtcp2_mem.h"
+
+int ngtcp2_objpool_new(ngtcp2_objpool **ppool, size_t max_cached_bytes,
+                       const ngtcp2_mem *mem) {
+  ngtcp2_objpool *pool;
+
+  if (mem == NULL) {
+    mem = ngtcp2_mem_default();
+  }
+
+  pool = ngtcp2_mem_calloc(mem, 1, sizeof(*pool));
+  if (pool == NULL) {
+    return NGTCP2_ERR_NOMEM;
+  }
+
+  pool->mem = mem;
+  pool->max_cached_bytes = max_cached_bytes;
+
+  *ppool = pool;
+
+  return 0;
+}
+
+void ngtcp2_objpool_del(ngtcp2_objpool *pool) {
+  ngtcp2_objpool_bucket *bucket;
+  ngtcp2_objpool_block *blk, *next;
+  size_t i;
+
+  if (pool == NULL) {
+    return;
+  }
+
+  for (i = 0; i < NGTCP2_OBJPOOL_MAX_BUCKETS; ++i) {
+    bucket = &pool->buckets[i];
+
+    for (blk = bucket->head; blk; blk = next) {
+      next = blk->next;
+      ngtcp2_mem_free(pool->mem, blk);
+    }
+  }
+
+  ngtcp2_mem_free(pool->mem, pool);
+}
+
+void ngtcp2_objpool_get_stat_versioned(const ngtcp2_objpool *pool,
+                                       int objpool_stat_version,
+                                       ngtcp2_objpool_stat *stat) {
+  (void)objpool_stat_version;
+
+  *stat = pool->stat;
+}
+
+/*
+ * objpool_find_bucket returns the bucket for memory blocks of
+ * |blklen| bytes.  If |create| is nonzero and there is no such
+ * bucket, an unused bucket is assigned to |blklen|.  It returns NULL
+ * if no bucket is found.
+ */
+static ngtcp2_objpool_bucket *objpool_find_bucket(ngtcp2_objpool *pool,
+                                                  size_t blklen, int create) {
+  ngtcp2_objpool_bucket *bucket;
+  size_t i;
+
+  for (i = 0; i < NGTCP2_OBJPOOL_MAX_BUCKETS; ++i) {
+    bucket = &pool->buckets[i];
+
+    if (bucket->blklen == blklen) {
+      return bucket;
+    }
+
+    if (bucket->blklen == 0) {
+      if (!create) {
+        return NULL;
+      }
+
+      bucket->blklen = blklen;
+
+      return bucket;
+    }
+  }
+
+  return NULL;
+}
+
+void *ngtcp2_objpool_get_block(ngtcp2_objpool *pool, size_t blklen) {
+  ngtcp2_objpool_bucket *bucket = objpool_find_bucket(pool, blklen, 0);
+  ngtcp2_objpool_block *blk;
+
+  if (bucket && bucket->head) {
+    blk = bucket->head;
+    bucket->head = blk->next;
+
+    ++pool->stat.nhit;
+    --pool->stat.ncached;
+    pool->stat.cached_bytes -= blklen;
+
+    return blk;
+  }
+
+  ++pool->stat.nmiss;
+
+  return ngtcp2_mem_malloc(pool->mem, blklen);
+}
+
+void ngtcp2_objpool_put_block(ngtcp2_objpool *pool, void *blk, size_t blklen) {
+  ngtcp2_objpool_bucket *bucket;
+  ngtcp2_objpool_block *b = blk;
+
+  if (pool->stat.cached_bytes + blklen > pool->max_cached_bytes ||
+      (bucket = objpool_find_bucket(pool, blklen, 1)) == NULL) {
+    ++pool->stat.ndiscard;
+    ngtcp2_mem_free(pool->mem, blk);
+
+    return;
+  }
+
+  b->next = bucket->head;
+  bucket->head = b;
+
+  ++pool->stat.ncached;
+  pool->stat.cached_bytes += blklen;
+}
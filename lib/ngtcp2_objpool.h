@@ -0,0 +1,85 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef NGTCP2_OBJPOOL_H
+#define NGTCP2_OBJPOOL_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* defined(HAVE_CONFIG_H) */
+
+#include <ngtcp2/ngtcp2.h>
+
+typedef struct ngtcp2_objpool_block ngtcp2_objpool_block;
+
+/*
+ * ngtcp2_objpool_block is the header of the cached memory block.  It
+ * overlays the first bytes of the block while it is in the pool.
+ */
+struct ngtcp2_objpool_block {
+  ngtcp2_objpool_block *next;
+};
+
+/*
+ * ngtcp2_objpool_bucket is the list of cached memory blocks of the
+ * same size.
+ */
+typedef struct ngtcp2_objpool_bucket {
+  /* blklen is the size of memory blocks in this bucket.  0 means that
+     the bucket is unused. */
+  size_t blklen;
+  /* head points to the list of cached memory blocks. */
+  ngtcp2_objpool_block *head;
+} ngtcp2_objpool_bucket;
+
+/* NGTCP2_OBJPOOL_MAX_BUCKETS is the maximum number of distinct memory
+   block sizes that ngtcp2_objpool caches.  The library only uses a
+   handful of fixed block sizes. */
+#define NGTCP2_OBJPOOL_MAX_BUCKETS 8
+
+struct ngtcp2_objpool {
+  /* mem is the underlying memory allocator. */
+  const ngtcp2_mem *mem;
+  /* max_cached_bytes is the maximum number of bytes that the pool
+     caches. */
+  size_t max_cached_bytes;
+  ngtcp2_objpool_bucket buckets[NGTCP2_OBJPOOL_MAX_BUCKETS];
+  ngtcp2_objpool_stat stat;
+};
+
+/*
+ * ngtcp2_objpool_get_block returns a memory block of |blklen| bytes.
+ * It returns a cached block if available, or allocates a new one.
+ * It returns NULL if it fails to allocate memory.
+ */
+void *ngtcp2_objpool_get_block(ngtcp2_objpool *pool, size_t blklen);
+
+/*
+ * ngtcp2_objpool_put_block returns |blk| of |blklen| bytes obtained
+ * by ngtcp2_objpool_get_block to |pool|.  If |pool| is full, |blk| is
+ * freed.
+ */
+void ngtcp2_objpool_put_block(ngtcp2_objpool *pool, void *blk, size_t blklen);
+
+#endif /* !defined(NGTCP2_OBJPOOL_H) */
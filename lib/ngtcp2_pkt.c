@@ -483,6 +483,40 @@ ngtcp2_ssize ngtcp2_pkt_encode_hd_short(uint8_t *out, size_t outlen,
   return (ngtcp2_ssize)len;
 }
 
+/*
+ * frame_decoder_decode_ext decodes a frame whose type is encoded in
+ * more than 1 byte.
+ */
+static ngtcp2_ssize frame_decoder_decode_ext(ngtcp2_frame_decoder *frd,
+                                             ngtcp2_frame *dest,
+                                             const uint8_t *payload,
+                                             size_t payloadlen) {
+  uint64_t type;
+  size_t n;
+
+  (void)frd;
+
+  n = ngtcp2_get_uvarintlen(payload);
+  if (payloadlen < n) {
+    return NGTCP2_ERR_FRAME_ENCODING;
+  }
+
+  ngtcp2_get_uvarint(&type, payload);
+
+  /* Frame type must be encoded in the shortest form. */
+  if (n != ngtcp2_put_uvarintlen(type)) {
+    return NGTCP2_ERR_FRAME_ENCODING;
+  }
+
+  switch (type) {
+  case NGTCP2_FRAME_ACK_FREQUENCY:
+    return ngtcp2_pkt_decode_ack_frequency_frame(&dest->ack_frequency, payload,
+                                                 payloadlen);
+  default:
+    return NGTCP2_ERR_FRAME_ENCODING;
+  }
+}
+
 ngtcp2_ssize ngtcp2_frame_decoder_decode(ngtcp2_frame_decoder *frd,
                                          ngtcp2_frame *dest,
                                          const uint8_t *payload,
@@ -555,6 +589,9 @@ ngtcp2_ssize ngtcp2_frame_decoder_decode(ngtcp2_frame_decoder *frd,
   case NGTCP2_FRAME_HANDSHAKE_DONE:
     return ngtcp2_pkt_decode_handshake_done_frame(&dest->handshake_done,
                                                   payload, payloadlen);
+  case NGTCP2_FRAME_IMMEDIATE_ACK:
+    return ngtcp2_pkt_decode_immediate_ack_frame(&dest->immediate_ack, payload,
+                                                 payloadlen);
   case NGTCP2_FRAME_DATAGRAM:
   case NGTCP2_FRAME_DATAGRAM_LEN:
     dest->datagram.data = &frd->buf.data;
@@ -566,12 +603,7 @@ ngtcp2_ssize ngtcp2_frame_decoder_decode(ngtcp2_frame_decoder *frd,
       return ngtcp2_pkt_decode_stream_frame(&dest->stream, payload, payloadlen);
     }
 
-    /* For frame types > 0xFF, use ngtcp2_get_uvarintlen and
-       ngtcp2_get_uvarint to get a frame type, and then switch over
-       it.  Verify that payloadlen >= ngtcp2_get_uvarintlen(payload)
-       before calling ngtcp2_get_uvarint(payload). */
-
-    return NGTCP2_ERR_FRAME_ENCODING;
+    return frame_decoder_decode_ext(frd, dest, payload, payloadlen);
   }
 }
 
@@ -1505,6 +1537,56 @@ ngtcp2_ssize ngtcp2_pkt_decode_datagram_frame(ngtcp2_datagram *dest,
   return (ngtcp2_ssize)len;
 }
 
+ngtcp2_ssize ngtcp2_pkt_decode_ack_frequency_frame(ngtcp2_ack_frequency *dest,
+                                                   const uint8_t *payload,
+                                                   size_t payloadlen) {
+  size_t len = 2 + 1 + 1 + 1 + 1;
+  const uint8_t *p;
+  size_t n;
+  size_t i;
+
+  if (payloadlen < len) {
+    return NGTCP2_ERR_FRAME_ENCODING;
+  }
+
+  p = payload + 2;
+
+  for (i = 0; i < 4; ++i) {
+    n = ngtcp2_get_uvarintlen(p);
+    len += n - 1;
+
+    if (payloadlen < len) {
+      return NGTCP2_ERR_FRAME_ENCODING;
+    }
+
+    p += n;
+  }
+
+  p = payload + 2;
+
+  dest->type = NGTCP2_FRAME_ACK_FREQUENCY;
+  p = ngtcp2_get_uvarint(&dest->seq, p);
+  p = ngtcp2_get_uvarint(&dest->ack_eliciting_thresh, p);
+  p = ngtcp2_get_uvarint(&dest->max_ack_delay, p);
+  p = ngtcp2_get_uvarint(&dest->reordering_thresh, p);
+
+  assert((size_t)(p - payload) == len);
+
+  return (ngtcp2_ssize)len;
+}
+
+ngtcp2_ssize ngtcp2_pkt_decode_immediate_ack_frame(ngtcp2_immediate_ack *dest,
+                                                   const uint8_t *payload,
+                                                   size_t payloadlen) {
+  (void)payload;
+  (void)payloadlen;
+
+  assert(payloadlen > 0);
+
+  dest->type = NGTCP2_FRAME_IMMEDIATE_ACK;
+  return 1;
+}
+
 ngtcp2_ssize ngtcp2_pkt_encode_frame(uint8_t *out, size_t outlen,
                                      ngtcp2_frame *fr) {
   switch (fr->hd.type) {
@@ -1564,13 +1646,19 @@ ngtcp2_ssize ngtcp2_pkt_encode_frame(uint8_t *out, size_t outlen,
   case NGTCP2_FRAME_DATAGRAM:
   case NGTCP2_FRAME_DATAGRAM_LEN:
     return ngtcp2_pkt_encode_datagram_frame(out, outlen, &fr->datagram);
+  case NGTCP2_FRAME_ACK_FREQUENCY:
+    return ngtcp2_pkt_encode_ack_frequency_frame(out, outlen,
+                                                 &fr->ack_frequency);
+  case NGTCP2_FRAME_IMMEDIATE_ACK:
+    return ngtcp2_pkt_encode_immediate_ack_frame(out, outlen,
+                                                 &fr->immediate_ack);
   default:
     return NGTCP2_ERR_INVALID_ARGUMENT;
   }
 }
 
-ngtcp2_ssize ngtcp2_pkt_encode_stream_frame(uint8_t *out, size_t outlen,
-                                            ngtcp2_stream *fr) {
+ngtcp2_ssize ngtcp2_pkt_encode_stream_frame_hd(uint8_t *out, size_t outlen,
+                                               ngtcp2_stream *fr) {
   size_t len = 1;
   uint8_t flags = NGTCP2_STREAM_LEN_BIT;
   uint8_t *p;
@@ -1593,9 +1681,8 @@ ngtcp2_ssize ngtcp2_pkt_encode_stream_frame(uint8_t *out, size_t outlen,
   }
 
   len += ngtcp2_put_uvarintlen(datalen);
-  len += datalen;
 
-  if (outlen < len) {
+  if (outlen < len + datalen) {
     return NGTCP2_ERR_NOBUF;
   }
 
@@ -1613,15 +1700,31 @@ ngtcp2_ssize ngtcp2_pkt_encode_stream_frame(uint8_t *out, size_t outlen,
 
   p = ngtcp2_put_uvarint(p, datalen);
 
+  assert((size_t)(p - out) == len);
+
+  return (ngtcp2_ssize)len;
+}
+
+ngtcp2_ssize ngtcp2_pkt_encode_stream_frame(uint8_t *out, size_t outlen,
+                                            ngtcp2_stream *fr) {
+  ngtcp2_ssize nwrite;
+  uint8_t *p;
+  size_t i;
+
+  nwrite = ngtcp2_pkt_encode_stream_frame_hd(out, outlen, fr);
+  if (nwrite < 0) {
+    return nwrite;
+  }
+
+  p = out + nwrite;
+
   for (i = 0; i < fr->datacnt; ++i) {
     assert(fr->data[i].len);
     assert(fr->data[i].base);
     p = ngtcp2_cpymem(p, fr->data[i].base, fr->data[i].len);
   }
 
-  assert((size_t)(p - out) == len);
-
-  return (ngtcp2_ssize)len;
+  return p - out;
 }
 
 ngtcp2_ssize ngtcp2_pkt_encode_ack_frame(uint8_t *out, size_t outlen,
@@ -2098,6 +2201,47 @@ ngtcp2_ssize ngtcp2_pkt_encode_datagram_frame(uint8_t *out, size_t outlen,
   return (ngtcp2_ssize)len;
 }
 
+ngtcp2_ssize
+ngtcp2_pkt_encode_ack_frequency_frame(uint8_t *out, size_t outlen,
+                                      const ngtcp2_ack_frequency *fr) {
+  size_t len = ngtcp2_put_uvarintlen(NGTCP2_FRAME_ACK_FREQUENCY) +
+               ngtcp2_put_uvarintlen(fr->seq) +
+               ngtcp2_put_uvarintlen(fr->ack_eliciting_thresh) +
+               ngtcp2_put_uvarintlen(fr->max_ack_delay) +
+               ngtcp2_put_uvarintlen(fr->reordering_thresh);
+  uint8_t *p;
+
+  if (outlen < len) {
+    return NGTCP2_ERR_NOBUF;
+  }
+
+  p = out;
+
+  p = ngtcp2_put_uvarint(p, NGTCP2_FRAME_ACK_FREQUENCY);
+  p = ngtcp2_put_uvarint(p, fr->seq);
+  p = ngtcp2_put_uvarint(p, fr->ack_eliciting_thresh);
+  p = ngtcp2_put_uvarint(p, fr->max_ack_delay);
+  p = ngtcp2_put_uvarint(p, fr->reordering_thresh);
+
+  assert((size_t)(p - out) == len);
+
+  return (ngtcp2_ssize)len;
+}
+
+ngtcp2_ssize
+ngtcp2_pkt_encode_immediate_ack_frame(uint8_t *out, size_t outlen,
+                                      const ngtcp2_immediate_ack *fr) {
+  (void)fr;
+
+  if (outlen < 1) {
+    return NGTCP2_ERR_NOBUF;
+  }
+
+  *out++ = NGTCP2_FRAME_IMMEDIATE_ACK;
+
+  return 1;
+}
+
 ngtcp2_ssize ngtcp2_pkt_write_version_negotiation(
   uint8_t *dest, size_t destlen, uint8_t unused_random, const uint8_t *dcid,
   size_t dcidlen, const uint8_t *scid, size_t scidlen, const uint32_t *sv,
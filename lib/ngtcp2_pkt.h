@@ -180,6 +180,11 @@ typedef struct ngtcp2_pkt_retry {
 #define NGTCP2_FRAME_DATAGRAM 0x30U
 #define NGTCP2_FRAME_DATAGRAM_LEN 0x31U
 
+/* Frame types defined by QUIC Acknowledgment Frequency
+   (draft-ietf-quic-ack-frequency). */
+#define NGTCP2_FRAME_IMMEDIATE_ACK 0x1FU
+#define NGTCP2_FRAME_ACK_FREQUENCY 0xAFU
+
 typedef struct ngtcp2_frame_hd {
   uint64_t type;
 } ngtcp2_frame_hd;
@@ -334,6 +339,19 @@ typedef struct ngtcp2_handshake_done {
   uint64_t type;
 } ngtcp2_handshake_done;
 
+typedef struct ngtcp2_ack_frequency {
+  uint64_t type;
+  uint64_t seq;
+  uint64_t ack_eliciting_thresh;
+  /* max_ack_delay is Requested Max Ack Delay in microseconds. */
+  uint64_t max_ack_delay;
+  uint64_t reordering_thresh;
+} ngtcp2_ack_frequency;
+
+typedef struct ngtcp2_immediate_ack {
+  uint64_t type;
+} ngtcp2_immediate_ack;
+
 typedef struct ngtcp2_datagram {
   uint64_t type;
   /* dgram_id is an opaque identifier chosen by an application. */
@@ -367,6 +385,8 @@ typedef union ngtcp2_frame {
   ngtcp2_retire_connection_id retire_connection_id;
   ngtcp2_handshake_done handshake_done;
   ngtcp2_datagram datagram;
+  ngtcp2_ack_frequency ack_frequency;
+  ngtcp2_immediate_ack immediate_ack;
 } ngtcp2_frame;
 
 typedef struct ngtcp2_pkt_chain ngtcp2_pkt_chain;
@@ -845,6 +865,53 @@ ngtcp2_ssize ngtcp2_pkt_decode_datagram_frame(ngtcp2_datagram *dest,
                                               const uint8_t *payload,
                                               size_t payloadlen);
 
+/*
+ * ngtcp2_pkt_decode_ack_frequency_frame decodes ACK_FREQUENCY frame
+ * from |payload| of length |payloadlen|.  The result is stored in the
+ * object pointed by |dest|.  ACK_FREQUENCY frame must start at
+ * payload[0], and its type must be encoded in 2 bytes.  This function
+ * finishes when it decodes one ACK_FREQUENCY frame, and returns the
+ * exact number of bytes read to decode a frame if it succeeds, or one
+ * of the following negative error codes:
+ *
+ * NGTCP2_ERR_FRAME_ENCODING
+ *     Payload is too short to include ACK_FREQUENCY frame.
+ */
+ngtcp2_ssize ngtcp2_pkt_decode_ack_frequency_frame(ngtcp2_ack_frequency *dest,
+                                                   const uint8_t *payload,
+                                                   size_t payloadlen);
+
+/*
+ * ngtcp2_pkt_decode_immediate_ack_frame decodes IMMEDIATE_ACK frame
+ * from |payload| of length |payloadlen|.  The result is stored in the
+ * object pointed by |dest|.  IMMEDIATE_ACK frame must start at
+ * payload[0].  This function finishes when it decodes one
+ * IMMEDIATE_ACK frame, and returns the exact number of bytes read to
+ * decode a frame.
+ */
+ngtcp2_ssize ngtcp2_pkt_decode_immediate_ack_frame(ngtcp2_immediate_ack *dest,
+                                                   const uint8_t *payload,
+                                                   size_t payloadlen);
+
+/*
+ * ngtcp2_pkt_encode_stream_frame_hd encodes STREAM frame |fr| into
+ * the buffer pointed by |out| of length |outlen| except for its
+ * data.  The buffer must have enough capacity to write the whole
+ * frame including data.
+ *
+ * This function assigns <the serialized frame type> &
+ * ~NGTCP2_FRAME_STREAM to fr->flags.
+ *
+ * This function returns the number of bytes written, which does not
+ * include the length of data, if it succeeds, or one of the
+ * following negative error codes:
+ *
+ * NGTCP2_ERR_NOBUF
+ *     Buffer does not have enough capacity to write a frame.
+ */
+ngtcp2_ssize ngtcp2_pkt_encode_stream_frame_hd(uint8_t *out, size_t outlen,
+                                               ngtcp2_stream *fr);
+
 /*
  * ngtcp2_pkt_encode_stream_frame encodes STREAM frame |fr| into the
  * buffer pointed by |out| of length |outlen|.
@@ -1135,6 +1202,34 @@ ngtcp2_pkt_encode_handshake_done_frame(uint8_t *out, size_t outlen,
 ngtcp2_ssize ngtcp2_pkt_encode_datagram_frame(uint8_t *out, size_t outlen,
                                               const ngtcp2_datagram *fr);
 
+/*
+ * ngtcp2_pkt_encode_ack_frequency_frame encodes ACK_FREQUENCY frame
+ * |fr| into the buffer pointed by |out| of length |outlen|.
+ *
+ * This function returns the number of bytes written if it succeeds,
+ * or one of the following negative error codes:
+ *
+ * NGTCP2_ERR_NOBUF
+ *     Buffer does not have enough capacity to write a frame.
+ */
+ngtcp2_ssize
+ngtcp2_pkt_encode_ack_frequency_frame(uint8_t *out, size_t outlen,
+                                      const ngtcp2_ack_frequency *fr);
+
+/*
+ * ngtcp2_pkt_encode_immediate_ack_frame encodes IMMEDIATE_ACK frame
+ * |fr| into the buffer pointed by |out| of length |outlen|.
+ *
+ * This function returns the number of bytes written if it succeeds,
+ * or one of the following negative error codes:
+ *
+ * NGTCP2_ERR_NOBUF
+ *     Buffer does not have enough capacity to write a frame.
+ */
+ngtcp2_ssize
+ngtcp2_pkt_encode_immediate_ack_frame(uint8_t *out, size_t outlen,
+                                      const ngtcp2_immediate_ack *fr);
+
 /*
  * ngtcp2_pkt_adjust_pkt_num finds the full 62 bits packet number for
  * |pkt_num|, which is encoded in |pkt_numlen| bytes.  The
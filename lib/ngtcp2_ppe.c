@@ -30,6 +30,7 @@
 #include "ngtcp2_str.h"
 #include "ngtcp2_conv.h"
 #include "ngtcp2_macro.h"
+#include "ngtcp2_vec.h"
 
 void ngtcp2_ppe_init(ngtcp2_ppe *ppe, uint8_t *out, size_t outlen,
                      size_t dgram_offset, ngtcp2_crypto_cc *cc) {
@@ -41,6 +42,7 @@ void ngtcp2_ppe_init(ngtcp2_ppe *ppe, uint8_t *out, size_t outlen,
   ppe->pkt_num_offset = 0;
   ppe->pkt_numlen = 0;
   ppe->pkt_num = 0;
+  ppe->extcnt = 0;
   ppe->cc = cc;
 }
 
@@ -97,6 +99,43 @@ int ngtcp2_ppe_encode_hd(ngtcp2_ppe *ppe, const ngtcp2_pkt_hd *hd) {
   return 0;
 }
 
+/*
+ * ppe_encode_stream_frame_nocopy encodes STREAM frame |fr| without
+ * copying its data.  The data is recorded in ppe->ext, and encrypted
+ * by cc->encryptv later.
+ */
+static int ppe_encode_stream_frame_nocopy(ngtcp2_ppe *ppe, ngtcp2_stream *fr) {
+  ngtcp2_buf *buf = &ppe->buf;
+  ngtcp2_crypto_cc *cc = ppe->cc;
+  ngtcp2_ppe_ext *ext;
+  ngtcp2_ssize rv;
+  uint8_t *p;
+  size_t i;
+
+  rv = ngtcp2_pkt_encode_stream_frame_hd(
+    buf->last, ngtcp2_buf_left(buf) - cc->aead.max_overhead, fr);
+  if (rv < 0) {
+    return (int)rv;
+  }
+
+  p = buf->last + rv;
+
+  for (i = 0; i < fr->datacnt; ++i) {
+    assert(fr->data[i].len);
+    assert(fr->data[i].base);
+
+    ext = &ppe->ext[ppe->extcnt++];
+    ext->offset = (size_t)(p - buf->begin);
+    ext->data = fr->data[i];
+
+    p += fr->data[i].len;
+  }
+
+  buf->last = p;
+
+  return 0;
+}
+
 int ngtcp2_ppe_encode_frame(ngtcp2_ppe *ppe, ngtcp2_frame *fr) {
   ngtcp2_ssize rv;
   ngtcp2_buf *buf = &ppe->buf;
@@ -107,6 +146,11 @@ int ngtcp2_ppe_encode_frame(ngtcp2_ppe *ppe, ngtcp2_frame *fr) {
     return NGTCP2_ERR_NOBUF;
   }
 
+  if (fr->hd.type == NGTCP2_FRAME_STREAM && cc->encryptv &&
+      ppe->extcnt + fr->stream.datacnt <= NGTCP2_PPE_MAX_EXTCNT) {
+    return ppe_encode_stream_frame_nocopy(ppe, &fr->stream);
+  }
+
   rv = ngtcp2_pkt_encode_frame(buf->last, buf_left - cc->aead.max_overhead, fr);
   if (rv < 0) {
     return (int)rv;
@@ -118,17 +162,73 @@ int ngtcp2_ppe_encode_frame(ngtcp2_ppe *ppe, ngtcp2_frame *fr) {
 }
 
 ngtcp2_ssize ngtcp2_ppe_final(ngtcp2_ppe *ppe, const uint8_t **ppkt) {
+  ngtcp2_buf *buf = &ppe->buf;
+  ngtcp2_crypto_cc *cc = ppe->cc;
+  uint8_t mask[NGTCP2_HP_SAMPLELEN];
+  ngtcp2_ssize nwrite;
+  int rv;
+
+  assert(cc->hp_mask);
+
+  nwrite = ngtcp2_ppe_final_defer_hp(ppe, NULL);
+  if (nwrite < 0) {
+    return nwrite;
+  }
+
+  rv = cc->hp_mask(mask, &cc->hp, &cc->hp_ctx,
+                   buf->begin + ppe_sample_offset(ppe));
+  if (rv != 0) {
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  }
+
+  ngtcp2_ppe_apply_hp_mask(buf->begin, ppe->pkt_num_offset, ppe->pkt_numlen,
+                           mask);
+
+  if (ppkt != NULL) {
+    *ppkt = buf->begin;
+  }
+
+  return nwrite;
+}
+
+/*
+ * ppe_encryptv encrypts |payload| of length |payloadlen| whose stream
+ * data in ppe->ext are not copied yet by cc->encryptv.
+ */
+static int ppe_encryptv(ngtcp2_ppe *ppe, uint8_t *payload,
+                        size_t payloadlen) {
+  ngtcp2_crypto_cc *cc = ppe->cc;
+  ngtcp2_vec v[NGTCP2_PPE_MAX_EXTCNT * 2 + 1];
+  uint8_t *p = payload, *q, *end = payload + payloadlen;
+  size_t i, n = 0;
+
+  for (i = 0; i < ppe->extcnt; ++i) {
+    q = ppe->buf.begin + ppe->ext[i].offset;
+    if (p < q) {
+      ngtcp2_vec_init(&v[n++], p, (size_t)(q - p));
+    }
+
+    v[n++] = ppe->ext[i].data;
+    p = q + ppe->ext[i].data.len;
+  }
+
+  if (p < end) {
+    ngtcp2_vec_init(&v[n++], p, (size_t)(end - p));
+  }
+
+  return cc->encryptv(payload, &cc->aead, &cc->ckm->aead_ctx, v, n,
+                      ppe->nonce, cc->ckm->iv.len, ppe->buf.begin,
+                      ppe->hdlen);
+}
+
+ngtcp2_ssize ngtcp2_ppe_final_defer_hp(ngtcp2_ppe *ppe, const uint8_t **ppkt) {
   ngtcp2_buf *buf = &ppe->buf;
   ngtcp2_crypto_cc *cc = ppe->cc;
   uint8_t *payload = buf->begin + ppe->hdlen;
   size_t payloadlen = ngtcp2_buf_len(buf) - ppe->hdlen;
-  uint8_t mask[NGTCP2_HP_SAMPLELEN];
-  uint8_t *p;
-  size_t i;
   int rv;
 
   assert(cc->encrypt);
-  assert(cc->hp_mask);
 
   if (ppe->len_offset) {
     ngtcp2_put_uvarint30(
@@ -139,8 +239,13 @@ ngtcp2_ssize ngtcp2_ppe_final(ngtcp2_ppe *ppe, const uint8_t **ppkt) {
   ngtcp2_crypto_create_nonce(ppe->nonce, cc->ckm->iv.base, cc->ckm->iv.len,
                              ppe->pkt_num);
 
-  rv = cc->encrypt(payload, &cc->aead, &cc->ckm->aead_ctx, payload, payloadlen,
-                   ppe->nonce, cc->ckm->iv.len, buf->begin, ppe->hdlen);
+  if (ppe->extcnt) {
+    rv = ppe_encryptv(ppe, payload, payloadlen);
+  } else {
+    rv = cc->encrypt(payload, &cc->aead, &cc->ckm->aead_ctx, payload,
+                     payloadlen, ppe->nonce, cc->ckm->iv.len, buf->begin,
+                     ppe->hdlen);
+  }
   if (rv != 0) {
     return NGTCP2_ERR_CALLBACK_FAILURE;
   }
@@ -150,29 +255,29 @@ ngtcp2_ssize ngtcp2_ppe_final(ngtcp2_ppe *ppe, const uint8_t **ppkt) {
   /* Make sure that we have enough space to get sample */
   assert(ppe_sample_offset(ppe) + NGTCP2_HP_SAMPLELEN <= ngtcp2_buf_len(buf));
 
-  rv = cc->hp_mask(mask, &cc->hp, &cc->hp_ctx,
-                   buf->begin + ppe_sample_offset(ppe));
-  if (rv != 0) {
-    return NGTCP2_ERR_CALLBACK_FAILURE;
+  if (ppkt != NULL) {
+    *ppkt = buf->begin;
   }
 
-  p = buf->begin;
+  return (ngtcp2_ssize)ngtcp2_buf_len(buf);
+}
+
+void ngtcp2_ppe_apply_hp_mask(uint8_t *pkt, size_t pkt_num_offset,
+                              size_t pkt_numlen, const uint8_t *mask) {
+  uint8_t *p;
+  size_t i;
+
+  p = pkt;
   if (*p & NGTCP2_HEADER_FORM_BIT) {
     *p = (uint8_t)(*p ^ (mask[0] & 0x0FU));
   } else {
     *p = (uint8_t)(*p ^ (mask[0] & 0x1FU));
   }
 
-  p = buf->begin + ppe->pkt_num_offset;
-  for (i = 0; i < ppe->pkt_numlen; ++i) {
+  p = pkt + pkt_num_offset;
+  for (i = 0; i < pkt_numlen; ++i) {
     *(p + i) ^= mask[i + 1];
   }
-
-  if (ppkt != NULL) {
-    *ppkt = buf->begin;
-  }
-
-  return (ngtcp2_ssize)ngtcp2_buf_len(buf);
 }
 
 size_t ngtcp2_ppe_left(const ngtcp2_ppe *ppe) {
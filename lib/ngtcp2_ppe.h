@@ -35,6 +35,22 @@
 #include "ngtcp2_buf.h"
 #include "ngtcp2_crypto.h"
 
+/* NGTCP2_PPE_MAX_EXTCNT is the maximum number of stream data
+   buffers that ngtcp2_ppe can leave uncopied in a single packet. */
+#define NGTCP2_PPE_MAX_EXTCNT 16
+
+/*
+ * ngtcp2_ppe_ext is the stream data which is not copied into the
+ * packet buffer.
+ */
+typedef struct ngtcp2_ppe_ext {
+  /* offset is the offset in the packet buffer where data should be
+     placed. */
+  size_t offset;
+  /* data is the stream data. */
+  ngtcp2_vec data;
+} ngtcp2_ppe_ext;
+
 /*
  * ngtcp2_ppe is the QUIC Packet Encoder.
  */
@@ -61,6 +77,12 @@ typedef struct ngtcp2_ppe {
   /* nonce is the buffer to store nonce.  It should be equal or longer
      than the length of IV. */
   uint8_t nonce[32];
+  /* extcnt is the number of elements in ext. */
+  size_t extcnt;
+  /* ext contains the stream data which are not copied into buf.  The
+     space for them is reserved in buf, and they are encrypted from
+     their original location by cc->encryptv. */
+  ngtcp2_ppe_ext ext[NGTCP2_PPE_MAX_EXTCNT];
 } ngtcp2_ppe;
 
 /*
@@ -81,7 +103,10 @@ void ngtcp2_ppe_init(ngtcp2_ppe *ppe, uint8_t *out, size_t outlen,
 int ngtcp2_ppe_encode_hd(ngtcp2_ppe *ppe, const ngtcp2_pkt_hd *hd);
 
 /*
- * ngtcp2_ppe_encode_frame encodes |fr|.
+ * ngtcp2_ppe_encode_frame encodes |fr|.  If |fr| is STREAM frame,
+ * and cc->encryptv is not NULL, its data is not copied into the
+ * buffer; only the space is reserved.  The data must be kept intact
+ * until ngtcp2_ppe_final or ngtcp2_ppe_final_defer_hp is called.
  *
  * This function returns 0 if it succeeds, or one of the following
  * negative error codes:
@@ -104,6 +129,29 @@ int ngtcp2_ppe_encode_frame(ngtcp2_ppe *ppe, ngtcp2_frame *fr);
  */
 ngtcp2_ssize ngtcp2_ppe_final(ngtcp2_ppe *ppe, const uint8_t **ppkt);
 
+/*
+ * ngtcp2_ppe_final_defer_hp is like ngtcp2_ppe_final, but it does
+ * not apply header protection.  The caller must take the sample at
+ * ppe->pkt_num_offset + 4, and apply the mask by
+ * ngtcp2_ppe_apply_hp_mask before the packet is sent.
+ *
+ * This function returns the length of QUIC packet, including header,
+ * and payload if it succeeds, or one of the following negative error
+ * codes:
+ *
+ * NGTCP2_ERR_CALLBACK_FAILURE
+ *     User-defined callback function failed.
+ */
+ngtcp2_ssize ngtcp2_ppe_final_defer_hp(ngtcp2_ppe *ppe, const uint8_t **ppkt);
+
+/*
+ * ngtcp2_ppe_apply_hp_mask applies header protection |mask| to the
+ * packet pointed by |pkt|.  |pkt_num_offset| is the offset to packet
+ * number field, and |pkt_numlen| is its length.
+ */
+void ngtcp2_ppe_apply_hp_mask(uint8_t *pkt, size_t pkt_num_offset,
+                              size_t pkt_numlen, const uint8_t *mask);
+
 /*
  * ngtcp2_ppe_left returns the number of bytes left to write
  * additional frames.  This does not count AEAD overhead.
@@ -634,6 +634,46 @@ static uint8_t *write_handshake_done_frame(uint8_t *p,
   return write_verbatim(p, "{\"frame_type\":\"handshake_done\"}");
 }
 
+static uint8_t *write_ack_frequency_frame(uint8_t *p,
+                                          const ngtcp2_ack_frequency *fr) {
+  ngtcp2_duration max_ack_delay;
+
+  /*
+   * {"frame_type":"ack_frequency","sequence_number":0000000000000000000,"ack_eliciting_threshold":0000000000000000000,"request_max_ack_delay":0000000000000000000,"reordering_threshold":0000000000000000000}
+   */
+#define NGTCP2_QLOG_ACK_FREQUENCY_FRAME_OVERHEAD 201
+
+  if (fr->max_ack_delay > UINT64_MAX / NGTCP2_MICROSECONDS) {
+    max_ack_delay = UINT64_MAX;
+  } else {
+    max_ack_delay = fr->max_ack_delay * NGTCP2_MICROSECONDS;
+  }
+
+  p = write_verbatim(p, "{\"frame_type\":\"ack_frequency\",");
+  p = write_pair_number(p, "sequence_number", fr->seq);
+  *p++ = ',';
+  p = write_pair_number(p, "ack_eliciting_threshold", fr->ack_eliciting_thresh);
+  *p++ = ',';
+  p = write_pair_duration(p, "request_max_ack_delay", max_ack_delay);
+  *p++ = ',';
+  p = write_pair_number(p, "reordering_threshold", fr->reordering_thresh);
+  *p++ = '}';
+
+  return p;
+}
+
+static uint8_t *write_immediate_ack_frame(uint8_t *p,
+                                          const ngtcp2_immediate_ack *fr) {
+  (void)fr;
+
+  /*
+   * {"frame_type":"immediate_ack"}
+   */
+#define NGTCP2_QLOG_IMMEDIATE_ACK_FRAME_OVERHEAD 30
+
+  return write_verbatim(p, "{\"frame_type\":\"immediate_ack\"}");
+}
+
 static uint8_t *write_datagram_frame(uint8_t *p, const ngtcp2_datagram *fr) {
   /*
    * {"frame_type":"datagram","length":0000000000000000000}
@@ -872,6 +912,20 @@ void ngtcp2_qlog_write_frame(ngtcp2_qlog *qlog, const ngtcp2_frame *fr) {
     }
     p = write_datagram_frame(p, &fr->datagram);
     break;
+  case NGTCP2_FRAME_ACK_FREQUENCY:
+    if (ngtcp2_buf_left(&qlog->buf) <
+        NGTCP2_QLOG_ACK_FREQUENCY_FRAME_OVERHEAD + 1) {
+      return;
+    }
+    p = write_ack_frequency_frame(p, &fr->ack_frequency);
+    break;
+  case NGTCP2_FRAME_IMMEDIATE_ACK:
+    if (ngtcp2_buf_left(&qlog->buf) <
+        NGTCP2_QLOG_IMMEDIATE_ACK_FRAME_OVERHEAD + 1) {
+      return;
+    }
+    p = write_immediate_ack_frame(p, &fr->immediate_ack);
+    break;
   default:
     ngtcp2_unreachable();
   }
@@ -1013,6 +1067,10 @@ void ngtcp2_qlog_parameters_set_transport_params(
                         params->max_datagram_frame_size);
   *p++ = ',';
   p = write_pair_bool(p, "grease_quic_bit", params->grease_quic_bit);
+  if (params->min_ack_delay) {
+    *p++ = ',';
+    p = write_pair_duration(p, "min_ack_delay", params->min_ack_delay);
+  }
   p = write_verbatim(p, "}}\n");
 
   qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, buf,
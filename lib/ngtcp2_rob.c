@@ -29,17 +29,135 @@
 
 #include "ngtcp2_macro.h"
 
-static int rob_data_new(uint8_t **pd, size_t chunk, const ngtcp2_mem *mem) {
-  *pd = ngtcp2_mem_malloc(mem, chunk);
-  if (*pd == NULL) {
+void ngtcp2_rxbuf_lim_init(ngtcp2_rxbuf_lim *lim, uint64_t max_nbytes,
+                           size_t max_nref) {
+  *lim = (ngtcp2_rxbuf_lim){
+    .max_nbytes = max_nbytes,
+    .max_nref = max_nref,
+  };
+}
+
+static int rxbuf_lim_allowed(const ngtcp2_rxbuf_lim *lim, size_t len) {
+  return lim->nref < lim->max_nref && lim->nbytes + len <= lim->max_nbytes;
+}
+
+static void rxbuf_lim_add(ngtcp2_rxbuf_lim *lim, size_t len) {
+  lim->nbytes += len;
+  ++lim->nref;
+}
+
+static void rxbuf_lim_sub(ngtcp2_rxbuf_lim *lim, size_t len) {
+  assert(lim->nbytes >= len);
+  assert(lim->nref);
+
+  lim->nbytes -= len;
+  --lim->nref;
+}
+
+void ngtcp2_rxbuf_init(ngtcp2_rxbuf *rxbuf, ngtcp2_rxbuf_release release,
+                       void *ctx, void *user_data, size_t len,
+                       ngtcp2_rxbuf_lim *lim) {
+  *rxbuf = (ngtcp2_rxbuf){
+    .ref = 1,
+    .release = release,
+    .ctx = ctx,
+    .user_data = user_data,
+    .len = len,
+    .lim = lim,
+  };
+}
+
+void ngtcp2_rxbuf_incref(ngtcp2_rxbuf *rxbuf) { ++rxbuf->ref; }
+
+void ngtcp2_rxbuf_decref(ngtcp2_rxbuf *rxbuf) {
+  assert(rxbuf->ref);
+
+  if (--rxbuf->ref == 0) {
+    rxbuf->release(rxbuf);
+  }
+}
+
+/*
+ * rob_data_new allocates ngtcp2_rob_data followed by the buffer of
+ * length |len|.
+ */
+static int rob_data_new(ngtcp2_rob_data **pd, size_t len,
+                        const ngtcp2_mem *mem) {
+  ngtcp2_rob_data *d = ngtcp2_mem_malloc(mem, sizeof(*d) + len);
+
+  if (d == NULL) {
+    return NGTCP2_ERR_NOMEM;
+  }
+
+  d->data = (const uint8_t *)(d + 1);
+  d->rxbuf = NULL;
+
+  *pd = d;
+
+  return 0;
+}
+
+/*
+ * rob_rxbuf_ref_allowed returns nonzero if |rob| may reference |len|
+ * bytes of data in |rxbuf|.  The data shorter than the half of
+ * |rxbuf| is copied so that the pinned memory stays proportional to
+ * the buffered data.
+ */
+static int rob_rxbuf_ref_allowed(const ngtcp2_rob *rob,
+                                 const ngtcp2_rxbuf *rxbuf, size_t len) {
+  if ((uint64_t)len * 2 < rxbuf->len) {
+    return 0;
+  }
+
+  if (!rxbuf_lim_allowed(&rob->rxbuf_lim, rxbuf->len)) {
+    return 0;
+  }
+
+  return rxbuf->lim == NULL || rxbuf_lim_allowed(rxbuf->lim, rxbuf->len);
+}
+
+/*
+ * rob_data_ref_new allocates ngtcp2_rob_data which references |data|
+ * in |rxbuf|.
+ */
+static int rob_data_ref_new(ngtcp2_rob *rob, ngtcp2_rob_data **pd,
+                            const uint8_t *data, ngtcp2_rxbuf *rxbuf) {
+  ngtcp2_rob_data *d = ngtcp2_mem_malloc(rob->mem, sizeof(*d));
+
+  if (d == NULL) {
     return NGTCP2_ERR_NOMEM;
   }
 
+  d->data = data;
+  d->rxbuf = rxbuf;
+
+  ngtcp2_rxbuf_incref(rxbuf);
+
+  rxbuf_lim_add(&rob->rxbuf_lim, rxbuf->len);
+
+  if (rxbuf->lim) {
+    rxbuf_lim_add(rxbuf->lim, rxbuf->len);
+  }
+
+  *pd = d;
+
   return 0;
 }
 
-static void rob_data_del(uint8_t *d, const ngtcp2_mem *mem) {
-  ngtcp2_mem_free(mem, d);
+static void rob_data_del(ngtcp2_rob *rob, ngtcp2_rob_data *d) {
+  ngtcp2_rxbuf *rxbuf = d->rxbuf;
+
+  if (rxbuf) {
+    rxbuf_lim_sub(&rob->rxbuf_lim, rxbuf->len);
+
+    if (rxbuf->lim) {
+      rxbuf_lim_sub(rxbuf->lim, rxbuf->len);
+    }
+
+    ngtcp2_rxbuf_decref(rxbuf);
+  }
+
+  ngtcp2_mem_free(rob->mem, d);
 }
 
 int ngtcp2_rob_init(ngtcp2_rob *rob, size_t chunk, const ngtcp2_mem *mem) {
@@ -62,6 +180,8 @@ int ngtcp2_rob_init(ngtcp2_rob *rob, size_t chunk, const ngtcp2_mem *mem) {
 
   rob->chunk = chunk;
   rob->mem = mem;
+  ngtcp2_rxbuf_lim_init(&rob->rxbuf_lim, NGTCP2_ROB_MAX_RXBUF_BYTES,
+                        NGTCP2_ROB_MAX_RXBUF_REF);
   rob->discard_data = 0;
 
   return 0;
@@ -76,7 +196,7 @@ void ngtcp2_rob_free(ngtcp2_rob *rob) {
 
   for (it = ngtcp2_ksl_begin(&rob->dataksl); !ngtcp2_ksl_it_end(&it);
        ngtcp2_ksl_it_next(&it)) {
-    rob_data_del(ngtcp2_ksl_it_get(&it), rob->mem);
+    rob_data_del(rob, ngtcp2_ksl_it_get(&it));
   }
 
   ngtcp2_ksl_free(&rob->dataksl);
@@ -84,17 +204,17 @@ void ngtcp2_rob_free(ngtcp2_rob *rob) {
 }
 
 static int rob_write_data(ngtcp2_rob *rob, uint64_t offset, const uint8_t *data,
-                          size_t len) {
+                          size_t len, ngtcp2_rxbuf *rxbuf) {
   size_t n;
   int rv;
-  uint8_t *d;
+  ngtcp2_rob_data *d;
   ngtcp2_range range = {
     .begin = offset,
     .end = offset + len,
   };
-  ngtcp2_ksl_it it;
+  ngtcp2_ksl_it it, prev;
   const ngtcp2_range *r;
-  uint64_t chunk_offset;
+  const ngtcp2_range *pr;
 
   if (rob->discard_data) {
     return 0;
@@ -111,21 +231,44 @@ static int rob_write_data(ngtcp2_rob *rob, uint64_t offset, const uint8_t *data,
     }
 
     if (d == NULL || offset < r->begin) {
-      rv = rob_data_new(&d, rob->chunk, rob->mem);
+      /* The data up to the next buffer. */
+      range.begin = offset;
+      range.end = offset + len;
+
+      if (d) {
+        range.end = ngtcp2_min(range.end, r->begin);
+      }
+
+      if (rxbuf && rob_rxbuf_ref_allowed(rob, rxbuf,
+                                         (size_t)(range.end - range.begin))) {
+        rv = rob_data_ref_new(rob, &d, data, rxbuf);
+      } else {
+        range.begin = (offset / rob->chunk) * rob->chunk;
+        range.end = range.begin + rob->chunk;
+
+        /* The chunk must not overlap the buffers which reference
+           receive buffers. */
+        if (d) {
+          range.end = ngtcp2_min(range.end, r->begin);
+        }
+
+        if (!ngtcp2_ksl_it_begin(&it)) {
+          prev = it;
+          ngtcp2_ksl_it_prev(&prev);
+          pr = ngtcp2_ksl_it_key(&prev);
+          range.begin = ngtcp2_max(range.begin, pr->end);
+        }
+
+        rv = rob_data_new(&d, (size_t)(range.end - range.begin), rob->mem);
+      }
+
       if (rv != 0) {
         return rv;
       }
 
-      chunk_offset = (offset / rob->chunk) * rob->chunk;
-
-      rv = ngtcp2_ksl_insert(&rob->dataksl, &it,
-                             &(ngtcp2_range){
-                               .begin = chunk_offset,
-                               .end = chunk_offset + rob->chunk,
-                             },
-                             d);
+      rv = ngtcp2_ksl_insert(&rob->dataksl, &it, &range, d);
       if (rv != 0) {
-        rob_data_del(d, rob->mem);
+        rob_data_del(rob, d);
         return rv;
       }
 
@@ -133,7 +276,11 @@ static int rob_write_data(ngtcp2_rob *rob, uint64_t offset, const uint8_t *data,
     }
 
     n = (size_t)ngtcp2_min((uint64_t)len, r->end - offset);
-    memcpy(d + (offset - r->begin), data, n);
+
+    if (d->rxbuf == NULL) {
+      memcpy((uint8_t *)(d + 1) + (offset - r->begin), data, n);
+    }
+
     offset += n;
     data += n;
     len -= n;
@@ -142,8 +289,9 @@ static int rob_write_data(ngtcp2_rob *rob, uint64_t offset, const uint8_t *data,
   return 0;
 }
 
-ngtcp2_ssize ngtcp2_rob_push(ngtcp2_rob *rob, uint64_t offset,
-                             const uint8_t *data, size_t datalen) {
+static ngtcp2_ssize rob_push(ngtcp2_rob *rob, uint64_t offset,
+                             const uint8_t *data, size_t datalen,
+                             ngtcp2_rxbuf *rxbuf) {
   int rv;
   ngtcp2_range g;
   ngtcp2_range m, l, r;
@@ -170,7 +318,8 @@ ngtcp2_ssize ngtcp2_rob_push(ngtcp2_rob *rob, uint64_t offset,
     if (ngtcp2_range_eq(&g, &m)) {
       ngtcp2_ksl_remove_hint(&rob->gapksl, &it, &it, &g);
 
-      rv = rob_write_data(rob, m.begin, data + (m.begin - offset), mlen);
+      rv = rob_write_data(rob, m.begin, data + (m.begin - offset), mlen,
+                          rxbuf);
       if (rv != 0) {
         return rv;
       }
@@ -195,7 +344,8 @@ ngtcp2_ssize ngtcp2_rob_push(ngtcp2_rob *rob, uint64_t offset,
       ngtcp2_ksl_update_key(&rob->gapksl, &g, &r);
     }
 
-    rv = rob_write_data(rob, m.begin, data + (m.begin - offset), mlen);
+    rv = rob_write_data(rob, m.begin, data + (m.begin - offset), mlen,
+                          rxbuf);
     if (rv != 0) {
       return rv;
     }
@@ -208,10 +358,21 @@ ngtcp2_ssize ngtcp2_rob_push(ngtcp2_rob *rob, uint64_t offset,
   return nwrite;
 }
 
+ngtcp2_ssize ngtcp2_rob_push(ngtcp2_rob *rob, uint64_t offset,
+                             const uint8_t *data, size_t datalen) {
+  return rob_push(rob, offset, data, datalen, NULL);
+}
+
+ngtcp2_ssize ngtcp2_rob_push_rxbuf(ngtcp2_rob *rob, uint64_t offset,
+                                   const uint8_t *data, size_t datalen,
+                                   ngtcp2_rxbuf *rxbuf) {
+  return rob_push(rob, offset, data, datalen, rxbuf);
+}
+
 void ngtcp2_rob_remove_prefix(ngtcp2_rob *rob, uint64_t offset) {
   ngtcp2_range g;
   ngtcp2_range r;
-  uint8_t *d;
+  ngtcp2_rob_data *d;
   ngtcp2_ksl_it it;
 
   it = ngtcp2_ksl_begin(&rob->gapksl);
@@ -250,7 +411,7 @@ void ngtcp2_rob_remove_prefix(ngtcp2_rob *rob, uint64_t offset) {
     d = ngtcp2_ksl_it_get(&it);
 
     ngtcp2_ksl_remove_hint(&rob->dataksl, &it, &it, &r);
-    rob_data_del(d, rob->mem);
+    rob_data_del(rob, d);
   }
 }
 
@@ -258,7 +419,7 @@ uint64_t ngtcp2_rob_data_at(const ngtcp2_rob *rob, const uint8_t **pdest,
                             uint64_t offset) {
   const ngtcp2_range *g;
   const ngtcp2_range *r;
-  uint8_t *d;
+  const ngtcp2_rob_data *d;
   ngtcp2_ksl_it it;
 
   it = ngtcp2_ksl_begin(&rob->gapksl);
@@ -286,7 +447,7 @@ uint64_t ngtcp2_rob_data_at(const ngtcp2_rob *rob, const uint8_t **pdest,
   assert(r->begin <= offset);
   assert(offset < r->end);
 
-  *pdest = d + (offset - r->begin);
+  *pdest = d->data + (offset - r->begin);
 
   return ngtcp2_min(g->begin, r->end) - offset;
 }
@@ -294,7 +455,7 @@ uint64_t ngtcp2_rob_data_at(const ngtcp2_rob *rob, const uint8_t **pdest,
 void ngtcp2_rob_pop(ngtcp2_rob *rob, uint64_t offset, uint64_t len) {
   ngtcp2_ksl_it it;
   ngtcp2_range r;
-  uint8_t *d;
+  ngtcp2_rob_data *d;
 
   if (rob->discard_data) {
     return;
@@ -311,7 +472,7 @@ void ngtcp2_rob_pop(ngtcp2_rob *rob, uint64_t offset, uint64_t len) {
   }
 
   ngtcp2_ksl_remove_hint(&rob->dataksl, NULL, &it, &r);
-  rob_data_del(d, rob->mem);
+  rob_data_del(rob, d);
 }
 
 uint64_t ngtcp2_rob_first_gap_offset(const ngtcp2_rob *rob) {
@@ -338,7 +499,7 @@ void ngtcp2_rob_discard_data(ngtcp2_rob *rob) {
 
   for (it = ngtcp2_ksl_begin(&rob->dataksl); !ngtcp2_ksl_it_end(&it);
        ngtcp2_ksl_it_next(&it)) {
-    rob_data_del(ngtcp2_ksl_it_get(&it), rob->mem);
+    rob_data_del(rob, ngtcp2_ksl_it_get(&it));
   }
 
   ngtcp2_ksl_clear(&rob->dataksl);
@@ -35,6 +35,97 @@
 #include "ngtcp2_range.h"
 #include "ngtcp2_ksl.h"
 
+/* NGTCP2_ROB_MAX_RXBUF_BYTES is the maximum total length of the
+   receive buffers which a single ngtcp2_rob references. */
+#define NGTCP2_ROB_MAX_RXBUF_BYTES (256 * 1024)
+
+/* NGTCP2_ROB_MAX_RXBUF_REF is the maximum number of ngtcp2_rob_data
+   which reference receive buffers in a single ngtcp2_rob. */
+#define NGTCP2_ROB_MAX_RXBUF_REF 128
+
+/*
+ * ngtcp2_rxbuf_lim limits the receive buffers which ngtcp2_rob
+ * references.  A receive buffer is counted once for each
+ * ngtcp2_rob_data which references it.
+ */
+typedef struct ngtcp2_rxbuf_lim {
+  /* nbytes is the total length of the referenced receive buffers. */
+  uint64_t nbytes;
+  /* max_nbytes is the maximum value of nbytes. */
+  uint64_t max_nbytes;
+  /* nref is the number of references. */
+  size_t nref;
+  /* max_nref is the maximum value of nref. */
+  size_t max_nref;
+} ngtcp2_rxbuf_lim;
+
+/*
+ * ngtcp2_rxbuf_lim_init initializes |lim| with the given limits.
+ */
+void ngtcp2_rxbuf_lim_init(ngtcp2_rxbuf_lim *lim, uint64_t max_nbytes,
+                           size_t max_nref);
+
+typedef struct ngtcp2_rxbuf ngtcp2_rxbuf;
+
+/*
+ * ngtcp2_rxbuf_release is called when the last reference to |rxbuf|
+ * is dropped.
+ */
+typedef void (*ngtcp2_rxbuf_release)(ngtcp2_rxbuf *rxbuf);
+
+/*
+ * ngtcp2_rxbuf is a reference counted handle to a receive buffer
+ * owned by an application.  ngtcp2_rob holds a reference to it
+ * instead of copying data which points into the buffer.
+ */
+struct ngtcp2_rxbuf {
+  /* ref is the reference count. */
+  size_t ref;
+  /* release is called when ref drops to 0. */
+  ngtcp2_rxbuf_release release;
+  /* ctx is an opaque pointer for release. */
+  void *ctx;
+  /* user_data is the application's handle to the buffer. */
+  void *user_data;
+  /* len is the length of the buffer which a reference pins. */
+  size_t len;
+  /* lim, if not NULL, limits the references to the receive buffers
+     which share it, in addition to the limit of each ngtcp2_rob. */
+  ngtcp2_rxbuf_lim *lim;
+};
+
+/*
+ * ngtcp2_rxbuf_init initializes |rxbuf| with the reference count of
+ * 1.  |len| is the length of the buffer.  |lim| is optional.
+ */
+void ngtcp2_rxbuf_init(ngtcp2_rxbuf *rxbuf, ngtcp2_rxbuf_release release,
+                       void *ctx, void *user_data, size_t len,
+                       ngtcp2_rxbuf_lim *lim);
+
+/*
+ * ngtcp2_rxbuf_incref increments the reference count of |rxbuf|.
+ */
+void ngtcp2_rxbuf_incref(ngtcp2_rxbuf *rxbuf);
+
+/*
+ * ngtcp2_rxbuf_decref decrements the reference count of |rxbuf|.  If
+ * it drops to 0, rxbuf->release is called.
+ */
+void ngtcp2_rxbuf_decref(ngtcp2_rxbuf *rxbuf);
+
+/*
+ * ngtcp2_rob_data is a buffer which stores a contiguous range of
+ * received data.
+ */
+typedef struct ngtcp2_rob_data {
+  /* data points to the data at the beginning of the range. */
+  const uint8_t *data;
+  /* rxbuf, if not NULL, is the receive buffer which data points
+     into.  Otherwise, data points to the buffer allocated right after
+     this object. */
+  ngtcp2_rxbuf *rxbuf;
+} ngtcp2_rob_data;
+
 /*
  * ngtcp2_rob is the reorder buffer which reassembles stream data
  * received in out of order.
@@ -43,13 +134,16 @@ typedef struct ngtcp2_rob {
   /* gapksl maintains the range of offset which is not received
      yet. Initially, its range is [0, UINT64_MAX). */
   ngtcp2_ksl gapksl;
-  /* dataksl maintains the buffers which store received out-of-order
-     data ordered by stream offset. */
+  /* dataksl maintains the buffers (ngtcp2_rob_data) which store
+     received out-of-order data ordered by stream offset. */
   ngtcp2_ksl dataksl;
   /* mem is custom memory allocator */
   const ngtcp2_mem *mem;
   /* chunk is the size of each buffer in data field */
   size_t chunk;
+  /* rxbuf_lim limits the receive buffers referenced by this
+     object. */
+  ngtcp2_rxbuf_lim rxbuf_lim;
   /* discard_data, if nonzero, stops buffering data.  If it is
      nonzero, ngtcp2_ksl_empty(&dataksl) always returns nonzero. */
   int discard_data;
@@ -89,6 +183,19 @@ void ngtcp2_rob_free(ngtcp2_rob *rob);
 ngtcp2_ssize ngtcp2_rob_push(ngtcp2_rob *rob, uint64_t offset,
                              const uint8_t *data, size_t datalen);
 
+/*
+ * ngtcp2_rob_push_rxbuf works like ngtcp2_rob_push, but |data| points
+ * into the receive buffer |rxbuf|.  Instead of copying data, |rob|
+ * references it and holds a reference to |rxbuf| until the data is
+ * removed.  Data is still copied if it falls into the buffer already
+ * allocated by ngtcp2_rob_push, if it is less than half of rxbuf->len,
+ * or if referencing |rxbuf| would exceed rob->rxbuf_lim or
+ * rxbuf->lim.
+ */
+ngtcp2_ssize ngtcp2_rob_push_rxbuf(ngtcp2_rob *rob, uint64_t offset,
+                                   const uint8_t *data, size_t datalen,
+                                   ngtcp2_rxbuf *rxbuf);
+
 /*
  * ngtcp2_rob_remove_prefix removes gap up to |offset|, exclusive.  It
  * also removes buffered data if it is completely included in
@@ -356,7 +356,15 @@ static ngtcp2_ssize rtb_reclaim_frame(ngtcp2_rtb *rtb, uint8_t flags,
       continue;
     case NGTCP2_FRAME_DATAGRAM:
     case NGTCP2_FRAME_DATAGRAM_LEN:
+    case NGTCP2_FRAME_IMMEDIATE_ACK:
       continue;
+    case NGTCP2_FRAME_ACK_FREQUENCY:
+      /* Only the most recent request is retransmitted. */
+      if ((int64_t)fr->ack_frequency.seq != conn->tx.ack_freq.seq) {
+        continue;
+      }
+
+      break;
     case NGTCP2_FRAME_RESET_STREAM:
       strm = ngtcp2_conn_find_stream(conn, fr->reset_stream.stream_id);
       if (strm == NULL || !ngtcp2_strm_require_retransmit_reset_stream(strm)) {
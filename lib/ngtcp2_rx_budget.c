@@ -0,0 +1,94 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_rx_budget.h"
+
+#include <assert.h>
+
+#include "ngtcp2_mem.h"
+
+int ngtcp2_rx_budget_new(ngtcp2_rx_budget **pbudget, uint64_t limit,
+                         const ngtcp2_mem *mem) {
+  ngtcp2_rx_budget *budget;
+
+  if (mem == NULL) {
+    mem = ngtcp2_mem_default();
+  }
+
+  budget = ngtcp2_mem_malloc(mem, sizeof(*budget));
+  if (budget == NULL) {
+    return NGTCP2_ERR_NOMEM;
+  }
+
+  *budget = (ngtcp2_rx_budget){
+    .mem = mem,
+    .limit = limit,
+  };
+
+  *pbudget = budget;
+
+  return 0;
+}
+
+void ngtcp2_rx_budget_del(ngtcp2_rx_budget *budget) {
+  if (budget == NULL) {
+    return;
+  }
+
+  ngtcp2_mem_free(budget->mem, budget);
+}
+
+void ngtcp2_rx_budget_set_limit(ngtcp2_rx_budget *budget, uint64_t limit) {
+  budget->limit = limit;
+}
+
+uint64_t ngtcp2_rx_budget_get_used(const ngtcp2_rx_budget *budget) {
+  return budget->used;
+}
+
+uint64_t ngtcp2_rx_budget_acquire(ngtcp2_rx_budget *budget, uint64_t n) {
+  if (budget->used >= budget->limit) {
+    return 0;
+  }
+
+  if (n > budget->limit - budget->used) {
+    n = budget->limit - budget->used;
+  }
+
+  budget->used += n;
+
+  return n;
+}
+
+void ngtcp2_rx_budget_release(ngtcp2_rx_budget *budget, uint64_t n) {
+  assert(budget->used >= n);
+
+  budget->used -= n;
+}
+
+int ngtcp2_rx_budget_under_pressure(const ngtcp2_rx_budget *budget) {
+  return budget->used >= budget->limit ||
+         budget->limit - budget->used <
+           budget->limit / NGTCP2_RX_BUDGET_PRESSURE_DIVISOR;
+}
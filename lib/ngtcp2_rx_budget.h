@@ -0,0 +1,71 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef NGTCP2_RX_BUDGET_H
+#define NGTCP2_RX_BUDGET_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* defined(HAVE_CONFIG_H) */
+
+#include <ngtcp2/ngtcp2.h>
+
+struct ngtcp2_rx_budget {
+  /* mem is the memory allocator that allocated this object. */
+  const ngtcp2_mem *mem;
+  /* limit is the maximum number of bytes that the connections
+     sharing this object can add to their flow control windows in
+     total. */
+  uint64_t limit;
+  /* used is the number of bytes currently charged to this object. */
+  uint64_t used;
+};
+
+/*
+ * ngtcp2_rx_budget_acquire charges at most |n| bytes to |budget|, and
+ * returns the number of bytes actually charged.  The returned value
+ * is less than |n| if |budget| does not have enough room.  The
+ * charged bytes must be returned by ngtcp2_rx_budget_release.
+ */
+uint64_t ngtcp2_rx_budget_acquire(ngtcp2_rx_budget *budget, uint64_t n);
+
+/*
+ * ngtcp2_rx_budget_release returns |n| bytes which have been charged
+ * by ngtcp2_rx_budget_acquire to |budget|.
+ */
+void ngtcp2_rx_budget_release(ngtcp2_rx_budget *budget, uint64_t n);
+
+/*
+ * ngtcp2_rx_budget_under_pressure returns nonzero if the room left in
+ * |budget| falls below NGTCP2_RX_BUDGET_PRESSURE_DIVISOR-th of its
+ * limit.  The connections should shrink their flow control windows
+ * while this function returns nonzero.
+ */
+int ngtcp2_rx_budget_under_pressure(const ngtcp2_rx_budget *budget);
+
+/* NGTCP2_RX_BUDGET_PRESSURE_DIVISOR defines the threshold of
+   ngtcp2_rx_budget_under_pressure. */
+#define NGTCP2_RX_BUDGET_PRESSURE_DIVISOR 8
+
+#endif /* !defined(NGTCP2_RX_BUDGET_H) */
@@ -39,6 +39,8 @@ void ngtcp2_strm_init(ngtcp2_strm *strm, int64_t stream_id, uint32_t flags,
   *strm = (ngtcp2_strm){
     .pe.index = NGTCP2_PQ_BAD_INDEX,
     .frc_objalloc = frc_objalloc,
+    .urgency = NGTCP2_DEFAULT_STREAM_URGENCY,
+    .weight = NGTCP2_DEFAULT_STREAM_WEIGHT,
     .tx =
       {
         .max_offset = max_tx_offset,
@@ -121,7 +123,8 @@ static int strm_rob_heavily_fragmented(const ngtcp2_rob *rob) {
 }
 
 ngtcp2_ssize ngtcp2_strm_recv_reordering(ngtcp2_strm *strm, const uint8_t *data,
-                                         size_t datalen, uint64_t offset) {
+                                         size_t datalen, uint64_t offset,
+                                         ngtcp2_rxbuf *rxbuf) {
   int rv;
   ngtcp2_ssize nwrite;
 
@@ -140,7 +143,11 @@ ngtcp2_ssize ngtcp2_strm_recv_reordering(ngtcp2_strm *strm, const uint8_t *data,
     }
   }
 
-  nwrite = ngtcp2_rob_push(strm->rx.rob, offset, data, datalen);
+  if (rxbuf) {
+    nwrite = ngtcp2_rob_push_rxbuf(strm->rx.rob, offset, data, datalen, rxbuf);
+  } else {
+    nwrite = ngtcp2_rob_push(strm->rx.rob, offset, data, datalen);
+  }
   if (nwrite < 0) {
     return nwrite;
   }
@@ -104,6 +104,16 @@ typedef struct ngtcp2_frame_chain ngtcp2_frame_chain;
 /* NGTCP2_STRM_FLAG_SEND_STREAM_DATA_BLOCKED is set when
    STREAM_DATA_BLOCKED and/or DATA_BLOCKED frame should be sent. */
 #define NGTCP2_STRM_FLAG_SEND_STREAM_DATA_BLOCKED 0x20000U
+/* NGTCP2_STRM_FLAG_NON_INCREMENTAL is set when the stream is not
+   incremental in the sense of RFC 9218.  Its data are sent without
+   interleaving with the other streams of the same urgency. */
+#define NGTCP2_STRM_FLAG_NON_INCREMENTAL 0x40000U
+
+/* NGTCP2_STRM_CYCLE_STRIDE is the amount of ngtcp2_strm.cycle
+   advanced when an incremental stream of weight 1 is served.  A
+   stream of weight w advances NGTCP2_STRM_CYCLE_STRIDE / w, so that
+   it is served w times as often. */
+#define NGTCP2_STRM_CYCLE_STRIDE NGTCP2_MAX_STREAM_WEIGHT
 
 typedef struct ngtcp2_strm ngtcp2_strm;
 
@@ -111,8 +121,19 @@ struct ngtcp2_strm {
   union {
     struct {
       ngtcp2_pq_entry pe;
+      /* cycle is the virtual time of this stream in
+         ngtcp2_conn.tx.strmq.  Among the streams of the same urgency,
+         the one with the smallest cycle is served first. */
       uint64_t cycle;
       ngtcp2_objalloc *frc_objalloc;
+      /* urgency is the urgency of this stream in [0,
+         NGTCP2_STREAM_URGENCY_LEVELS).  The smaller value is more
+         urgent. */
+      uint8_t urgency;
+      /* weight is the weight of this stream in [1,
+         NGTCP2_MAX_STREAM_WEIGHT] relative to the other incremental
+         streams of the same urgency. */
+      uint16_t weight;
 
       struct {
         /* acked_offset tracks acknowledged outgoing data. */
@@ -189,6 +210,9 @@ struct ngtcp2_strm {
         uint64_t unsent_max_offset;
         /* window is the stream-level flow control window size. */
         uint64_t window;
+        /* budget_used is the number of bytes of window which are
+           charged to ngtcp2_settings.rx_budget. */
+        uint64_t budget_used;
         /* app_error_code is the application error code that is
            received in RESET_STREAM frame.  If this field is set,
            NGTCP2_STRM_FLAG_RX_APP_ERROR_CODE_SET is set.  This field
@@ -241,6 +265,9 @@ uint64_t ngtcp2_strm_rx_offset(const ngtcp2_strm *strm);
  * function only records the range of the reordered data.  The actual
  * data is not buffered.
  *
+ * If |rxbuf| is not NULL, |data| points into |rxbuf|, and the data
+ * is referenced rather than copied.
+ *
  * It returns the number of bytes newly buffered if it succeeds, or
  * one of the following negative error codes:
  *
@@ -248,7 +275,8 @@ uint64_t ngtcp2_strm_rx_offset(const ngtcp2_strm *strm);
  *     Out of memory
  */
 ngtcp2_ssize ngtcp2_strm_recv_reordering(ngtcp2_strm *strm, const uint8_t *data,
-                                         size_t datalen, uint64_t offset);
+                                         size_t datalen, uint64_t offset,
+                                         ngtcp2_rxbuf *rxbuf);
 
 /*
  * ngtcp2_strm_update_rx_offset tells that data up to |offset| bytes
@@ -0,0 +1,325 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_timerq.h"
+
+#include <assert.h>
+
+#include "ngtcp2_mem.h"
+#include "ngtcp2_macro.h"
+#include "ngtcp2_conn.h"
+
+void ngtcp2_timerq_entry_init(ngtcp2_timerq_entry *ent) {
+  *ent = (ngtcp2_timerq_entry){
+    .expiry = UINT64_MAX,
+  };
+}
+
+int ngtcp2_timerq_new(ngtcp2_timerq **ptimerq, ngtcp2_duration granularity,
+                      const ngtcp2_mem *mem) {
+  ngtcp2_timerq *timerq;
+
+  assert(granularity);
+
+  if (mem == NULL) {
+    mem = ngtcp2_mem_default();
+  }
+
+  timerq = ngtcp2_mem_calloc(mem, 1, sizeof(*timerq));
+  if (timerq == NULL) {
+    return NGTCP2_ERR_NOMEM;
+  }
+
+  timerq->mem = mem;
+  timerq->granularity = granularity;
+
+  *ptimerq = timerq;
+
+  return 0;
+}
+
+void ngtcp2_timerq_del(ngtcp2_timerq *timerq) {
+  if (timerq == NULL) {
+    return;
+  }
+
+  assert(timerq->len == 0);
+
+  ngtcp2_mem_free(timerq->mem, timerq);
+}
+
+/* countr_zero counts the number of trailing zeros in |x|.  It is
+   undefined if |x| is 0. */
+static size_t countr_zero(uint64_t x) {
+#ifdef __GNUC__
+  return (size_t)__builtin_ctzll(x);
+#else  /* !defined(__GNUC__) */
+  size_t n = 0;
+
+  for (; !(x & 1); x >>= 1, ++n)
+    ;
+
+  return n;
+#endif /* !defined(__GNUC__) */
+}
+
+/* rotr rotates |x| to the right by |n| bits. */
+static uint64_t rotr(uint64_t x, size_t n) {
+  if (n == 0) {
+    return x;
+  }
+
+  return (x >> n) | (x << (64 - n));
+}
+
+/*
+ * timerq_tick returns the tick that |ts| is rounded up to.
+ */
+static uint64_t timerq_tick(const ngtcp2_timerq *timerq, ngtcp2_tstamp ts) {
+  return ts / timerq->granularity + (ts % timerq->granularity != 0);
+}
+
+static void timerq_link(ngtcp2_timerq *timerq, ngtcp2_timerq_entry *ent,
+                        size_t level, size_t slot) {
+  ngtcp2_timerq_entry **phead = &timerq->slots[level][slot];
+
+  ent->level = (uint8_t)level;
+  ent->slot = (uint8_t)slot;
+  ent->next = *phead;
+  ent->pprev = phead;
+
+  if (*phead) {
+    (*phead)->pprev = &ent->next;
+  }
+
+  *phead = ent;
+
+  timerq->bitmap[level] |= 1ULL << slot;
+}
+
+static void timerq_unlink(ngtcp2_timerq *timerq, ngtcp2_timerq_entry *ent) {
+  *ent->pprev = ent->next;
+
+  if (ent->next) {
+    ent->next->pprev = ent->pprev;
+  }
+
+  if (!timerq->slots[ent->level][ent->slot]) {
+    timerq->bitmap[ent->level] &= ~(1ULL << ent->slot);
+  }
+
+  ent->next = NULL;
+  ent->pprev = NULL;
+}
+
+/*
+ * timerq_insert links |ent| to the slot that its expiry falls in,
+ * relative to the current tick.
+ */
+static void timerq_insert(ngtcp2_timerq *timerq, ngtcp2_timerq_entry *ent) {
+  uint64_t tick = timerq_tick(timerq, ent->expiry);
+  uint64_t delta;
+  size_t level;
+
+  if (tick <= timerq->now) {
+    timerq_link(timerq, ent, 0, timerq->now & NGTCP2_TIMERQ_SLOT_MASK);
+    return;
+  }
+
+  delta = tick - timerq->now;
+
+  for (level = 0; level < NGTCP2_TIMERQ_NUM_LEVELS - 1 &&
+                  delta >> ((level + 1) * NGTCP2_TIMERQ_LEVEL_BITS);
+       ++level)
+    ;
+
+  if (level == NGTCP2_TIMERQ_NUM_LEVELS - 1 &&
+      delta >> (NGTCP2_TIMERQ_NUM_LEVELS * NGTCP2_TIMERQ_LEVEL_BITS)) {
+    tick = timerq->now +
+           (1ULL << (NGTCP2_TIMERQ_NUM_LEVELS * NGTCP2_TIMERQ_LEVEL_BITS)) - 1;
+  }
+
+  timerq_link(timerq, ent, level,
+              (tick >> (level * NGTCP2_TIMERQ_LEVEL_BITS)) &
+                NGTCP2_TIMERQ_SLOT_MASK);
+}
+
+void ngtcp2_timerq_update(ngtcp2_timerq *timerq, ngtcp2_timerq_entry *ent,
+                          ngtcp2_tstamp expiry) {
+  if (ent->pprev) {
+    if (ent->expiry == expiry) {
+      return;
+    }
+
+    timerq_unlink(timerq, ent);
+    --timerq->len;
+  }
+
+  ent->expiry = expiry;
+
+  if (expiry == UINT64_MAX) {
+    return;
+  }
+
+  timerq_insert(timerq, ent);
+  ++timerq->len;
+}
+
+void ngtcp2_timerq_remove(ngtcp2_timerq *timerq, ngtcp2_timerq_entry *ent) {
+  if (!ent->pprev) {
+    return;
+  }
+
+  timerq_unlink(timerq, ent);
+  --timerq->len;
+
+  ent->expiry = UINT64_MAX;
+}
+
+/*
+ * timerq_next_tick returns the first tick after the current tick at
+ * which a non-empty slot starts.  It returns UINT64_MAX if there is
+ * no such slot.
+ */
+static uint64_t timerq_next_tick(const ngtcp2_timerq *timerq) {
+  uint64_t res = UINT64_MAX, base, d;
+  size_t i, shift;
+
+  for (i = 0; i < NGTCP2_TIMERQ_NUM_LEVELS; ++i) {
+    if (!timerq->bitmap[i]) {
+      continue;
+    }
+
+    shift = i * NGTCP2_TIMERQ_LEVEL_BITS;
+    base = timerq->now >> shift;
+    d = countr_zero(rotr(timerq->bitmap[i],
+                         (size_t)((base + 1) & NGTCP2_TIMERQ_SLOT_MASK))) +
+        1;
+
+    res = ngtcp2_min(res, (base + d) << shift);
+  }
+
+  return res;
+}
+
+/*
+ * timerq_cascade reinserts the entries in the slots of the upper
+ * levels which start at the current tick into the lower levels.
+ */
+static void timerq_cascade(ngtcp2_timerq *timerq) {
+  ngtcp2_timerq_entry *ent, *next;
+  size_t i, shift, slot;
+
+  for (i = NGTCP2_TIMERQ_NUM_LEVELS - 1; i > 0; --i) {
+    shift = i * NGTCP2_TIMERQ_LEVEL_BITS;
+
+    if (timerq->now & ((1ULL << shift) - 1)) {
+      continue;
+    }
+
+    slot = (timerq->now >> shift) & NGTCP2_TIMERQ_SLOT_MASK;
+    ent = timerq->slots[i][slot];
+
+    if (!ent) {
+      continue;
+    }
+
+    timerq->slots[i][slot] = NULL;
+    timerq->bitmap[i] &= ~(1ULL << slot);
+
+    for (; ent; ent = next) {
+      next = ent->next;
+      timerq_insert(timerq, ent);
+    }
+  }
+}
+
+ngtcp2_timerq_entry *ngtcp2_timerq_pop(ngtcp2_timerq *timerq,
+                                       ngtcp2_tstamp ts) {
+  uint64_t target = ts / timerq->granularity, next;
+  ngtcp2_timerq_entry *ent;
+
+  for (;;) {
+    ent = timerq->slots[0][timerq->now & NGTCP2_TIMERQ_SLOT_MASK];
+    if (ent) {
+      timerq_unlink(timerq, ent);
+      --timerq->len;
+
+      ent->expiry = UINT64_MAX;
+
+      return ent;
+    }
+
+    if (timerq->now >= target) {
+      return NULL;
+    }
+
+    next = timerq_next_tick(timerq);
+    if (next > target) {
+      timerq->now = target;
+
+      return NULL;
+    }
+
+    timerq->now = next;
+
+    timerq_cascade(timerq);
+  }
+}
+
+ngtcp2_tstamp ngtcp2_timerq_get_expiry(const ngtcp2_timerq *timerq) {
+  uint64_t tick;
+
+  if (timerq->slots[0][timerq->now & NGTCP2_TIMERQ_SLOT_MASK]) {
+    tick = timerq->now;
+  } else {
+    tick = timerq_next_tick(timerq);
+    if (tick == UINT64_MAX) {
+      return UINT64_MAX;
+    }
+  }
+
+  if (tick > (UINT64_MAX - 1) / timerq->granularity) {
+    return UINT64_MAX - 1;
+  }
+
+  return tick * timerq->granularity;
+}
+
+size_t ngtcp2_timerq_pop_expired(ngtcp2_timerq *timerq, ngtcp2_conn **pconns,
+                                 size_t nconns, ngtcp2_tstamp ts) {
+  ngtcp2_timerq_entry *ent;
+  size_t i;
+
+  for (i = 0; i < nconns; ++i) {
+    ent = ngtcp2_timerq_pop(timerq, ts);
+    if (!ent) {
+      break;
+    }
+
+    pconns[i] = ngtcp2_struct_of(ent, ngtcp2_conn, timerq_ent);
+  }
+
+  return i;
+}
@@ -0,0 +1,122 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef NGTCP2_TIMERQ_H
+#define NGTCP2_TIMERQ_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* defined(HAVE_CONFIG_H) */
+
+#include <ngtcp2/ngtcp2.h>
+
+/* NGTCP2_TIMERQ_LEVEL_BITS is the number of bits of the tick that
+   each level of ngtcp2_timerq covers. */
+#define NGTCP2_TIMERQ_LEVEL_BITS 6
+/* NGTCP2_TIMERQ_NUM_SLOTS is the number of slots in each level. */
+#define NGTCP2_TIMERQ_NUM_SLOTS (1 << NGTCP2_TIMERQ_LEVEL_BITS)
+/* NGTCP2_TIMERQ_SLOT_MASK is the bit mask to get a slot index from a
+   tick. */
+#define NGTCP2_TIMERQ_SLOT_MASK (NGTCP2_TIMERQ_NUM_SLOTS - 1)
+/* NGTCP2_TIMERQ_NUM_LEVELS is the number of levels.  With 1ms
+   granularity, 6 levels cover more than 2 years.  The entries beyond
+   that are kept in the last level, and reinserted when the slot is
+   cascaded. */
+#define NGTCP2_TIMERQ_NUM_LEVELS 6
+
+typedef struct ngtcp2_timerq_entry ngtcp2_timerq_entry;
+
+/*
+ * ngtcp2_timerq_entry is an entry of ngtcp2_timerq.  It is embedded
+ * in the object whose expiry is managed by ngtcp2_timerq.
+ */
+struct ngtcp2_timerq_entry {
+  /* next points to the next entry in the same slot. */
+  ngtcp2_timerq_entry *next;
+  /* pprev points to the pointer which points to this entry.  It is
+     NULL if this entry is not in ngtcp2_timerq. */
+  ngtcp2_timerq_entry **pprev;
+  /* expiry is the deadline of this entry.  UINT64_MAX means that this
+     entry is not in ngtcp2_timerq. */
+  ngtcp2_tstamp expiry;
+  /* level is the level of the slot that this entry belongs to. */
+  uint8_t level;
+  /* slot is the index of the slot that this entry belongs to. */
+  uint8_t slot;
+};
+
+/*
+ * ngtcp2_timerq_entry_init initializes |ent|.
+ */
+void ngtcp2_timerq_entry_init(ngtcp2_timerq_entry *ent);
+
+/*
+ * ngtcp2_timerq is a hierarchical timer wheel.  The level 0 has a
+ * slot per tick, and a slot of the level n covers
+ * NGTCP2_TIMERQ_NUM_SLOTS times as many ticks as the level n - 1.
+ * The entries in a slot of the level n > 0 are reinserted into the
+ * lower levels (cascaded) when the current tick reaches the first
+ * tick of the slot.  The expiry of an entry is rounded up to the
+ * tick, so that all entries in the current slot of the level 0 are
+ * due.
+ */
+struct ngtcp2_timerq {
+  /* mem is the memory allocator that allocated this object. */
+  const ngtcp2_mem *mem;
+  /* granularity is the duration of a tick. */
+  ngtcp2_duration granularity;
+  /* now is the current tick. */
+  uint64_t now;
+  /* len is the number of entries in this object. */
+  size_t len;
+  /* bitmap has a bit set for each non-empty slot in each level. */
+  uint64_t bitmap[NGTCP2_TIMERQ_NUM_LEVELS];
+  ngtcp2_timerq_entry *slots[NGTCP2_TIMERQ_NUM_LEVELS]
+                            [NGTCP2_TIMERQ_NUM_SLOTS];
+};
+
+/*
+ * ngtcp2_timerq_update sets the deadline of |ent| to |expiry|, and
+ * moves it to the appropriate slot of |timerq|.  If |expiry| is
+ * UINT64_MAX, |ent| is removed from |timerq|.  If |ent| is already
+ * in |timerq| with the same deadline, this function does nothing.
+ */
+void ngtcp2_timerq_update(ngtcp2_timerq *timerq, ngtcp2_timerq_entry *ent,
+                          ngtcp2_tstamp expiry);
+
+/*
+ * ngtcp2_timerq_remove removes |ent| from |timerq|.  It does nothing
+ * if |ent| is not in |timerq|.
+ */
+void ngtcp2_timerq_remove(ngtcp2_timerq *timerq, ngtcp2_timerq_entry *ent);
+
+/*
+ * ngtcp2_timerq_pop advances the current tick of |timerq| up to |ts|,
+ * and removes and returns an entry which is due at |ts|.  It returns
+ * NULL if there is no such entry.
+ */
+ngtcp2_timerq_entry *ngtcp2_timerq_pop(ngtcp2_timerq *timerq,
+                                       ngtcp2_tstamp ts);
+
+#endif /* !defined(NGTCP2_TIMERQ_H) */
@@ -30,25 +30,32 @@
 #include "ngtcp2_conv.h"
 #include "ngtcp2_str.h"
 #include "ngtcp2_mem.h"
+#include "ngtcp2_macro.h"
 #include "ngtcp2_unreachable.h"
 
-void ngtcp2_transport_params_default_versioned(
-  int transport_params_version, ngtcp2_transport_params *params) {
-  size_t len;
+size_t ngtcp2_transport_paramslen_version(int transport_params_version) {
+  ngtcp2_transport_params params;
 
   switch (transport_params_version) {
   case NGTCP2_TRANSPORT_PARAMS_VERSION:
-    len = sizeof(*params);
-
-    break;
+    return sizeof(params);
+  case NGTCP2_TRANSPORT_PARAMS_V1:
+    return offsetof(ngtcp2_transport_params, version_info_present) +
+           sizeof(params.version_info_present);
   default:
     ngtcp2_unreachable();
   }
+}
+
+void ngtcp2_transport_params_default_versioned(
+  int transport_params_version, ngtcp2_transport_params *params) {
+  size_t len = ngtcp2_transport_paramslen_version(transport_params_version);
 
   memset(params, 0, len);
 
   switch (transport_params_version) {
   case NGTCP2_TRANSPORT_PARAMS_VERSION:
+  case NGTCP2_TRANSPORT_PARAMS_V1:
     params->max_udp_payload_size = NGTCP2_DEFAULT_MAX_RECV_UDP_PAYLOAD_SIZE;
     params->active_connection_id_limit =
       NGTCP2_DEFAULT_ACTIVE_CONNECTION_ID_LIMIT;
@@ -233,6 +240,11 @@ ngtcp2_ssize ngtcp2_transport_params_encode_versioned(
   if (params->grease_quic_bit) {
     len += zero_paramlen(NGTCP2_TRANSPORT_PARAM_GREASE_QUIC_BIT);
   }
+
+  if (params->min_ack_delay) {
+    len += varint_paramlen(NGTCP2_TRANSPORT_PARAM_MIN_ACK_DELAY,
+                           params->min_ack_delay / NGTCP2_MICROSECONDS);
+  }
   if (params->version_info_present) {
     version_infolen =
       sizeof(uint32_t) + params->version_info.available_versionslen;
@@ -378,6 +390,11 @@ ngtcp2_ssize ngtcp2_transport_params_encode_versioned(
     p = write_zero_param(p, NGTCP2_TRANSPORT_PARAM_GREASE_QUIC_BIT);
   }
 
+  if (params->min_ack_delay) {
+    p = write_varint_param(p, NGTCP2_TRANSPORT_PARAM_MIN_ACK_DELAY,
+                           params->min_ack_delay / NGTCP2_MICROSECONDS);
+  }
+
   if (params->version_info_present) {
     p = ngtcp2_put_uvarint(p, NGTCP2_TRANSPORT_PARAM_VERSION_INFORMATION);
     p = ngtcp2_put_uvarint(p, version_infolen);
@@ -402,19 +419,13 @@ ngtcp2_ssize ngtcp2_transport_params_encode_versioned(
  */
 static int decode_varint(uint64_t *pdest, const uint8_t **pp,
                          const uint8_t *end) {
-  const uint8_t *p = *pp;
-  size_t len;
-
-  if (p == end) {
-    return -1;
-  }
+  const uint8_t *p = ngtcp2_get_uvarintv(pdest, 1, *pp, end);
 
-  len = ngtcp2_get_uvarintlen(p);
-  if ((size_t)(end - p) < len) {
+  if (p == NULL) {
     return -1;
   }
 
-  *pp = ngtcp2_get_uvarint(pdest, p);
+  *pp = p;
 
   return 0;
 }
@@ -428,26 +439,21 @@ static int decode_varint(uint64_t *pdest, const uint8_t **pp,
  */
 static int decode_varint_param(uint64_t *pdest, const uint8_t **pp,
                                const uint8_t *end) {
-  const uint8_t *p = *pp;
-  uint64_t valuelen;
+  const uint8_t *p;
+  /* Length, and value */
+  uint64_t v[2];
 
-  if (decode_varint(&valuelen, &p, end) != 0) {
+  p = ngtcp2_get_uvarintv(v, ngtcp2_arraylen(v), *pp, end);
+  if (p == NULL) {
     return -1;
   }
 
-  if (p == end) {
+  if ((size_t)(p - *pp) - ngtcp2_get_uvarintlen(*pp) != v[0]) {
     return -1;
   }
 
-  if ((uint64_t)(end - p) < valuelen) {
-    return -1;
-  }
-
-  if (ngtcp2_get_uvarintlen(p) != valuelen) {
-    return -1;
-  }
-
-  *pp = ngtcp2_get_uvarint(pdest, p);
+  *pdest = v[1];
+  *pp = p;
 
   return 0;
 }
@@ -729,6 +735,15 @@ int ngtcp2_transport_params_decode_versioned(int transport_params_version,
       }
       params->grease_quic_bit = 1;
       break;
+    case NGTCP2_TRANSPORT_PARAM_MIN_ACK_DELAY:
+      if (decode_varint_param(&params->min_ack_delay, &p, end) != 0) {
+        return NGTCP2_ERR_MALFORMED_TRANSPORT_PARAM;
+      }
+      if (params->min_ack_delay >= 16384 * 1000) {
+        return NGTCP2_ERR_MALFORMED_TRANSPORT_PARAM;
+      }
+      params->min_ack_delay *= NGTCP2_MICROSECONDS;
+      break;
     case NGTCP2_TRANSPORT_PARAM_VERSION_INFORMATION:
       if (decode_varint(&valuelen, &p, end) != 0) {
         return NGTCP2_ERR_MALFORMED_TRANSPORT_PARAM;
@@ -859,14 +874,8 @@ static void transport_params_copy(ngtcp2_transport_params *dest,
                                   int transport_params_version) {
   assert(transport_params_version != NGTCP2_TRANSPORT_PARAMS_VERSION);
 
-  switch (transport_params_version) {
-  case NGTCP2_TRANSPORT_PARAMS_V1:
-    memcpy(dest, src,
-           offsetof(ngtcp2_transport_params, version_info_present) +
-             sizeof(src->version_info_present));
-
-    break;
-  }
+  memcpy(dest, src,
+         ngtcp2_transport_paramslen_version(transport_params_version));
 }
 
 const ngtcp2_transport_params *
@@ -57,6 +57,8 @@ typedef uint64_t ngtcp2_transport_param_id;
 #define NGTCP2_TRANSPORT_PARAM_GREASE_QUIC_BIT 0x2AB2U
 /* https://datatracker.ietf.org/doc/html/rfc9368 */
 #define NGTCP2_TRANSPORT_PARAM_VERSION_INFORMATION 0x11U
+/* https://datatracker.ietf.org/doc/html/draft-ietf-quic-ack-frequency */
+#define NGTCP2_TRANSPORT_PARAM_MIN_ACK_DELAY 0xFF04DE1BU
 
 /* NGTCP2_MAX_STREAMS is the maximum number of streams. */
 #define NGTCP2_MAX_STREAMS (1LL << 60)
@@ -115,4 +117,10 @@ void ngtcp2_transport_params_convert_to_old(int transport_params_version,
                                             ngtcp2_transport_params *dest,
                                             const ngtcp2_transport_params *src);
 
+/*
+ * ngtcp2_transport_paramslen_version returns the effective length of
+ * ngtcp2_transport_params at the version |transport_params_version|.
+ */
+size_t ngtcp2_transport_paramslen_version(int transport_params_version);
+
 #endif /* !defined(NGTCP2_TRANSPORT_PARAMS_H) */
@@ -59,11 +59,15 @@
 #include "ngtcp2_addr_test.h"
 #include "ngtcp2_pcg_test.h"
 #include "ngtcp2_ratelim_test.h"
+#include "ngtcp2_objpool_test.h"
 #include "ngtcp2_conn_info_test.h"
 #include "ngtcp2_cid_test.h"
 #include "ngtcp2_log_test.h"
 #include "ngtcp2_fmt_test.h"
 #include "ngtcp2_macro_test.h"
+#include "ngtcp2_rx_budget_test.h"
+#include "ngtcp2_timerq_test.h"
+#include "ngtcp2_cid_table_test.h"
 
 int main(int argc, char *argv[]) {
   const MunitSuite suites[] = {
@@ -96,11 +100,15 @@ int main(int argc, char *argv[]) {
     addr_suite,
     pcg_suite,
     ratelim_suite,
+    objpool_suite,
     conn_info_suite,
     cid_suite,
     log_suite,
     fmt_suite,
     macro_suite,
+    rx_budget_suite,
+    timerq_suite,
+    cid_table_suite,
     {0},
   };
   const MunitSuite suite = {
@@ -0,0 +1,187 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_cid_table_test.h"
+
+#include <stdio.h>
+
+#include "ngtcp2_cid_table.h"
+#include "ngtcp2_macro.h"
+#include "ngtcp2_test_helper.h"
+
+static const MunitTest tests[] = {
+  munit_void_test(test_ngtcp2_cid_table_hash),
+  munit_void_test(test_ngtcp2_cid_table_insert_remove),
+  munit_void_test(test_ngtcp2_cid_table_find_batch),
+  munit_test_end(),
+};
+
+const MunitSuite cid_table_suite = {
+  "/cid_table", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE,
+};
+
+static const uint8_t key[NGTCP2_CID_TABLE_KEYLEN] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+};
+
+static void make_cid(ngtcp2_cid *cid, size_t cidlen, uint32_t n) {
+  uint8_t data[NGTCP2_MAX_CIDLEN] = {0};
+
+  data[0] = (uint8_t)(n >> 24);
+  data[1] = (uint8_t)(n >> 16);
+  data[2] = (uint8_t)(n >> 8);
+  data[3] = (uint8_t)n;
+
+  ngtcp2_cid_init(cid, data, cidlen);
+}
+
+void test_ngtcp2_cid_table_hash(void) {
+  /* Test vectors from the reference implementation of SipHash-2-4
+     with key 00 01 .. 0f and input 00 01 .. (len - 1). */
+  const uint64_t k[] = {0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL};
+  uint8_t data[15];
+  size_t i;
+
+  for (i = 0; i < ngtcp2_arraylen(data); ++i) {
+    data[i] = (uint8_t)i;
+  }
+
+  assert_uint64(0x726FDB47DD0E0E31ULL, ==, ngtcp2_cid_table_hash(k, data, 0));
+  assert_uint64(0x93F5F5799A932462ULL, ==, ngtcp2_cid_table_hash(k, data, 8));
+  assert_uint64(0xA129CA6149BE45E5ULL, ==,
+                ngtcp2_cid_table_hash(k, data, 15));
+}
+
+void test_ngtcp2_cid_table_insert_remove(void) {
+  ngtcp2_cid_table *table;
+  ngtcp2_cid cid;
+  size_t i;
+  int rv;
+
+  rv = ngtcp2_cid_table_new(&table, 8, key, NULL);
+
+  assert_int(0, ==, rv);
+  assert_size(0, ==, ngtcp2_cid_table_size(table));
+
+  make_cid(&cid, 8, 0);
+
+  assert_null(ngtcp2_cid_table_find(table, cid.data));
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==,
+             ngtcp2_cid_table_remove(table, &cid));
+
+  /* Insert enough Connection IDs to grow the table several times. */
+  for (i = 0; i < 1000; ++i) {
+    make_cid(&cid, 8, (uint32_t)i);
+
+    rv = ngtcp2_cid_table_insert(table, &cid, (void *)(uintptr_t)(i + 1));
+
+    assert_int(0, ==, rv);
+  }
+
+  assert_size(1000, ==, ngtcp2_cid_table_size(table));
+
+  /* Duplicate */
+  make_cid(&cid, 8, 7);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==,
+             ngtcp2_cid_table_insert(table, &cid, (void *)1));
+
+  /* Length mismatch */
+  make_cid(&cid, 9, 1000);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==,
+             ngtcp2_cid_table_insert(table, &cid, (void *)1));
+
+  for (i = 0; i < 1000; ++i) {
+    make_cid(&cid, 8, (uint32_t)i);
+
+    assert_ptr_equal((void *)(uintptr_t)(i + 1),
+                     ngtcp2_cid_table_find(table, cid.data));
+  }
+
+  for (i = 0; i < 1000; i += 2) {
+    make_cid(&cid, 8, (uint32_t)i);
+
+    assert_int(0, ==, ngtcp2_cid_table_remove(table, &cid));
+  }
+
+  assert_size(500, ==, ngtcp2_cid_table_size(table));
+
+  for (i = 0; i < 1000; ++i) {
+    make_cid(&cid, 8, (uint32_t)i);
+
+    if (i & 1) {
+      assert_ptr_equal((void *)(uintptr_t)(i + 1),
+                       ngtcp2_cid_table_find(table, cid.data));
+    } else {
+      assert_null(ngtcp2_cid_table_find(table, cid.data));
+    }
+  }
+
+  ngtcp2_cid_table_del(table);
+}
+
+void test_ngtcp2_cid_table_find_batch(void) {
+  ngtcp2_cid_table *table;
+  ngtcp2_cid cids[40];
+  const uint8_t *pcids[ngtcp2_arraylen(cids)];
+  void *data[ngtcp2_arraylen(cids)];
+  size_t i;
+  int rv;
+
+  rv = ngtcp2_cid_table_new(&table, NGTCP2_MAX_CIDLEN, key, NULL);
+
+  assert_int(0, ==, rv);
+
+  for (i = 0; i < ngtcp2_arraylen(cids); ++i) {
+    make_cid(&cids[i], NGTCP2_MAX_CIDLEN, (uint32_t)i);
+    pcids[i] = cids[i].data;
+  }
+
+  ngtcp2_cid_table_find_batch(table, data, pcids, ngtcp2_arraylen(cids));
+
+  for (i = 0; i < ngtcp2_arraylen(cids); ++i) {
+    assert_null(data[i]);
+  }
+
+  /* Only register every third Connection ID. */
+  for (i = 0; i < ngtcp2_arraylen(cids); i += 3) {
+    rv = ngtcp2_cid_table_insert(table, &cids[i], &cids[i]);
+
+    assert_int(0, ==, rv);
+  }
+
+  ngtcp2_cid_table_find_batch(table, data, pcids, ngtcp2_arraylen(cids));
+
+  for (i = 0; i < ngtcp2_arraylen(cids); ++i) {
+    if (i % 3 == 0) {
+      assert_ptr_equal(&cids[i], data[i]);
+    } else {
+      assert_null(data[i]);
+    }
+  }
+
+  ngtcp2_cid_table_del(table);
+}
@@ -47,6 +47,7 @@ static const MunitTest tests[] = {
   munit_void_test(test_ngtcp2_conn_stream_rx_flow_control),
   munit_void_test(test_ngtcp2_conn_stream_rx_flow_control_error),
   munit_void_test(test_ngtcp2_conn_stream_tx_flow_control),
+  munit_void_test(test_ngtcp2_conn_stream_priority),
   munit_void_test(test_ngtcp2_conn_rx_flow_control),
   munit_void_test(test_ngtcp2_conn_rx_flow_control_error),
   munit_void_test(test_ngtcp2_conn_tx_flow_control),
@@ -76,10 +77,14 @@ static const MunitTest tests[] = {
   munit_void_test(test_ngtcp2_conn_send_early_data),
   munit_void_test(test_ngtcp2_conn_recv_early_data),
   munit_void_test(test_ngtcp2_conn_recv_compound_pkt),
+  munit_void_test(test_ngtcp2_conn_read_pkts),
+  munit_void_test(test_ngtcp2_conn_read_pkt_rx_buf),
   munit_void_test(test_ngtcp2_conn_pkt_payloadlen),
   munit_void_test(test_ngtcp2_conn_writev_stream),
   munit_void_test(test_ngtcp2_conn_writev_datagram),
   munit_void_test(test_ngtcp2_conn_recv_datagram),
+  munit_void_test(test_ngtcp2_conn_recv_ack_frequency),
+  munit_void_test(test_ngtcp2_conn_submit_ack_frequency),
   munit_void_test(test_ngtcp2_conn_recv_new_connection_id),
   munit_void_test(test_ngtcp2_conn_recv_retire_connection_id),
   munit_void_test(test_ngtcp2_conn_server_path_validation),
@@ -129,12 +134,20 @@ static const MunitTest tests[] = {
   munit_void_test(test_ngtcp2_conn_super_small_rtt),
   munit_void_test(test_ngtcp2_conn_recv_ack),
   munit_void_test(test_ngtcp2_conn_write_aggregate_pkt),
+  munit_void_test(test_ngtcp2_conn_write_aggregate_pkt_txtime),
+  munit_void_test(test_ngtcp2_conn_write_stream_encryptv),
   munit_void_test(test_ngtcp2_conn_crumble_initial_pkt),
   munit_void_test(test_ngtcp2_conn_skip_pkt_num),
   munit_void_test(test_ngtcp2_conn_get_timestamp),
   munit_void_test(test_ngtcp2_conn_get_stream_user_data),
   munit_void_test(test_ngtcp2_conn_new_failmalloc),
   munit_void_test(test_ngtcp2_conn_post_handshake_failmalloc),
+  munit_void_test(test_ngtcp2_conn_handshake_arena),
+  munit_void_test(test_ngtcp2_conn_objpool),
+  munit_void_test(test_ngtcp2_conn_rx_budget),
+  munit_void_test(test_ngtcp2_conn_timerq),
+  munit_void_test(test_ngtcp2_conn_poll_expiry),
+  munit_void_test(test_ngtcp2_conn_cid_table),
   munit_void_test(test_ngtcp2_accept),
   munit_void_test(test_ngtcp2_select_version),
   munit_void_test(test_ngtcp2_pkt_write_connection_close),
@@ -178,6 +191,47 @@ static int null_encrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
   return 0;
 }
 
+static struct {
+  size_t ncalled;
+  size_t plaintextcnt;
+  const uint8_t *data;
+  int data_found;
+} encryptv_stat;
+
+static int null_encryptv(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                         const ngtcp2_crypto_aead_ctx *aead_ctx,
+                         const ngtcp2_vec *plaintextv, size_t plaintextcnt,
+                         const uint8_t *nonce, size_t noncelen,
+                         const uint8_t *aad, size_t aadlen) {
+  uint8_t *p = dest;
+  size_t i;
+  (void)aead;
+  (void)aead_ctx;
+  (void)nonce;
+  (void)noncelen;
+  (void)aad;
+  (void)aadlen;
+
+  ++encryptv_stat.ncalled;
+  encryptv_stat.plaintextcnt = plaintextcnt;
+
+  for (i = 0; i < plaintextcnt; ++i) {
+    if (plaintextv[i].base == encryptv_stat.data) {
+      encryptv_stat.data_found = 1;
+    }
+
+    if (plaintextv[i].len && plaintextv[i].base != p) {
+      memcpy(p, plaintextv[i].base, plaintextv[i].len);
+    }
+
+    p += plaintextv[i].len;
+  }
+
+  memset(p, 0, NGTCP2_FAKE_AEAD_OVERHEAD);
+
+  return 0;
+}
+
 static int null_decrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
                         const ngtcp2_crypto_aead_ctx *aead_ctx,
                         const uint8_t *ciphertext, size_t ciphertextlen,
@@ -223,6 +277,86 @@ static int null_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
   return 0;
 }
 
+/*
+ * sample_hp_mask derives a non-zero header protection mask from
+ * |sample|.  Unlike null_hp_mask, a mask which is computed for a
+ * wrong sample, or not applied at all, corrupts the header.
+ */
+static int sample_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                          const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                          const uint8_t *sample) {
+  size_t i;
+  (void)hp;
+  (void)hp_ctx;
+
+  for (i = 0; i < 5; ++i) {
+    dest[i] = (uint8_t)(0xA5 ^ sample[i] ^ sample[i + 5] ^ sample[i + 10]);
+  }
+
+  return 0;
+}
+
+static struct {
+  size_t ncalled;
+  size_t nsamples;
+} hp_mask_batch_stat;
+
+static int sample_hp_mask_batch(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                                const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                                const uint8_t *const *samples,
+                                size_t nsamples) {
+  size_t i;
+
+  ++hp_mask_batch_stat.ncalled;
+  hp_mask_batch_stat.nsamples += nsamples;
+
+  for (i = 0; i < nsamples; ++i) {
+    sample_hp_mask(dest + i * NGTCP2_HP_SAMPLELEN, hp, hp_ctx, samples[i]);
+  }
+
+  return 0;
+}
+
+/* decrypt_hd records the packet headers passed to record_decrypt as
+   AAD, that is, after header protection is removed. */
+static struct {
+  uint8_t hd[4][64];
+  size_t hdlen[4];
+  size_t n;
+} decrypt_hd;
+
+static int record_decrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                          const ngtcp2_crypto_aead_ctx *aead_ctx,
+                          const uint8_t *ciphertext, size_t ciphertextlen,
+                          const uint8_t *nonce, size_t noncelen,
+                          const uint8_t *aad, size_t aadlen) {
+  assert(decrypt_hd.n < ngtcp2_arraylen(decrypt_hd.hd));
+  assert(aadlen <= sizeof(decrypt_hd.hd[0]));
+
+  memcpy(decrypt_hd.hd[decrypt_hd.n], aad, aadlen);
+  decrypt_hd.hdlen[decrypt_hd.n] = aadlen;
+  ++decrypt_hd.n;
+
+  return null_decrypt(dest, aead, aead_ctx, ciphertext, ciphertextlen, nonce,
+                      noncelen, aad, aadlen);
+}
+
+/*
+ * assert_decrypt_hd_1rtt asserts that decrypt_hd.hd[idx] is a short
+ * header whose first byte is |first_byte| and whose packet number is
+ * |pkt_num|.
+ */
+static void assert_decrypt_hd_1rtt(size_t idx, uint8_t first_byte,
+                                   int64_t pkt_num) {
+  const uint8_t *hd = decrypt_hd.hd[idx];
+  size_t pkt_numlen = (size_t)(hd[0] & NGTCP2_PKT_NUMLEN_MASK) + 1;
+
+  assert_uint8(first_byte, ==, hd[0]);
+  assert_int64(pkt_num, ==,
+               ngtcp2_get_pkt_num(hd + decrypt_hd.hdlen[idx] - pkt_numlen,
+                                  pkt_numlen));
+}
+
 static int get_new_connection_id(ngtcp2_conn *conn, ngtcp2_cid *cid,
                                  ngtcp2_stateless_reset_token *token,
                                  size_t cidlen, void *user_data) {
@@ -237,6 +371,43 @@ static int get_new_connection_id(ngtcp2_conn *conn, ngtcp2_cid *cid,
   return 0;
 }
 
+/* cid_gen controls the Connection IDs generated by
+   get_new_connection_id_gen, and counts the ones passed to
+   remove_connection_id_gen. */
+static struct {
+  uint8_t next;
+  uint8_t step;
+  size_t nremoved;
+} cid_gen;
+
+static int get_new_connection_id_gen(ngtcp2_conn *conn, ngtcp2_cid *cid,
+                                     ngtcp2_stateless_reset_token *token,
+                                     size_t cidlen, void *user_data) {
+  (void)conn;
+  (void)user_data;
+
+  *cid = (ngtcp2_cid){
+    .datalen = cidlen,
+    .data = {0xFF, cid_gen.next},
+  };
+  *token = (ngtcp2_stateless_reset_token){0};
+
+  cid_gen.next = (uint8_t)(cid_gen.next + cid_gen.step);
+
+  return 0;
+}
+
+static int remove_connection_id_gen(ngtcp2_conn *conn, const ngtcp2_cid *cid,
+                                    void *user_data) {
+  (void)conn;
+  (void)cid;
+  (void)user_data;
+
+  ++cid_gen.nremoved;
+
+  return 0;
+}
+
 static uint8_t null_secret[32];
 static uint8_t null_iv[16];
 static uint8_t null_data[4096];
@@ -336,6 +507,10 @@ typedef struct {
     uint64_t app_error_code;
     size_t ncalled;
   } stop_sending;
+  struct {
+    void *rx_buf;
+    size_t ncalled;
+  } release_rx_buf;
 } my_user_data;
 
 static int client_initial(ngtcp2_conn *conn, void *user_data) {
@@ -720,6 +895,16 @@ static int recv_stop_sending(ngtcp2_conn *conn, int64_t stream_id,
   return 0;
 }
 
+static void release_rx_buf(ngtcp2_conn *conn, void *rx_buf, void *user_data) {
+  my_user_data *ud = user_data;
+  (void)conn;
+
+  if (ud) {
+    ud->release_rx_buf.rx_buf = rx_buf;
+    ++ud->release_rx_buf.ncalled;
+  }
+}
+
 static int recv_retry(ngtcp2_conn *conn, const ngtcp2_pkt_hd *hd,
                       void *user_data) {
   (void)conn;
@@ -1706,6 +1891,160 @@ void test_ngtcp2_conn_stream_tx_flow_control(void) {
   ngtcp2_conn_del(conn);
 }
 
+static void push_stream_frame(ngtcp2_conn *conn, ngtcp2_strm *strm,
+                              uint64_t offset, size_t datalen) {
+  ngtcp2_frame_chain *frc;
+  int rv;
+
+  rv = ngtcp2_frame_chain_stream_datacnt_objalloc_new(
+    &frc, 1, &conn->frc_objalloc, conn->mem);
+
+  assert_int(0, ==, rv);
+
+  frc->fr.stream.type = NGTCP2_FRAME_STREAM;
+  frc->fr.stream.flags = 0;
+  frc->fr.stream.fin = 0;
+  frc->fr.stream.stream_id = strm->stream_id;
+  frc->fr.stream.offset = offset;
+  frc->fr.stream.datacnt = 1;
+  frc->fr.stream.data[0] = (ngtcp2_vec){
+    .base = null_data,
+    .len = datalen,
+  };
+
+  rv = ngtcp2_strm_streamfrq_push(strm, frc);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_conn_tx_strmq_push_if_not(conn, strm);
+
+  assert_int(0, ==, rv);
+}
+
+void test_ngtcp2_conn_stream_priority(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[1200];
+  ngtcp2_ssize spktlen;
+  int rv;
+  int64_t stream_id[4];
+  ngtcp2_strm *strm[4];
+  ngtcp2_ssize nwrite;
+  ngtcp2_ksl_it it;
+  ngtcp2_rtb_entry *ent;
+  ngtcp2_frame_chain *frc;
+  size_t i;
+  ngtcp2_tstamp t = 0;
+  ngtcp2_transport_params remote_params;
+  conn_options opts;
+
+  client_default_remote_transport_params(&remote_params);
+  remote_params.initial_max_streams_bidi = ngtcp2_arraylen(stream_id);
+
+  opts = (conn_options){
+    .remote_params = &remote_params,
+  };
+
+  setup_default_client_with_options(&conn, opts);
+
+  for (i = 0; i < ngtcp2_arraylen(stream_id); ++i) {
+    rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id[i], NULL);
+
+    assert_int(0, ==, rv);
+
+    strm[i] = ngtcp2_conn_find_stream(conn, stream_id[i]);
+
+    assert_uint8(NGTCP2_DEFAULT_STREAM_URGENCY, ==, strm[i]->urgency);
+    assert_uint16(NGTCP2_DEFAULT_STREAM_WEIGHT, ==, strm[i]->weight);
+  }
+
+  /* Invalid arguments */
+  rv = ngtcp2_conn_set_stream_priority(conn, stream_id[0],
+                                       NGTCP2_STREAM_URGENCY_LEVELS, 1, 0);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==, rv);
+
+  rv = ngtcp2_conn_set_stream_priority(conn, stream_id[0], 0, 1,
+                                       NGTCP2_MAX_STREAM_WEIGHT + 1);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==, rv);
+
+  rv = ngtcp2_conn_set_stream_priority(conn, 1000000007, 0, 1, 0);
+
+  assert_int(NGTCP2_ERR_STREAM_NOT_FOUND, ==, rv);
+
+  /* Retransmission is scheduled in the order of urgency */
+  for (i = 0; i < 3; ++i) {
+    push_stream_frame(conn, strm[i], 0, 100);
+  }
+
+  assert_int64(stream_id[0], ==, ngtcp2_conn_tx_strmq_top(conn)->stream_id);
+
+  rv = ngtcp2_conn_set_stream_priority(conn, stream_id[2], 0, 1, 0);
+
+  assert_int(0, ==, rv);
+  assert_int64(stream_id[2], ==, ngtcp2_conn_tx_strmq_top(conn)->stream_id);
+
+  rv = ngtcp2_conn_set_stream_priority(conn, stream_id[1], 1, 0,
+                                       NGTCP2_MAX_STREAM_WEIGHT);
+
+  assert_int(0, ==, rv);
+  assert_uint8(1, ==, strm[1]->urgency);
+  assert_uint16(NGTCP2_MAX_STREAM_WEIGHT, ==, strm[1]->weight);
+  assert_true(strm[1]->flags & NGTCP2_STRM_FLAG_NON_INCREMENTAL);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_true(ngtcp2_pq_empty(&conn->tx.strmq));
+
+  it = ngtcp2_rtb_head(&conn->pktns.rtb);
+  ent = ngtcp2_ksl_it_get(&it);
+
+  for (i = 0, frc = ent->frc; frc; frc = frc->next) {
+    if (frc->fr.hd.type != NGTCP2_FRAME_STREAM) {
+      continue;
+    }
+
+    assert_int64(stream_id[2 - i], ==, frc->fr.stream.stream_id);
+    ++i;
+  }
+
+  assert_size(3, ==, i);
+
+  /* New data of more urgent stream is sent before retransmission of
+     less urgent stream. */
+  push_stream_frame(conn, strm[0], 0, 1000);
+
+  rv = ngtcp2_conn_set_stream_priority(conn, stream_id[3], 0, 1, 0);
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                     &nwrite, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                     stream_id[3], null_data, 100, ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_ptrdiff(100, ==, nwrite);
+  assert_false(ngtcp2_strm_streamfrq_empty(strm[0]));
+
+  /* Retransmission of equally urgent stream goes first. */
+  rv = ngtcp2_conn_set_stream_priority(conn, stream_id[3],
+                                       NGTCP2_DEFAULT_STREAM_URGENCY, 1, 0);
+
+  assert_int(0, ==, rv);
+
+  push_stream_frame(conn, strm[0], 1000, 1000);
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                     &nwrite, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                     stream_id[3], null_data, 100, ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_ptrdiff(-1, ==, nwrite);
+
+  ngtcp2_conn_del(conn);
+}
+
 void test_ngtcp2_conn_rx_flow_control(void) {
   ngtcp2_conn *conn;
   uint8_t buf[2048];
@@ -8520,77 +8859,409 @@ void test_ngtcp2_conn_recv_compound_pkt(void) {
   ngtcp2_conn_del(conn);
 }
 
-void test_ngtcp2_conn_pkt_payloadlen(void) {
+void test_ngtcp2_conn_read_pkts(void) {
   ngtcp2_conn *conn;
-  uint8_t buf[2048];
-  size_t pktlen;
+  uint8_t buf[3][1200];
+  ngtcp2_vec pktv[3];
   ngtcp2_vec datav;
   ngtcp2_frame fr;
   ngtcp2_tstamp t = 0;
-  uint64_t payloadlen;
-  int rv;
-  const ngtcp2_cid *dcid;
+  ngtcp2_callbacks callbacks;
+  conn_options opts;
+  ngtcp2_strm *strm;
   ngtcp2_tpe tpe;
+  uint8_t hd[3][64];
+  size_t hdlen[3];
+  size_t i;
+  int rv;
 
-  /* Payload length is invalid */
-  setup_handshake_server(&conn);
-  ngtcp2_tpe_init_conn_handshake_server(&tpe, conn, &null_ckm);
+  server_default_callbacks(&callbacks);
+  callbacks.decrypt = record_decrypt;
+  callbacks.hp_mask = sample_hp_mask;
+  callbacks.hp_mask_batch = sample_hp_mask_batch;
 
-  fr.stream = (ngtcp2_stream){
-    .type = NGTCP2_FRAME_CRYPTO,
-    .datacnt = 1,
-    .data = &datav,
+  opts = (conn_options){
+    .callbacks = &callbacks,
   };
+
+  /* Short header packets are unprotected with the batched masks. */
+  setup_default_server_with_options(&conn, opts);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+  tpe.hp_mask = sample_hp_mask;
+
   datav = (ngtcp2_vec){
-    .len = 1231,
+    .len = 100,
     .base = null_data,
   };
 
-  pktlen = ngtcp2_tpe_write_initial(&tpe, buf, sizeof(buf), &fr, 1);
+  for (i = 0; i < ngtcp2_arraylen(buf); ++i) {
+    fr.stream = (ngtcp2_stream){
+      .type = NGTCP2_FRAME_STREAM,
+      .stream_id = 4,
+      .offset = i * datav.len,
+      .datacnt = 1,
+      .data = &datav,
+    };
 
-  dcid = ngtcp2_conn_get_dcid2(conn);
-  payloadlen = read_pkt_payloadlen(buf, dcid, &conn->oscid);
-  write_pkt_payloadlen(buf, dcid, &conn->oscid, payloadlen + 1);
+    pktv[i].base = buf[i];
+    pktv[i].len = ngtcp2_tpe_write_1rtt(&tpe, buf[i], sizeof(buf[i]), &fr, 1);
+  }
 
-  /* This first packet which does not increase initial packet number
-     space CRYPTO offset or it does not get buffered as 0RTT is an
-     error.  But it is unsecured Initial, so we just ignore it. */
-  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, ++t);
+  hp_mask_batch_stat.ncalled = 0;
+  hp_mask_batch_stat.nsamples = 0;
+  decrypt_hd.n = 0;
 
-  assert_int(NGTCP2_ERR_DROP_CONN, ==, rv);
-  assert_int((int)NGTCP2_CS_SERVER_INITIAL, ==, (int)conn->state);
+  rv = ngtcp2_conn_read_pkts(conn, &null_path.path, NULL, pktv,
+                             ngtcp2_arraylen(pktv), ++t);
+
+  assert_int(0, ==, rv);
+  assert_size(1, ==, hp_mask_batch_stat.ncalled);
+  assert_size(3, ==, hp_mask_batch_stat.nsamples);
+  assert_uint64(3, ==, conn->cstat.pkt_recv);
+  assert_null(conn->crypto.hp_mask_batch.pktv);
+  assert_size(3, ==, decrypt_hd.n);
+
+  for (i = 0; i < decrypt_hd.n; ++i) {
+    assert_decrypt_hd_1rtt(i, NGTCP2_FIXED_BIT_MASK | 0x03, (int64_t)i);
+
+    memcpy(hd[i], decrypt_hd.hd[i], decrypt_hd.hdlen[i]);
+    hdlen[i] = decrypt_hd.hdlen[i];
+  }
+
+  strm = ngtcp2_conn_find_stream(conn, 4);
+
+  assert_not_null(strm);
+  assert_uint64(300, ==, ngtcp2_strm_rx_offset(strm));
 
   ngtcp2_conn_del(conn);
 
-  /* Client Initial packet included in UDP datagram smaller than 1200
-     is discarded. */
-  setup_handshake_server(&conn);
-  ngtcp2_tpe_init_conn_handshake_server(&tpe, conn, &null_ckm);
+  /* Without hp_mask_batch, the same packets are unprotected one by
+     one to the same headers. */
+  callbacks.hp_mask_batch = NULL;
 
-  fr.stream = (ngtcp2_stream){
-    .type = NGTCP2_FRAME_CRYPTO,
-    .datacnt = 1,
-    .data = &datav,
-  };
-  datav = (ngtcp2_vec){
-    .len = 1000,
-    .base = null_data,
-  };
+  setup_default_server_with_options(&conn, opts);
 
-  pktlen = ngtcp2_tpe_write_initial(&tpe, buf, sizeof(buf), &fr, 1);
+  hp_mask_batch_stat.ncalled = 0;
+  decrypt_hd.n = 0;
 
-  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, ++t);
+  rv = ngtcp2_conn_read_pkts(conn, &null_path.path, NULL, pktv,
+                             ngtcp2_arraylen(pktv), ++t);
 
-  assert_int(NGTCP2_ERR_DROP_CONN, ==, rv);
-  assert_int((int)NGTCP2_CS_SERVER_INITIAL, ==, (int)conn->state);
+  assert_int(0, ==, rv);
+  assert_size(0, ==, hp_mask_batch_stat.ncalled);
+  assert_uint64(3, ==, conn->cstat.pkt_recv);
+  assert_size(3, ==, decrypt_hd.n);
+
+  for (i = 0; i < decrypt_hd.n; ++i) {
+    assert_size(hdlen[i], ==, decrypt_hd.hdlen[i]);
+    assert_memory_equal(hdlen[i], hd[i], decrypt_hd.hd[i]);
+  }
 
   ngtcp2_conn_del(conn);
-}
 
-void test_ngtcp2_conn_writev_stream(void) {
-  ngtcp2_conn *conn;
-  uint8_t buf[2048];
-  ngtcp2_ssize spktlen;
+  callbacks.hp_mask_batch = sample_hp_mask_batch;
+
+  /* A long header packet is unprotected with ngtcp2_hp_mask. */
+  setup_default_server_with_options(&conn, opts);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+  tpe.hp_mask = sample_hp_mask;
+
+  fr.padding = (ngtcp2_padding){
+    .type = NGTCP2_FRAME_PADDING,
+    .len = 1,
+  };
+
+  pktv[0].base = buf[0];
+  pktv[0].len =
+    ngtcp2_tpe_write_handshake(&tpe, buf[0], sizeof(buf[0]), &fr, 1);
+
+  for (i = 1; i < ngtcp2_arraylen(buf); ++i) {
+    fr.stream = (ngtcp2_stream){
+      .type = NGTCP2_FRAME_STREAM,
+      .stream_id = 4,
+      .offset = (i - 1) * datav.len,
+      .datacnt = 1,
+      .data = &datav,
+    };
+
+    pktv[i].base = buf[i];
+    pktv[i].len = ngtcp2_tpe_write_1rtt(&tpe, buf[i], sizeof(buf[i]), &fr, 1);
+  }
+
+  hp_mask_batch_stat.ncalled = 0;
+  hp_mask_batch_stat.nsamples = 0;
+  decrypt_hd.n = 0;
+
+  rv = ngtcp2_conn_read_pkts(conn, &null_path.path, NULL, pktv,
+                             ngtcp2_arraylen(pktv), ++t);
+
+  assert_int(0, ==, rv);
+  assert_size(1, ==, hp_mask_batch_stat.ncalled);
+  assert_size(2, ==, hp_mask_batch_stat.nsamples);
+  assert_uint64(3, ==, conn->cstat.pkt_recv);
+  assert_size(3, ==, decrypt_hd.n);
+  assert_uint8(NGTCP2_HEADER_FORM_BIT | NGTCP2_FIXED_BIT_MASK |
+                 (NGTCP2_PKT_TYPE_HANDSHAKE_V1 << 4) | 0x03,
+               ==, decrypt_hd.hd[0][0]);
+  assert_int64(0, ==,
+               ngtcp2_get_pkt_num(decrypt_hd.hd[0] + decrypt_hd.hdlen[0] - 4,
+                                  4));
+
+  for (i = 1; i < decrypt_hd.n; ++i) {
+    assert_decrypt_hd_1rtt(i, NGTCP2_FIXED_BIT_MASK | 0x03, (int64_t)(i - 1));
+  }
+
+  strm = ngtcp2_conn_find_stream(conn, 4);
+
+  assert_not_null(strm);
+  assert_uint64(200, ==, ngtcp2_strm_rx_offset(strm));
+
+  ngtcp2_conn_del(conn);
+
+  /* A single datagram does not use ngtcp2_hp_mask_batch. */
+  setup_default_server_with_options(&conn, opts);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+  tpe.hp_mask = sample_hp_mask;
+
+  fr.stream = (ngtcp2_stream){
+    .type = NGTCP2_FRAME_STREAM,
+    .stream_id = 4,
+    .datacnt = 1,
+    .data = &datav,
+  };
+
+  pktv[0].base = buf[0];
+  pktv[0].len = ngtcp2_tpe_write_1rtt(&tpe, buf[0], sizeof(buf[0]), &fr, 1);
+
+  hp_mask_batch_stat.ncalled = 0;
+  hp_mask_batch_stat.nsamples = 0;
+
+  decrypt_hd.n = 0;
+
+  rv = ngtcp2_conn_read_pkts(conn, &null_path.path, NULL, pktv, 1, ++t);
+
+  assert_int(0, ==, rv);
+  assert_size(0, ==, hp_mask_batch_stat.ncalled);
+  assert_uint64(1, ==, conn->cstat.pkt_recv);
+  assert_size(1, ==, decrypt_hd.n);
+  assert_decrypt_hd_1rtt(0, NGTCP2_FIXED_BIT_MASK | 0x03, 0);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_read_pkt_rx_buf(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[2][1200];
+  size_t pktlen[2];
+  ngtcp2_vec datav;
+  ngtcp2_frame fr;
+  ngtcp2_tstamp t = 0;
+  ngtcp2_callbacks callbacks;
+  conn_options opts;
+  my_user_data ud;
+  ngtcp2_strm *strm;
+  ngtcp2_ksl_it it;
+  const ngtcp2_rob_data *d;
+  ngtcp2_tpe tpe;
+  size_t i;
+  int rv;
+
+  server_default_callbacks(&callbacks);
+  callbacks.recv_stream_data = recv_stream_data;
+  callbacks.release_rx_buf = release_rx_buf;
+
+  ud = (my_user_data){0};
+
+  opts = (conn_options){
+    .callbacks = &callbacks,
+    .user_data = &ud,
+  };
+
+  /* Out-of-order stream data is referenced until it is delivered. */
+  setup_default_server_with_options(&conn, opts);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+
+  datav = (ngtcp2_vec){
+    .len = 100,
+    .base = null_data,
+  };
+
+  for (i = 0; i < ngtcp2_arraylen(buf); ++i) {
+    fr.stream = (ngtcp2_stream){
+      .type = NGTCP2_FRAME_STREAM,
+      .stream_id = 4,
+      .offset = (ngtcp2_arraylen(buf) - i - 1) * datav.len,
+      .datacnt = 1,
+      .data = &datav,
+    };
+
+    pktlen[i] = ngtcp2_tpe_write_1rtt(&tpe, buf[i], sizeof(buf[i]), &fr, 1);
+  }
+
+  rv = ngtcp2_conn_read_pkt_rx_buf(conn, &null_path.path, NULL, buf[0],
+                                   pktlen[0], buf[0], ++t);
+
+  assert_int(0, ==, rv);
+  assert_size(0, ==, ud.release_rx_buf.ncalled);
+
+  strm = ngtcp2_conn_find_stream(conn, 4);
+
+  assert_not_null(strm);
+  assert_not_null(strm->rx.rob);
+
+  it = ngtcp2_ksl_begin(&strm->rx.rob->dataksl);
+  d = ngtcp2_ksl_it_get(&it);
+
+  assert_not_null(d->rxbuf);
+  assert_ptr_equal(buf[0], d->rxbuf->user_data);
+  assert_true(d->data > buf[0]);
+  assert_true(d->data + datav.len <= buf[0] + pktlen[0]);
+
+  ud.stream_data.datalen = 0;
+
+  rv = ngtcp2_conn_read_pkt_rx_buf(conn, &null_path.path, NULL, buf[1],
+                                   pktlen[1], buf[1], ++t);
+
+  assert_int(0, ==, rv);
+  assert_size(100, ==, ud.stream_data.datalen);
+  assert_uint64(100, ==, ud.stream_data.offset);
+  assert_size(2, ==, ud.release_rx_buf.ncalled);
+  assert_ptr_equal(buf[1], ud.release_rx_buf.rx_buf);
+
+  ngtcp2_conn_del(conn);
+
+  /* Referenced receive buffer is released when connection is
+     deleted. */
+  ud = (my_user_data){0};
+
+  setup_default_server_with_options(&conn, opts);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+
+  fr.stream = (ngtcp2_stream){
+    .type = NGTCP2_FRAME_STREAM,
+    .stream_id = 4,
+    .offset = 100,
+    .datacnt = 1,
+    .data = &datav,
+  };
+
+  pktlen[0] = ngtcp2_tpe_write_1rtt(&tpe, buf[0], sizeof(buf[0]), &fr, 1);
+
+  rv = ngtcp2_conn_read_pkt_rx_buf(conn, &null_path.path, NULL, buf[0],
+                                   pktlen[0], buf[0], ++t);
+
+  assert_int(0, ==, rv);
+  assert_size(0, ==, ud.release_rx_buf.ncalled);
+
+  ngtcp2_conn_del(conn);
+
+  assert_size(1, ==, ud.release_rx_buf.ncalled);
+  assert_ptr_equal(buf[0], ud.release_rx_buf.rx_buf);
+
+  /* Out-of-order stream data is copied if the connection references
+     too many receive buffers. */
+  ud = (my_user_data){0};
+
+  setup_default_server_with_options(&conn, opts);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+
+  conn->rx.rxbuf.lim.max_nref = 0;
+
+  pktlen[0] = ngtcp2_tpe_write_1rtt(&tpe, buf[0], sizeof(buf[0]), &fr, 1);
+
+  rv = ngtcp2_conn_read_pkt_rx_buf(conn, &null_path.path, NULL, buf[0],
+                                   pktlen[0], buf[0], ++t);
+
+  assert_int(0, ==, rv);
+  assert_size(1, ==, ud.release_rx_buf.ncalled);
+
+  strm = ngtcp2_conn_find_stream(conn, 4);
+
+  assert_not_null(strm);
+  assert_not_null(strm->rx.rob);
+
+  it = ngtcp2_ksl_begin(&strm->rx.rob->dataksl);
+  d = ngtcp2_ksl_it_get(&it);
+
+  assert_null(d->rxbuf);
+  assert_uint64(0, ==, conn->rx.rxbuf.lim.nref);
+
+  ngtcp2_conn_del(conn);
+
+  assert_size(1, ==, ud.release_rx_buf.ncalled);
+}
+
+void test_ngtcp2_conn_pkt_payloadlen(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[2048];
+  size_t pktlen;
+  ngtcp2_vec datav;
+  ngtcp2_frame fr;
+  ngtcp2_tstamp t = 0;
+  uint64_t payloadlen;
+  int rv;
+  const ngtcp2_cid *dcid;
+  ngtcp2_tpe tpe;
+
+  /* Payload length is invalid */
+  setup_handshake_server(&conn);
+  ngtcp2_tpe_init_conn_handshake_server(&tpe, conn, &null_ckm);
+
+  fr.stream = (ngtcp2_stream){
+    .type = NGTCP2_FRAME_CRYPTO,
+    .datacnt = 1,
+    .data = &datav,
+  };
+  datav = (ngtcp2_vec){
+    .len = 1231,
+    .base = null_data,
+  };
+
+  pktlen = ngtcp2_tpe_write_initial(&tpe, buf, sizeof(buf), &fr, 1);
+
+  dcid = ngtcp2_conn_get_dcid2(conn);
+  payloadlen = read_pkt_payloadlen(buf, dcid, &conn->oscid);
+  write_pkt_payloadlen(buf, dcid, &conn->oscid, payloadlen + 1);
+
+  /* This first packet which does not increase initial packet number
+     space CRYPTO offset or it does not get buffered as 0RTT is an
+     error.  But it is unsecured Initial, so we just ignore it. */
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, ++t);
+
+  assert_int(NGTCP2_ERR_DROP_CONN, ==, rv);
+  assert_int((int)NGTCP2_CS_SERVER_INITIAL, ==, (int)conn->state);
+
+  ngtcp2_conn_del(conn);
+
+  /* Client Initial packet included in UDP datagram smaller than 1200
+     is discarded. */
+  setup_handshake_server(&conn);
+  ngtcp2_tpe_init_conn_handshake_server(&tpe, conn, &null_ckm);
+
+  fr.stream = (ngtcp2_stream){
+    .type = NGTCP2_FRAME_CRYPTO,
+    .datacnt = 1,
+    .data = &datav,
+  };
+  datav = (ngtcp2_vec){
+    .len = 1000,
+    .base = null_data,
+  };
+
+  pktlen = ngtcp2_tpe_write_initial(&tpe, buf, sizeof(buf), &fr, 1);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, ++t);
+
+  assert_int(NGTCP2_ERR_DROP_CONN, ==, rv);
+  assert_int((int)NGTCP2_CS_SERVER_INITIAL, ==, (int)conn->state);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_writev_stream(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[2048];
+  ngtcp2_ssize spktlen;
   ngtcp2_tstamp t = 0;
   int rv;
   int64_t stream_id;
@@ -9752,54 +10423,262 @@ void test_ngtcp2_conn_recv_datagram(void) {
   ngtcp2_conn_del(conn);
 }
 
-void test_ngtcp2_conn_recv_new_connection_id(void) {
+void test_ngtcp2_conn_recv_ack_frequency(void) {
   ngtcp2_conn *conn;
   uint8_t buf[2048];
-  size_t pktlen;
-  ngtcp2_ssize spktlen;
-  ngtcp2_tstamp t = 0;
   ngtcp2_frame fr;
-  ngtcp2_frame frs[16];
-  static const ngtcp2_cid cid = {
-    .datalen = 4,
-    .data = {0xF0, 0xF1, 0xF2, 0xF3},
-  };
-  static const ngtcp2_stateless_reset_token token = {
-    .data = {0xFF},
-  };
-  static const ngtcp2_cid cid2 = {
-    .datalen = 4,
-    .data = {0xF0, 0xF1, 0xF2, 0xF4},
-  };
-  static const ngtcp2_stateless_reset_token token2 = {
-    .data = {0xFE},
-  };
-  static const ngtcp2_cid cid3 = {
-    .datalen = 4,
-    .data = {0xF0, 0xF1, 0xF2, 0xF5},
-  };
-  static const ngtcp2_stateless_reset_token token3 = {
-    .data = {0xFD},
-  };
-  ngtcp2_dcid *dcid;
+  size_t pktlen;
   int rv;
-  ngtcp2_frame_chain *frc;
-  size_t i;
-  ngtcp2_vec datav;
   ngtcp2_tpe tpe;
   ngtcp2_transport_params params;
-  ngtcp2_callbacks callbacks;
   conn_options opts;
 
-  setup_default_client(&conn);
+  /* ACK_FREQUENCY is rejected if min_ack_delay is not advertised. */
+  setup_default_server(&conn);
   ngtcp2_tpe_init_conn(&tpe, conn);
 
-  /* This will send NEW_CONNECTION_ID frames */
-  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+  fr.ack_frequency = (ngtcp2_ack_frequency){
+    .type = NGTCP2_FRAME_ACK_FREQUENCY,
+    .ack_eliciting_thresh = 9,
+    .max_ack_delay = 50000,
+    .reordering_thresh = 3,
+  };
 
-  assert_ptrdiff(0, <, spktlen);
+  pktlen = ngtcp2_tpe_write_1rtt(&tpe, buf, sizeof(buf), &fr, 1);
 
-  fr.new_connection_id = (ngtcp2_new_connection_id){
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, 1);
+
+  assert_int(NGTCP2_ERR_PROTO, ==, rv);
+
+  ngtcp2_conn_del(conn);
+
+  /* IMMEDIATE_ACK is rejected if min_ack_delay is not advertised. */
+  setup_default_server(&conn);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+
+  fr.immediate_ack.type = NGTCP2_FRAME_IMMEDIATE_ACK;
+
+  pktlen = ngtcp2_tpe_write_1rtt(&tpe, buf, sizeof(buf), &fr, 1);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, 1);
+
+  assert_int(NGTCP2_ERR_PROTO, ==, rv);
+
+  ngtcp2_conn_del(conn);
+
+  /* ACK_FREQUENCY updates ACK behavior */
+  server_default_transport_params(&params);
+  params.min_ack_delay = NGTCP2_MILLISECONDS;
+
+  opts = (conn_options){
+    .params = &params,
+  };
+
+  setup_default_server_with_options(&conn, opts);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+
+  fr.ack_frequency = (ngtcp2_ack_frequency){
+    .type = NGTCP2_FRAME_ACK_FREQUENCY,
+    .seq = 1,
+    .ack_eliciting_thresh = 9,
+    .max_ack_delay = 50000,
+    .reordering_thresh = 3,
+  };
+
+  pktlen = ngtcp2_tpe_write_1rtt(&tpe, buf, sizeof(buf), &fr, 1);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, 1);
+
+  assert_int(0, ==, rv);
+  assert_int64(1, ==, conn->rx.ack_freq.seq);
+  assert_size(10, ==, conn->rx.ack_freq.thresh);
+  assert_uint64(50 * NGTCP2_MILLISECONDS, ==, conn->rx.ack_freq.max_ack_delay);
+  assert_uint64(3, ==, conn->rx.ack_freq.reordering_thresh);
+
+  /* ACK_FREQUENCY with an older sequence number is ignored. */
+  fr.ack_frequency = (ngtcp2_ack_frequency){
+    .type = NGTCP2_FRAME_ACK_FREQUENCY,
+    .seq = 0,
+    .ack_eliciting_thresh = 1,
+    .max_ack_delay = 2000,
+  };
+
+  pktlen = ngtcp2_tpe_write_1rtt(&tpe, buf, sizeof(buf), &fr, 1);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, 2);
+
+  assert_int(0, ==, rv);
+  assert_int64(1, ==, conn->rx.ack_freq.seq);
+  assert_size(10, ==, conn->rx.ack_freq.thresh);
+  assert_uint64(50 * NGTCP2_MILLISECONDS, ==, conn->rx.ack_freq.max_ack_delay);
+  assert_uint64(3, ==, conn->rx.ack_freq.reordering_thresh);
+
+  /* IMMEDIATE_ACK elicits an ACK without delay */
+  assert_false(conn->pktns.acktr.flags & NGTCP2_ACKTR_FLAG_IMMEDIATE_ACK);
+
+  fr.immediate_ack.type = NGTCP2_FRAME_IMMEDIATE_ACK;
+
+  pktlen = ngtcp2_tpe_write_1rtt(&tpe, buf, sizeof(buf), &fr, 1);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, 3);
+
+  assert_int(0, ==, rv);
+  assert_true(conn->pktns.acktr.flags & NGTCP2_ACKTR_FLAG_IMMEDIATE_ACK);
+
+  ngtcp2_conn_del(conn);
+
+  /* Requested Max Ack Delay is smaller than min_ack_delay */
+  setup_default_server_with_options(&conn, opts);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+
+  fr.ack_frequency = (ngtcp2_ack_frequency){
+    .type = NGTCP2_FRAME_ACK_FREQUENCY,
+    .ack_eliciting_thresh = 1,
+    .max_ack_delay = 999,
+  };
+
+  pktlen = ngtcp2_tpe_write_1rtt(&tpe, buf, sizeof(buf), &fr, 1);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, NULL, buf, pktlen, 1);
+
+  assert_int(NGTCP2_ERR_PROTO, ==, rv);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_submit_ack_frequency(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[2048];
+  ngtcp2_ssize spktlen;
+  int rv;
+  ngtcp2_transport_params remote_params;
+  conn_options opts;
+  ngtcp2_frame_chain *frc;
+  ngtcp2_ksl_it it;
+  ngtcp2_rtb_entry *ent;
+  size_t i;
+
+  /* Remote endpoint does not support ACK Frequency extension */
+  setup_default_client(&conn);
+
+  rv = ngtcp2_conn_submit_ack_frequency(conn, 9, 25 * NGTCP2_MILLISECONDS, 1);
+
+  assert_int(NGTCP2_ERR_INVALID_STATE, ==, rv);
+
+  ngtcp2_conn_del(conn);
+
+  client_default_remote_transport_params(&remote_params);
+  remote_params.max_ack_delay = NGTCP2_DEFAULT_MAX_ACK_DELAY;
+  remote_params.min_ack_delay = NGTCP2_MILLISECONDS;
+
+  opts = (conn_options){
+    .remote_params = &remote_params,
+  };
+
+  setup_default_client_with_options(&conn, opts);
+
+  rv = ngtcp2_conn_submit_ack_frequency(conn, 9, 999 * NGTCP2_MICROSECONDS,
+                                        1);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==, rv);
+
+  rv = ngtcp2_conn_submit_ack_frequency(conn, 9, 16384 * NGTCP2_MILLISECONDS,
+                                        1);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==, rv);
+
+  rv = ngtcp2_conn_submit_ack_frequency(conn, 9, 25 * NGTCP2_MILLISECONDS, 1);
+
+  assert_int(0, ==, rv);
+  assert_int64(0, ==, conn->tx.ack_freq.seq);
+  assert_uint64(25 * NGTCP2_MILLISECONDS, ==, conn->tx.ack_freq.max_ack_delay);
+
+  frc = conn->pktns.tx.frq;
+
+  assert_not_null(frc);
+  assert_uint64(NGTCP2_FRAME_ACK_FREQUENCY, ==, frc->fr.hd.type);
+  assert_uint64(0, ==, frc->fr.ack_frequency.seq);
+  assert_uint64(9, ==, frc->fr.ack_frequency.ack_eliciting_thresh);
+  assert_uint64(25000, ==, frc->fr.ack_frequency.max_ack_delay);
+  assert_uint64(1, ==, frc->fr.ack_frequency.reordering_thresh);
+
+  /* A newer request supersedes the older one. */
+  rv = ngtcp2_conn_submit_ack_frequency(conn, 1, 5 * NGTCP2_MILLISECONDS, 0);
+
+  assert_int(0, ==, rv);
+  assert_int64(1, ==, conn->tx.ack_freq.seq);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), 1);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_null(conn->pktns.tx.frq);
+
+  it = ngtcp2_rtb_head(&conn->pktns.rtb);
+  ent = ngtcp2_ksl_it_get(&it);
+
+  for (i = 0, frc = ent->frc; frc; frc = frc->next) {
+    if (frc->fr.hd.type != NGTCP2_FRAME_ACK_FREQUENCY) {
+      continue;
+    }
+
+    assert_uint64(1, ==, frc->fr.ack_frequency.seq);
+
+    ++i;
+  }
+
+  assert_size(1, ==, i);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_recv_new_connection_id(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[2048];
+  size_t pktlen;
+  ngtcp2_ssize spktlen;
+  ngtcp2_tstamp t = 0;
+  ngtcp2_frame fr;
+  ngtcp2_frame frs[16];
+  static const ngtcp2_cid cid = {
+    .datalen = 4,
+    .data = {0xF0, 0xF1, 0xF2, 0xF3},
+  };
+  static const ngtcp2_stateless_reset_token token = {
+    .data = {0xFF},
+  };
+  static const ngtcp2_cid cid2 = {
+    .datalen = 4,
+    .data = {0xF0, 0xF1, 0xF2, 0xF4},
+  };
+  static const ngtcp2_stateless_reset_token token2 = {
+    .data = {0xFE},
+  };
+  static const ngtcp2_cid cid3 = {
+    .datalen = 4,
+    .data = {0xF0, 0xF1, 0xF2, 0xF5},
+  };
+  static const ngtcp2_stateless_reset_token token3 = {
+    .data = {0xFD},
+  };
+  ngtcp2_dcid *dcid;
+  int rv;
+  ngtcp2_frame_chain *frc;
+  size_t i;
+  ngtcp2_vec datav;
+  ngtcp2_tpe tpe;
+  ngtcp2_transport_params params;
+  ngtcp2_callbacks callbacks;
+  conn_options opts;
+
+  setup_default_client(&conn);
+  ngtcp2_tpe_init_conn(&tpe, conn);
+
+  /* This will send NEW_CONNECTION_ID frames */
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  fr.new_connection_id = (ngtcp2_new_connection_id){
     .type = NGTCP2_FRAME_NEW_CONNECTION_ID,
     .seq = 1,
     .cid = cid,
@@ -18555,6 +19434,9 @@ void test_ngtcp2_conn_write_aggregate_pkt(void) {
   int rv;
   size_t pktlen;
   ngtcp2_tpe tpe;
+  ngtcp2_callbacks callbacks;
+  uint8_t batched[16384];
+  size_t batchedlen;
 
   opt = (conn_options){
     .user_data = &ud,
@@ -18751,90 +19633,379 @@ void test_ngtcp2_conn_write_aggregate_pkt(void) {
   assert_size(9, ==, ud.write_pkt.num_write_left);
 
   ngtcp2_conn_del(conn);
-}
-
-void test_ngtcp2_conn_crumble_initial_pkt(void) {
-  ngtcp2_conn *conn;
-  uint8_t tls_rawbuf[4096] = {0};
-  ngtcp2_buf tls_buf;
-  int rv;
-  ngtcp2_tstamp t = 0;
-  uint8_t buf[1200];
-  ngtcp2_ssize spktlen;
-  ngtcp2_ssize slen;
-  ngtcp2_pkt_hd hd;
-  ngtcp2_frame_decoder frd;
-  ngtcp2_frame fr;
-  uint64_t offset;
-  uint8_t *p;
-  size_t len;
-  ngtcp2_frame_chain *frc;
-  ngtcp2_ksl_it it;
-  ngtcp2_rtb_entry *ent;
-  ngtcp2_callbacks callbacks;
-  conn_options opts;
-  uint8_t *end_data;
-
-  ngtcp2_buf_init(&tls_buf, tls_rawbuf, sizeof(tls_rawbuf));
-
-  /* msg_type */
-  *tls_buf.last++ = 1;
-  /* length */
-  tls_buf.last = ngtcp2_put_uint24be(tls_buf.last, 1000);
-  /* legacy_version */
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 0x0303);
-  /* random */
-  tls_buf.last += 32;
-  /* legacy_session_id */
-  *tls_buf.last++ = 23;
-  tls_buf.last += 23;
-  /* cipher_suites */
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 125);
-  tls_buf.last += 125;
-  /* legacy_compression_methods */
-  *tls_buf.last++ = 7;
-  tls_buf.last += 7;
-  /* extensions */
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 400);
-  /* extension 1 */
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 999);
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 120);
-  tls_buf.last += 120;
-  /* extension 2 */
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 65530);
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 0);
-  /* server_name extension */
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 0);
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 15);
-  /* server_name_list */
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 13);
-  /* name_type */
-  *tls_buf.last++ = 0;
-  /* name */
-  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 10);
-  tls_buf.last += 10;
 
-  /* Crumble client Initial CRYPTO frame */
+  /* Header protection is applied in batch if hp_mask_batch is
+     set. */
   client_default_callbacks(&callbacks);
-  callbacks.client_initial = client_initial_null;
+  callbacks.hp_mask = sample_hp_mask;
+  callbacks.hp_mask_batch = sample_hp_mask_batch;
 
-  opts = (conn_options){
+  opt = (conn_options){
     .callbacks = &callbacks,
+    .user_data = &ud,
   };
 
-  setup_handshake_client_with_options(&conn, opts);
-  conn->flags |= NGTCP2_CONN_FLAG_CRUMBLE_INITIAL_CRYPTO;
+  setup_default_client_with_options(&conn, opt);
+  ngtcp2_path_storage_zero(&ps);
+  pi = (ngtcp2_pkt_info){0};
 
-  rv = ngtcp2_conn_submit_crypto_data(conn, NGTCP2_ENCRYPTION_LEVEL_INITIAL,
-                                      tls_buf.pos, ngtcp2_buf_len(&tls_buf));
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
 
   assert_int(0, ==, rv);
 
-  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
-
-  assert_ssize(0, <, spktlen);
+  ud.write_pkt.stream_id = stream_id;
+  ud.write_pkt.num_write_left = 10;
+  hp_mask_batch_stat.ncalled = 0;
+  hp_mask_batch_stat.nsamples = 0;
 
-  slen = ngtcp2_pkt_decode_hd_long(&hd, buf, (size_t)spktlen);
+  spktlen = ngtcp2_conn_write_aggregate_pkt(conn, &ps.path, &pi, buf,
+                                            sizeof(buf), &gsolen, write_pkt, t);
+
+  assert_ptrdiff(
+    (ngtcp2_ssize)ngtcp2_conn_get_path_max_tx_udp_payload_size2(conn) * 8, ==,
+    spktlen);
+  assert_size(1, ==, hp_mask_batch_stat.ncalled);
+  assert_size(8, ==, hp_mask_batch_stat.nsamples);
+  assert_size(0, ==, conn->tx.hp_batch.len);
+  assert_false(conn->flags & NGTCP2_CONN_FLAG_DEFER_HP);
+  assert_size(sizeof(batched), >=, (size_t)spktlen);
+
+  batchedlen = (size_t)spktlen;
+  memcpy(batched, buf, batchedlen);
+
+  ngtcp2_conn_del(conn);
+
+  /* The batched masks are applied to the same packets as
+     ngtcp2_hp_mask does. */
+  callbacks.hp_mask_batch = NULL;
+
+  setup_default_client_with_options(&conn, opt);
+  ngtcp2_path_storage_zero(&ps);
+  pi = (ngtcp2_pkt_info){0};
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  ud.write_pkt.stream_id = stream_id;
+  ud.write_pkt.num_write_left = 10;
+  hp_mask_batch_stat.ncalled = 0;
+
+  spktlen = ngtcp2_conn_write_aggregate_pkt(conn, &ps.path, &pi, buf,
+                                            sizeof(buf), &gsolen, write_pkt, t);
+
+  assert_ptrdiff((ngtcp2_ssize)batchedlen, ==, spktlen);
+  assert_size(0, ==, hp_mask_batch_stat.ncalled);
+  assert_memory_equal(batchedlen, batched, buf);
+
+  ngtcp2_conn_del(conn);
+
+  /* Packets written outside of aggregation are protected
+     immediately. */
+  callbacks.hp_mask_batch = sample_hp_mask_batch;
+
+  setup_default_client_with_options(&conn, opt);
+  ngtcp2_path_storage_zero(&ps);
+  pi = (ngtcp2_pkt_info){0};
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  ud.write_pkt.stream_id = stream_id;
+  ud.write_pkt.num_write_left = 2;
+  hp_mask_batch_stat.ncalled = 0;
+  hp_mask_batch_stat.nsamples = 0;
+
+  spktlen = ngtcp2_conn_write_aggregate_pkt(conn, &ps.path, &pi, buf,
+                                            sizeof(buf), &gsolen, write_pkt, t);
+
+  assert_ptrdiff(
+    (ngtcp2_ssize)ngtcp2_conn_get_path_max_tx_udp_payload_size2(conn) * 2, ==,
+    spktlen);
+  assert_size(1, ==, hp_mask_batch_stat.ncalled);
+  assert_size(2, ==, hp_mask_batch_stat.nsamples);
+
+  /* Wait for pacing */
+  t = conn->tx.pacing.next_ts;
+  ud.write_pkt.num_write_left = 1;
+  hp_mask_batch_stat.ncalled = 0;
+
+  spktlen = write_pkt(conn, NULL, NULL, buf, sizeof(buf), t, &ud);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_size(0, ==, ud.write_pkt.num_write_left);
+  assert_size(0, ==, hp_mask_batch_stat.ncalled);
+  assert_size(0, ==, conn->tx.hp_batch.len);
+  assert_false(conn->flags & NGTCP2_CONN_FLAG_DEFER_HP);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_write_aggregate_pkt_txtime(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[65536];
+  ngtcp2_ssize spktlen;
+  ngtcp2_path_storage ps;
+  ngtcp2_pkt_info pi;
+  ngtcp2_tstamp t = 0;
+  ngtcp2_tstamp txtime, next_ts;
+  int64_t stream_id;
+  my_user_data ud;
+  conn_options opt;
+  size_t gsolen;
+  size_t pktlen;
+  size_t burstlen;
+  size_t i;
+  int rv;
+
+  opt = (conn_options){
+    .user_data = &ud,
+  };
+
+  setup_default_client_with_options(&conn, opt);
+  ngtcp2_path_storage_zero(&ps);
+  pi = (ngtcp2_pkt_info){0};
+
+  /* 1 nanosecond per byte */
+  conn->cstat.pacing_interval_m = 1 << 10;
+  pktlen = ngtcp2_conn_get_path_max_tx_udp_payload_size2(conn);
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  ud.write_pkt.stream_id = stream_id;
+  ud.write_pkt.num_write_left = 10;
+
+  spktlen = ngtcp2_conn_write_aggregate_pkt_txtime(
+    conn, &ps.path, &pi, buf, sizeof(buf), &gsolen, &txtime, write_pkt, 2, 0,
+    t);
+
+  assert_ptrdiff((ngtcp2_ssize)pktlen * 2, ==, spktlen);
+  assert_size(pktlen, ==, gsolen);
+  assert_uint64(t, ==, txtime);
+  assert_uint64(t + pktlen * 2, ==, conn->tx.pacing.next_ts);
+  assert_size(0, ==, conn->tx.pacing.pktlen);
+  assert_uint64(0, ==, conn->tx.pacing.horizon);
+  assert_uint64(conn->tx.pacing.next_ts, ==, ngtcp2_conn_get_expiry2(conn));
+
+  /* Without horizon, pacing blocks the next write. */
+  spktlen = ngtcp2_conn_write_aggregate_pkt_txtime(
+    conn, &ps.path, &pi, buf, sizeof(buf), &gsolen, &txtime, write_pkt, 2, 0,
+    t);
+
+  assert_ptrdiff(0, ==, spktlen);
+  assert_size(8, ==, ud.write_pkt.num_write_left);
+
+  /* Horizon is too short to reach the next departure time. */
+  spktlen = ngtcp2_conn_write_aggregate_pkt_txtime(
+    conn, &ps.path, &pi, buf, sizeof(buf), &gsolen, &txtime, write_pkt, 2,
+    pktlen * 2 - 1, t);
+
+  assert_ptrdiff(0, ==, spktlen);
+  assert_size(8, ==, ud.write_pkt.num_write_left);
+
+  /* Packets ahead of the schedule are stamped with their departure
+     time. */
+  next_ts = conn->tx.pacing.next_ts;
+
+  spktlen = ngtcp2_conn_write_aggregate_pkt_txtime(
+    conn, &ps.path, &pi, buf, sizeof(buf), &gsolen, &txtime, write_pkt, 2,
+    NGTCP2_MILLISECONDS, t);
+
+  assert_ptrdiff((ngtcp2_ssize)pktlen * 2, ==, spktlen);
+  assert_uint64(next_ts, ==, txtime);
+  assert_uint64(next_ts + pktlen * 2, ==, conn->tx.pacing.next_ts);
+  assert_uint64(0, ==, conn->tx.pacing.horizon);
+  assert_size(6, ==, ud.write_pkt.num_write_left);
+
+  /* Late wakeup sends packets immediately.  The next burst is not
+     brought forward to make up for the delay because the kernel
+     sends it at its departure time. */
+  t = conn->tx.pacing.next_ts + 100;
+
+  spktlen = ngtcp2_conn_write_aggregate_pkt_txtime(
+    conn, &ps.path, &pi, buf, sizeof(buf), &gsolen, &txtime, write_pkt, 1,
+    NGTCP2_MILLISECONDS, t);
+
+  assert_ptrdiff((ngtcp2_ssize)pktlen, ==, spktlen);
+  assert_uint64(t, ==, txtime);
+  assert_uint64(t + pktlen, ==, conn->tx.pacing.next_ts);
+  assert_uint64(0, ==, conn->tx.pacing.compensation);
+  assert_size(5, ==, ud.write_pkt.num_write_left);
+
+  /* Bursts written in a row within the horizon are at least one
+     pacing interval apart. */
+  next_ts = txtime;
+  burstlen = pktlen;
+
+  for (i = 0; i < 2; ++i) {
+    spktlen = ngtcp2_conn_write_aggregate_pkt_txtime(
+      conn, &ps.path, &pi, buf, sizeof(buf), &gsolen, &txtime, write_pkt, 2,
+      NGTCP2_MILLISECONDS, t);
+
+    assert_ptrdiff(0, <, spktlen);
+    assert_uint64(next_ts + burstlen, <=, txtime);
+    assert_uint64(txtime + (size_t)spktlen, ==, conn->tx.pacing.next_ts);
+
+    next_ts = txtime;
+    burstlen = (size_t)spktlen;
+  }
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_write_stream_encryptv(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[1200], expected[1200];
+  uint8_t data[1024];
+  ngtcp2_ssize spktlen, expectedlen;
+  ngtcp2_ssize datalen, expected_datalen;
+  ngtcp2_tstamp t = 0;
+  int64_t stream_id;
+  ngtcp2_callbacks callbacks;
+  conn_options opts;
+  size_t i;
+  int rv;
+
+  for (i = 0; i < sizeof(data); ++i) {
+    data[i] = (uint8_t)i;
+  }
+
+  /* Write a packet with stream data copied into the buffer. */
+  setup_default_client(&conn);
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  expectedlen = ngtcp2_conn_write_stream(
+    conn, NULL, NULL, expected, sizeof(expected), &expected_datalen,
+    NGTCP2_WRITE_STREAM_FLAG_NONE, stream_id, data, sizeof(data), ++t);
+
+  assert_ptrdiff(0, <, expectedlen);
+  assert_ptrdiff(0, <, expected_datalen);
+
+  ngtcp2_conn_del(conn);
+
+  /* The same packet is produced by encryptv without copying stream
+     data. */
+  client_default_callbacks(&callbacks);
+  callbacks.encryptv = null_encryptv;
+
+  opts = (conn_options){
+    .callbacks = &callbacks,
+  };
+
+  setup_default_client_with_options(&conn, opts);
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  encryptv_stat.ncalled = 0;
+  encryptv_stat.data = data;
+  encryptv_stat.data_found = 0;
+
+  t = 0;
+
+  spktlen = ngtcp2_conn_write_stream(
+    conn, NULL, NULL, buf, sizeof(buf), &datalen,
+    NGTCP2_WRITE_STREAM_FLAG_NONE, stream_id, data, sizeof(data), ++t);
+
+  assert_ptrdiff(expectedlen, ==, spktlen);
+  assert_ptrdiff(expected_datalen, ==, datalen);
+  assert_memory_equal((size_t)spktlen, expected, buf);
+  assert_size(1, ==, encryptv_stat.ncalled);
+  assert_size(2, <=, encryptv_stat.plaintextcnt);
+  assert_true(encryptv_stat.data_found);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_crumble_initial_pkt(void) {
+  ngtcp2_conn *conn;
+  uint8_t tls_rawbuf[4096] = {0};
+  ngtcp2_buf tls_buf;
+  int rv;
+  ngtcp2_tstamp t = 0;
+  uint8_t buf[1200];
+  ngtcp2_ssize spktlen;
+  ngtcp2_ssize slen;
+  ngtcp2_pkt_hd hd;
+  ngtcp2_frame_decoder frd;
+  ngtcp2_frame fr;
+  uint64_t offset;
+  uint8_t *p;
+  size_t len;
+  ngtcp2_frame_chain *frc;
+  ngtcp2_ksl_it it;
+  ngtcp2_rtb_entry *ent;
+  ngtcp2_callbacks callbacks;
+  conn_options opts;
+  uint8_t *end_data;
+
+  ngtcp2_buf_init(&tls_buf, tls_rawbuf, sizeof(tls_rawbuf));
+
+  /* msg_type */
+  *tls_buf.last++ = 1;
+  /* length */
+  tls_buf.last = ngtcp2_put_uint24be(tls_buf.last, 1000);
+  /* legacy_version */
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 0x0303);
+  /* random */
+  tls_buf.last += 32;
+  /* legacy_session_id */
+  *tls_buf.last++ = 23;
+  tls_buf.last += 23;
+  /* cipher_suites */
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 125);
+  tls_buf.last += 125;
+  /* legacy_compression_methods */
+  *tls_buf.last++ = 7;
+  tls_buf.last += 7;
+  /* extensions */
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 400);
+  /* extension 1 */
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 999);
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 120);
+  tls_buf.last += 120;
+  /* extension 2 */
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 65530);
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 0);
+  /* server_name extension */
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 0);
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 15);
+  /* server_name_list */
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 13);
+  /* name_type */
+  *tls_buf.last++ = 0;
+  /* name */
+  tls_buf.last = ngtcp2_put_uint16be(tls_buf.last, 10);
+  tls_buf.last += 10;
+
+  /* Crumble client Initial CRYPTO frame */
+  client_default_callbacks(&callbacks);
+  callbacks.client_initial = client_initial_null;
+
+  opts = (conn_options){
+    .callbacks = &callbacks,
+  };
+
+  setup_handshake_client_with_options(&conn, opts);
+  conn->flags |= NGTCP2_CONN_FLAG_CRUMBLE_INITIAL_CRYPTO;
+
+  rv = ngtcp2_conn_submit_crypto_data(conn, NGTCP2_ENCRYPTION_LEVEL_INITIAL,
+                                      tls_buf.pos, ngtcp2_buf_len(&tls_buf));
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+
+  assert_ssize(0, <, spktlen);
+
+  slen = ngtcp2_pkt_decode_hd_long(&hd, buf, (size_t)spktlen);
 
   assert_ptrdiff(0, <, slen);
   assert_uint8(NGTCP2_PKT_INITIAL, ==, hd.type);
@@ -19555,6 +20726,549 @@ void test_ngtcp2_conn_post_handshake_failmalloc(void) {
   assert_size(nmalloc, ==, n);
 }
 
+void test_ngtcp2_conn_handshake_arena(void) {
+  ngtcp2_conn *conn;
+  failmalloc mc;
+  ngtcp2_mem mem;
+  ngtcp2_settings settings;
+  conn_options opts;
+  size_t nmalloc;
+
+  setup_failmalloc_mem(&mem, &mc);
+
+  server_default_settings(&settings);
+
+  opts = (conn_options){
+    .settings = &settings,
+    .mem = &mem,
+  };
+
+  /* Without arena */
+  mc.nmalloc = 0;
+  mc.fail_start = SIZE_MAX;
+
+  setup_default_server_with_options(&conn, opts);
+
+  nmalloc = mc.nmalloc;
+
+  assert_ptr_equal(&mem, conn->hs_mem);
+  assert_null(conn->hs_arena.head);
+
+  ngtcp2_conn_del(conn);
+
+  /* With arena */
+  settings.handshake_arena = 1;
+
+  mc.nmalloc = 0;
+
+  setup_default_server_with_options(&conn, opts);
+
+  assert_size(nmalloc, >, mc.nmalloc);
+  assert_ptr_equal(&conn->hs_arena_mem, conn->hs_mem);
+  assert_null(conn->in_pktns);
+  assert_not_null(conn->hs_pktns);
+  assert_not_null(conn->hs_arena.head);
+
+  ngtcp2_conn_discard_handshake_state(conn, 0);
+
+  assert_null(conn->hs_pktns);
+  assert_null(conn->hs_arena.head);
+
+  ngtcp2_conn_del(conn);
+
+  /* Connection is deleted while the arena is still in use */
+  setup_handshake_server_with_options(&conn, opts);
+
+  assert_not_null(conn->in_pktns);
+  assert_not_null(conn->hs_arena.head);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_objpool(void) {
+  ngtcp2_conn *conn;
+  ngtcp2_objpool *pool;
+  ngtcp2_objpool_stat stat;
+  failmalloc mc;
+  ngtcp2_mem mem;
+  ngtcp2_settings settings;
+  conn_options opts;
+  size_t nmalloc;
+  size_t ncached;
+  int rv;
+
+  setup_failmalloc_mem(&mem, &mc);
+
+  mc.nmalloc = 0;
+  mc.fail_start = SIZE_MAX;
+
+  rv = ngtcp2_objpool_new(&pool, SIZE_MAX, &mem);
+
+  assert_int(0, ==, rv);
+
+  server_default_settings(&settings);
+  settings.handshake_arena = 1;
+  settings.objpool = pool;
+
+  opts = (conn_options){
+    .settings = &settings,
+    .mem = &mem,
+  };
+
+  mc.nmalloc = 0;
+
+  setup_default_server_with_options(&conn, opts);
+
+  nmalloc = mc.nmalloc;
+
+  ngtcp2_conn_del(conn);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_uint64(0, ==, stat.nhit);
+  assert_uint64(0, <, stat.nmiss);
+  assert_size(stat.nmiss, ==, stat.ncached);
+
+  /* The second connection reuses the memory blocks released by the
+     first one. */
+  mc.nmalloc = 0;
+
+  setup_default_server_with_options(&conn, opts);
+
+  assert_size(nmalloc - stat.nmiss, ==, mc.nmalloc);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_uint64(0, <, stat.nhit);
+
+  /* The handshake arena returns its memory blocks to the pool when
+     the handshake state is discarded. */
+  ncached = stat.ncached;
+
+  ngtcp2_conn_discard_handshake_state(conn, 0);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_size(ncached, <, stat.ncached);
+
+  ngtcp2_conn_del(conn);
+
+  ngtcp2_objpool_del(pool);
+}
+
+/*
+ * find_max_data_frame returns the MAX_DATA frame in the most recently
+ * sent packet.
+ */
+static ngtcp2_frame_chain *find_max_data_frame(ngtcp2_conn *conn) {
+  ngtcp2_ksl_it it = ngtcp2_rtb_head(&conn->pktns.rtb);
+  ngtcp2_rtb_entry *ent = ngtcp2_ksl_it_get(&it);
+  ngtcp2_frame_chain *frc;
+
+  for (frc = ent->frc; frc; frc = frc->next) {
+    if (frc->fr.hd.type == NGTCP2_FRAME_MAX_DATA) {
+      return frc;
+    }
+  }
+
+  return NULL;
+}
+
+void test_ngtcp2_conn_rx_budget(void) {
+  ngtcp2_conn *conn;
+  ngtcp2_rx_budget *budget;
+  ngtcp2_settings settings;
+  ngtcp2_transport_params params;
+  conn_options opts;
+  ngtcp2_frame_chain *frc;
+  uint8_t buf[1200];
+  ngtcp2_ssize spktlen;
+  ngtcp2_tstamp t = 0;
+  int rv;
+
+  rv = ngtcp2_rx_budget_new(&budget, 600, NULL);
+
+  assert_int(0, ==, rv);
+
+  server_default_settings(&settings);
+  settings.max_window = 1000000;
+  settings.rx_budget = budget;
+
+  server_default_transport_params(&params);
+  params.initial_max_data = 1000;
+
+  opts = (conn_options){
+    .settings = &settings,
+    .params = &params,
+  };
+
+  setup_default_server_with_options(&conn, opts);
+
+  /* The first MAX_DATA does not grow the window. */
+  ngtcp2_conn_extend_max_offset(conn, 1000);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  frc = find_max_data_frame(conn);
+
+  assert_not_null(frc);
+  assert_uint64(2000, ==, frc->fr.max_data.max_data);
+  assert_uint64(1000, ==, conn->rx.window);
+  assert_uint64(0, ==, ngtcp2_rx_budget_get_used(budget));
+
+  /* The window growth is capped by the budget. */
+  ngtcp2_conn_extend_max_offset(conn, 1000);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  frc = find_max_data_frame(conn);
+
+  assert_not_null(frc);
+  assert_uint64(3600, ==, frc->fr.max_data.max_data);
+  assert_uint64(1600, ==, conn->rx.window);
+  assert_uint64(600, ==, conn->rx.budget_used);
+  assert_uint64(600, ==, ngtcp2_rx_budget_get_used(budget));
+
+  /* The budget is exhausted, and the window shrinks. */
+  ngtcp2_conn_extend_max_offset(conn, 1000);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  frc = find_max_data_frame(conn);
+
+  assert_not_null(frc);
+  assert_uint64(4100, ==, frc->fr.max_data.max_data);
+  assert_uint64(1100, ==, conn->rx.window);
+  assert_uint64(100, ==, conn->rx.budget_used);
+  assert_uint64(100, ==, ngtcp2_rx_budget_get_used(budget));
+
+  ngtcp2_conn_del(conn);
+
+  assert_uint64(0, ==, ngtcp2_rx_budget_get_used(budget));
+
+  ngtcp2_rx_budget_del(budget);
+}
+
+void test_ngtcp2_conn_timerq(void) {
+  ngtcp2_conn *conn;
+  ngtcp2_conn *conns[2];
+  ngtcp2_timerq *timerq;
+  ngtcp2_settings settings;
+  conn_options opts;
+  uint8_t buf[1200];
+  uint8_t abuf[65536];
+  ngtcp2_ssize spktlen;
+  ngtcp2_tstamp t = 0, expiry, txtime;
+  int64_t stream_id;
+  size_t nconns;
+  size_t gsolen;
+  my_user_data ud;
+  int rv;
+
+  rv = ngtcp2_timerq_new(&timerq, NGTCP2_MILLISECONDS, NULL);
+
+  assert_int(0, ==, rv);
+
+  client_default_settings(&settings);
+  settings.timerq = timerq;
+
+  opts = (conn_options){
+    .settings = &settings,
+  };
+
+  setup_default_client_with_options(&conn, opts);
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  spktlen =
+    ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf), NULL,
+                             NGTCP2_WRITE_STREAM_FLAG_NONE, stream_id,
+                             null_data, 100, ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  expiry = ngtcp2_conn_get_expiry2(conn);
+
+  assert_uint64(UINT64_MAX, >, expiry);
+  assert_uint64(expiry, ==, conn->timerq_ent.expiry);
+  assert_size(1, ==, timerq->len);
+
+  /* The timer wheel might wake up the application earlier than the
+     deadline to cascade the slots. */
+  for (;;) {
+    t = ngtcp2_timerq_get_expiry(timerq);
+
+    assert_uint64(expiry + NGTCP2_MILLISECONDS, >, t);
+
+    nconns =
+      ngtcp2_timerq_pop_expired(timerq, conns, ngtcp2_arraylen(conns), t);
+    if (nconns) {
+      break;
+    }
+  }
+
+  assert_size(1, ==, nconns);
+  assert_ptr_equal(conn, conns[0]);
+  assert_uint64(expiry, <=, t);
+  assert_size(0, ==, timerq->len);
+
+  rv = ngtcp2_conn_handle_expiry(conn, expiry);
+
+  assert_int(0, ==, rv);
+  assert_size(1, ==, timerq->len);
+  assert_uint64(ngtcp2_conn_get_expiry2(conn), ==, conn->timerq_ent.expiry);
+
+  ngtcp2_conn_del(conn);
+
+  assert_size(0, ==, timerq->len);
+
+  /* Pacing deadline is scheduled in the timer queue. */
+  t = 0;
+
+  opts = (conn_options){
+    .settings = &settings,
+    .user_data = &ud,
+  };
+
+  setup_default_client_with_options(&conn, opts);
+
+  /* 1 nanosecond per byte */
+  conn->cstat.pacing_interval_m = 1 << 10;
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  ud.write_pkt.stream_id = stream_id;
+  ud.write_pkt.num_write_left = 2;
+
+  spktlen = ngtcp2_conn_write_aggregate_pkt(conn, NULL, NULL, abuf,
+                                            sizeof(abuf), &gsolen, write_pkt,
+                                            ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_uint64(UINT64_MAX, >, conn->tx.pacing.next_ts);
+  assert_uint64(conn->tx.pacing.next_ts, ==, conn->timerq_ent.expiry);
+  assert_size(1, ==, timerq->len);
+
+  ud.write_pkt.num_write_left = 2;
+
+  spktlen = ngtcp2_conn_write_aggregate_pkt_txtime(
+    conn, NULL, NULL, abuf, sizeof(abuf), &gsolen, &txtime, write_pkt, 2,
+    NGTCP2_MILLISECONDS, t);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_uint64(t, <, txtime);
+  assert_uint64(conn->tx.pacing.next_ts, ==, conn->timerq_ent.expiry);
+
+  /* Stopping PMTUD and changing keep-alive timeout reschedule the
+     connection. */
+  ngtcp2_conn_stop_pmtud(conn);
+
+  assert_uint64(conn->tx.pacing.next_ts, ==, conn->timerq_ent.expiry);
+
+  ngtcp2_conn_set_keep_alive_timeout(conn, 1);
+
+  assert_uint64(t + 1, ==, conn->timerq_ent.expiry);
+
+  ngtcp2_conn_del(conn);
+
+  assert_size(0, ==, timerq->len);
+
+  ngtcp2_timerq_del(timerq);
+}
+
+void test_ngtcp2_conn_poll_expiry(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[1200];
+  ngtcp2_ssize spktlen;
+  ngtcp2_tstamp t = 0, expiry;
+  int64_t stream_id;
+  int rv;
+
+  setup_default_client(&conn);
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  spktlen =
+    ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf), NULL,
+                             NGTCP2_WRITE_STREAM_FLAG_NONE, stream_id,
+                             null_data, 100, ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  /* Writing a packet does not compute the expiry.  It is computed
+     when it is asked, and cached by ngtcp2_conn_poll_expiry. */
+  assert_true(conn->flags & NGTCP2_CONN_FLAG_EXPIRY_STALE);
+  assert_uint64(UINT64_MAX, >, ngtcp2_conn_get_expiry2(conn));
+  assert_true(conn->flags & NGTCP2_CONN_FLAG_EXPIRY_STALE);
+  assert_true(ngtcp2_conn_poll_expiry(conn, &expiry));
+  assert_false(conn->flags & NGTCP2_CONN_FLAG_EXPIRY_STALE);
+  assert_uint64(conn->expiry.ts, ==, expiry);
+  assert_uint64(expiry, ==, ngtcp2_conn_get_expiry2(conn));
+  assert_false(ngtcp2_conn_poll_expiry(conn, &expiry));
+  assert_uint64(conn->expiry.ts, ==, expiry);
+
+  /* Nothing to send does not change the expiry. */
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), t);
+
+  assert_ptrdiff(0, ==, spktlen);
+  assert_true(conn->flags & NGTCP2_CONN_FLAG_EXPIRY_STALE);
+  assert_false(ngtcp2_conn_poll_expiry(conn, &expiry));
+
+  /* Keep-alive timer makes the expiry stale, and it is recomputed
+     lazily. */
+  ngtcp2_conn_set_keep_alive_timeout(conn, NGTCP2_MILLISECONDS);
+
+  assert_true(conn->flags & NGTCP2_CONN_FLAG_EXPIRY_STALE);
+  assert_uint64(t + NGTCP2_MILLISECONDS, ==, ngtcp2_conn_get_expiry2(conn));
+  assert_true(conn->flags & NGTCP2_CONN_FLAG_EXPIRY_STALE);
+  assert_true(ngtcp2_conn_poll_expiry(conn, &expiry));
+  assert_uint64(t + NGTCP2_MILLISECONDS, ==, expiry);
+  assert_false(conn->flags & NGTCP2_CONN_FLAG_EXPIRY_STALE);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_cid_table(void) {
+  ngtcp2_conn *conn;
+  ngtcp2_cid_table *table;
+  ngtcp2_settings settings;
+  conn_options opts;
+  static const uint8_t key[NGTCP2_CID_TABLE_KEYLEN];
+  static const ngtcp2_cid dcid = make_dcid();
+  static const ngtcp2_cid scid = make_scid();
+  ngtcp2_transport_params params;
+  int user_data;
+  uint8_t buf[1200];
+  ngtcp2_ssize spktlen;
+  ngtcp2_ksl_it it;
+  ngtcp2_scid *ent;
+  ngtcp2_callbacks callbacks;
+  ngtcp2_cid other_cid;
+  int other_user_data;
+  int rv;
+
+  rv = ngtcp2_cid_table_new(&table, scid.datalen, key, NULL);
+
+  assert_int(0, ==, rv);
+
+  server_default_settings(&settings);
+  settings.cid_table = table;
+
+  opts = (conn_options){
+    .settings = &settings,
+    .user_data = &user_data,
+  };
+
+  setup_default_server_with_options(&conn, opts);
+
+  assert_size(1, ==, ngtcp2_cid_table_size(table));
+  assert_ptr_equal(&user_data, ngtcp2_cid_table_find(table, scid.data));
+
+  /* Connection IDs issued by NEW_CONNECTION_ID are registered. */
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), 1);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_size(1, <, ngtcp2_ksl_len(&conn->scid.set));
+  assert_size(ngtcp2_ksl_len(&conn->scid.set), ==,
+              ngtcp2_cid_table_size(table));
+
+  for (it = ngtcp2_ksl_begin(&conn->scid.set); !ngtcp2_ksl_it_end(&it);
+       ngtcp2_ksl_it_next(&it)) {
+    ent = ngtcp2_ksl_it_get(&it);
+
+    assert_ptr_equal(&user_data, ngtcp2_cid_table_find(table, ent->cid.data));
+  }
+
+  ngtcp2_conn_del(conn);
+
+  assert_size(0, ==, ngtcp2_cid_table_size(table));
+
+  /* A Connection ID which is used by another connection is generated
+     again. */
+  server_default_callbacks(&callbacks);
+  callbacks.get_new_connection_id2 = get_new_connection_id_gen;
+  callbacks.remove_connection_id = remove_connection_id_gen;
+
+  opts.callbacks = &callbacks;
+
+  cid_gen.next = 0;
+  cid_gen.step = 1;
+  cid_gen.nremoved = 0;
+
+  other_cid = (ngtcp2_cid){
+    .datalen = scid.datalen,
+    .data = {0xFF, 0},
+  };
+
+  rv = ngtcp2_cid_table_insert(table, &other_cid, &other_user_data);
+
+  assert_int(0, ==, rv);
+
+  setup_default_server_with_options(&conn, opts);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), 1);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_size(1, <, ngtcp2_ksl_len(&conn->scid.set));
+  assert_size(ngtcp2_ksl_len(&conn->scid.set) + 1, ==,
+              ngtcp2_cid_table_size(table));
+  assert_ptr_equal(&other_user_data,
+                   ngtcp2_cid_table_find(table, other_cid.data));
+  /* The rejected Connection ID is reported to the application. */
+  assert_size(1, ==, cid_gen.nremoved);
+
+  it = ngtcp2_ksl_lower_bound(&conn->scid.set, &other_cid);
+
+  assert_true(ngtcp2_ksl_it_end(&it) ||
+              !ngtcp2_cid_eq(ngtcp2_ksl_it_key(&it), &other_cid));
+
+  ngtcp2_conn_del(conn);
+
+  assert_size(1, ==, ngtcp2_cid_table_size(table));
+
+  /* The connection fails if it keeps generating a Connection ID which
+     is used by another connection. */
+  cid_gen.next = 0;
+  cid_gen.step = 0;
+  cid_gen.nremoved = 0;
+
+  setup_default_server_with_options(&conn, opts);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), 1);
+
+  assert_ptrdiff(NGTCP2_ERR_CALLBACK_FAILURE, ==, spktlen);
+  assert_size(1, ==, ngtcp2_ksl_len(&conn->scid.set));
+  assert_size(NGTCP2_MAX_SCID_REGEN, ==, cid_gen.nremoved);
+
+  ngtcp2_conn_del(conn);
+
+  assert_size(1, ==, ngtcp2_cid_table_size(table));
+
+  /* user_data must not be NULL if the table is set. */
+  server_default_transport_params(&params);
+
+  rv = ngtcp2_conn_server_new(&conn, &dcid, &scid, &null_path.path,
+                              NGTCP2_PROTO_VER_V1, &callbacks, &settings,
+                              &params, NULL, NULL);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==, rv);
+  assert_size(1, ==, ngtcp2_cid_table_size(table));
+
+  ngtcp2_cid_table_del(table);
+}
+
 void test_ngtcp2_accept(void) {
   size_t pktlen;
   uint8_t buf[2048];
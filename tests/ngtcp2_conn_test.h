@@ -41,6 +41,7 @@ munit_void_test_decl(test_ngtcp2_conn_stream_open_close)
 munit_void_test_decl(test_ngtcp2_conn_stream_rx_flow_control)
 munit_void_test_decl(test_ngtcp2_conn_stream_rx_flow_control_error)
 munit_void_test_decl(test_ngtcp2_conn_stream_tx_flow_control)
+munit_void_test_decl(test_ngtcp2_conn_stream_priority)
 munit_void_test_decl(test_ngtcp2_conn_rx_flow_control)
 munit_void_test_decl(test_ngtcp2_conn_rx_flow_control_error)
 munit_void_test_decl(test_ngtcp2_conn_tx_flow_control)
@@ -70,10 +71,14 @@ munit_void_test_decl(test_ngtcp2_conn_recv_max_stream_data)
 munit_void_test_decl(test_ngtcp2_conn_send_early_data)
 munit_void_test_decl(test_ngtcp2_conn_recv_early_data)
 munit_void_test_decl(test_ngtcp2_conn_recv_compound_pkt)
+munit_void_test_decl(test_ngtcp2_conn_read_pkts)
+munit_void_test_decl(test_ngtcp2_conn_read_pkt_rx_buf)
 munit_void_test_decl(test_ngtcp2_conn_pkt_payloadlen)
 munit_void_test_decl(test_ngtcp2_conn_writev_stream)
 munit_void_test_decl(test_ngtcp2_conn_writev_datagram)
 munit_void_test_decl(test_ngtcp2_conn_recv_datagram)
+munit_void_test_decl(test_ngtcp2_conn_recv_ack_frequency)
+munit_void_test_decl(test_ngtcp2_conn_submit_ack_frequency)
 munit_void_test_decl(test_ngtcp2_conn_recv_new_connection_id)
 munit_void_test_decl(test_ngtcp2_conn_recv_retire_connection_id)
 munit_void_test_decl(test_ngtcp2_conn_server_path_validation)
@@ -123,12 +128,20 @@ munit_void_test_decl(test_ngtcp2_conn_ack_padding)
 munit_void_test_decl(test_ngtcp2_conn_super_small_rtt)
 munit_void_test_decl(test_ngtcp2_conn_recv_ack)
 munit_void_test_decl(test_ngtcp2_conn_write_aggregate_pkt)
+munit_void_test_decl(test_ngtcp2_conn_write_aggregate_pkt_txtime)
+munit_void_test_decl(test_ngtcp2_conn_write_stream_encryptv)
 munit_void_test_decl(test_ngtcp2_conn_crumble_initial_pkt)
 munit_void_test_decl(test_ngtcp2_conn_skip_pkt_num)
 munit_void_test_decl(test_ngtcp2_conn_get_timestamp)
 munit_void_test_decl(test_ngtcp2_conn_get_stream_user_data)
 munit_void_test_decl(test_ngtcp2_conn_new_failmalloc)
 munit_void_test_decl(test_ngtcp2_conn_post_handshake_failmalloc)
+munit_void_test_decl(test_ngtcp2_conn_handshake_arena)
+munit_void_test_decl(test_ngtcp2_conn_objpool)
+munit_void_test_decl(test_ngtcp2_conn_rx_budget)
+munit_void_test_decl(test_ngtcp2_conn_timerq)
+munit_void_test_decl(test_ngtcp2_conn_poll_expiry)
+munit_void_test_decl(test_ngtcp2_conn_cid_table)
 munit_void_test_decl(test_ngtcp2_accept)
 munit_void_test_decl(test_ngtcp2_select_version)
 munit_void_test_decl(test_ngtcp2_pkt_write_connection_close)
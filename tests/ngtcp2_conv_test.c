@@ -33,6 +33,7 @@
 static const MunitTest tests[] = {
   munit_void_test(test_ngtcp2_get_varint),
   munit_void_test(test_ngtcp2_get_uvarintlen),
+  munit_void_test(test_ngtcp2_get_uvarintv),
   munit_void_test(test_ngtcp2_put_uvarintlen),
   munit_void_test(test_ngtcp2_get_uint64be),
   munit_void_test(test_ngtcp2_get_uint32be),
@@ -174,6 +175,49 @@ void test_ngtcp2_get_uvarintlen(void) {
   assert_size(8, ==, ngtcp2_get_uvarintlen(&c));
 }
 
+void test_ngtcp2_get_uvarintv(void) {
+  uint8_t buf[256];
+  uint8_t *p;
+  const uint8_t *q;
+  uint64_t v[16];
+  size_t i;
+
+  /* Mixed lengths */
+  p = buf;
+  for (i = 0; i < 9; ++i) {
+    p = ngtcp2_put_uvarint(p, i);
+  }
+  p = ngtcp2_put_uvarint(p, 16383);
+  p = ngtcp2_put_uvarint(p, 1073741823);
+  p = ngtcp2_put_uvarint(p, 4611686018427387903ULL);
+  p = ngtcp2_put_uvarint(p, 63);
+
+  q = ngtcp2_get_uvarintv(v, 13, buf, p);
+
+  assert_ptr_equal(p, q);
+
+  for (i = 0; i < 9; ++i) {
+    assert_uint64(i, ==, v[i]);
+  }
+
+  assert_uint64(16383, ==, v[9]);
+  assert_uint64(1073741823, ==, v[10]);
+  assert_uint64(4611686018427387903ULL, ==, v[11]);
+  assert_uint64(63, ==, v[12]);
+
+  /* Buffer is too short */
+  assert_null(ngtcp2_get_uvarintv(v, 13, buf, p - 1));
+  assert_null(ngtcp2_get_uvarintv(v, 14, buf, p));
+
+  /* Truncated integer */
+  p = ngtcp2_put_uvarint(buf, 1073741823);
+
+  assert_null(ngtcp2_get_uvarintv(v, 1, buf, p - 1));
+
+  /* n == 0 */
+  assert_ptr_equal(buf, ngtcp2_get_uvarintv(v, 0, buf, buf));
+}
+
 void test_ngtcp2_get_uint64be(void) {
   uint8_t buf[256];
   const uint8_t *p;
@@ -37,6 +37,7 @@ extern const MunitSuite conv_suite;
 
 munit_void_test_decl(test_ngtcp2_get_varint)
 munit_void_test_decl(test_ngtcp2_get_uvarintlen)
+munit_void_test_decl(test_ngtcp2_get_uvarintv)
 munit_void_test_decl(test_ngtcp2_put_uvarintlen)
 munit_void_test_decl(test_ngtcp2_get_uint64be)
 munit_void_test_decl(test_ngtcp2_get_uint32be)
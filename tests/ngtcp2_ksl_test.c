@@ -37,6 +37,7 @@ static const MunitTest tests[] = {
   munit_void_test(test_ngtcp2_ksl_dup),
   munit_void_test(test_ngtcp2_ksl_remove_hint),
   munit_void_test(test_ngtcp2_ksl_remove),
+  munit_void_test(test_ngtcp2_ksl_bsearch),
   munit_test_end(),
 };
 
@@ -558,3 +559,69 @@ void test_ngtcp2_ksl_remove(void) {
   assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==,
              ngtcp2_ksl_remove(&ksl, NULL, &key));
 }
+
+ngtcp2_ksl_search_def(linear_int64_greater, ngtcp2_ksl_int64_greater)
+ngtcp2_ksl_bsearch_def(binary_int64_greater, ngtcp2_ksl_int64_greater)
+ngtcp2_ksl_search_def(linear_range_exclusive,
+                      ngtcp2_ksl_range_exclusive_compar)
+ngtcp2_ksl_bsearch_def(binary_range_exclusive,
+                       ngtcp2_ksl_range_exclusive_compar)
+
+void test_ngtcp2_ksl_bsearch(void) {
+  ngtcp2_ksl ksl;
+  const ngtcp2_mem *mem = ngtcp2_mem_default();
+  int64_t key;
+  ngtcp2_range r;
+  size_t i, n;
+
+  /* Compare binary search against linear scan for every block size
+     that a single leaf block can have. */
+  for (n = 0; n <= NGTCP2_KSL_MAX_NBLK; ++n) {
+    ngtcp2_ksl_init(&ksl, ngtcp2_ksl_int64_greater,
+                    ngtcp2_ksl_int64_greater_search, sizeof(int64_t), mem);
+
+    for (i = 0; i < n; ++i) {
+      key = (int64_t)i * 2;
+      assert_int(0, ==, ngtcp2_ksl_insert(&ksl, NULL, &key, NULL));
+    }
+
+    if (n) {
+      assert_true(ksl.root->leaf);
+      assert_uint32((uint32_t)n, ==, ksl.root->n);
+
+      for (key = -1; key <= (int64_t)n * 2; ++key) {
+        assert_size(ksl_linear_int64_greater_search(&ksl, ksl.root, &key), ==,
+                    ksl_binary_int64_greater_search(&ksl, ksl.root, &key));
+      }
+    }
+
+    ngtcp2_ksl_free(&ksl);
+
+    ngtcp2_ksl_init(&ksl, ngtcp2_ksl_range_exclusive_compar,
+                    ngtcp2_ksl_range_exclusive_search, sizeof(ngtcp2_range),
+                    mem);
+
+    for (i = 0; i < n; ++i) {
+      r = (ngtcp2_range){
+        .begin = i * 10,
+        .end = i * 10 + 5,
+      };
+      assert_int(0, ==, ngtcp2_ksl_insert(&ksl, NULL, &r, NULL));
+    }
+
+    if (n) {
+      for (i = 0; i <= n * 10; ++i) {
+        r = (ngtcp2_range){
+          .begin = i,
+          .end = i + 3,
+        };
+
+        assert_size(
+          ksl_linear_range_exclusive_search(&ksl, ksl.root, &r), ==,
+          ksl_binary_range_exclusive_search(&ksl, ksl.root, &r));
+      }
+    }
+
+    ngtcp2_ksl_free(&ksl);
+  }
+}
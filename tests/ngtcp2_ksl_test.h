@@ -42,5 +42,6 @@ munit_void_test_decl(test_ngtcp2_ksl_update_key_range)
 munit_void_test_decl(test_ngtcp2_ksl_dup)
 munit_void_test_decl(test_ngtcp2_ksl_remove_hint)
 munit_void_test_decl(test_ngtcp2_ksl_remove)
+munit_void_test_decl(test_ngtcp2_ksl_bsearch)
 
 #endif /* !defined(NGTCP2_KSL_TEST_H) */
@@ -0,0 +1,164 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_objpool_test.h"
+
+#include <stdio.h>
+
+#include "ngtcp2_objpool.h"
+#include "ngtcp2_balloc.h"
+#include "ngtcp2_test_helper.h"
+
+static const MunitTest tests[] = {
+  munit_void_test(test_ngtcp2_objpool_get_put_block),
+  munit_void_test(test_ngtcp2_objpool_balloc),
+  munit_test_end(),
+};
+
+const MunitSuite objpool_suite = {
+  "/objpool", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE,
+};
+
+void test_ngtcp2_objpool_get_put_block(void) {
+  ngtcp2_objpool *pool;
+  ngtcp2_objpool_stat stat;
+  void *a, *b, *c;
+  int rv;
+
+  rv = ngtcp2_objpool_new(&pool, 256, NULL);
+
+  assert_int(0, ==, rv);
+
+  a = ngtcp2_objpool_get_block(pool, 128);
+  b = ngtcp2_objpool_get_block(pool, 128);
+  c = ngtcp2_objpool_get_block(pool, 64);
+
+  assert_not_null(a);
+  assert_not_null(b);
+  assert_not_null(c);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_uint64(0, ==, stat.nhit);
+  assert_uint64(3, ==, stat.nmiss);
+  assert_size(0, ==, stat.ncached);
+
+  ngtcp2_objpool_put_block(pool, a, 128);
+  ngtcp2_objpool_put_block(pool, c, 64);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_size(2, ==, stat.ncached);
+  assert_size(192, ==, stat.cached_bytes);
+
+  /* Exceeds max_cached_bytes */
+  ngtcp2_objpool_put_block(pool, b, 128);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_uint64(1, ==, stat.ndiscard);
+  assert_size(2, ==, stat.ncached);
+  assert_size(192, ==, stat.cached_bytes);
+
+  /* Cached block is reused only for the same size */
+  b = ngtcp2_objpool_get_block(pool, 128);
+
+  assert_ptr_equal(a, b);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_uint64(1, ==, stat.nhit);
+  assert_size(1, ==, stat.ncached);
+  assert_size(64, ==, stat.cached_bytes);
+
+  a = ngtcp2_objpool_get_block(pool, 32);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_uint64(1, ==, stat.nhit);
+  assert_uint64(4, ==, stat.nmiss);
+
+  ngtcp2_objpool_put_block(pool, a, 32);
+  ngtcp2_objpool_put_block(pool, b, 128);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_size(3, ==, stat.ncached);
+  assert_size(224, ==, stat.cached_bytes);
+
+  ngtcp2_objpool_del(pool);
+}
+
+void test_ngtcp2_objpool_balloc(void) {
+  ngtcp2_objpool *pool;
+  ngtcp2_objpool_stat stat;
+  ngtcp2_balloc balloc1, balloc2;
+  const ngtcp2_mem *mem = ngtcp2_mem_default();
+  void *p, *blk;
+  int rv;
+
+  rv = ngtcp2_objpool_new(&pool, SIZE_MAX, mem);
+
+  assert_int(0, ==, rv);
+
+  ngtcp2_balloc_init(&balloc1, 1024, mem);
+  ngtcp2_balloc_set_objpool(&balloc1, pool);
+
+  rv = ngtcp2_balloc_get(&balloc1, &p, 1000);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_balloc_get(&balloc1, &p, 1000);
+
+  assert_int(0, ==, rv);
+
+  /* The oldest block is at the top of the pool after balloc1 is
+     freed. */
+  blk = balloc1.head->next;
+
+  ngtcp2_balloc_free(&balloc1);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_uint64(2, ==, stat.nmiss);
+  assert_size(2, ==, stat.ncached);
+
+  /* Another allocator takes the block released by balloc1. */
+  ngtcp2_balloc_init(&balloc2, 1024, mem);
+  ngtcp2_balloc_set_objpool(&balloc2, pool);
+
+  rv = ngtcp2_balloc_get(&balloc2, &p, 16);
+
+  assert_int(0, ==, rv);
+  assert_ptr_equal(blk, balloc2.head);
+
+  ngtcp2_objpool_get_stat(pool, &stat);
+
+  assert_uint64(1, ==, stat.nhit);
+  assert_uint64(2, ==, stat.nmiss);
+  assert_size(1, ==, stat.ncached);
+
+  ngtcp2_balloc_free(&balloc2);
+  ngtcp2_objpool_del(pool);
+}
@@ -63,6 +63,8 @@ static const MunitTest tests[] = {
   munit_void_test(test_ngtcp2_pkt_encode_retire_connection_id_frame),
   munit_void_test(test_ngtcp2_pkt_encode_handshake_done_frame),
   munit_void_test(test_ngtcp2_pkt_encode_datagram_frame),
+  munit_void_test(test_ngtcp2_pkt_encode_ack_frequency_frame),
+  munit_void_test(test_ngtcp2_pkt_encode_immediate_ack_frame),
   munit_void_test(test_ngtcp2_pkt_adjust_pkt_num),
   munit_void_test(test_ngtcp2_pkt_validate_ack),
   munit_void_test(test_ngtcp2_pkt_write_stateless_reset),
@@ -1847,6 +1849,81 @@ void test_ngtcp2_pkt_encode_datagram_frame(void) {
   assert_size(fr.datacnt, ==, nfr.datacnt);
 }
 
+void test_ngtcp2_pkt_encode_ack_frequency_frame(void) {
+  uint8_t buf[256];
+  ngtcp2_ack_frequency fr, nfr;
+  ngtcp2_frame nframe;
+  ngtcp2_frame_decoder frd;
+  ngtcp2_ssize rv;
+  size_t framelen;
+  size_t i;
+
+  fr = (ngtcp2_ack_frequency){
+    .type = NGTCP2_FRAME_ACK_FREQUENCY,
+    .seq = 1000000007,
+    .ack_eliciting_thresh = 9,
+    .max_ack_delay = 16383 * 1000,
+    .reordering_thresh = 3,
+  };
+
+  framelen = 2 + ngtcp2_put_uvarintlen(fr.seq) +
+             ngtcp2_put_uvarintlen(fr.ack_eliciting_thresh) +
+             ngtcp2_put_uvarintlen(fr.max_ack_delay) +
+             ngtcp2_put_uvarintlen(fr.reordering_thresh);
+
+  rv = ngtcp2_pkt_encode_ack_frequency_frame(buf, sizeof(buf), &fr);
+
+  assert_ptrdiff((ngtcp2_ssize)framelen, ==, rv);
+
+  rv = ngtcp2_pkt_decode_ack_frequency_frame(&nfr, buf, framelen);
+
+  assert_ptrdiff((ngtcp2_ssize)framelen, ==, rv);
+  assert_uint64(fr.type, ==, nfr.type);
+  assert_uint64(fr.seq, ==, nfr.seq);
+  assert_uint64(fr.ack_eliciting_thresh, ==, nfr.ack_eliciting_thresh);
+  assert_uint64(fr.max_ack_delay, ==, nfr.max_ack_delay);
+  assert_uint64(fr.reordering_thresh, ==, nfr.reordering_thresh);
+
+  /* Fail if a frame is truncated. */
+  for (i = 1; i < framelen; ++i) {
+    rv = ngtcp2_pkt_decode_ack_frequency_frame(&nfr, buf, i);
+
+    assert_ptrdiff(NGTCP2_ERR_FRAME_ENCODING, ==, rv);
+  }
+
+  /* Decode through ngtcp2_frame_decoder */
+  rv = ngtcp2_frame_decoder_decode(&frd, &nframe, buf, framelen);
+
+  assert_ptrdiff((ngtcp2_ssize)framelen, ==, rv);
+  assert_uint64(NGTCP2_FRAME_ACK_FREQUENCY, ==, nframe.hd.type);
+  assert_uint64(fr.seq, ==, nframe.ack_frequency.seq);
+  assert_uint64(fr.max_ack_delay, ==, nframe.ack_frequency.max_ack_delay);
+}
+
+void test_ngtcp2_pkt_encode_immediate_ack_frame(void) {
+  uint8_t buf[16];
+  ngtcp2_immediate_ack fr = {
+    .type = NGTCP2_FRAME_IMMEDIATE_ACK,
+  };
+  ngtcp2_frame nframe;
+  ngtcp2_frame_decoder frd;
+  ngtcp2_ssize rv;
+
+  rv = ngtcp2_pkt_encode_immediate_ack_frame(buf, 0, &fr);
+
+  assert_ptrdiff(NGTCP2_ERR_NOBUF, ==, rv);
+
+  rv = ngtcp2_pkt_encode_immediate_ack_frame(buf, sizeof(buf), &fr);
+
+  assert_ptrdiff(1, ==, rv);
+  assert_uint8(NGTCP2_FRAME_IMMEDIATE_ACK, ==, buf[0]);
+
+  rv = ngtcp2_frame_decoder_decode(&frd, &nframe, buf, 1);
+
+  assert_ptrdiff(1, ==, rv);
+  assert_uint64(NGTCP2_FRAME_IMMEDIATE_ACK, ==, nframe.hd.type);
+}
+
 void test_ngtcp2_pkt_adjust_pkt_num(void) {
   assert_int64(0xAA831F94ULL, ==,
                ngtcp2_pkt_adjust_pkt_num(0xAA82F30EULL, 0x1F94, 2));
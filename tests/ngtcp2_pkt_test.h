@@ -65,6 +65,8 @@ munit_void_test_decl(test_ngtcp2_pkt_encode_new_token_frame)
 munit_void_test_decl(test_ngtcp2_pkt_encode_retire_connection_id_frame)
 munit_void_test_decl(test_ngtcp2_pkt_encode_handshake_done_frame)
 munit_void_test_decl(test_ngtcp2_pkt_encode_datagram_frame)
+munit_void_test_decl(test_ngtcp2_pkt_encode_ack_frequency_frame)
+munit_void_test_decl(test_ngtcp2_pkt_encode_immediate_ack_frame)
 munit_void_test_decl(test_ngtcp2_pkt_adjust_pkt_num)
 munit_void_test_decl(test_ngtcp2_pkt_validate_ack)
 munit_void_test_decl(test_ngtcp2_pkt_write_stateless_reset)
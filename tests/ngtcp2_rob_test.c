@@ -35,6 +35,8 @@ static const MunitTest tests[] = {
   munit_void_test(test_ngtcp2_rob_push_random),
   munit_void_test(test_ngtcp2_rob_data_at),
   munit_void_test(test_ngtcp2_rob_remove_prefix),
+  munit_void_test(test_ngtcp2_rob_push_rxbuf),
+  munit_void_test(test_ngtcp2_rob_push_rxbuf_limit),
   munit_test_end(),
 };
 
@@ -598,3 +600,261 @@ void test_ngtcp2_rob_remove_prefix(void) {
 
   ngtcp2_rob_free(&rob);
 }
+
+static void rxbuf_release(ngtcp2_rxbuf *rxbuf) { ++*(size_t *)rxbuf->ctx; }
+
+void test_ngtcp2_rob_push_rxbuf(void) {
+  const ngtcp2_mem *mem = ngtcp2_mem_default();
+  ngtcp2_rob rob;
+  ngtcp2_rxbuf rxbuf1, rxbuf2;
+  size_t nrelease = 0;
+  ngtcp2_ssize nwrite;
+  uint8_t data[256];
+  size_t i;
+  const uint8_t *p;
+  uint64_t len;
+  ngtcp2_ksl_it it;
+  const ngtcp2_range *r;
+  const ngtcp2_rob_data *d;
+
+  for (i = 0; i < sizeof(data); ++i) {
+    data[i] = (uint8_t)i;
+  }
+
+  ngtcp2_rob_init(&rob, 16, mem);
+  ngtcp2_rxbuf_init(&rxbuf1, rxbuf_release, &nrelease, NULL, 10, NULL);
+  ngtcp2_rxbuf_init(&rxbuf2, rxbuf_release, &nrelease, NULL, 3, NULL);
+
+  /* Data is referenced rather than copied. */
+  nwrite = ngtcp2_rob_push_rxbuf(&rob, 20, &data[20], 10, &rxbuf1);
+
+  assert_ptrdiff(10, ==, nwrite);
+  assert_size(2, ==, rxbuf1.ref);
+
+  /* Chunks do not overlap referenced data. */
+  nwrite = ngtcp2_rob_push(&rob, 3, &data[3], 27);
+
+  assert_ptrdiff(17, ==, nwrite);
+
+  it = ngtcp2_ksl_begin(&rob.dataksl);
+  r = ngtcp2_ksl_it_key(&it);
+
+  assert_uint64(0, ==, r->begin);
+  assert_uint64(16, ==, r->end);
+
+  ngtcp2_ksl_it_next(&it);
+  r = ngtcp2_ksl_it_key(&it);
+
+  assert_uint64(16, ==, r->begin);
+  assert_uint64(20, ==, r->end);
+
+  ngtcp2_ksl_it_next(&it);
+  r = ngtcp2_ksl_it_key(&it);
+  d = ngtcp2_ksl_it_get(&it);
+
+  assert_uint64(20, ==, r->begin);
+  assert_uint64(30, ==, r->end);
+  assert_ptr_equal(&data[20], d->data);
+  assert_ptr_equal(&rxbuf1, d->rxbuf);
+
+  /* Data which falls into an existing chunk is copied. */
+  nwrite = ngtcp2_rob_push_rxbuf(&rob, 0, &data[0], 3, &rxbuf2);
+
+  assert_ptrdiff(3, ==, nwrite);
+  assert_size(1, ==, rxbuf2.ref);
+
+  len = ngtcp2_rob_data_at(&rob, &p, 0);
+
+  assert_uint64(16, ==, len);
+
+  for (i = 0; i < len; ++i) {
+    assert_uint8((uint8_t)i, ==, *(p + i));
+  }
+
+  ngtcp2_rob_pop(&rob, 0, len);
+
+  len = ngtcp2_rob_data_at(&rob, &p, 16);
+
+  assert_uint64(4, ==, len);
+
+  for (i = 0; i < len; ++i) {
+    assert_uint8((uint8_t)(16 + i), ==, *(p + i));
+  }
+
+  ngtcp2_rob_pop(&rob, 16, len);
+
+  len = ngtcp2_rob_data_at(&rob, &p, 20);
+
+  assert_uint64(10, ==, len);
+  assert_ptr_equal(&data[20], p);
+
+  ngtcp2_rob_pop(&rob, 20, len);
+
+  assert_size(1, ==, rxbuf1.ref);
+  assert_size(0, ==, nrelease);
+
+  ngtcp2_rxbuf_decref(&rxbuf1);
+
+  assert_size(1, ==, nrelease);
+
+  ngtcp2_rob_free(&rob);
+
+  /* Removing data or freeing ngtcp2_rob drops the references. */
+  nrelease = 0;
+
+  ngtcp2_rob_init(&rob, 16, mem);
+  ngtcp2_rxbuf_init(&rxbuf1, rxbuf_release, &nrelease, NULL, 10, NULL);
+
+  nwrite = ngtcp2_rob_push_rxbuf(&rob, 40, &data[40], 5, &rxbuf1);
+
+  assert_ptrdiff(5, ==, nwrite);
+
+  nwrite = ngtcp2_rob_push_rxbuf(&rob, 50, &data[50], 5, &rxbuf1);
+
+  assert_ptrdiff(5, ==, nwrite);
+  assert_size(3, ==, rxbuf1.ref);
+
+  ngtcp2_rob_remove_prefix(&rob, 45);
+
+  assert_size(2, ==, rxbuf1.ref);
+
+  ngtcp2_rob_free(&rob);
+
+  assert_size(1, ==, rxbuf1.ref);
+
+  ngtcp2_rxbuf_decref(&rxbuf1);
+
+  assert_size(1, ==, nrelease);
+}
+
+void test_ngtcp2_rob_push_rxbuf_limit(void) {
+  const ngtcp2_mem *mem = ngtcp2_mem_default();
+  ngtcp2_rob rob;
+  ngtcp2_rxbuf rxbuf[3];
+  ngtcp2_rxbuf_lim lim;
+  size_t nrelease = 0;
+  ngtcp2_ssize nwrite;
+  uint8_t data[256];
+  size_t i;
+  const uint8_t *p;
+  uint64_t len;
+  ngtcp2_ksl_it it;
+  const ngtcp2_rob_data *d;
+
+  for (i = 0; i < sizeof(data); ++i) {
+    data[i] = (uint8_t)i;
+  }
+
+  /* Data shorter than the half of the receive buffer is copied. */
+  ngtcp2_rob_init(&rob, 16, mem);
+  ngtcp2_rxbuf_init(&rxbuf[0], rxbuf_release, &nrelease, NULL, 100, NULL);
+
+  nwrite = ngtcp2_rob_push_rxbuf(&rob, 20, &data[20], 49, &rxbuf[0]);
+
+  assert_ptrdiff(49, ==, nwrite);
+  assert_size(1, ==, rxbuf[0].ref);
+  assert_uint64(0, ==, rob.rxbuf_lim.nbytes);
+  assert_size(0, ==, rob.rxbuf_lim.nref);
+
+  it = ngtcp2_ksl_begin(&rob.dataksl);
+  d = ngtcp2_ksl_it_get(&it);
+
+  assert_null(d->rxbuf);
+
+  nwrite = ngtcp2_rob_push_rxbuf(&rob, 100, &data[100], 50, &rxbuf[0]);
+
+  assert_ptrdiff(50, ==, nwrite);
+  assert_size(2, ==, rxbuf[0].ref);
+  assert_uint64(100, ==, rob.rxbuf_lim.nbytes);
+  assert_size(1, ==, rob.rxbuf_lim.nref);
+
+  ngtcp2_rob_free(&rob);
+
+  assert_size(1, ==, rxbuf[0].ref);
+
+  /* The limit of ngtcp2_rob is exceeded. */
+  ngtcp2_rob_init(&rob, 16, mem);
+  rob.rxbuf_lim.max_nref = 1;
+
+  for (i = 0; i < 2; ++i) {
+    ngtcp2_rxbuf_init(&rxbuf[i], rxbuf_release, &nrelease, NULL, 10, NULL);
+  }
+
+  nwrite = ngtcp2_rob_push_rxbuf(&rob, 20, &data[20], 10, &rxbuf[0]);
+
+  assert_ptrdiff(10, ==, nwrite);
+  assert_size(2, ==, rxbuf[0].ref);
+
+  nwrite = ngtcp2_rob_push_rxbuf(&rob, 40, &data[40], 10, &rxbuf[1]);
+
+  assert_ptrdiff(10, ==, nwrite);
+  assert_size(1, ==, rxbuf[1].ref);
+  assert_size(1, ==, rob.rxbuf_lim.nref);
+
+  it = ngtcp2_ksl_begin(&rob.dataksl);
+  d = ngtcp2_ksl_it_get(&it);
+
+  assert_ptr_equal(&rxbuf[0], d->rxbuf);
+
+  ngtcp2_ksl_it_next(&it);
+  d = ngtcp2_ksl_it_get(&it);
+
+  assert_null(d->rxbuf);
+
+  ngtcp2_rob_free(&rob);
+
+  /* The limit shared by receive buffers is exceeded. */
+  ngtcp2_rob_init(&rob, 16, mem);
+  ngtcp2_rxbuf_lim_init(&lim, 20, 16);
+
+  for (i = 0; i < 3; ++i) {
+    ngtcp2_rxbuf_init(&rxbuf[i], rxbuf_release, &nrelease, NULL, 10, &lim);
+  }
+
+  for (i = 0; i < 3; ++i) {
+    nwrite = ngtcp2_rob_push_rxbuf(&rob, 20 + i * 20, &data[20 + i * 20], 10,
+                                   &rxbuf[i]);
+
+    assert_ptrdiff(10, ==, nwrite);
+  }
+
+  assert_size(2, ==, rxbuf[0].ref);
+  assert_size(2, ==, rxbuf[1].ref);
+  assert_size(1, ==, rxbuf[2].ref);
+  assert_uint64(20, ==, lim.nbytes);
+  assert_size(2, ==, lim.nref);
+
+  /* Removing data releases the limit. */
+  nwrite = ngtcp2_rob_push(&rob, 0, &data[0], 20);
+
+  assert_ptrdiff(20, ==, nwrite);
+
+  len = ngtcp2_rob_data_at(&rob, &p, 0);
+
+  assert_uint64(16, ==, len);
+
+  ngtcp2_rob_pop(&rob, 0, len);
+
+  len = ngtcp2_rob_data_at(&rob, &p, 16);
+
+  assert_uint64(4, ==, len);
+
+  ngtcp2_rob_pop(&rob, 16, len);
+
+  len = ngtcp2_rob_data_at(&rob, &p, 20);
+
+  assert_uint64(10, ==, len);
+  assert_ptr_equal(&data[20], p);
+
+  ngtcp2_rob_pop(&rob, 20, len);
+
+  assert_size(1, ==, rxbuf[0].ref);
+  assert_uint64(10, ==, lim.nbytes);
+  assert_size(1, ==, lim.nref);
+
+  ngtcp2_rob_free(&rob);
+
+  assert_size(1, ==, rxbuf[1].ref);
+  assert_uint64(0, ==, lim.nbytes);
+  assert_size(0, ==, lim.nref);
+}
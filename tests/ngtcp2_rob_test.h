@@ -39,5 +39,7 @@ munit_void_test_decl(test_ngtcp2_rob_push)
 munit_void_test_decl(test_ngtcp2_rob_push_random)
 munit_void_test_decl(test_ngtcp2_rob_data_at)
 munit_void_test_decl(test_ngtcp2_rob_remove_prefix)
+munit_void_test_decl(test_ngtcp2_rob_push_rxbuf)
+munit_void_test_decl(test_ngtcp2_rob_push_rxbuf_limit)
 
 #endif /* !defined(NGTCP2_ROB_TEST_H) */
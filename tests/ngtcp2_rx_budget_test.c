@@ -0,0 +1,82 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_rx_budget_test.h"
+
+#include <stdio.h>
+
+#include "ngtcp2_rx_budget.h"
+#include "ngtcp2_test_helper.h"
+
+static const MunitTest tests[] = {
+  munit_void_test(test_ngtcp2_rx_budget_acquire_release),
+  munit_test_end(),
+};
+
+const MunitSuite rx_budget_suite = {
+  "/rx_budget", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE,
+};
+
+void test_ngtcp2_rx_budget_acquire_release(void) {
+  ngtcp2_rx_budget *budget;
+  int rv;
+
+  rv = ngtcp2_rx_budget_new(&budget, 1024, NULL);
+
+  assert_int(0, ==, rv);
+  assert_uint64(0, ==, ngtcp2_rx_budget_get_used(budget));
+  assert_false(ngtcp2_rx_budget_under_pressure(budget));
+
+  assert_uint64(512, ==, ngtcp2_rx_budget_acquire(budget, 512));
+  assert_uint64(512, ==, ngtcp2_rx_budget_get_used(budget));
+  assert_false(ngtcp2_rx_budget_under_pressure(budget));
+
+  /* Only the room left is granted. */
+  assert_uint64(512, ==, ngtcp2_rx_budget_acquire(budget, 1000));
+  assert_uint64(1024, ==, ngtcp2_rx_budget_get_used(budget));
+  assert_true(ngtcp2_rx_budget_under_pressure(budget));
+  assert_uint64(0, ==, ngtcp2_rx_budget_acquire(budget, 1));
+
+  /* The room left is 1/8 of the limit. */
+  ngtcp2_rx_budget_release(budget, 128);
+
+  assert_uint64(896, ==, ngtcp2_rx_budget_get_used(budget));
+  assert_false(ngtcp2_rx_budget_under_pressure(budget));
+
+  ngtcp2_rx_budget_release(budget, 127);
+
+  /* Lowering the limit below the usage puts the budget under
+     pressure. */
+  ngtcp2_rx_budget_set_limit(budget, 512);
+
+  assert_true(ngtcp2_rx_budget_under_pressure(budget));
+  assert_uint64(0, ==, ngtcp2_rx_budget_acquire(budget, 1));
+
+  ngtcp2_rx_budget_release(budget, 769);
+
+  assert_uint64(0, ==, ngtcp2_rx_budget_get_used(budget));
+  assert_false(ngtcp2_rx_budget_under_pressure(budget));
+
+  ngtcp2_rx_budget_del(budget);
+}
@@ -823,8 +823,8 @@ void test_ngtcp2_strm_discard_ordered_data(void) {
   /* Discard the ordered data */
   ngtcp2_strm_init(&strm, 0, NGTCP2_STRM_FLAG_NONE, 0, 0, NULL, NULL, mem);
 
-  ngtcp2_strm_recv_reordering(&strm, nulldata, 1024, 1000000007);
-  ngtcp2_strm_recv_reordering(&strm, nulldata, 999, 1000001032);
+  ngtcp2_strm_recv_reordering(&strm, nulldata, 1024, 1000000007, NULL);
+  ngtcp2_strm_recv_reordering(&strm, nulldata, 999, 1000001032, NULL);
 
   assert_not_null(strm.rx.rob);
   assert_uint64(0, ==, ngtcp2_strm_rx_offset(&strm));
@@ -114,15 +114,16 @@ static int null_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
 /*
  * write_short_pkt writes a QUIC short header packet containing
  * |frlen| frames pointed by |fr| into |out| whose capacity is
- * |outlen|.  This function returns the number of bytes written.
+ * |outlen|.  |hp_mask| is used to apply header protection.  This
+ * function returns the number of bytes written.
  */
 static size_t write_short_pkt(uint8_t *out, size_t outlen, uint8_t flags,
                               const ngtcp2_cid *dcid, int64_t pkt_num,
                               ngtcp2_frame *fr, size_t frlen,
-                              ngtcp2_crypto_km *ckm) {
+                              ngtcp2_crypto_km *ckm, ngtcp2_hp_mask hp_mask) {
   ngtcp2_crypto_cc cc = {
     .encrypt = null_encrypt,
-    .hp_mask = null_hp_mask,
+    .hp_mask = hp_mask,
     .ckm = ckm,
     .aead.max_overhead = NGTCP2_FAKE_AEAD_OVERHEAD,
   };
@@ -154,18 +155,19 @@ static size_t write_short_pkt(uint8_t *out, size_t outlen, uint8_t flags,
  * write_long_pkt writes a QUIC long header packet containing |frlen|
  * frames pointed by |fr| into |out| whose capacity is |outlen|.  If
  * |padding| is nonzero, this function adds padding to fill the
- * remaining space.  This function returns the number of bytes
- * written.
+ * remaining space.  |hp_mask| is used to apply header protection.
+ * This function returns the number of bytes written.
  */
 static size_t write_long_pkt(uint8_t *out, size_t outlen, uint8_t flags,
                              uint8_t pkt_type, const ngtcp2_cid *dcid,
                              const ngtcp2_cid *scid, int64_t pkt_num,
                              uint32_t version, const uint8_t *token,
                              size_t tokenlen, ngtcp2_frame *fr, size_t frlen,
-                             ngtcp2_crypto_km *ckm, int padding) {
+                             ngtcp2_crypto_km *ckm, ngtcp2_hp_mask hp_mask,
+                             int padding) {
   ngtcp2_crypto_cc cc = {
     .encrypt = null_encrypt,
-    .hp_mask = null_hp_mask,
+    .hp_mask = hp_mask,
     .ckm = ckm,
   };
   ngtcp2_ppe ppe;
@@ -406,13 +408,17 @@ void ngtcp2_tpe_init_conn_handshake_server(ngtcp2_tpe *tpe, ngtcp2_conn *conn,
   tpe->initial.ckm = ckm;
 }
 
+static ngtcp2_hp_mask tpe_hp_mask(const ngtcp2_tpe *tpe) {
+  return tpe->hp_mask ? tpe->hp_mask : null_hp_mask;
+}
+
 static size_t tpe_write_initial_padding(ngtcp2_tpe *tpe, uint8_t *out,
                                         size_t outlen, ngtcp2_frame *fr,
                                         size_t frlen, int padding) {
   return write_long_pkt(out, outlen, tpe->flags, NGTCP2_PKT_INITIAL, &tpe->dcid,
                         &tpe->scid, ++tpe->initial.last_pkt_num, tpe->version,
                         tpe->token, tpe->tokenlen, fr, frlen, tpe->initial.ckm,
-                        padding);
+                        tpe_hp_mask(tpe), padding);
 }
 
 size_t ngtcp2_tpe_write_initial(ngtcp2_tpe *tpe, uint8_t *out, size_t outlen,
@@ -433,18 +439,20 @@ size_t ngtcp2_tpe_write_handshake(ngtcp2_tpe *tpe, uint8_t *out, size_t outlen,
   return write_long_pkt(out, outlen, tpe->flags, NGTCP2_PKT_HANDSHAKE,
                         &tpe->dcid, &tpe->scid, ++tpe->handshake.last_pkt_num,
                         tpe->version, NULL, 0, fr, frlen, tpe->handshake.ckm,
-                        /* padding = */ 0);
+                        tpe_hp_mask(tpe), /* padding = */ 0);
 }
 
 size_t ngtcp2_tpe_write_0rtt(ngtcp2_tpe *tpe, uint8_t *out, size_t outlen,
                              ngtcp2_frame *fr, size_t frlen) {
   return write_long_pkt(out, outlen, tpe->flags, NGTCP2_PKT_0RTT, &tpe->dcid,
                         &tpe->scid, ++tpe->app.last_pkt_num, tpe->version, NULL,
-                        0, fr, frlen, tpe->early.ckm, /* padding = */ 0);
+                        0, fr, frlen, tpe->early.ckm, tpe_hp_mask(tpe),
+                        /* padding = */ 0);
 }
 
 size_t ngtcp2_tpe_write_1rtt(ngtcp2_tpe *tpe, uint8_t *out, size_t outlen,
                              ngtcp2_frame *fr, size_t frlen) {
   return write_short_pkt(out, outlen, tpe->flags, &tpe->dcid,
-                         ++tpe->app.last_pkt_num, fr, frlen, tpe->app.ckm);
+                         ++tpe->app.last_pkt_num, fr, frlen, tpe->app.ckm,
+                         tpe_hp_mask(tpe));
 }
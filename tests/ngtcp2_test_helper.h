@@ -204,6 +204,9 @@ typedef struct ngtcp2_tpe {
   /* flags is a bitwise OR of one or more of NGTCP2_PKT_FLAG_*
      flags. */
   uint8_t flags;
+  /* hp_mask, if not NULL, is used to apply header protection instead
+     of NGTCP2_FAKE_HP_MASK. */
+  ngtcp2_hp_mask hp_mask;
 
   /* Initial packet number space. */
   struct {
@@ -0,0 +1,151 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2026 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_timerq_test.h"
+
+#include <stdio.h>
+
+#include "ngtcp2_timerq.h"
+#include "ngtcp2_macro.h"
+#include "ngtcp2_test_helper.h"
+
+static const MunitTest tests[] = {
+  munit_void_test(test_ngtcp2_timerq_update_pop),
+  munit_void_test(test_ngtcp2_timerq_cascade),
+  munit_test_end(),
+};
+
+const MunitSuite timerq_suite = {
+  "/timerq", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE,
+};
+
+void test_ngtcp2_timerq_update_pop(void) {
+  ngtcp2_timerq *timerq;
+  ngtcp2_timerq_entry ents[3];
+  int rv;
+
+  rv = ngtcp2_timerq_new(&timerq, NGTCP2_MILLISECONDS, NULL);
+
+  assert_int(0, ==, rv);
+  assert_uint64(UINT64_MAX, ==, ngtcp2_timerq_get_expiry(timerq));
+
+  ngtcp2_timerq_entry_init(&ents[0]);
+  ngtcp2_timerq_entry_init(&ents[1]);
+  ngtcp2_timerq_entry_init(&ents[2]);
+
+  ngtcp2_timerq_update(timerq, &ents[0], 10 * NGTCP2_MILLISECONDS);
+  ngtcp2_timerq_update(timerq, &ents[1], 5 * NGTCP2_MILLISECONDS + 1);
+  ngtcp2_timerq_update(timerq, &ents[2], 30 * NGTCP2_MILLISECONDS);
+
+  assert_size(3, ==, timerq->len);
+
+  /* The deadline is rounded up to the granularity. */
+  assert_uint64(6 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_timerq_get_expiry(timerq));
+  assert_null(ngtcp2_timerq_pop(timerq, 5 * NGTCP2_MILLISECONDS + 1));
+  assert_ptr_equal(&ents[1],
+                   ngtcp2_timerq_pop(timerq, 6 * NGTCP2_MILLISECONDS));
+  assert_uint64(UINT64_MAX, ==, ents[1].expiry);
+  assert_null(ngtcp2_timerq_pop(timerq, 6 * NGTCP2_MILLISECONDS));
+
+  /* Updating with the same deadline is no-op. */
+  ngtcp2_timerq_update(timerq, &ents[0], 10 * NGTCP2_MILLISECONDS);
+
+  assert_size(2, ==, timerq->len);
+
+  /* Move ents[2] before ents[0]. */
+  ngtcp2_timerq_update(timerq, &ents[2], 8 * NGTCP2_MILLISECONDS);
+
+  assert_uint64(8 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_timerq_get_expiry(timerq));
+
+  /* A deadline in the past is due immediately. */
+  ngtcp2_timerq_update(timerq, &ents[1], 0);
+
+  assert_uint64(6 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_timerq_get_expiry(timerq));
+  assert_ptr_equal(&ents[1],
+                   ngtcp2_timerq_pop(timerq, 6 * NGTCP2_MILLISECONDS));
+
+  ngtcp2_timerq_remove(timerq, &ents[2]);
+
+  assert_size(1, ==, timerq->len);
+  assert_null(ents[2].pprev);
+  assert_ptr_equal(&ents[0],
+                   ngtcp2_timerq_pop(timerq, 100 * NGTCP2_MILLISECONDS));
+  assert_size(0, ==, timerq->len);
+  assert_uint64(UINT64_MAX, ==, ngtcp2_timerq_get_expiry(timerq));
+
+  /* Removing an entry which is not in the queue is no-op. */
+  ngtcp2_timerq_remove(timerq, &ents[2]);
+
+  ngtcp2_timerq_del(timerq);
+}
+
+void test_ngtcp2_timerq_cascade(void) {
+  ngtcp2_timerq *timerq;
+  ngtcp2_timerq_entry ents[4];
+  const ngtcp2_tstamp expiries[] = {100, 5000, 300000, 1ULL << 40};
+  const uint8_t levels[] = {1, 2, 3, NGTCP2_TIMERQ_NUM_LEVELS - 1};
+  ngtcp2_timerq_entry *ent;
+  ngtcp2_tstamp ts;
+  size_t i, nwakeup;
+  int rv;
+
+  rv = ngtcp2_timerq_new(&timerq, 1, NULL);
+
+  assert_int(0, ==, rv);
+
+  /* The last entry is beyond the range of the timer wheel, and it is
+     kept in the last level. */
+  for (i = 0; i < ngtcp2_arraylen(ents); ++i) {
+    ngtcp2_timerq_entry_init(&ents[i]);
+    ngtcp2_timerq_update(timerq, &ents[i], expiries[i]);
+
+    assert_uint8(levels[i], ==, ents[i].level);
+  }
+
+  for (i = 0; i < ngtcp2_arraylen(ents); ++i) {
+    for (nwakeup = 0;; ++nwakeup) {
+      ts = ngtcp2_timerq_get_expiry(timerq);
+
+      assert_uint64(expiries[i], >=, ts);
+
+      ent = ngtcp2_timerq_pop(timerq, ts);
+      if (ent) {
+        break;
+      }
+
+      /* The wakeups before the deadline are only for cascading. */
+      assert_size(64, >, nwakeup);
+    }
+
+    assert_ptr_equal(&ents[i], ent);
+    assert_uint64(expiries[i], ==, ts);
+  }
+
+  assert_size(0, ==, timerq->len);
+
+  ngtcp2_timerq_del(timerq);
+}
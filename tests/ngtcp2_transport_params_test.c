@@ -106,6 +106,7 @@ void test_ngtcp2_transport_params_encode(void) {
         .available_versionslen = ngtcp2_arraylen(available_versions),
       },
     .version_info_present = 1,
+    .min_ack_delay = 1777 * NGTCP2_MICROSECONDS,
   };
 
   len =
@@ -161,7 +162,9 @@ void test_ngtcp2_transport_params_encode(void) {
      ngtcp2_put_uvarintlen(sizeof(params.version_info.chosen_version) +
                            params.version_info.available_versionslen) +
      sizeof(params.version_info.chosen_version) +
-     params.version_info.available_versionslen);
+     params.version_info.available_versionslen) +
+    varint_paramlen(NGTCP2_TRANSPORT_PARAM_MIN_ACK_DELAY,
+                    params.min_ack_delay / NGTCP2_MICROSECONDS);
 
   nwrite = ngtcp2_transport_params_encode(NULL, 0, &params);
 
@@ -239,6 +242,7 @@ void test_ngtcp2_transport_params_encode(void) {
   assert_memory_equal(params.version_info.available_versionslen,
                       params.version_info.available_versions,
                       nparams.version_info.available_versions);
+  assert_uint64(params.min_ack_delay, ==, nparams.min_ack_delay);
 }
 
 void test_ngtcp2_transport_params_decode(void) {
@@ -465,9 +469,10 @@ void test_ngtcp2_transport_params_decode_new(void) {
 }
 
 void test_ngtcp2_transport_params_convert_to_latest(void) {
+  const int srcver = NGTCP2_TRANSPORT_PARAMS_V1;
   ngtcp2_transport_params *src, srcbuf, paramsbuf;
   const ngtcp2_transport_params *dest;
-  size_t v1len;
+  size_t srclen;
   uint8_t available_versions[sizeof(uint32_t) * 3];
   size_t i;
 
@@ -475,8 +480,7 @@ void test_ngtcp2_transport_params_convert_to_latest(void) {
     ngtcp2_put_uint32be(&available_versions[i], (uint32_t)(0xFF000000U + i));
   }
 
-  ngtcp2_transport_params_default_versioned(NGTCP2_TRANSPORT_PARAMS_V1,
-                                            &srcbuf);
+  ngtcp2_transport_params_default_versioned(srcver, &srcbuf);
 
   srcbuf.initial_max_stream_data_bidi_local = 1000000007;
   srcbuf.initial_max_stream_data_bidi_remote = 961748941;
@@ -517,16 +521,17 @@ void test_ngtcp2_transport_params_convert_to_latest(void) {
     ngtcp2_arraylen(available_versions);
   srcbuf.version_info_present = 1;
 
-  v1len = sizeof(srcbuf);
+  srclen = ngtcp2_transport_paramslen_version(srcver);
+
+  src = malloc(srclen);
 
-  src = malloc(v1len);
+  memcpy(src, &srcbuf, srclen);
 
-  memcpy(src, &srcbuf, v1len);
+  dest = ngtcp2_transport_params_convert_to_latest(&paramsbuf, srcver, src);
 
-  dest = ngtcp2_transport_params_convert_to_latest(
-    &paramsbuf, NGTCP2_TRANSPORT_PARAMS_V1, src);
+  free(src);
 
-  assert_ptr_equal(src, dest);
+  assert_ptr_equal(&paramsbuf, dest);
   assert_uint64(srcbuf.initial_max_stream_data_bidi_local, ==,
                 dest->initial_max_stream_data_bidi_local);
   assert_uint64(srcbuf.initial_max_stream_data_bidi_remote, ==,
@@ -576,8 +581,39 @@ void test_ngtcp2_transport_params_convert_to_latest(void) {
   assert_memory_equal(srcbuf.version_info.available_versionslen,
                       srcbuf.version_info.available_versions,
                       dest->version_info.available_versions);
-
-  free(src);
+  assert_uint64(0, ==, dest->min_ack_delay);
 }
 
-void test_ngtcp2_transport_params_convert_to_old(void) {}
+void test_ngtcp2_transport_params_convert_to_old(void) {
+  const int destver = NGTCP2_TRANSPORT_PARAMS_V1;
+  ngtcp2_transport_params src, *dest, destbuf;
+  size_t destlen;
+
+  destlen = ngtcp2_transport_paramslen_version(destver);
+
+  dest = malloc(destlen);
+
+  ngtcp2_transport_params_default(&src);
+  src.initial_max_data = 1000000009;
+  src.max_ack_delay = 63 * NGTCP2_MILLISECONDS;
+  src.active_connection_id_limit = 1073741824;
+  src.max_datagram_frame_size = 63;
+  src.grease_quic_bit = 1;
+  src.min_ack_delay = 3 * NGTCP2_MILLISECONDS;
+
+  ngtcp2_transport_params_convert_to_old(destver, dest, &src);
+
+  memset(&destbuf, 0, sizeof(destbuf));
+  memcpy(&destbuf, dest, destlen);
+
+  free(dest);
+
+  assert_uint64(src.initial_max_data, ==, destbuf.initial_max_data);
+  assert_uint64(src.max_ack_delay, ==, destbuf.max_ack_delay);
+  assert_uint64(src.active_connection_id_limit, ==,
+                destbuf.active_connection_id_limit);
+  assert_uint64(src.max_datagram_frame_size, ==,
+                destbuf.max_datagram_frame_size);
+  assert_uint8(src.grease_quic_bit, ==, destbuf.grease_quic_bit);
+  assert_uint64(0, ==, destbuf.min_ack_delay);
+}